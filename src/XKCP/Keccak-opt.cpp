@@ -0,0 +1,274 @@
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "Keccak-opt.hpp"
+
+using namespace std;
+
+static const uint64_t keccakRoundConstants[24] =
+{
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/* Lane operations, on one lane or on 4 lanes of 4 different states */
+
+static inline uint64_t kXor (uint64_t a, uint64_t b) { return a ^ b; }
+static inline uint64_t kAndNot (uint64_t a, uint64_t b) { return ~a & b; }
+template <int n> static inline uint64_t kRol (uint64_t a) { return (a << n) | (a >> (64 - n)); }
+static inline void kBroadcast (uint64_t &a, uint64_t c) { a = c; }
+
+#ifdef __AVX2__
+static inline __m256i kXor (__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+static inline __m256i kAndNot (__m256i a, __m256i b) { return _mm256_andnot_si256(a, b); }
+template <int n> static inline __m256i kRol (__m256i a) { return _mm256_or_si256(_mm256_slli_epi64(a, n), _mm256_srli_epi64(a, 64 - n)); }
+static inline void kBroadcast (__m256i &a, uint64_t c) { a = _mm256_set1_epi64x(c); }
+#endif
+
+// The 24 rounds, with θ, ρ, π and χ unrolled over the 25 lanes
+template <typename V>
+static inline void keccakF1600Rounds (V (&A)[KECCAK_STATE_LANES])
+{
+    V B[KECCAK_STATE_LANES];
+    V C0, C1, C2, C3, C4, D0, D1, D2, D3, D4, RC;
+
+    for (uint64_t round = 0; round < 24; round++)
+    {
+        // θ
+        C0 = kXor(kXor(kXor(kXor(A[0], A[5]), A[10]), A[15]), A[20]);
+        C1 = kXor(kXor(kXor(kXor(A[1], A[6]), A[11]), A[16]), A[21]);
+        C2 = kXor(kXor(kXor(kXor(A[2], A[7]), A[12]), A[17]), A[22]);
+        C3 = kXor(kXor(kXor(kXor(A[3], A[8]), A[13]), A[18]), A[23]);
+        C4 = kXor(kXor(kXor(kXor(A[4], A[9]), A[14]), A[19]), A[24]);
+        D0 = kXor(C4, kRol<1>(C1));
+        D1 = kXor(C0, kRol<1>(C2));
+        D2 = kXor(C1, kRol<1>(C3));
+        D3 = kXor(C2, kRol<1>(C4));
+        D4 = kXor(C3, kRol<1>(C0));
+
+        // ρ and π: lane (x,y) is rotated and moved to (y,2x+3y)
+        B[ 0] = kXor(A[ 0], D0);
+        B[10] = kRol<1>(kXor(A[ 1], D1));
+        B[20] = kRol<62>(kXor(A[ 2], D2));
+        B[ 5] = kRol<28>(kXor(A[ 3], D3));
+        B[15] = kRol<27>(kXor(A[ 4], D4));
+        B[16] = kRol<36>(kXor(A[ 5], D0));
+        B[ 1] = kRol<44>(kXor(A[ 6], D1));
+        B[11] = kRol<6>(kXor(A[ 7], D2));
+        B[21] = kRol<55>(kXor(A[ 8], D3));
+        B[ 6] = kRol<20>(kXor(A[ 9], D4));
+        B[ 7] = kRol<3>(kXor(A[10], D0));
+        B[17] = kRol<10>(kXor(A[11], D1));
+        B[ 2] = kRol<43>(kXor(A[12], D2));
+        B[12] = kRol<25>(kXor(A[13], D3));
+        B[22] = kRol<39>(kXor(A[14], D4));
+        B[23] = kRol<41>(kXor(A[15], D0));
+        B[ 8] = kRol<45>(kXor(A[16], D1));
+        B[18] = kRol<15>(kXor(A[17], D2));
+        B[ 3] = kRol<21>(kXor(A[18], D3));
+        B[13] = kRol<8>(kXor(A[19], D4));
+        B[14] = kRol<18>(kXor(A[20], D0));
+        B[24] = kRol<2>(kXor(A[21], D1));
+        B[ 9] = kRol<61>(kXor(A[22], D2));
+        B[19] = kRol<56>(kXor(A[23], D3));
+        B[ 4] = kRol<14>(kXor(A[24], D4));
+
+        // χ
+        A[ 0] = kXor(B[ 0], kAndNot(B[ 1], B[ 2]));
+        A[ 1] = kXor(B[ 1], kAndNot(B[ 2], B[ 3]));
+        A[ 2] = kXor(B[ 2], kAndNot(B[ 3], B[ 4]));
+        A[ 3] = kXor(B[ 3], kAndNot(B[ 4], B[ 0]));
+        A[ 4] = kXor(B[ 4], kAndNot(B[ 0], B[ 1]));
+        A[ 5] = kXor(B[ 5], kAndNot(B[ 6], B[ 7]));
+        A[ 6] = kXor(B[ 6], kAndNot(B[ 7], B[ 8]));
+        A[ 7] = kXor(B[ 7], kAndNot(B[ 8], B[ 9]));
+        A[ 8] = kXor(B[ 8], kAndNot(B[ 9], B[ 5]));
+        A[ 9] = kXor(B[ 9], kAndNot(B[ 5], B[ 6]));
+        A[10] = kXor(B[10], kAndNot(B[11], B[12]));
+        A[11] = kXor(B[11], kAndNot(B[12], B[13]));
+        A[12] = kXor(B[12], kAndNot(B[13], B[14]));
+        A[13] = kXor(B[13], kAndNot(B[14], B[10]));
+        A[14] = kXor(B[14], kAndNot(B[10], B[11]));
+        A[15] = kXor(B[15], kAndNot(B[16], B[17]));
+        A[16] = kXor(B[16], kAndNot(B[17], B[18]));
+        A[17] = kXor(B[17], kAndNot(B[18], B[19]));
+        A[18] = kXor(B[18], kAndNot(B[19], B[15]));
+        A[19] = kXor(B[19], kAndNot(B[15], B[16]));
+        A[20] = kXor(B[20], kAndNot(B[21], B[22]));
+        A[21] = kXor(B[21], kAndNot(B[22], B[23]));
+        A[22] = kXor(B[22], kAndNot(B[23], B[24]));
+        A[23] = kXor(B[23], kAndNot(B[24], B[20]));
+        A[24] = kXor(B[24], kAndNot(B[20], B[21]));
+
+        // ι
+        kBroadcast(RC, keccakRoundConstants[round]);
+        A[0] = kXor(A[0], RC);
+    }
+}
+
+void KeccakF1600Unrolled (uint64_t (&state)[KECCAK_STATE_LANES])
+{
+    keccakF1600Rounds(state);
+}
+
+void KeccakF1600Times4 (uint64_t (&states)[4][KECCAK_STATE_LANES])
+{
+#ifdef __AVX2__
+    __m256i A[KECCAK_STATE_LANES];
+    for (uint64_t i = 0; i < KECCAK_STATE_LANES; i++)
+    {
+        A[i] = _mm256_set_epi64x(states[3][i], states[2][i], states[1][i], states[0][i]);
+    }
+    keccakF1600Rounds(A);
+    for (uint64_t i = 0; i < KECCAK_STATE_LANES; i++)
+    {
+        uint64_t lanes[4];
+        _mm256_storeu_si256((__m256i *)lanes, A[i]);
+        states[0][i] = lanes[0];
+        states[1][i] = lanes[1];
+        states[2][i] = lanes[2];
+        states[3][i] = lanes[3];
+    }
+#else
+    for (uint64_t s = 0; s < 4; s++)
+    {
+        keccakF1600Rounds(states[s]);
+    }
+#endif
+}
+
+void KeccakF1600Batch (uint64_t (*pStates)[KECCAK_STATE_LANES], uint64_t n)
+{
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        KeccakF1600Times4(*(uint64_t (*)[4][KECCAK_STATE_LANES])&pStates[i]);
+    }
+    for (; i < n; i++)
+    {
+        keccakF1600Rounds(pStates[i]);
+    }
+}
+
+/* Sponge */
+
+// XORs a block of input bytes into the state
+static inline void absorbBlock (uint64_t (&state)[KECCAK_STATE_LANES], const uint8_t *pBlock)
+{
+    for (uint64_t i = 0; i < KECCAK256_RATE / 8; i++)
+    {
+        uint64_t lane;
+        memcpy(&lane, pBlock + 8*i, 8);
+        state[i] ^= lane;
+    }
+}
+
+// Builds the last, padded block of an input, that holds its remaining inputSize % rate bytes
+static inline void lastBlock (const uint8_t *pInput, uint64_t inputSize, uint8_t (&block)[KECCAK256_RATE])
+{
+    uint64_t offset = (inputSize / KECCAK256_RATE) * KECCAK256_RATE;
+    uint64_t remaining = inputSize - offset;
+    memset(block, 0, sizeof(block));
+    if (remaining > 0)
+    {
+        memcpy(block, pInput + offset, remaining);
+    }
+    block[remaining] ^= 0x01;
+    block[KECCAK256_RATE - 1] ^= 0x80;
+}
+
+void Keccak256Sponge (const uint8_t *pInput, uint64_t inputSize, uint8_t *pOutput, uint64_t outputSize)
+{
+    uint64_t state[KECCAK_STATE_LANES] = {0};
+
+    // Absorb the full blocks and the padded last one
+    uint64_t nFullBlocks = inputSize / KECCAK256_RATE;
+    for (uint64_t b = 0; b < nFullBlocks; b++)
+    {
+        absorbBlock(state, pInput + b*KECCAK256_RATE);
+        keccakF1600Rounds(state);
+    }
+    uint8_t block[KECCAK256_RATE];
+    lastBlock(pInput, inputSize, block);
+    absorbBlock(state, block);
+    keccakF1600Rounds(state);
+
+    // Squeeze
+    while (outputSize > 0)
+    {
+        uint64_t size = (outputSize < KECCAK256_RATE) ? outputSize : KECCAK256_RATE;
+        memcpy(pOutput, state, size);
+        pOutput += size;
+        outputSize -= size;
+        if (outputSize > 0)
+        {
+            keccakF1600Rounds(state);
+        }
+    }
+}
+
+void Keccak256Batch (uint64_t n, const uint8_t * const *pInputs, const uint64_t *pInputSizes, uint8_t (*pHashes)[32])
+{
+    // Sort the inputs by size, so that the 4 inputs hashed together need about the same number of
+    // permutations
+    vector<uint64_t> order(n);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [pInputSizes](uint64_t a, uint64_t b) { return pInputSizes[a] > pInputSizes[b]; });
+
+    uint64_t g = 0;
+    for (; g + 4 <= n; g += 4)
+    {
+        uint64_t states[4][KECCAK_STATE_LANES];
+        memset(states, 0, sizeof(states));
+        uint64_t nBlocks[4];
+        for (uint64_t l = 0; l < 4; l++)
+        {
+            nBlocks[l] = pInputSizes[order[g + l]] / KECCAK256_RATE + 1;
+        }
+
+        // The first input of the group is the longest one; the inputs that are done get permuted
+        // with the others, but their states are no longer used
+        for (uint64_t b = 0; b < nBlocks[0]; b++)
+        {
+            for (uint64_t l = 0; l < 4; l++)
+            {
+                uint64_t i = order[g + l];
+                if (b + 1 < nBlocks[l])
+                {
+                    absorbBlock(states[l], pInputs[i] + b*KECCAK256_RATE);
+                }
+                else if (b + 1 == nBlocks[l])
+                {
+                    uint8_t block[KECCAK256_RATE];
+                    lastBlock(pInputs[i], pInputSizes[i], block);
+                    absorbBlock(states[l], block);
+                }
+            }
+            KeccakF1600Times4(states);
+            for (uint64_t l = 0; l < 4; l++)
+            {
+                if (b + 1 == nBlocks[l])
+                {
+                    memcpy(pHashes[order[g + l]], states[l], 32);
+                }
+            }
+        }
+    }
+
+    // Hash the remaining inputs one by one
+    for (; g < n; g++)
+    {
+        uint64_t i = order[g];
+        Keccak256Sponge(pInputs[i], pInputSizes[i], pHashes[i], 32);
+    }
+}
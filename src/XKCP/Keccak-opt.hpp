@@ -0,0 +1,31 @@
+#ifndef KECCAK_OPT_HPP
+#define KECCAK_OPT_HPP
+
+#include <stdint.h>
+
+// Optimized Keccak-f[1600], as a faster drop-in for KeccakF1600() and Keccak() of
+// Keccak-more-compact.hpp when hashing large amounts of data.
+// The state is 25 little endian 64-bit lanes, so on x86 it has the same memory layout as the
+// 200-byte state of KeccakF1600(). There is an unrolled scalar permutation and, if compiled with
+// AVX2, a 4-way one that permutes 4 independent states at once, one per 64-bit element of the
+// 256-bit registers; the batch functions use it to process independent states or inputs 4 by 4.
+
+#define KECCAK_STATE_LANES 25
+#define KECCAK256_RATE 136 // Bytes absorbed per permutation by keccak256
+
+// Permutes one state
+void KeccakF1600Unrolled (uint64_t (&state)[KECCAK_STATE_LANES]);
+
+// Permutes 4 independent states
+void KeccakF1600Times4 (uint64_t (&states)[4][KECCAK_STATE_LANES]);
+
+// Permutes n independent states
+void KeccakF1600Batch (uint64_t (*pStates)[KECCAK_STATE_LANES], uint64_t n);
+
+// keccak256 (Keccak with rate 1088, capacity 512 and 0x01 padding) of one input, with any output size
+void Keccak256Sponge (const uint8_t *pInput, uint64_t inputSize, uint8_t *pOutput, uint64_t outputSize);
+
+// keccak256 of n independent inputs; inputs of similar size are hashed together, 4 at a time
+void Keccak256Batch (uint64_t n, const uint8_t * const *pInputs, const uint64_t *pInputSizes, uint8_t (*pHashes)[32]);
+
+#endif
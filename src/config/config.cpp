@@ -32,6 +32,10 @@ void Config::load(json &config)
     if (config.contains("runStateDBTest") && config["runStateDBTest"].is_boolean())
         runStateDBTest = config["runStateDBTest"];
 
+    runStateDBPerfTest = false;
+    if (config.contains("runStateDBPerfTest") && config["runStateDBPerfTest"].is_boolean())
+        runStateDBPerfTest = config["runStateDBPerfTest"];
+
     runAggregatorServer = false;
     if (config.contains("runAggregatorServer") && config["runAggregatorServer"].is_boolean())
         runAggregatorServer = config["runAggregatorServer"];
@@ -44,6 +48,10 @@ void Config::load(json &config)
     if (config.contains("runAggregatorClientMock") && config["runAggregatorClientMock"].is_boolean())
         runAggregatorClientMock = config["runAggregatorClientMock"];
 
+    runMetricsServer = false;
+    if (config.contains("runMetricsServer") && config["runMetricsServer"].is_boolean())
+        runMetricsServer = config["runMetricsServer"];
+
         
     runFileGenBatchProof = false;
     if (config.contains("runFileGenBatchProof") && config["runFileGenBatchProof"].is_boolean())
@@ -53,6 +61,10 @@ void Config::load(json &config)
     if (config.contains("runFileGenAggregatedProof") && config["runFileGenAggregatedProof"].is_boolean())
         runFileGenAggregatedProof = config["runFileGenAggregatedProof"];
 
+    runFileGenAggregatedProofTree = false;
+    if (config.contains("runFileGenAggregatedProofTree") && config["runFileGenAggregatedProofTree"].is_boolean())
+        runFileGenAggregatedProofTree = config["runFileGenAggregatedProofTree"];
+
     runFileGenFinalProof = false;
     if (config.contains("runFileGenFinalProof") && config["runFileGenFinalProof"].is_boolean())
         runFileGenFinalProof = config["runFileGenFinalProof"];
@@ -74,6 +86,10 @@ void Config::load(json &config)
     if (config.contains("runKeccakScriptGenerator") && config["runKeccakScriptGenerator"].is_boolean())
         runKeccakScriptGenerator = config["runKeccakScriptGenerator"];
 
+    runDbReadsJournalConverter = false;
+    if (config.contains("runDbReadsJournalConverter") && config["runDbReadsJournalConverter"].is_boolean())
+        runDbReadsJournalConverter = config["runDbReadsJournalConverter"];
+
     runKeccakTest = false;
     if (config.contains("runKeccakTest") && config["runKeccakTest"].is_boolean())
         runKeccakTest = config["runKeccakTest"];
@@ -98,6 +114,10 @@ void Config::load(json &config)
     if (config.contains("runBlakeTest") && config["runBlakeTest"].is_boolean())
         runBlakeTest = config["runBlakeTest"];
 
+    runUnitTests = false;
+    if (config.contains("runUnitTests") && config["runUnitTests"].is_boolean())
+        runUnitTests = config["runUnitTests"];
+
     useMainExecGenerated = false;
     if (config.contains("useMainExecGenerated") && config["useMainExecGenerated"].is_boolean())
         useMainExecGenerated = config["useMainExecGenerated"];
@@ -122,14 +142,26 @@ void Config::load(json &config)
     if (config.contains("saveDbReadsToFileOnChange") && config["saveDbReadsToFileOnChange"].is_boolean())
         saveDbReadsToFileOnChange = config["saveDbReadsToFileOnChange"];
 
+    dbReadsJournalSyncPeriod = 1000;
+    if (config.contains("dbReadsJournalSyncPeriod") && config["dbReadsJournalSyncPeriod"].is_number())
+        dbReadsJournalSyncPeriod = config["dbReadsJournalSyncPeriod"];
+
     saveInputToFile = false;
     if (config.contains("saveInputToFile") && config["saveInputToFile"].is_boolean())
         saveInputToFile = config["saveInputToFile"];
 
+    saveInputInBinaryFormat = false;
+    if (config.contains("saveInputInBinaryFormat") && config["saveInputInBinaryFormat"].is_boolean())
+        saveInputInBinaryFormat = config["saveInputInBinaryFormat"];
+
     saveResponseToFile = false;
     if (config.contains("saveResponseToFile") && config["saveResponseToFile"].is_boolean())
         saveResponseToFile = config["saveResponseToFile"];
 
+    saveTraceEventsToFile = false;
+    if (config.contains("saveTraceEventsToFile") && config["saveTraceEventsToFile"].is_boolean())
+        saveTraceEventsToFile = config["saveTraceEventsToFile"];
+
     saveOutputToFile = false;
     if (config.contains("saveOutputToFile") && config["saveOutputToFile"].is_boolean())
         saveOutputToFile = config["saveOutputToFile"];
@@ -162,6 +194,14 @@ void Config::load(json &config)
     if (config.contains("executorServerPort") && config["executorServerPort"].is_number())
         executorServerPort = config["executorServerPort"];
 
+    executorServerAsync = false;
+    if (config.contains("executorServerAsync") && config["executorServerAsync"].is_boolean())
+        executorServerAsync = config["executorServerAsync"];
+
+    executorServerMaxInFlight = 64;
+    if (config.contains("executorServerMaxInFlight") && config["executorServerMaxInFlight"].is_number())
+        executorServerMaxInFlight = config["executorServerMaxInFlight"];
+
     executorROMLineTraces = false;
     if (config.contains("executorROMLineTraces") && config["executorROMLineTraces"].is_boolean())
         executorROMLineTraces = config["executorROMLineTraces"];
@@ -182,6 +222,34 @@ void Config::load(json &config)
     if (config.contains("stateDBURL") && config["stateDBURL"].is_string())
         stateDBURL = config["stateDBURL"];
 
+    stateDBStreaming = true;
+    if (config.contains("stateDBStreaming") && config["stateDBStreaming"].is_boolean())
+        stateDBStreaming = config["stateDBStreaming"];
+
+    stateDBPerfThreads = 8;
+    if (config.contains("stateDBPerfThreads") && config["stateDBPerfThreads"].is_number())
+        stateDBPerfThreads = config["stateDBPerfThreads"];
+
+    stateDBPerfOperations = 10000;
+    if (config.contains("stateDBPerfOperations") && config["stateDBPerfOperations"].is_number())
+        stateDBPerfOperations = config["stateDBPerfOperations"];
+
+    stateDBPerfReadPercentage = 80;
+    if (config.contains("stateDBPerfReadPercentage") && config["stateDBPerfReadPercentage"].is_number())
+        stateDBPerfReadPercentage = config["stateDBPerfReadPercentage"];
+
+    stateDBPerfKeys = 100000;
+    if (config.contains("stateDBPerfKeys") && config["stateDBPerfKeys"].is_number())
+        stateDBPerfKeys = config["stateDBPerfKeys"];
+
+    stateDBPerfZipfSkew = 0.99;
+    if (config.contains("stateDBPerfZipfSkew") && config["stateDBPerfZipfSkew"].is_number())
+        stateDBPerfZipfSkew = config["stateDBPerfZipfSkew"];
+
+    stateDBPerfColdCache = false;
+    if (config.contains("stateDBPerfColdCache") && config["stateDBPerfColdCache"].is_boolean())
+        stateDBPerfColdCache = config["stateDBPerfColdCache"];
+
     aggregatorServerPort = 50071;
     if (config.contains("aggregatorServerPort") && config["aggregatorServerPort"].is_number())
         aggregatorServerPort = config["aggregatorServerPort"];
@@ -198,6 +266,10 @@ void Config::load(json &config)
     if (config.contains("aggregatorClientMockTimeout") && config["aggregatorClientMockTimeout"].is_number())
         aggregatorClientMockTimeout = config["aggregatorClientMockTimeout"];
 
+    metricsServerPort = 9091;
+    if (config.contains("metricsServerPort") && config["metricsServerPort"].is_number())
+        metricsServerPort = config["metricsServerPort"];
+
     if (config.contains("inputFile") && config["inputFile"].is_string())
         inputFile = config["inputFile"];
     if (config.contains("inputFile2") && config["inputFile2"].is_string())
@@ -294,6 +366,37 @@ void Config::load(json &config)
     if (config.contains("mapConstantsTreeFile") && config["mapConstantsTreeFile"].is_boolean())
         mapConstantsTreeFile = config["mapConstantsTreeFile"];
 
+    lowMemoryProver = false;
+    if (config.contains("lowMemoryProver") && config["lowMemoryProver"].is_boolean())
+        lowMemoryProver = config["lowMemoryProver"];
+
+    lowMemoryProverPath = "runtime";
+    if (config.contains("lowMemoryProverPath") && config["lowMemoryProverPath"].is_string())
+        lowMemoryProverPath = config["lowMemoryProverPath"];
+
+    lowMemoryProverTileSize = 4096;
+    if (config.contains("lowMemoryProverTileSize") && config["lowMemoryProverTileSize"].is_number())
+        lowMemoryProverTileSize = config["lowMemoryProverTileSize"];
+
+    numaPolicy = "none";
+    if (config.contains("numaPolicy") && config["numaPolicy"].is_string())
+        numaPolicy = config["numaPolicy"];
+
+    numaBindNode = 0;
+    if (config.contains("numaBindNode") && config["numaBindNode"].is_number())
+        numaBindNode = config["numaBindNode"];
+
+    groth16FixedBaseWindowBits = 0;
+    if (config.contains("groth16FixedBaseWindowBits") && config["groth16FixedBaseWindowBits"].is_number())
+        groth16FixedBaseWindowBits = config["groth16FixedBaseWindowBits"];
+
+    if (config.contains("groth16PreparedZkey") && config["groth16PreparedZkey"].is_string())
+        groth16PreparedZkey = config["groth16PreparedZkey"];
+
+    groth16PreparedZkeyVerify = false;
+    if (config.contains("groth16PreparedZkeyVerify") && config["groth16PreparedZkeyVerify"].is_boolean())
+        groth16PreparedZkeyVerify = config["groth16PreparedZkeyVerify"];
+
     if (config.contains("finalVerkey") && config["finalVerkey"].is_string())
         finalVerkey = config["finalVerkey"];
 
@@ -385,6 +488,34 @@ void Config::load(json &config)
     if (config.contains("requestsPersistence") && config["requestsPersistence"].is_number())
         requestsPersistence = config["requestsPersistence"];
 
+    requestsPersistenceSize = 0;
+    if (config.contains("requestsPersistenceSize") && config["requestsPersistenceSize"].is_number())
+        requestsPersistenceSize = config["requestsPersistenceSize"];
+
+    proverMemoryBudget = 0;
+    if (config.contains("proverMemoryBudget") && config["proverMemoryBudget"].is_number())
+        proverMemoryBudget = config["proverMemoryBudget"];
+
+    proverPriorityBatchProof = 0;
+    if (config.contains("proverPriorityBatchProof") && config["proverPriorityBatchProof"].is_number())
+        proverPriorityBatchProof = config["proverPriorityBatchProof"];
+
+    proverPriorityAggregatedProof = 1;
+    if (config.contains("proverPriorityAggregatedProof") && config["proverPriorityAggregatedProof"].is_number())
+        proverPriorityAggregatedProof = config["proverPriorityAggregatedProof"];
+
+    proverPriorityFinalProof = 2;
+    if (config.contains("proverPriorityFinalProof") && config["proverPriorityFinalProof"].is_number())
+        proverPriorityFinalProof = config["proverPriorityFinalProof"];
+
+    proverPriorityExecute = 0;
+    if (config.contains("proverPriorityExecute") && config["proverPriorityExecute"].is_number())
+        proverPriorityExecute = config["proverPriorityExecute"];
+
+    proverAgingPeriod = 600;
+    if (config.contains("proverAgingPeriod") && config["proverAgingPeriod"].is_number())
+        proverAgingPeriod = config["proverAgingPeriod"];
+
     maxExecutorThreads = 16;
     if (config.contains("maxExecutorThreads") && config["maxExecutorThreads"].is_number())
         maxExecutorThreads = config["maxExecutorThreads"];
@@ -414,16 +545,22 @@ void Config::print(void)
         cout << "    runStateDBServer=true" << endl;
     if (runStateDBTest)
         cout << "    runStateDBTest=true" << endl;
+    if (runStateDBPerfTest)
+        cout << "    runStateDBPerfTest=true" << endl;
     if (runAggregatorServer)
         cout << "    runAggregatorServer=true" << endl;
     if (runAggregatorClient)
         cout << "    runAggregatorClient=true" << endl;
     if (runAggregatorClientMock)        
         cout << "    runAggregatorClientMock=true" << endl;
+    if (runMetricsServer)
+        cout << "    runMetricsServer=true" << endl;
     if (runFileGenBatchProof)
         cout << "    runFileGenBatchProof=true" << endl;
     if (runFileGenAggregatedProof)
         cout << "    runFileGenAggregatedProof=true" << endl;
+    if (runFileGenAggregatedProofTree)
+        cout << "    runFileGenAggregatedProofTree=true" << endl;
     if (runFileGenFinalProof)
         cout << "    runFileGenFinalProof=true" << endl;
     if (runFileProcessBatch)
@@ -435,6 +572,8 @@ void Config::print(void)
 
     if (runKeccakScriptGenerator)
         cout << "    runKeccakScriptGenerator=true" << endl;
+    if (runDbReadsJournalConverter)
+        cout << "    runDbReadsJournalConverter=true" << endl;
     if (runKeccakTest)
         cout << "    runKeccakTest=true" << endl;
     if (runStorageSMTest)
@@ -447,6 +586,8 @@ void Config::print(void)
         cout << "    runSHA256Test=true" << endl;
     if (runBlakeTest)
         cout << "    runBlakeTest=true" << endl;
+    if (runUnitTests)
+        cout << "    runUnitTests=true" << endl;
 
     if (executeInParallel)
         cout << "    executeInParallel=true" << endl;
@@ -463,12 +604,17 @@ void Config::print(void)
         cout << "    saveDbReadsToFile=true" << endl;
     if (saveDbReadsToFileOnChange)
         cout << "    saveDbReadsToFileOnChange=true" << endl;
+    cout << "    dbReadsJournalSyncPeriod=" << dbReadsJournalSyncPeriod << endl;
+    if (saveInputInBinaryFormat)
+        cout << "    saveInputInBinaryFormat=true" << endl;
     if (saveOutputToFile)
         cout << "    saveOutputToFile=true" << endl;
     if (saveProofToFile)
         cout << "    saveProofToFile=true" << endl;
     if (saveResponseToFile)
         cout << "    saveResponseToFile=true" << endl;
+    if (saveTraceEventsToFile)
+        cout << "    saveTraceEventsToFile=true" << endl;
     if (loadDBToMemCache)
         cout << "    loadDBToMemCache=true" << endl;
     if (opcodeTracer)
@@ -479,14 +625,30 @@ void Config::print(void)
         cout << "    logExecutorServerResponses=true" << endl;
 
     cout << "    executorServerPort=" << to_string(executorServerPort) << endl;
+    if (executorServerAsync)
+        cout << "    executorServerAsync=true" << endl;
+    cout << "    executorServerMaxInFlight=" << executorServerMaxInFlight << endl;
     cout << "    executorClientPort=" << to_string(executorClientPort) << endl;
     cout << "    executorClientHost=" << executorClientHost << endl;
     cout << "    stateDBServerPort=" << to_string(stateDBServerPort) << endl;
     cout << "    stateDBURL=" << stateDBURL << endl;
+    if (stateDBStreaming)
+        cout << "    stateDBStreaming=true" << endl;
+    if (runStateDBPerfTest)
+    {
+        cout << "    stateDBPerfThreads=" << stateDBPerfThreads << endl;
+        cout << "    stateDBPerfOperations=" << stateDBPerfOperations << endl;
+        cout << "    stateDBPerfReadPercentage=" << stateDBPerfReadPercentage << endl;
+        cout << "    stateDBPerfKeys=" << stateDBPerfKeys << endl;
+        cout << "    stateDBPerfZipfSkew=" << stateDBPerfZipfSkew << endl;
+        if (stateDBPerfColdCache)
+            cout << "    stateDBPerfColdCache=true" << endl;
+    }
     cout << "    aggregatorServerPort=" << to_string(aggregatorServerPort) << endl;
     cout << "    aggregatorClientPort=" << to_string(aggregatorClientPort) << endl;
     cout << "    aggregatorClientHost=" << aggregatorClientHost << endl;
     cout << "    aggregatorClientMockTimeout=" << to_string(aggregatorClientMockTimeout) << endl;
+    cout << "    metricsServerPort=" << to_string(metricsServerPort) << endl;
 
     cout << "    inputFile=" << inputFile << endl;
     cout << "    inputFile2=" << inputFile2 << endl;
@@ -504,6 +666,21 @@ void Config::print(void)
     cout << "    c12aConstantsTree=" << c12aConstantsTree << endl;
     if (mapConstantsTreeFile)
         cout << "    mapConstantsTreeFile=true" << endl;
+    if (lowMemoryProver)
+    {
+        cout << "    lowMemoryProver=true" << endl;
+        cout << "    lowMemoryProverPath=" << lowMemoryProverPath << endl;
+        cout << "    lowMemoryProverTileSize=" << lowMemoryProverTileSize << endl;
+    }
+    cout << "    numaPolicy=" << numaPolicy << endl;
+    if (numaPolicy == "bind")
+        cout << "    numaBindNode=" << numaBindNode << endl;
+    if (groth16FixedBaseWindowBits > 0)
+        cout << "    groth16FixedBaseWindowBits=" << groth16FixedBaseWindowBits << endl;
+    if (groth16PreparedZkey != "")
+        cout << "    groth16PreparedZkey=" << groth16PreparedZkey << endl;
+    if (groth16PreparedZkeyVerify)
+        cout << "    groth16PreparedZkeyVerify=true" << endl;
     cout << "    finalVerkey=" << finalVerkey << endl;
     cout << "    zkevmVerifier=" << zkevmVerifier << endl;
     cout << "    recursive1Verifier=" << recursive1Verifier << endl;
@@ -526,6 +703,13 @@ void Config::print(void)
     cout << "    dbAsyncWrite=" << to_string(dbAsyncWrite) << endl;
     cout << "    cleanerPollingPeriod=" << cleanerPollingPeriod << endl;
     cout << "    requestsPersistence=" << requestsPersistence << endl;
+    cout << "    requestsPersistenceSize=" << requestsPersistenceSize << endl;
+    cout << "    proverMemoryBudget=" << proverMemoryBudget << endl;
+    cout << "    proverPriorityBatchProof=" << proverPriorityBatchProof << endl;
+    cout << "    proverPriorityAggregatedProof=" << proverPriorityAggregatedProof << endl;
+    cout << "    proverPriorityFinalProof=" << proverPriorityFinalProof << endl;
+    cout << "    proverPriorityExecute=" << proverPriorityExecute << endl;
+    cout << "    proverAgingPeriod=" << proverAgingPeriod << endl;
     cout << "    maxExecutorThreads=" << maxExecutorThreads << endl;
     cout << "    maxProverThreads=" << maxProverThreads << endl;
     cout << "    maxStateDBThreads=" << maxStateDBThreads << endl;
@@ -19,24 +19,29 @@ public:
     bool runExecutorClientMultithread;
     bool runStateDBServer;
     bool runStateDBTest;
+    bool runStateDBPerfTest; // Runs the StateDB performance test, configured by the stateDBPerf* fields
     bool runAggregatorServer;
     bool runAggregatorClient;
     bool runAggregatorClientMock;    
+    bool runMetricsServer; // Serves the metrics registry in Prometheus text format on 127.0.0.1:metricsServerPort/metrics
 
     bool runFileGenBatchProof;              // Proof of 1 batch = Executor + Stark + StarkC12a + Recursive1
     bool runFileGenAggregatedProof;         // Proof of 2 batches = Recursive2 (of the 2 batches StarkC12a)
+    bool runFileGenAggregatedProofTree;     // Proof of N batches = tree of Recursive2 (of the N batch proofs in inputFile)
     bool runFileGenFinalProof;              // Final proof of an aggregated proof = RecursiveF + Groth16 (Snark)
     bool runFileProcessBatch;               // Executor (only main SM)
     bool runFileProcessBatchMultithread;    // Executor (only main SM) in parallel
     bool runFileExecute;                    // Executor (all SMs)
 
     bool runKeccakScriptGenerator;
+    bool runDbReadsJournalConverter; // Converts the database reads journal in inputFile into an input file with its database reads
     bool runKeccakTest;
     bool runStorageSMTest;
     bool runBinarySMTest;
     bool runMemAlignSMTest;
     bool runSHA256Test;
     bool runBlakeTest;
+    bool runUnitTests; // Self-contained tests: StateDB streaming protocol codec, binary batch input format and database reads journal conversion
     
     bool executeInParallel;
     bool useMainExecGenerated;
@@ -45,10 +50,13 @@ public:
     bool saveRequestToFile; // Saves the grpc service request, in text format
     bool saveInputToFile; // Saves the grpc input data, in json format
     bool saveDbReadsToFile; // Saves the grpc input data, including database reads done during execution, in json format
-    bool saveDbReadsToFileOnChange; // Same as saveDbReadsToFile, but saving the file at every read (slow, but useful if executor crashes)
+    bool saveDbReadsToFileOnChange; // Same as saveDbReadsToFile, but also appending every read to a binary journal file, useful if executor crashes
+    uint64_t dbReadsJournalSyncPeriod; // Number of records appended to the database reads journal between fsync calls; 0 syncs only when the journal is closed
+    bool saveInputInBinaryFormat; // Saves the input and database reads files in the binary batch input format instead of json
     bool saveOutputToFile; // Saves the grpc output data, in json format
     bool saveProofToFile; // Saves the proof, in json format
     bool saveResponseToFile; // Saves the grpc service response, in text format
+    bool saveTraceEventsToFile; // Saves a timeline of the timers, state machine threads and proof phases of every request, in Chrome trace-event json format
     bool saveFilesInSubfolders; // Saves output files in folders per hour, e.g. output/2023/01/10/18
 
     bool loadDBToMemCache;
@@ -57,18 +65,29 @@ public:
     bool logExecutorServerResponses;
 
     uint16_t executorServerPort;
+    bool executorServerAsync; // Serve ProcessBatch from a completion queue with a pool of maxExecutorThreads workers
+    uint64_t executorServerMaxInFlight; // Async server requests being processed or queued; above it, new ones get RESOURCE_EXHAUSTED; 0 means no limit
     bool executorROMLineTraces;
     uint16_t executorClientPort;
     string executorClientHost;
 
     uint16_t stateDBServerPort;
     string stateDBURL;
+    bool stateDBStreaming; // Send remote StateDB get and set requests on a single stream, falling back to unary calls if it fails
+    uint64_t stateDBPerfThreads; // StateDB performance test: concurrent client threads, each one with its own client
+    uint64_t stateDBPerfOperations; // StateDB performance test: get and set operations per client thread
+    uint64_t stateDBPerfReadPercentage; // StateDB performance test: percentage (0...100) of the operations that are gets
+    uint64_t stateDBPerfKeys; // StateDB performance test: number of keys set in the tree before the test, and accessed by the operations
+    double stateDBPerfZipfSkew; // StateDB performance test: skew of the zipfian distribution of the accessed keys; 0 means uniform
+    bool stateDBPerfColdCache; // StateDB performance test: empties the database cache before the test, so that reads go to databaseURL
 
     uint16_t aggregatorServerPort;
     uint16_t aggregatorClientPort;
     string aggregatorClientHost;
     uint64_t aggregatorClientMockTimeout;
 
+    uint16_t metricsServerPort;
+
     string inputFile;
     string inputFile2; // Used as the second input in genAggregatedProof
     string outputPath;
@@ -89,6 +108,14 @@ public:
     string recursive2ConstantsTree;
     string recursivefConstantsTree;
     bool mapConstantsTreeFile;
+    bool lowMemoryProver; // Keeps committed polynomials and merkle trees in files, and extends polynomials in column tiles
+    string lowMemoryProverPath; // Folder for the low memory prover files
+    uint64_t lowMemoryProverTileSize; // RAM budget of a column tile, in MB
+    string numaPolicy; // Placement of the prover buffers: none, firstTouch, interleave or bind
+    uint64_t numaBindNode; // Node used by the bind NUMA policy
+    uint64_t groth16FixedBaseWindowBits; // Window of the Groth16 fixed-base multiexp tables, in bits; 0 disables them
+    string groth16PreparedZkey; // Prover-native copy of finalStarkZkey, created if missing or stale; empty disables it
+    bool groth16PreparedZkeyVerify; // If true, groth16PreparedZkey is only used if the checksum of the whole finalStarkZkey matches, which reads it all
     string finalVerkey;
     string zkevmVerifier;
     string recursive1Verifier;
@@ -118,11 +145,18 @@ public:
     bool dbAsyncWrite;
     uint64_t cleanerPollingPeriod;
     uint64_t requestsPersistence;
+    uint64_t requestsPersistenceSize; // MB of completed requests kept; above it, the oldest delivered ones are deleted; 0 means no limit
+    uint64_t proverMemoryBudget; // MB that requests of different classes may use at the same time; 0 runs one request at a time
+    uint64_t proverPriorityBatchProof; // Priority of the pending prover requests of each type; the higher, the sooner
+    uint64_t proverPriorityAggregatedProof;
+    uint64_t proverPriorityFinalProof;
+    uint64_t proverPriorityExecute;
+    uint64_t proverAgingPeriod; // Seconds of wait that raise the priority of a pending request by one; 0 disables aging
     uint64_t maxExecutorThreads;
     uint64_t maxProverThreads;
     uint64_t maxStateDBThreads;
     void load(json &config);
-    bool generateProof(void) const { return runFileGenBatchProof || runFileGenAggregatedProof || runFileGenFinalProof || runAggregatorClient; }
+    bool generateProof(void) const { return runFileGenBatchProof || runFileGenAggregatedProof || runFileGenAggregatedProofTree || runFileGenFinalProof || runAggregatorClient; }
     void print(void);
 };
 
@@ -26,7 +26,8 @@ struct {
     { ZKR_SM_MAIN_OOC_MEM_ALIGN, "Main state machine executor out of mem align counters" },
     { ZKR_SM_MAIN_OOC_KECCAK_F, "Main state machine executor out of keccak-f counters" },
     { ZKR_SM_MAIN_OOC_PADDING_PG, "Main state machine executor out of padding pg counters" },
-    { ZKR_SM_MAIN_OOC_POSEIDON_G, "Main state machine executor out of poseidon g counters" }
+    { ZKR_SM_MAIN_OOC_POSEIDON_G, "Main state machine executor out of poseidon g counters" },
+    { ZKR_INPUT_INVALID_FORMAT, "Input data has an invalid format" }
 };
 
 const char* zkresult2string (int code)
@@ -25,7 +25,8 @@ typedef enum : int
     ZKR_SM_MAIN_OOC_MEM_ALIGN = 19, // Incremented mem align counters exceeded the maximum
     ZKR_SM_MAIN_OOC_KECCAK_F = 20, // Incremented keccak-f counters exceeded the maximum
     ZKR_SM_MAIN_OOC_PADDING_PG = 21, // Incremented padding pg counters exceeded the maximum
-    ZKR_SM_MAIN_OOC_POSEIDON_G = 22 // Incremented poseidon g counters exceeded the maximum
+    ZKR_SM_MAIN_OOC_POSEIDON_G = 22, // Incremented poseidon g counters exceeded the maximum
+    ZKR_INPUT_INVALID_FORMAT = 23 // Input data is not a valid JSON or binary batch input
 } zkresult;
 
 const char* zkresult2string (int code);
@@ -41,12 +41,24 @@ public:
     Executor * pExecutor;
     MainExecRequired * pRequired;
     CommitPols * pCommitPols;
+    TraceEvents * pTraceEvents; // Timeline of the request, if it is being traced
 };
 
+// Adds the spans of a state machine thread to the timeline of the request, if it is being traced
+static void traceThread (ExecutorContext * pExecutorContext, const char * pThreadName)
+{
+    TraceEvents::setCurrent(pExecutorContext->pTraceEvents);
+    if (pExecutorContext->pTraceEvents != NULL)
+    {
+        pExecutorContext->pTraceEvents->nameThread(pThreadName);
+    }
+}
+
 void* BinaryThread (void* arg)
 {
     // Get the context
     ExecutorContext * pExecutorContext = (ExecutorContext *)arg;
+    traceThread(pExecutorContext, "BINARY_SM_THREAD");
     
     // Execute the Binary State Machine
     TimerStart(BINARY_SM_EXECUTE_THREAD);
@@ -60,6 +72,7 @@ void* MemAlignThread (void* arg)
 {
     // Get the context
     ExecutorContext * pExecutorContext = (ExecutorContext *)arg;
+    traceThread(pExecutorContext, "MEM_ALIGN_SM_THREAD");
     
     // Execute the MemAlign State Machine
     TimerStart(MEM_ALIGN_SM_EXECUTE_THREAD);
@@ -73,6 +86,7 @@ void* MemoryThread (void* arg)
 {
     // Get the context
     ExecutorContext * pExecutorContext = (ExecutorContext *)arg;
+    traceThread(pExecutorContext, "MEMORY_SM_THREAD");
     
     // Execute the Binary State Machine
     TimerStart(MEMORY_SM_EXECUTE_THREAD);
@@ -86,6 +100,7 @@ void* ArithThread (void* arg)
 {
     // Get the context
     ExecutorContext * pExecutorContext = (ExecutorContext *)arg;
+    traceThread(pExecutorContext, "ARITH_SM_THREAD");
     
     // Execute the Binary State Machine
     TimerStart(ARITH_SM_EXECUTE_THREAD);
@@ -99,6 +114,7 @@ void* PoseidonThread (void* arg)
 {
     // Get the context
     ExecutorContext * pExecutorContext = (ExecutorContext *)arg;
+    traceThread(pExecutorContext, "POSEIDON_SM_THREAD");
     
     // Execute the Padding PG State Machine
     TimerStart(PADDING_PG_SM_EXECUTE_THREAD);
@@ -122,6 +138,7 @@ void* KeccakThread (void* arg)
 {
     // Get the context
     ExecutorContext * pExecutorContext = (ExecutorContext *)arg;
+    traceThread(pExecutorContext, "KECCAK_SM_THREAD");
     
     // Execute the Padding KK State Machine
     TimerStart(PADDING_KK_SM_EXECUTE_THREAD);
@@ -235,6 +252,7 @@ void Executor::execute (ProverRequest &proverRequest, CommitPols & commitPols)
         executorContext.pExecutor = this;
         executorContext.pCommitPols = &commitPols;
         executorContext.pRequired = &required;
+        executorContext.pTraceEvents = TraceEvents::current();
 
         // Execute the Main State Machine
         TimerStart(MAIN_EXECUTOR_EXECUTE);
@@ -3,6 +3,7 @@
 #include <string>
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <sstream>
 #include <iomanip>
 #include <sys/time.h>
 #include "goldilocks_base_field.hpp"
@@ -21,6 +22,7 @@
 #include "service/aggregator/aggregator_client.hpp"
 #include "service/aggregator/aggregator_client_mock.hpp"
 #include "sm/keccak_f/keccak.hpp"
+#include "db_reads_journal/db_reads_journal.hpp"
 #include "sm/keccak_f/keccak_executor_test.hpp"
 #include "sm/storage/storage_executor.hpp"
 #include "sm/storage/storage_test.hpp"
@@ -28,11 +30,17 @@
 #include "sm/mem_align/mem_align_test.hpp"
 #include "timer.hpp"
 #include "statedb/statedb_server.hpp"
+#include "metrics/metrics_server.hpp"
 #include "service/statedb/statedb_test.hpp"
+#include "service/statedb/statedb_test_perf.hpp"
+#include "service/statedb/statedb_test_stream.hpp"
+#include "input/input_test.hpp"
+#include "statedb/database_journal_test.hpp"
 #include "service/statedb/statedb.hpp"
 #include "sha256.hpp"
 #include "blake.hpp"
 #include "goldilocks_precomputed.hpp"
+#include "numa_policy.hpp"
 
 using namespace std;
 using json = nlohmann::json;
@@ -66,18 +74,16 @@ using json = nlohmann::json;
 
 void runFileGenBatchProof(Goldilocks fr, Prover &prover, Config &config)
 {
-    // Load and parse input JSON file
+    // Load and parse input file, in JSON or binary format
     TimerStart(INPUT_LOAD);
     // Create and init an empty prover request
     ProverRequest proverRequest(fr, config, prt_genBatchProof);
     if (config.inputFile.size() > 0)
     {
-        json inputJson;
-        file2json(config.inputFile, inputJson);
-        zkresult zkResult = proverRequest.input.load(inputJson);
+        zkresult zkResult = proverRequest.input.loadFile(config.inputFile);
         if (zkResult != ZKR_SUCCESS)
         {
-            cerr << "Error: runFileGenBatchProof() failed calling proverRequest.input.load() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
+            cerr << "Error: runFileGenBatchProof() failed calling proverRequest.input.loadFile() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
             exit(-1);
         }
     }
@@ -107,6 +113,46 @@ void runFileGenAggregatedProof(Goldilocks fr, Prover &prover, Config &config)
     prover.genAggregatedProof(&proverRequest);
 }
 
+void runFileGenAggregatedProofTree(Goldilocks fr, Prover &prover, Config &config)
+{
+    // Load and parse the input JSON files: all the files of the inputFile folder, sorted alphabetically,
+    // or a comma-separated list of files, in both cases in batch order
+    TimerStart(INPUT_LOAD);
+    // Create and init an empty prover request
+    ProverRequest proverRequest(fr, config, prt_genAggregatedProof);
+    vector<string> files;
+    if (config.inputFile.back() == '/')
+    {
+        files = getFolderFiles(config.inputFile, true);
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            files[i] = config.inputFile + files[i];
+        }
+    }
+    else
+    {
+        stringstream ss(config.inputFile);
+        string file;
+        while (getline(ss, file, ','))
+        {
+            if (file.size() > 0)
+            {
+                files.push_back(file);
+            }
+        }
+    }
+    proverRequest.aggregatedProofInputs.resize(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        cout << "runFileGenAggregatedProofTree inputFile=" << files[i] << endl;
+        file2json(files[i], proverRequest.aggregatedProofInputs[i]);
+    }
+    TimerStopAndLog(INPUT_LOAD);
+
+    // Call the prover
+    prover.genAggregatedProofTree(&proverRequest);
+}
+
 void runFileGenFinalProof(Goldilocks fr, Prover &prover, Config &config)
 {
     // Load and parse input JSON file
@@ -125,18 +171,16 @@ void runFileGenFinalProof(Goldilocks fr, Prover &prover, Config &config)
 
 void runFileProcessBatch(Goldilocks fr, Prover &prover, Config &config)
 {
-    // Load and parse input JSON file
+    // Load and parse input file, in JSON or binary format
     TimerStart(INPUT_LOAD);
     // Create and init an empty prover request
     ProverRequest proverRequest(fr, config, prt_processBatch);
     if (config.inputFile.size() > 0)
     {
-        json inputJson;
-        file2json(config.inputFile, inputJson);
-        zkresult zkResult = proverRequest.input.load(inputJson);
+        zkresult zkResult = proverRequest.input.loadFile(config.inputFile);
         if (zkResult != ZKR_SUCCESS)
         {
-            cerr << "Error: runFileProcessBatch() failed calling proverRequest.input.load() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
+            cerr << "Error: runFileProcessBatch() failed calling proverRequest.input.loadFile() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
             exit(-1);
         }
     }
@@ -192,18 +236,16 @@ void runFileProcessBatchMultithread(Goldilocks &fr, Prover &prover, Config &conf
 
 void runFileExecute(Goldilocks fr, Prover &prover, Config &config)
 {
-    // Load and parse input JSON file
+    // Load and parse input file, in JSON or binary format
     TimerStart(INPUT_LOAD);
     // Create and init an empty prover request
     ProverRequest proverRequest(fr, config, prt_execute);
     if (config.inputFile.size() > 0)
     {
-        json inputJson;
-        file2json(config.inputFile, inputJson);
-        zkresult zkResult = proverRequest.input.load(inputJson);
+        zkresult zkResult = proverRequest.input.loadFile(config.inputFile);
         if (zkResult != ZKR_SUCCESS)
         {
-            cerr << "Error: runFileExecute() failed calling proverRequest.input.load() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
+            cerr << "Error: runFileExecute() failed calling proverRequest.input.loadFile() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
             exit(-1);
         }
     }
@@ -260,6 +302,9 @@ int main(int argc, char **argv)
     config.print();
     TimerStopAndLog(LOAD_CONFIG_JSON);
 
+    // Set the NUMA policy and thread affinity before any OpenMP parallel region
+    numaInit(config);
+
     // Check required files presence
     bool bError = false;
     if (!fileExists(config.rom))
@@ -428,6 +473,12 @@ int main(int argc, char **argv)
         KeccakGenerateScript(config);
     }
 
+    // Convert a database reads journal into an input file
+    if (config.runDbReadsJournalConverter)
+    {
+        DbReadsJournalConvert(fr, config);
+    }
+
     /* TESTS */
 
     // Test Keccak SM
@@ -468,11 +519,25 @@ int main(int argc, char **argv)
         Blake2b256_Test(fr, config);
     }
 
+    // Run the self-contained tests, failing if any of them fails
+    if (config.runUnitTests)
+    {
+        uint64_t errors = 0;
+        errors += StateDBStreamTest(fr);
+        errors += InputBinaryTest(fr);
+        errors += DatabaseJournalTest(fr, config);
+        if (errors != 0)
+        {
+            cerr << "Error: main() unit tests failed with " << errors << " errors" << endl;
+            exitProcess();
+        }
+    }
+
     // If there is nothing else to run, exit normally
     if (!config.runExecutorServer && !config.runExecutorClient && !config.runExecutorClientMultithread &&
-        !config.runStateDBServer && !config.runStateDBTest &&
+        !config.runStateDBServer && !config.runStateDBTest && !config.runStateDBPerfTest &&
         !config.runAggregatorServer && !config.runAggregatorClient && !config.runAggregatorClientMock &&
-        !config.runFileGenBatchProof && !config.runFileGenAggregatedProof && !config.runFileGenFinalProof &&
+        !config.runFileGenBatchProof && !config.runFileGenAggregatedProof && !config.runFileGenAggregatedProofTree && !config.runFileGenFinalProof &&
         !config.runFileProcessBatch && !config.runFileProcessBatchMultithread && !config.runFileExecute)
     {
         exit(0);
@@ -534,6 +599,16 @@ int main(int argc, char **argv)
         pAggregatorServer->runThread();
     }
 
+    // Create the metrics server and run it, if configured; it is not waited for, since it serves the others
+    MetricsServer *pMetricsServer = NULL;
+    if (config.runMetricsServer)
+    {
+        pMetricsServer = new MetricsServer(config);
+        zkassert(pMetricsServer != NULL);
+        cout << "Launching metrics server thread..." << endl;
+        pMetricsServer->runThread();
+    }
+
     /* FILE-BASED INPUT */
 
     // Generate a batch proof from the input file
@@ -584,6 +659,12 @@ int main(int argc, char **argv)
         }
     }
 
+    // Generate an aggregated proof of all the batch proofs of the input folder or list of files
+    if (config.runFileGenAggregatedProofTree)
+    {
+        runFileGenAggregatedProofTree(fr, prover, config);
+    }
+
     // Generate a final proof from the input file
     if (config.runFileGenFinalProof)
     {
@@ -674,6 +755,13 @@ int main(int argc, char **argv)
         runStateDBTest(config);
     }
 
+    // Run the StateDB performance test, if configured
+    if (config.runStateDBPerfTest)
+    {
+        cout << "Launching StateDB performance test thread..." << endl;
+        runStateDBPerfTest(config);
+    }
+
     // Create the aggregator client and run it, if configured
     AggregatorClient *pAggregatorClient = NULL;
     if (config.runAggregatorClient)
@@ -715,6 +803,14 @@ int main(int argc, char **argv)
         exit(0);
     }
 
+    // Wait for the StateDB performance test thread to end
+    if (config.runStateDBPerfTest)
+    {
+        waitStateDBPerfTest();
+        sleep(1);
+        exit(0);
+    }
+
     // Wait for the executor server thread to end
     if (config.runExecutorServer)
     {
@@ -1,3 +1,4 @@
+#include <iostream>
 #include "poseidon_opt.hpp"
 
 void Poseidon_opt::hash(vector<FrElement> &state, FrElement *result)
@@ -98,3 +99,29 @@ void Poseidon_opt::mix(vector<FrElement> *new_state, vector<FrElement> state, co
 		}
 	}
 }
+
+void Poseidon_opt::hashBatch(FrElement *states, uint64_t t, uint64_t n)
+{
+	switch (t)
+	{
+	case 2: hashBatch<2>(states, n); break;
+	case 3: hashBatch<3>(states, n); break;
+	case 4: hashBatch<4>(states, n); break;
+	case 5: hashBatch<5>(states, n); break;
+	case 6: hashBatch<6>(states, n); break;
+	case 7: hashBatch<7>(states, n); break;
+	case 8: hashBatch<8>(states, n); break;
+	case 9: hashBatch<9>(states, n); break;
+	case 10: hashBatch<10>(states, n); break;
+	case 11: hashBatch<11>(states, n); break;
+	case 12: hashBatch<12>(states, n); break;
+	case 13: hashBatch<13>(states, n); break;
+	case 14: hashBatch<14>(states, n); break;
+	case 15: hashBatch<15>(states, n); break;
+	case 16: hashBatch<16>(states, n); break;
+	case 17: hashBatch<17>(states, n); break;
+	default:
+		cerr << "Error: Poseidon_opt::hashBatch() got invalid width " << t << endl;
+		exit(-1);
+	}
+}
@@ -6,14 +6,18 @@
 #include "ffiasm/fr.hpp"
 #include "constants_opt.hpp"
 #include <cassert>
+#include <cstring>
 using namespace std;
 
+// Number of independent permutations interleaved by Poseidon_opt::hashBatch()
+#define POSEIDON_OPT_BATCH 4
+
 class Poseidon_opt
 {
   typedef RawFr::Element FrElement;
 
   const static int N_ROUNDS_F = 8;
-  const unsigned int N_ROUNDS_P[16] = {56, 57, 56, 60, 60, 63, 64, 63, 60, 66, 60, 65, 70, 60, 64, 68};
+  constexpr static unsigned int N_ROUNDS_P[16] = {56, 57, 56, 60, 60, 63, 64, 63, 60, 66, 60, 65, 70, 60, 64, 68};
 
 private:
   RawFr field;
@@ -23,10 +27,135 @@ private:
   void exp5(FrElement &r);
   void stateExp5(vector<FrElement> *state, const int ssize);
 
+  template <int t, int nb>
+  static inline void permute(FrElement *states);
+  template <int t, int nb>
+  static inline void mixFull(FrElement *states, const FrElement *const *m);
+  static inline void exp5Raw(FrElement &r)
+  {
+    FrElement aux = r;
+    RawFr::field.square(r, r);
+    RawFr::field.square(r, r);
+    RawFr::field.mul(r, r, aux);
+  }
+
 public:
   void hash(vector<FrElement> &state);
   void hash(vector<FrElement> &state, FrElement *result);
   void gmimc(vector<FrElement>, FrElement *result);
+
+  // Allocation-free permutation of n independent states of width t (2..17), stored contiguously (n x t);
+  // the result of every hash is left in the first element of its state
+  template <int t>
+  static void hashBatch(FrElement *states, uint64_t n);
+  static void hashBatch(FrElement *states, uint64_t t, uint64_t n);
+  static void hash(FrElement *state, uint64_t t) { hashBatch(state, t, 1); };
 };
 
+// Permutes nb states of width t at the same time; the field operations of different states are independent,
+// so interleaving them keeps the multiplier busy while every single state waits for its previous result
+template <int t, int nb>
+inline void Poseidon_opt::permute(FrElement *states)
+{
+  static_assert(t >= 2 && t <= 17, "Poseidon_opt width must be in [2, 17]");
+  constexpr int nRoundsP = N_ROUNDS_P[t - 2];
+
+  const FrElement *c = Constants_opt::C[t - 2].data();
+  const FrElement *s = Constants_opt::S[t - 2].data();
+  const FrElement *m[t];
+  const FrElement *p[t];
+  for (int j = 0; j < t; j++)
+  {
+    m[j] = Constants_opt::M[t - 2][j].data();
+    p[j] = Constants_opt::P[t - 2][j].data();
+  }
+
+  for (int b = 0; b < nb; b++)
+    for (int i = 0; i < t; i++)
+      RawFr::field.add(states[b * t + i], states[b * t + i], c[i]);
+
+  for (int r = 0; r < N_ROUNDS_F / 2; r++)
+  {
+    for (int b = 0; b < nb; b++)
+      for (int i = 0; i < t; i++)
+      {
+        exp5Raw(states[b * t + i]);
+        RawFr::field.add(states[b * t + i], states[b * t + i], c[(r + 1) * t + i]);
+      }
+    mixFull<t, nb>(states, (r < N_ROUNDS_F / 2 - 1) ? m : p);
+  }
+
+  // Partial rounds, with the sparse matrices precomputed in Constants_opt::S
+  for (int r = 0; r < nRoundsP; r++)
+  {
+    const FrElement *sr = &s[(t * 2 - 1) * r];
+    const FrElement &cr = c[(N_ROUNDS_F / 2 + 1) * t + r];
+    for (int b = 0; b < nb; b++)
+    {
+      FrElement *state = &states[b * t];
+      exp5Raw(state[0]);
+      RawFr::field.add(state[0], state[0], cr);
+
+      FrElement s0;
+      FrElement acc;
+      RawFr::field.mul(s0, sr[0], state[0]);
+      for (int j = 1; j < t; j++)
+      {
+        RawFr::field.mul(acc, sr[j], state[j]);
+        RawFr::field.add(s0, s0, acc);
+        RawFr::field.mul(acc, state[0], sr[t + j - 1]);
+        RawFr::field.add(state[j], state[j], acc);
+      }
+      state[0] = s0;
+    }
+  }
+
+  for (int r = 0; r < N_ROUNDS_F / 2 - 1; r++)
+  {
+    for (int b = 0; b < nb; b++)
+      for (int i = 0; i < t; i++)
+      {
+        exp5Raw(states[b * t + i]);
+        RawFr::field.add(states[b * t + i], states[b * t + i], c[(N_ROUNDS_F / 2 + 1) * t + nRoundsP + r * t + i]);
+      }
+    mixFull<t, nb>(states, m);
+  }
+  for (int b = 0; b < nb; b++)
+    for (int i = 0; i < t; i++)
+      exp5Raw(states[b * t + i]);
+  mixFull<t, nb>(states, m);
+}
+
+template <int t, int nb>
+inline void Poseidon_opt::mixFull(FrElement *states, const FrElement *const *m)
+{
+  FrElement newStates[nb * t];
+  FrElement acc;
+  for (int b = 0; b < nb; b++)
+    for (int i = 0; i < t; i++)
+      RawFr::field.mul(newStates[b * t + i], m[0][i], states[b * t]);
+  for (int j = 1; j < t; j++)
+    for (int i = 0; i < t; i++)
+      for (int b = 0; b < nb; b++)
+      {
+        RawFr::field.mul(acc, m[j][i], states[b * t + j]);
+        RawFr::field.add(newStates[b * t + i], newStates[b * t + i], acc);
+      }
+  std::memcpy(states, newStates, sizeof(newStates));
+}
+
+template <int t>
+void Poseidon_opt::hashBatch(FrElement *states, uint64_t n)
+{
+  uint64_t i = 0;
+  for (; i + POSEIDON_OPT_BATCH <= n; i += POSEIDON_OPT_BATCH)
+  {
+    permute<t, POSEIDON_OPT_BATCH>(&states[i * t]);
+  }
+  for (; i < n; i++)
+  {
+    permute<t, 1>(&states[i * t]);
+  }
+}
+
 #endif // POSEIDON_OPT
\ No newline at end of file
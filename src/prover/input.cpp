@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string.h>
 #include "config.hpp"
 #include "input.hpp"
 #include "scalar.hpp"
@@ -410,3 +411,403 @@ void Input::saveDatabase (json &input, DatabaseMap &dbReadLog) const
     db2json(input, dbReadLog.getMTDB(), "db");
     contractsBytecode2json(input, dbReadLog.getProgramDB(), "contractsBytecode");
 }
+
+/* Binary batch input format */
+
+static void appendU64 (string &output, uint64_t value)
+{
+    output.append((const char *)&value, 8);
+}
+
+static void appendBlob (string &output, const uint8_t *pData, uint64_t dataSize)
+{
+    appendU64(output, dataSize);
+    output.append((const char *)pData, dataSize);
+}
+
+static void appendScalar (string &output, const mpz_class &s)
+{
+    uint8_t bytes[32] = {0};
+    if (mpz_sizeinbase(s.get_mpz_t(), 256) > 32)
+    {
+        cerr << "Error: Input::saveBinary() found a scalar longer than 32 bytes: " << s.get_str(16) << endl;
+        exitProcess();
+    }
+    uint8_t aux[32];
+    size_t count = 0;
+    mpz_export(aux, &count, 1, 1, 0, 0, s.get_mpz_t());
+    memcpy(bytes + 32 - count, aux, count);
+    output.append((const char *)bytes, 32);
+}
+
+static void appendKey (string &output, const string &key)
+{
+    uint8_t bytes[32];
+    uint64_t bytesSize = 32;
+    string2ba(NormalizeToNFormat(key, 64), bytes, bytesSize);
+    output.append((const char *)bytes, 32);
+}
+
+// Sequential reader of the binary batch input data; any read past the end of the data fails
+class InputBinaryReader
+{
+    const uint8_t *pData;
+    uint64_t dataSize;
+    uint64_t offset;
+public:
+    InputBinaryReader (const uint8_t *pData, uint64_t dataSize) : pData(pData), dataSize(dataSize), offset(0) {};
+
+    bool bytes (const uint8_t * &p, uint64_t size)
+    {
+        if (size > dataSize - offset) return false;
+        p = pData + offset;
+        offset += size;
+        return true;
+    }
+
+    bool u64 (uint64_t &value)
+    {
+        const uint8_t *p;
+        if (!bytes(p, 8)) return false;
+        memcpy(&value, p, 8);
+        return true;
+    }
+
+    bool scalar (mpz_class &s)
+    {
+        const uint8_t *p;
+        if (!bytes(p, 32)) return false;
+        mpz_import(s.get_mpz_t(), 32, 1, 1, 0, 0, p);
+        return true;
+    }
+
+    // Converts a 32-byte key into its 64-char lower case hex string
+    bool key (string &key)
+    {
+        static const char hexChars[] = "0123456789abcdef";
+        const uint8_t *p;
+        if (!bytes(p, 32)) return false;
+        key.resize(64);
+        for (uint64_t i=0; i<32; i++)
+        {
+            key[2*i] = hexChars[p[i] >> 4];
+            key[2*i + 1] = hexChars[p[i] & 0x0F];
+        }
+        return true;
+    }
+
+    bool blob (string &s)
+    {
+        uint64_t size;
+        const uint8_t *p;
+        if (!u64(size) || !bytes(p, size)) return false;
+        s.assign((const char *)p, size);
+        return true;
+    }
+
+    bool blob (vector<uint8_t> &v)
+    {
+        uint64_t size;
+        const uint8_t *p;
+        if (!u64(size) || !bytes(p, size)) return false;
+        v.assign(p, p + size);
+        return true;
+    }
+
+    bool done (void) { return offset == dataSize; };
+};
+
+void Input::saveBinary (string &output, const DatabaseMap::MTMap &db, const DatabaseMap::ProgramMap &contractsBytecode) const
+{
+    output.clear();
+
+    // Header
+    output.append(INPUT_BINARY_MAGIC, 4);
+    uint32_t version = INPUT_BINARY_VERSION;
+    output.append((const char *)&version, 4);
+    appendU64(output, (bUpdateMerkleTree ? 1 : 0) | (bNoCounters ? 2 : 0));
+
+    // Scalars
+    const PublicInputs &publicInputs = publicInputsExtended.publicInputs;
+    appendScalar(output, publicInputs.oldStateRoot);
+    appendScalar(output, publicInputs.oldAccInputHash);
+    appendScalar(output, publicInputs.globalExitRoot);
+    appendScalar(output, publicInputs.sequencerAddr);
+    appendScalar(output, publicInputs.aggregatorAddress);
+    appendScalar(output, publicInputsExtended.newStateRoot);
+    appendScalar(output, publicInputsExtended.newAccInputHash);
+    appendScalar(output, publicInputsExtended.newLocalExitRoot);
+
+    // Numbers
+    appendU64(output, publicInputs.oldBatchNum);
+    appendU64(output, publicInputs.chainID);
+    appendU64(output, publicInputs.timestamp);
+    appendU64(output, publicInputsExtended.newBatchNum);
+
+    // Blobs
+    appendBlob(output, (const uint8_t *)from.c_str(), from.size());
+    appendBlob(output, (const uint8_t *)txHashToGenerateExecuteTrace.c_str(), txHashToGenerateExecuteTrace.size());
+    appendBlob(output, (const uint8_t *)txHashToGenerateCallTrace.c_str(), txHashToGenerateCallTrace.size());
+    appendBlob(output, (const uint8_t *)publicInputs.batchL2Data.c_str(), publicInputs.batchL2Data.size());
+
+    // Database, first the fixed-size records, then the longer ones
+    uint64_t nLongRecords = 0;
+    for (DatabaseMap::MTMap::const_iterator it = db.begin(); it != db.end(); it++)
+    {
+        if (it->second.size() > INPUT_BINARY_DB_VALUES) nLongRecords++;
+    }
+    output.reserve(output.size() + (db.size() - nLongRecords)*(32 + 8 + 8*INPUT_BINARY_DB_VALUES));
+    appendU64(output, db.size() - nLongRecords);
+    for (DatabaseMap::MTMap::const_iterator it = db.begin(); it != db.end(); it++)
+    {
+        if (it->second.size() > INPUT_BINARY_DB_VALUES) continue;
+        appendKey(output, it->first);
+        appendU64(output, it->second.size());
+        for (uint64_t i=0; i<INPUT_BINARY_DB_VALUES; i++)
+        {
+            appendU64(output, (i < it->second.size()) ? fr.toU64(it->second[i]) : 0);
+        }
+    }
+    appendU64(output, nLongRecords);
+    for (DatabaseMap::MTMap::const_iterator it = db.begin(); it != db.end(); it++)
+    {
+        if (it->second.size() <= INPUT_BINARY_DB_VALUES) continue;
+        appendKey(output, it->first);
+        appendU64(output, it->second.size());
+        for (uint64_t i=0; i<it->second.size(); i++)
+        {
+            appendU64(output, fr.toU64(it->second[i]));
+        }
+    }
+
+    // Contracts bytecode
+    appendU64(output, contractsBytecode.size());
+    for (DatabaseMap::ProgramMap::const_iterator it = contractsBytecode.begin(); it != contractsBytecode.end(); it++)
+    {
+        appendKey(output, it->first);
+        appendBlob(output, it->second.data(), it->second.size());
+    }
+}
+
+void Input::saveBinary (string &output) const
+{
+    saveBinary(output, db, contractsBytecode);
+}
+
+void Input::saveBinary (string &output, DatabaseMap &dbReadLog) const
+{
+    saveBinary(output, dbReadLog.getMTDB(), dbReadLog.getProgramDB());
+}
+
+zkresult Input::loadBinary (const uint8_t *pData, uint64_t dataSize)
+{
+    InputBinaryReader r(pData, dataSize);
+
+    // Header
+    const uint8_t *pMagic;
+    const uint8_t *pVersion;
+    if (!r.bytes(pMagic, 4) || (memcmp(pMagic, INPUT_BINARY_MAGIC, 4) != 0) || !r.bytes(pVersion, 4))
+    {
+        cerr << "Error: Input::loadBinary() found an invalid header" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    uint32_t version;
+    memcpy(&version, pVersion, 4);
+    if (version != INPUT_BINARY_VERSION)
+    {
+        cerr << "Error: Input::loadBinary() found an unsupported version=" << version << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    uint64_t flags;
+    if (!r.u64(flags))
+    {
+        cerr << "Error: Input::loadBinary() found truncated data" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    bUpdateMerkleTree = (flags & 1) != 0;
+    bNoCounters = (flags & 2) != 0;
+
+    // Scalars, numbers and blobs
+    PublicInputs &publicInputs = publicInputsExtended.publicInputs;
+    uint64_t oldBatchNum, newBatchNum;
+    if (!r.scalar(publicInputs.oldStateRoot) ||
+        !r.scalar(publicInputs.oldAccInputHash) ||
+        !r.scalar(publicInputs.globalExitRoot) ||
+        !r.scalar(publicInputs.sequencerAddr) ||
+        !r.scalar(publicInputs.aggregatorAddress) ||
+        !r.scalar(publicInputsExtended.newStateRoot) ||
+        !r.scalar(publicInputsExtended.newAccInputHash) ||
+        !r.scalar(publicInputsExtended.newLocalExitRoot) ||
+        !r.u64(oldBatchNum) ||
+        !r.u64(publicInputs.chainID) ||
+        !r.u64(publicInputs.timestamp) ||
+        !r.u64(newBatchNum) ||
+        !r.blob(from) ||
+        !r.blob(txHashToGenerateExecuteTrace) ||
+        !r.blob(txHashToGenerateCallTrace) ||
+        !r.blob(publicInputs.batchL2Data))
+    {
+        cerr << "Error: Input::loadBinary() found truncated data" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    publicInputs.oldBatchNum = oldBatchNum;
+    publicInputsExtended.newBatchNum = newBatchNum;
+
+    // Check the batchL2Data length
+    if (publicInputs.batchL2Data.size() > (MAX_BATCH_L2_DATA_SIZE))
+    {
+        cerr << "Error: Input::loadBinary() found batchL2Data.size()=" << publicInputs.batchL2Data.size() << " > MAX_BATCH_L2_DATA_SIZE=" << MAX_BATCH_L2_DATA_SIZE << endl;
+        return ZKR_SM_MAIN_BATCH_L2_DATA_TOO_BIG;
+    }
+
+    // Database fixed-size records
+    uint64_t nRecords;
+    if (!r.u64(nRecords))
+    {
+        cerr << "Error: Input::loadBinary() found truncated data" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    string key;
+    for (uint64_t i=0; i<nRecords; i++)
+    {
+        uint64_t nValues;
+        const uint8_t *pValues;
+        if (!r.key(key) || !r.u64(nValues) || !r.bytes(pValues, 8*INPUT_BINARY_DB_VALUES))
+        {
+            cerr << "Error: Input::loadBinary() found truncated data" << endl;
+            return ZKR_INPUT_INVALID_FORMAT;
+        }
+        if (nValues > INPUT_BINARY_DB_VALUES)
+        {
+            cerr << "Error: Input::loadBinary() found a db record with nValues=" << nValues << endl;
+            return ZKR_INPUT_INVALID_FORMAT;
+        }
+        vector<Goldilocks::Element> &dbValue = db[key];
+        dbValue.resize(nValues);
+        for (uint64_t v=0; v<nValues; v++)
+        {
+            uint64_t value;
+            memcpy(&value, pValues + 8*v, 8);
+            dbValue[v] = fr.fromU64(value);
+        }
+    }
+
+    // Database longer records
+    if (!r.u64(nRecords))
+    {
+        cerr << "Error: Input::loadBinary() found truncated data" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    for (uint64_t i=0; i<nRecords; i++)
+    {
+        uint64_t nValues;
+        const uint8_t *pValues;
+        if (!r.key(key) || !r.u64(nValues) || (nValues > dataSize/8) || !r.bytes(pValues, 8*nValues))
+        {
+            cerr << "Error: Input::loadBinary() found truncated data" << endl;
+            return ZKR_INPUT_INVALID_FORMAT;
+        }
+        vector<Goldilocks::Element> &dbValue = db[key];
+        dbValue.resize(nValues);
+        for (uint64_t v=0; v<nValues; v++)
+        {
+            uint64_t value;
+            memcpy(&value, pValues + 8*v, 8);
+            dbValue[v] = fr.fromU64(value);
+        }
+    }
+
+    // Contracts bytecode
+    if (!r.u64(nRecords))
+    {
+        cerr << "Error: Input::loadBinary() found truncated data" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    for (uint64_t i=0; i<nRecords; i++)
+    {
+        if (!r.key(key) || !r.blob(contractsBytecode[key]))
+        {
+            cerr << "Error: Input::loadBinary() found truncated data" << endl;
+            return ZKR_INPUT_INVALID_FORMAT;
+        }
+    }
+
+    if (!r.done())
+    {
+        cerr << "Error: Input::loadBinary() found unexpected data after the end of the input" << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+
+    return ZKR_SUCCESS;
+}
+
+zkresult Input::loadFile (const string &fileName)
+{
+    uint64_t size = fileSize(fileName);
+    if (size == 0)
+    {
+        cerr << "Error: Input::loadFile() found an empty file " << fileName << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+
+    // Map the file, and decode it directly from the mapped memory
+    const uint8_t *pData = (const uint8_t *)mapFile(fileName, size, false);
+    zkresult zkr;
+    if ((size >= 4) && (memcmp(pData, INPUT_BINARY_MAGIC, 4) == 0))
+    {
+        zkr = loadBinary(pData, size);
+    }
+    else
+    {
+        json input;
+        try
+        {
+            input = json::parse(pData, pData + size);
+            zkr = ZKR_SUCCESS;
+        }
+        catch (exception &e)
+        {
+            cerr << "Error: Input::loadFile() failed parsing input JSON file " << fileName << " exception=" << e.what() << endl;
+            zkr = ZKR_INPUT_INVALID_FORMAT;
+        }
+        if (zkr == ZKR_SUCCESS)
+        {
+            zkr = load(input);
+        }
+    }
+    unmapFile((void *)pData, size);
+
+    return zkr;
+}
+
+void Input::saveFile (const string &fileName, bool bBinary) const
+{
+    if (bBinary)
+    {
+        string output;
+        saveBinary(output);
+        string2file(output, fileName);
+    }
+    else
+    {
+        json input;
+        save(input);
+        json2file(input, fileName);
+    }
+}
+
+void Input::saveFile (const string &fileName, bool bBinary, DatabaseMap &dbReadLog) const
+{
+    if (bBinary)
+    {
+        string output;
+        saveBinary(output, dbReadLog);
+        string2file(output, fileName);
+    }
+    else
+    {
+        json input;
+        save(input, dbReadLog);
+        json2file(input, fileName);
+    }
+}
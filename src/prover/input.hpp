@@ -17,11 +17,30 @@ using json = nlohmann::json;
 // This max length is checked in preprocessTxs()
 #define MAX_BATCH_L2_DATA_SIZE (120000)
 
+/* Binary batch input format
+   A compact alternative to the JSON input, that can be mapped from a file and decoded without any
+   hex string parsing. All integers are little endian; scalars are 32-byte big endian byte arrays.
+     Header: magic "ZKBI" (4 B), version (u32), flags (u64: bit 0 = updateMerkleTree, bit 1 = noCounters)
+     Scalars: oldStateRoot, oldAccInputHash, globalExitRoot, sequencerAddr, aggregatorAddress,
+              newStateRoot, newAccInputHash, newLocalExitRoot (32 B each)
+     Numbers: oldNumBatch, chainID, timestamp, newNumBatch (u64 each)
+     Blobs: from, txHashToGenerateExecuteTrace, txHashToGenerateCallTrace, batchL2Data (u64 size + data)
+     db: number of records (u64), followed by fixed-size records of key (32 B), number of values
+         (u64) and 12 values (u64), unused values set to zero
+     db values longer than 12: number of records (u64), followed by records of key (32 B), number of
+         values (u64) and the values (u64 each)
+     contractsBytecode: number of records (u64), followed by records of key (32 B) and bytecode (u64 size + data)
+*/
+#define INPUT_BINARY_MAGIC "ZKBI"
+#define INPUT_BINARY_VERSION 1
+#define INPUT_BINARY_DB_VALUES 12
+
 class Input
 {
     Goldilocks &fr;
     void db2json (json &input, const DatabaseMap::MTMap &db, string name) const;
     void contractsBytecode2json (json &input, const DatabaseMap::ProgramMap &contractsBytecode, string name) const;
+    void saveBinary (string &output, const DatabaseMap::MTMap &db, const DatabaseMap::ProgramMap &contractsBytecode) const;
 
 public:
     PublicInputsExtended publicInputsExtended;
@@ -46,6 +65,18 @@ public:
     void save (json &input) const;
     void save (json &input, DatabaseMap &dbReadLog) const;
 
+    // Loads/saves the input object data from/into the binary batch input format
+    zkresult loadBinary (const uint8_t *pData, uint64_t dataSize);
+    void saveBinary (string &output) const;
+    void saveBinary (string &output, DatabaseMap &dbReadLog) const;
+
+    // Loads the input object data from a file, in JSON or in binary format, detected by its content
+    zkresult loadFile (const string &fileName);
+
+    // Saves the input object data into a file, in JSON or in binary format
+    void saveFile (const string &fileName, bool bBinary) const;
+    void saveFile (const string &fileName, bool bBinary, DatabaseMap &dbReadLog) const;
+
 private:
     void loadGlobals      (json &input);
     void saveGlobals      (json &input) const;
@@ -1,6 +1,7 @@
 #include <fstream>
 #include <iomanip>
 #include <unistd.h>
+#include <malloc.h>
 #include "prover.hpp"
 #include "utils.hpp"
 #include "scalar.hpp"
@@ -14,14 +15,17 @@
 #include "zkey_utils.hpp"
 #include "wtns_utils.hpp"
 #include "groth16.hpp"
+#include "stark_registry.hpp"
 #include "sm/storage/storage_executor.hpp"
 #include "timer.hpp"
+#include "numa_policy.hpp"
 #include "execFile.hpp"
 #include <math.h> /* log2 */
 #include "proof2zkinStark.hpp"
 
 #include "friProofC12.hpp"
 #include <algorithm> // std::min
+#include <thread>
 #include <openssl/sha.h>
 
 #include "commit_pols_starks.hpp"
@@ -30,6 +34,27 @@
 #include "recursive1Steps.hpp"
 #include "recursive2Steps.hpp"
 
+/* Places the pages of the committed polynomials area with the firstTouch policy: every section of the zkevm
+   stark info (a matrix of mapDeg rows of mapSectionsN elements) and the buffer after them (N rows of
+   3*nCm1 elements) is touched with the row partition the STARK kernels use on it. The placement is done once,
+   before the first request; every proof then zeroes the cm1_n section with the same partition, so that the
+   pages do not move */
+static void firstTouchSections(void *pAddress, const StarkInfo &starkInfo)
+{
+    TimerStart(PROVER_NUMA_FIRST_TOUCH);
+    Goldilocks::Element *pols = (Goldilocks::Element *)pAddress;
+    for (uint64_t s = 0; s < eSectionMax; s++)
+    {
+        if (starkInfo.mapSectionsN.section[s] == 0)
+        {
+            continue;
+        }
+        numaFirstTouch(&pols[starkInfo.mapOffsets.section[s]], starkInfo.mapDeg.section[s], starkInfo.mapSectionsN.section[s] * sizeof(Goldilocks::Element));
+    }
+    numaFirstTouch(&pols[starkInfo.mapTotalN], 1 << starkInfo.starkStruct.nBits, starkInfo.mapSectionsN.section[eSection::cm1_n] * FIELD_EXTENSION * sizeof(Goldilocks::Element));
+    TimerStopAndLog(PROVER_NUMA_FIRST_TOUCH);
+}
+
 Prover::Prover(Goldilocks &fr,
                PoseidonGoldilocks &poseidon,
                const Config &config) : fr(fr),
@@ -37,7 +62,8 @@ Prover::Prover(Goldilocks &fr,
                                        executor(fr, config, poseidon),
                                        starkRecursiveF(config),
 
-                                       pCurrentRequest(NULL),
+                                       scheduler(config),
+                                       completedRequestsSize(0),
                                        config(config),
                                        lastComputedRequestEndTime(0)
 {
@@ -48,41 +74,67 @@ Prover::Prover(Goldilocks &fr,
     {
         if (config.generateProof())
         {
-            zkey = BinFileUtils::openExisting(config.finalStarkZkey, "zkey", 1);
-            zkeyHeader = ZKeyUtils::loadHeader(zkey.get());
-
-            if (mpz_cmp(zkeyHeader->rPrime, altBbn128r) != 0)
+            // Map the prepared zkey, if any and up to date, instead of loading the zkey
+            if (config.groth16PreparedZkey != "")
             {
-                throw std::invalid_argument("zkey curve not supported");
+                TimerStart(PROVER_OPEN_PREPARED_ZKEY);
+                preparedZkey = Groth16::PreparedZkey<AltBn128::Engine>::open(config.groth16PreparedZkey, config.finalStarkZkey, config.groth16FixedBaseWindowBits, config.groth16PreparedZkeyVerify);
+                if (preparedZkey)
+                {
+                    groth16Prover = preparedZkey->makeProver();
+                }
+                TimerStopAndLog(PROVER_OPEN_PREPARED_ZKEY);
             }
 
-            groth16Prover = Groth16::makeProver<AltBn128::Engine>(
-                zkeyHeader->nVars,
-                zkeyHeader->nPublic,
-                zkeyHeader->domainSize,
-                zkeyHeader->nCoefs,
-                zkeyHeader->vk_alpha1,
-                zkeyHeader->vk_beta1,
-                zkeyHeader->vk_beta2,
-                zkeyHeader->vk_delta1,
-                zkeyHeader->vk_delta2,
-                zkey->getSectionData(4), // Coefs
-                zkey->getSectionData(5), // pointsA
-                zkey->getSectionData(6), // pointsB1
-                zkey->getSectionData(7), // pointsB2
-                zkey->getSectionData(8), // pointsC
-                zkey->getSectionData(9)  // pointsH1
-            );
+            if (!groth16Prover)
+            {
+                zkey = BinFileUtils::openExisting(config.finalStarkZkey, "zkey", 1);
+                zkeyHeader = ZKeyUtils::loadHeader(zkey.get());
 
-            lastComputedRequestEndTime = 0;
+                if (mpz_cmp(zkeyHeader->rPrime, altBbn128r) != 0)
+                {
+                    throw std::invalid_argument("zkey curve not supported");
+                }
 
-            sem_init(&pendingRequestSem, 0, 0);
-            pthread_mutex_init(&mutex, NULL);
-            pCurrentRequest = NULL;
-            pthread_create(&proverPthread, NULL, proverThread, this);
-            pthread_create(&cleanerPthread, NULL, cleanerThread, this);
+                groth16Prover = Groth16::makeProver<AltBn128::Engine>(
+                    zkeyHeader->nVars,
+                    zkeyHeader->nPublic,
+                    zkeyHeader->domainSize,
+                    zkeyHeader->nCoefs,
+                    zkeyHeader->vk_alpha1,
+                    zkeyHeader->vk_beta1,
+                    zkeyHeader->vk_beta2,
+                    zkeyHeader->vk_delta1,
+                    zkeyHeader->vk_delta2,
+                    zkey->getSectionData(4), // Coefs
+                    zkey->getSectionData(5), // pointsA
+                    zkey->getSectionData(6), // pointsB1
+                    zkey->getSectionData(7), // pointsB2
+                    zkey->getSectionData(8), // pointsC
+                    zkey->getSectionData(9)  // pointsH1
+                );
+
+                if (config.groth16FixedBaseWindowBits > 0)
+                {
+                    TimerStart(PROVER_GROTH16_FIXED_BASE_TABLES);
+                    groth16Prover->precomputeTables(config.groth16FixedBaseWindowBits);
+                    TimerStopAndLog(PROVER_GROTH16_FIXED_BASE_TABLES);
+                }
 
-            StarkInfo _starkInfo(config, config.zkevmStarkInfo);
+                // Prepare the zkey for the next start; a failure only costs the next start its speed-up
+                if (config.groth16PreparedZkey != "")
+                {
+                    TimerStart(PROVER_SAVE_PREPARED_ZKEY);
+                    Groth16::PreparedZkey<AltBn128::Engine>::save(config.groth16PreparedZkey, config.finalStarkZkey, *groth16Prover);
+                    TimerStopAndLog(PROVER_SAVE_PREPARED_ZKEY);
+                }
+            }
+
+            lastComputedRequestEndTime = 0;
+
+            // Parse the stark infos and the recursive2 verification key once; they are shared by all requests
+            const StarkInfo &_starkInfo = StarkRegistry::getStarkInfo(config, config.zkevmStarkInfo);
+            StarkRegistry::getVerKey(config.recursive2Verkey);
 
             // Allocate an area of memory, mapped to file, to store all the committed polynomials,
             // and create them using the allocated address
@@ -95,6 +147,11 @@ Prover::Prover(Goldilocks &fr,
                 pAddress = mapFile(config.zkevmCmPols, polsSize, true);
                 cout << "Prover::genBatchProof() successfully mapped " << polsSize << " bytes to file " << config.zkevmCmPols << endl;
             }
+            else if (config.lowMemoryProver)
+            {
+                pAddress = mapFile(config.lowMemoryProverPath + "/zkevm.commit", polsSize, true);
+                cout << "Prover::genBatchProof() successfully mapped " << polsSize << " bytes to low memory file " << config.lowMemoryProverPath << "/zkevm.commit" << endl;
+            }
             else
             {
                 pAddress = calloc(polsSize, 1);
@@ -105,11 +162,39 @@ Prover::Prover(Goldilocks &fr,
                 }
                 cout << "Prover::genBatchProof() successfully allocated " << polsSize << " bytes" << endl;
             }
+            numaPlace(pAddress, polsSize);
+            if ((config.numaPolicy == "firstTouch") && (config.zkevmCmPols.size() == 0) && !config.lowMemoryProver)
+            {
+                firstTouchSections(pAddress, _starkInfo);
+            }
 
             starkZkevm = new Starks(config, {config.zkevmConstPols, config.mapConstPolsFile, config.zkevmConstantsTree, config.zkevmStarkInfo}, pAddress);
             starksC12a = new Starks(config, {config.c12aConstPols, config.mapConstPolsFile, config.c12aConstantsTree, config.c12aStarkInfo}, pAddress);
             starksRecursive1 = new Starks(config, {config.recursive1ConstPols, config.mapConstPolsFile, config.recursive1ConstantsTree, config.recursive1StarkInfo}, pAddress);
             starksRecursive2 = new Starks(config, {config.recursive2ConstPols, config.mapConstPolsFile, config.recursive2ConstantsTree, config.recursive2StarkInfo}, pAddress);
+
+            // Allocate the memory pool of the final requests; its pages are not used until the first one
+            uint64_t polsSizeRecursiveF = starkRecursiveF.getTotalPolsSize();
+            pAddressRecursiveF = malloc(polsSizeRecursiveF);
+            if (pAddressRecursiveF == NULL)
+            {
+                cerr << "Error: Prover::Prover() failed calling malloc() of size " << polsSizeRecursiveF << endl;
+                exitProcess();
+            }
+
+            // Tell the scheduler the memory used by each request class while it runs
+            scheduler.setPoolSize(prc_zkevm, polsSize);
+            scheduler.setPoolSize(prc_final, polsSizeRecursiveF + groth16Prover->getProveMemorySize());
+
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&schedulerCond, NULL);
+            for (uint64_t c = 0; c < prc_size; c++)
+            {
+                workers[c].pProver = this;
+                workers[c].requestClass = (tProverRequestClass)c;
+                pthread_create(&proverPthread[c], NULL, proverThread, &workers[c]);
+            }
+            pthread_create(&cleanerPthread, NULL, cleanerThread, this);
         }
     }
     catch (std::exception &e)
@@ -128,7 +213,7 @@ Prover::~Prover()
     uint64_t polsSize = starkZkevm->starkInfo.mapTotalN * sizeof(Goldilocks::Element) + starkZkevm->starkInfo.mapSectionsN.section[eSection::cm1_n] * (1 << starkZkevm->starkInfo.starkStruct.nBits) * FIELD_EXTENSION * sizeof(Goldilocks::Element);
 
     // Unmap committed polynomials address
-    if (config.zkevmCmPols.size() > 0)
+    if ((config.zkevmCmPols.size() > 0) || config.lowMemoryProver)
     {
         unmapFile(pAddress, polsSize);
     }
@@ -136,6 +221,7 @@ Prover::~Prover()
     {
         free(pAddress);
     }
+    free(pAddressRecursiveF);
 
     delete starkZkevm;
     delete starksC12a;
@@ -145,76 +231,79 @@ Prover::~Prover()
 
 void *proverThread(void *arg)
 {
-    Prover *pProver = (Prover *)arg;
-    cout << "proverThread() started" << endl;
+    Prover::ProverWorker *pWorker = (Prover::ProverWorker *)arg;
+    Prover *pProver = pWorker->pProver;
+    string className = proverRequestClass2string(pWorker->requestClass);
+    cout << "proverThread() started class=" << className << endl;
 
     zkassert(pProver->config.generateProof());
 
+    pProver->lock();
+
     while (true)
     {
-        pProver->lock();
-
-        // Wait for the pending request queue semaphore to be released, if there are no more pending requests
-        if (pProver->pendingRequests.size() == 0)
+        // Get the next request of this class that the scheduler lets start, or wait for a change of
+        // the pending requests or the slots of the other classes
+        ProverRequest *pProverRequest = pProver->scheduler.next(pWorker->requestClass);
+        if (pProverRequest == NULL)
         {
-            pProver->unlock();
-            sem_wait(&pProver->pendingRequestSem);
-        }
-
-        // Check that the pending requests queue is not empty
-        if (pProver->pendingRequests.size() == 0)
-        {
-            pProver->unlock();
-            cout << "proverThread() found pending requests queue empty, so ignoring" << endl;
+            pthread_cond_wait(&pProver->schedulerCond, &pProver->mutex);
             continue;
         }
 
-        // Extract the first pending request (first in, first out)
-        pProver->pCurrentRequest = pProver->pendingRequests[0];
-        pProver->pCurrentRequest->startTime = time(NULL);
-        pProver->pendingRequests.erase(pProver->pendingRequests.begin());
+        // The slot taken by this request may change what the other classes can start
+        pthread_cond_broadcast(&pProver->schedulerCond);
 
-        cout << "proverThread() starting to process request with UUID: " << pProver->pCurrentRequest->uuid << endl;
+        cout << "proverThread() class=" << className << " starting to process request with UUID: " << pProverRequest->uuid << " after waiting " << double(pProverRequest->queueWait) / 1000000 << " s" << endl;
 
         pProver->unlock();
 
         // Process the request
-        switch (pProver->pCurrentRequest->type)
+        switch (pProverRequest->type)
         {
         case prt_genBatchProof:
-            pProver->genBatchProof(pProver->pCurrentRequest);
+            pProver->genBatchProof(pProverRequest);
             break;
         case prt_genAggregatedProof:
-            pProver->genAggregatedProof(pProver->pCurrentRequest);
+            pProver->genAggregatedProof(pProverRequest);
             break;
         case prt_genFinalProof:
-            pProver->genFinalProof(pProver->pCurrentRequest);
+            pProver->genFinalProof(pProverRequest);
             break;
         case prt_execute:
-            pProver->execute(pProver->pCurrentRequest);
+            pProver->execute(pProverRequest);
             break;
         default:
-            cerr << "Error: proverThread() got an invalid prover request type=" << pProver->pCurrentRequest->type << endl;
+            cerr << "Error: proverThread() got an invalid prover request type=" << pProverRequest->type << endl;
             exitProcess();
         }
 
-        // Move to completed requests
+        // Free the input data and the execution traces, since only the result is kept from now on
+        pProverRequest->releaseInputs();
+        uint64_t requestSize = pProverRequest->memorySize();
+
+        // Move to completed requests, and free the slot
         pProver->lock();
-        ProverRequest *pProverRequest = pProver->pCurrentRequest;
-        pProverRequest->endTime = time(NULL);
+        pProver->scheduler.done(pProverRequest);
         pProver->lastComputedRequestId = pProverRequest->uuid;
         pProver->lastComputedRequestEndTime = pProverRequest->endTime;
 
-        pProver->completedRequests.push_back(pProver->pCurrentRequest);
-        pProver->pCurrentRequest = NULL;
-        pProver->unlock();
+        pProver->completedRequests.push_back(pProverRequest);
+        pProver->completedRequestsSize += requestSize;
+        pthread_cond_broadcast(&pProver->schedulerCond);
 
-        cout << "proverThread() done processing request with UUID: " << pProverRequest->uuid << endl;
+        cout << "proverThread() class=" << className << " done processing request with UUID: " << pProverRequest->uuid << " in " << double(pProverRequest->runTime) / 1000000 << " s, retaining " << requestSize << " bytes" << endl;
+        pProver->scheduler.printMetrics();
 
         // Release the prove request semaphore to notify any blocked waiting call
         pProverRequest->notifyCompleted();
+
+        // Enforce the retention limits now, rather than waiting for the cleaner
+        pProver->cleanCompletedRequests();
     }
-    cout << "proverThread() done" << endl;
+
+    pProver->unlock();
+    cout << "proverThread() done class=" << className << endl;
     return NULL;
 }
 
@@ -233,26 +322,7 @@ void *cleanerThread(void *arg)
         // Lock the prover
         pProver->lock();
 
-        // Delete all requests older than requests persistence configuration setting
-        time_t now = time(NULL);
-        bool bRequestDeleted = false;
-        do
-        {
-            bRequestDeleted = false;
-            for (uint64_t i = 0; i < pProver->completedRequests.size(); i++)
-            {
-                if (now - pProver->completedRequests[i]->endTime > (int64_t)pProver->config.requestsPersistence)
-                {
-                    cout << "cleanerThread() deleting request with uuid: " << pProver->completedRequests[i]->uuid << endl;
-                    ProverRequest *pProverRequest = pProver->completedRequests[i];
-                    pProver->completedRequests.erase(pProver->completedRequests.begin() + i);
-                    pProver->requestsMap.erase(pProverRequest->uuid);
-                    delete (pProverRequest);
-                    bRequestDeleted = true;
-                    break;
-                }
-            }
-        } while (bRequestDeleted);
+        pProver->cleanCompletedRequests();
 
         // Unlock the prover
         pProver->unlock();
@@ -261,6 +331,68 @@ void *cleanerThread(void *arg)
     return NULL;
 }
 
+void Prover::cleanCompletedRequests(void)
+{
+    bool bRequestDeleted = false;
+
+    // Delete all requests older than requests persistence configuration setting
+    time_t now = time(NULL);
+    for (uint64_t i = 0; i < completedRequests.size();)
+    {
+        if (now - completedRequests[i]->endTime > (int64_t)config.requestsPersistence)
+        {
+            deleteCompletedRequest(i);
+            bRequestDeleted = true;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    // Delete delivered requests while they retain more than the requests persistence size; completed
+    // requests are sorted by end time, so the first delivered ones are the oldest delivered ones.
+    // Requests not delivered yet are kept, until they exceed the requests persistence time
+    if (config.requestsPersistenceSize > 0)
+    {
+        uint64_t maxSize = config.requestsPersistenceSize * 1024 * 1024;
+        for (uint64_t i = 0; (i < completedRequests.size()) && (completedRequestsSize > maxSize);)
+        {
+            if (completedRequests[i]->bDelivered)
+            {
+                deleteCompletedRequest(i);
+                bRequestDeleted = true;
+            }
+            else
+            {
+                i++;
+            }
+        }
+        if (completedRequestsSize > maxSize)
+        {
+            cout << "Prover::cleanCompletedRequests() keeps " << completedRequestsSize << " bytes of requests not delivered yet, more than requestsPersistenceSize=" << config.requestsPersistenceSize << "MB" << endl;
+        }
+    }
+
+    // Return the freed heap memory to the system, so that it does not stay in the process RSS
+    if (bRequestDeleted)
+    {
+        malloc_trim(0);
+        cout << "Prover::cleanCompletedRequests() keeps " << completedRequests.size() << " completed requests retaining " << completedRequestsSize << " bytes" << endl;
+    }
+}
+
+void Prover::deleteCompletedRequest(uint64_t i)
+{
+    ProverRequest *pProverRequest = completedRequests[i];
+    cout << "Prover::deleteCompletedRequest() deleting request with uuid: " << pProverRequest->uuid << " delivered=" << pProverRequest->bDelivered << endl;
+    uint64_t requestSize = pProverRequest->memorySize();
+    completedRequestsSize = (completedRequestsSize > requestSize) ? completedRequestsSize - requestSize : 0;
+    completedRequests.erase(completedRequests.begin() + i);
+    requestsMap.erase(pProverRequest->uuid);
+    delete pProverRequest;
+}
+
 string Prover::submitRequest(ProverRequest *pProverRequest) // returns UUID for this request
 {
     zkassert(config.generateProof());
@@ -271,11 +403,11 @@ string Prover::submitRequest(ProverRequest *pProverRequest) // returns UUID for
     // Get the prover request UUID
     string uuid = pProverRequest->uuid;
 
-    // Add the request to the pending requests queue, and release the semaphore to notify the prover thread
+    // Add the request to the pending requests, and wake up the prover threads
     lock();
     requestsMap[uuid] = pProverRequest;
-    pendingRequests.push_back(pProverRequest);
-    sem_post(&pendingRequestSem);
+    scheduler.submit(pProverRequest);
+    pthread_cond_broadcast(&schedulerCond);
     unlock();
 
     cout << "Prover::submitRequest() returns UUID: " << uuid << endl;
@@ -308,36 +440,48 @@ ProverRequest *Prover::waitForRequestToComplete(const string &uuid, const uint64
     pProverRequest->waitForCompleted(timeoutInSeconds);
     cout << "Prover::waitForRequestToComplete() done waiting for request with UUID: " << uuid << endl;
 
+    // Look for the request again, since completed requests can be deleted once the prover is unlocked;
+    // a request not delivered yet is only deleted after config.requestsPersistence seconds
+    lock();
+    it = requestsMap.find(uuid);
+    pProverRequest = (it == requestsMap.end()) ? NULL : it->second;
+    unlock();
+    if (pProverRequest == NULL)
+    {
+        cerr << "Error: Prover::waitForRequestToComplete() found request with uuid: " << uuid << " deleted while waiting for it" << endl;
+    }
+
     // Return the request pointer
     return pProverRequest;
 }
 
 void Prover::processBatch(ProverRequest *pProverRequest)
 {
-    TimerStart(PROVER_PROCESS_BATCH);
     zkassert(pProverRequest != NULL);
     zkassert(pProverRequest->type == prt_processBatch);
 
+    ProverRequestTrace proverRequestTrace(*pProverRequest);
+    TimerStart(PROVER_PROCESS_BATCH);
+
     cout << "Prover::processBatch() timestamp: " << pProverRequest->timestamp << endl;
     cout << "Prover::processBatch() UUID: " << pProverRequest->uuid << endl;
 
     // Save input to <timestamp>.input.json, as provided by client
     if (config.saveInputToFile)
     {
-        json inputJson;
-        pProverRequest->input.save(inputJson);
-        json2file(inputJson, pProverRequest->inputFile());
+        pProverRequest->input.saveFile(pProverRequest->inputFile(), config.saveInputInBinaryFormat);
     }
 
+    // Journal the database reads as they happen, if requested
+    pProverRequest->openDbReadLogJournal();
+
     // Execute the program, in the process batch way
     executor.process_batch(*pProverRequest);
 
     // Save input to <timestamp>.input.json after execution including dbReadLog
     if (config.saveDbReadsToFile)
     {
-        json inputJsonEx;
-        pProverRequest->input.save(inputJsonEx, *pProverRequest->dbReadLog);
-        json2file(inputJsonEx, pProverRequest->inputDbFile());
+        pProverRequest->input.saveFile(pProverRequest->inputDbFile(), config.saveInputInBinaryFormat, *pProverRequest->dbReadLog);
     }
 
     TimerStopAndLog(PROVER_PROCESS_BATCH);
@@ -348,10 +492,15 @@ void Prover::genBatchProof(ProverRequest *pProverRequest)
     zkassert(config.generateProof());
     zkassert(pProverRequest != NULL);
 
+    ProverRequestTrace proverRequestTrace(*pProverRequest);
     TimerStart(PROVER_BATCH_PROOF);
 
     printMemoryInfo(true);
     printProcessInfo(true);
+    if (config.numaPolicy != "none")
+    {
+        numaPrintStats(__func__);
+    }
 
     zkassert(pProverRequest != NULL);
 
@@ -364,24 +513,19 @@ void Prover::genBatchProof(ProverRequest *pProverRequest)
     // Save input to <timestamp>.input.json, as provided by client
     if (config.saveInputToFile)
     {
-        json inputJson;
-        pProverRequest->input.save(inputJson);
-        json2file(inputJson, pProverRequest->inputFile());
+        pProverRequest->input.saveFile(pProverRequest->inputFile(), config.saveInputInBinaryFormat);
     }
 
+    // Journal the database reads as they happen, if requested
+    pProverRequest->openDbReadLogJournal();
+
     /************/
     /* Executor */
     /************/
     TimerStart(EXECUTOR_EXECUTE_INITIALIZATION);
 
     CommitPols cmPols(pAddress, CommitPols::pilDegree());
-    uint64_t num_threads = omp_get_max_threads();
-    uint64_t bytes_per_thread = cmPols.size() / num_threads;
-#pragma omp parallel for num_threads(num_threads)
-    for (uint64_t i = 0; i < cmPols.size(); i += bytes_per_thread) // Each iteration processes 64 bytes at a time
-    {
-        memset((uint8_t *)pAddress + i, 0, bytes_per_thread);
-    }
+    numaFirstTouch(pAddress, CommitPols::pilDegree(), cmPols.size() / CommitPols::pilDegree());
 
     TimerStopAndLog(EXECUTOR_EXECUTE_INITIALIZATION);
     // Execute all the State Machines
@@ -392,9 +536,7 @@ void Prover::genBatchProof(ProverRequest *pProverRequest)
     // Save input to <timestamp>.input.json after execution including dbReadLog
     if (config.saveDbReadsToFile)
     {
-        json inputJsonEx;
-        pProverRequest->input.save(inputJsonEx, *pProverRequest->dbReadLog);
-        json2file(inputJsonEx, pProverRequest->inputDbFile());
+        pProverRequest->input.saveFile(pProverRequest->inputDbFile(), config.saveInputInBinaryFormat, *pProverRequest->dbReadLog);
     }
 
     if (pProverRequest->result == ZKR_SUCCESS)
@@ -407,8 +549,7 @@ void Prover::genBatchProof(ProverRequest *pProverRequest)
 
         uint64_t lastN = cmPols.pilDegree() - 1;
 
-        json recursive2Verkey;
-        file2json(config.recursive2Verkey, recursive2Verkey);
+        const VerKey &recursive2Verkey = StarkRegistry::getVerKey(config.recursive2Verkey);
 
         Goldilocks::Element publics[starksRecursive1->starkInfo.nPublics];
 
@@ -470,10 +611,10 @@ void Prover::genBatchProof(ProverRequest *pProverRequest)
         // newBatchNum
         publics[42] = cmPols.Main.PC[lastN];
 
-        publics[43] = Goldilocks::fromU64(recursive2Verkey["constRoot"][0]);
-        publics[44] = Goldilocks::fromU64(recursive2Verkey["constRoot"][1]);
-        publics[45] = Goldilocks::fromU64(recursive2Verkey["constRoot"][2]);
-        publics[46] = Goldilocks::fromU64(recursive2Verkey["constRoot"][3]);
+        publics[43] = recursive2Verkey.constRoot[0];
+        publics[44] = recursive2Verkey.constRoot[1];
+        publics[45] = recursive2Verkey.constRoot[2];
+        publics[46] = recursive2Verkey.constRoot[3];
 
         for (uint64_t i = 0; i < starkZkevm->starkInfo.nPublics; i++)
         {
@@ -530,10 +671,10 @@ void Prover::genBatchProof(ProverRequest *pProverRequest)
 
         // Add the recursive2 verification key
         json rootC;
-        rootC[0] = to_string(recursive2Verkey["constRoot"][0]);
-        rootC[1] = to_string(recursive2Verkey["constRoot"][1]);
-        rootC[2] = to_string(recursive2Verkey["constRoot"][2]);
-        rootC[3] = to_string(recursive2Verkey["constRoot"][3]);
+        rootC[0] = recursive2Verkey.constRootString[0];
+        rootC[1] = recursive2Verkey.constRootString[1];
+        rootC[2] = recursive2Verkey.constRootString[2];
+        rootC[3] = recursive2Verkey.constRootString[3];
         zkinC12a["publics"] = publicStarkJson;
         zkinC12a["rootC"] = rootC;
         TimerStopAndLog(STARK_JSON_GENERATION_BATCH_PROOF_C12A);
@@ -588,10 +729,15 @@ void Prover::genAggregatedProof(ProverRequest *pProverRequest)
     zkassert(pProverRequest != NULL);
     zkassert(pProverRequest->type == prt_genAggregatedProof);
 
+    ProverRequestTrace proverRequestTrace(*pProverRequest);
     TimerStart(PROVER_AGGREGATED_PROOF);
 
     printMemoryInfo(true);
     printProcessInfo(true);
+    if (config.numaPolicy != "none")
+    {
+        numaPrintStats(__func__);
+    }
 
     // Save input to file
     if (config.saveInputToFile)
@@ -602,55 +748,88 @@ void Prover::genAggregatedProof(ProverRequest *pProverRequest)
 
     // Input is pProverRequest->aggregatedProofInput1 and pProverRequest->aggregatedProofInput2 (of type json)
 
-    ordered_json verKey;
-    file2json(config.recursive2Verkey, verKey);
+    pProverRequest->result = checkAggregatedProofInputs(pProverRequest->aggregatedProofInput1, pProverRequest->aggregatedProofInput2);
+    if (pProverRequest->result != ZKR_SUCCESS)
+    {
+        return;
+    }
 
-    // ----------------------------------------------
-    // CHECKS
-    // ----------------------------------------------
-    // Check chainID
+    json zkinInputRecursive2;
+    genRecursive2Witness(pProverRequest->aggregatedProofInput1, pProverRequest->aggregatedProofInput2, zkinInputRecursive2, pAddress);
+
+    nlohmann::ordered_json jProofRecursive2;
+    genRecursive2Proof(zkinInputRecursive2, pProverRequest->aggregatedProofOutput, jProofRecursive2);
+
+    // Save output to file
+    if (config.saveOutputToFile)
+    {
+        json2file(pProverRequest->aggregatedProofOutput, pProverRequest->filePrefix + "aggregated_proof.output.json");
+    }
+    // Save proof to file
+    if (config.saveProofToFile)
+    {
+        json2file(jProofRecursive2, pProverRequest->filePrefix + "aggregated_proof.proof.json");
+    }
 
-    if (pProverRequest->aggregatedProofInput1["publics"][17] != pProverRequest->aggregatedProofInput2["publics"][17])
+    saveAggregatedProofPublics(pProverRequest);
+
+    pProverRequest->result = ZKR_SUCCESS;
+
+    TimerStopAndLog(PROVER_AGGREGATED_PROOF);
+}
+
+zkresult Prover::checkAggregatedProofInputs(nlohmann::ordered_json &input1, nlohmann::ordered_json &input2)
+{
+    // Check chainID
+    if (input1["publics"][17] != input2["publics"][17])
     {
         std::cerr << "Error: Inputs has different chainId" << std::endl;
-        std::cerr << pProverRequest->aggregatedProofInput1["publics"][17] << "!=" << pProverRequest->aggregatedProofInput2["publics"][17] << std::endl;
-        pProverRequest->result = ZKR_AGGREGATED_PROOF_INVALID_INPUT;
-        return;
+        std::cerr << input1["publics"][17] << "!=" << input2["publics"][17] << std::endl;
+        return ZKR_AGGREGATED_PROOF_INVALID_INPUT;
     }
     // Check midStateRoot
     for (int i = 0; i < 8; i++)
     {
-        if (pProverRequest->aggregatedProofInput1["publics"][18 + i] != pProverRequest->aggregatedProofInput2["publics"][0 + i])
+        if (input1["publics"][18 + i] != input2["publics"][0 + i])
         {
             std::cerr << "Error: The newStateRoot and the oldStateRoot are not consistent" << std::endl;
-            std::cerr << pProverRequest->aggregatedProofInput1["publics"][18 + i] << "!=" << pProverRequest->aggregatedProofInput2["publics"][0 + i] << std::endl;
-            pProverRequest->result = ZKR_AGGREGATED_PROOF_INVALID_INPUT;
-            return;
+            std::cerr << input1["publics"][18 + i] << "!=" << input2["publics"][0 + i] << std::endl;
+            return ZKR_AGGREGATED_PROOF_INVALID_INPUT;
         }
     }
     // Check midAccInputHash0
     for (int i = 0; i < 8; i++)
     {
-        if (pProverRequest->aggregatedProofInput1["publics"][26 + i] != pProverRequest->aggregatedProofInput2["publics"][8 + i])
+        if (input1["publics"][26 + i] != input2["publics"][8 + i])
         {
             std::cerr << "Error: newAccInputHash and oldAccInputHash are not consistent" << std::endl;
-            std::cerr << pProverRequest->aggregatedProofInput1["publics"][26 + i] << "!=" << pProverRequest->aggregatedProofInput2["publics"][8 + i] << std::endl;
-            pProverRequest->result = ZKR_AGGREGATED_PROOF_INVALID_INPUT;
-            return;
+            std::cerr << input1["publics"][26 + i] << "!=" << input2["publics"][8 + i] << std::endl;
+            return ZKR_AGGREGATED_PROOF_INVALID_INPUT;
         }
     }
     // Check batchNum
-    if (pProverRequest->aggregatedProofInput1["publics"][42] != pProverRequest->aggregatedProofInput2["publics"][16])
+    if (input1["publics"][42] != input2["publics"][16])
     {
         std::cerr << "Error: newBatchNum and oldBatchNum are not consistent" << std::endl;
-        std::cerr << pProverRequest->aggregatedProofInput1["publics"][42] << "!=" << pProverRequest->aggregatedProofInput2["publics"][16] << std::endl;
-        pProverRequest->result = ZKR_AGGREGATED_PROOF_INVALID_INPUT;
-        return;
+        std::cerr << input1["publics"][42] << "!=" << input2["publics"][16] << std::endl;
+        return ZKR_AGGREGATED_PROOF_INVALID_INPUT;
     }
+    return ZKR_SUCCESS;
+}
 
-    json zkinInputRecursive2 = joinzkin(pProverRequest->aggregatedProofInput1, pProverRequest->aggregatedProofInput2, verKey);
-    json recursive2Verkey;
-    file2json(config.recursive2Verkey, recursive2Verkey);
+void Prover::genRecursive2Witness(nlohmann::ordered_json &input1, nlohmann::ordered_json &input2, json &zkinInputRecursive2, void *pWitnessAddress)
+{
+    const VerKey &recursive2Verkey = StarkRegistry::getVerKey(config.recursive2Verkey);
+
+    zkinInputRecursive2 = joinzkin(input1, input2, recursive2Verkey.verKeyJson);
+
+    CommitPolsStarks cmPolsRecursive2(pWitnessAddress, (1 << starksRecursive2->starkInfo.starkStruct.nBits));
+    CircomRecursive2::getCommitedPols(&cmPolsRecursive2, config.recursive2Verifier, config.recursive2Exec, zkinInputRecursive2, (1 << starksRecursive2->starkInfo.starkStruct.nBits));
+}
+
+void Prover::genRecursive2Proof(json &zkinInputRecursive2, nlohmann::ordered_json &output, nlohmann::ordered_json &jProofRecursive2)
+{
+    const VerKey &recursive2Verkey = StarkRegistry::getVerKey(config.recursive2Verkey);
 
     Goldilocks::Element publics[starksRecursive2->starkInfo.nPublics];
 
@@ -659,14 +838,11 @@ void Prover::genAggregatedProof(ProverRequest *pProverRequest)
         publics[i] = Goldilocks::fromString(zkinInputRecursive2["publics"][i]);
     }
 
-    for (uint64_t i = 0; i < recursive2Verkey["constRoot"].size(); i++)
+    for (uint64_t i = 0; i < VERKEY_CONST_ROOT_SIZE; i++)
     {
-        publics[starkZkevm->starkInfo.nPublics + i] = Goldilocks::fromU64(recursive2Verkey["constRoot"][i]);
+        publics[starkZkevm->starkInfo.nPublics + i] = recursive2Verkey.constRoot[i];
     }
 
-    CommitPolsStarks cmPolsRecursive2(pAddress, (1 << starksRecursive2->starkInfo.starkStruct.nBits));
-    CircomRecursive2::getCommitedPols(&cmPolsRecursive2, config.recursive2Verifier, config.recursive2Exec, zkinInputRecursive2, (1 << starksRecursive2->starkInfo.starkStruct.nBits));
-
     //-------------------------------------------
     // Generate Recursive 2 proof
     //-------------------------------------------
@@ -679,45 +855,155 @@ void Prover::genAggregatedProof(ProverRequest *pProverRequest)
     TimerStopAndLog(STARK_RECURSIVE_2_PROOF_BATCH_PROOF);
 
     // Save the proof & zkinproof
-    nlohmann::ordered_json jProofRecursive2 = fproofRecursive2.proofs.proof2json();
+    jProofRecursive2 = fproofRecursive2.proofs.proof2json();
     nlohmann::ordered_json zkinRecursive2 = proof2zkinStark(jProofRecursive2);
     zkinRecursive2["publics"] = zkinInputRecursive2["publics"];
+    jProofRecursive2["publics"] = zkinInputRecursive2["publics"];
 
-    // Output is pProverRequest->aggregatedProofOutput (of type json)
-    pProverRequest->aggregatedProofOutput = zkinRecursive2;
+    output = zkinRecursive2;
+}
 
-    // Save output to file
-    if (config.saveOutputToFile)
+void Prover::saveAggregatedProofPublics(ProverRequest *pProverRequest)
+{
+    const VerKey &recursive2Verkey = StarkRegistry::getVerKey(config.recursive2Verkey);
+
+    json publicsJson = json::array();
+    for (int i = 0; i < 43; i++)
     {
-        json2file(pProverRequest->aggregatedProofOutput, pProverRequest->filePrefix + "aggregated_proof.output.json");
+        publicsJson[i] = pProverRequest->aggregatedProofOutput["publics"][i];
     }
-    // Save proof to file
-    if (config.saveProofToFile)
+    // Add the recursive2 verification key
+    publicsJson[43] = recursive2Verkey.constRootString[0];
+    publicsJson[44] = recursive2Verkey.constRootString[1];
+    publicsJson[45] = recursive2Verkey.constRootString[2];
+    publicsJson[46] = recursive2Verkey.constRootString[3];
+
+    json2file(publicsJson, pProverRequest->publicsOutputFile());
+}
+
+void Prover::genAggregatedProofTree(ProverRequest *pProverRequest)
+{
+    zkassert(config.generateProof());
+    zkassert(pProverRequest != NULL);
+    zkassert(pProverRequest->type == prt_genAggregatedProof);
+
+    ProverRequestTrace proverRequestTrace(*pProverRequest);
+    TimerStart(PROVER_AGGREGATED_PROOF_TREE);
+
+    // Input is pProverRequest->aggregatedProofInputs, the batch proofs of consecutive batches, in order
+    vector<nlohmann::ordered_json> &inputs = pProverRequest->aggregatedProofInputs;
+    uint64_t nLeaves = inputs.size();
+    if (nLeaves < 2)
     {
-        jProofRecursive2["publics"] = zkinInputRecursive2["publics"];
-        json2file(jProofRecursive2, pProverRequest->filePrefix + "aggregated_proof.proof.json");
+        cerr << "Error: Prover::genAggregatedProofTree() got " << nLeaves << " inputs, but at least 2 are required" << endl;
+        pProverRequest->result = ZKR_AGGREGATED_PROOF_INVALID_INPUT;
+        return;
     }
 
-    // Add the recursive2 verification key
-    json publicsJson = json::array();
+    // Every join of the tree is valid if every pair of consecutive inputs is
+    for (uint64_t i = 0; i < nLeaves - 1; i++)
+    {
+        pProverRequest->result = checkAggregatedProofInputs(inputs[i], inputs[i + 1]);
+        if (pProverRequest->result != ZKR_SUCCESS)
+        {
+            cerr << "Error: Prover::genAggregatedProofTree() found inputs " << i << " and " << i + 1 << " are not consecutive" << endl;
+            return;
+        }
+    }
 
-    file2json(config.recursive2Verkey, recursive2Verkey);
+    // Build the joins level by level; the last node of a level with an odd number of nodes goes up unchanged.
+    // Nodes 0..nLeaves-1 are the inputs, and node nLeaves+j is the output of join j
+    vector<pair<uint64_t, uint64_t>> joins;
+    vector<uint64_t> level;
+    for (uint64_t i = 0; i < nLeaves; i++)
+    {
+        level.push_back(i);
+    }
+    while (level.size() > 1)
+    {
+        vector<uint64_t> nextLevel;
+        for (uint64_t i = 0; i < level.size(); i += 2)
+        {
+            if (i + 1 < level.size())
+            {
+                joins.push_back(make_pair(level[i], level[i + 1]));
+                nextLevel.push_back(nLeaves + joins.size() - 1);
+            }
+            else
+            {
+                nextLevel.push_back(level[i]);
+            }
+        }
+        level = nextLevel;
+    }
+    uint64_t nJoins = joins.size();
+    cout << "Prover::genAggregatedProofTree() aggregating " << nLeaves << " proofs with " << nJoins << " recursive2 proofs" << endl;
 
-    for (int i = 0; i < 43; i++)
+    vector<nlohmann::ordered_json> outputs(nJoins);
+    vector<bool> nodeReady(nLeaves + nJoins, false);
+    for (uint64_t i = 0; i < nLeaves; i++)
     {
-        publicsJson[i] = zkinInputRecursive2["publics"][i];
+        nodeReady[i] = true;
     }
-    // Add the recursive2 verification key
-    publicsJson[43] = to_string(recursive2Verkey["constRoot"][0]);
-    publicsJson[44] = to_string(recursive2Verkey["constRoot"][1]);
-    publicsJson[45] = to_string(recursive2Verkey["constRoot"][2]);
-    publicsJson[46] = to_string(recursive2Verkey["constRoot"][3]);
+    auto node = [&](uint64_t n) -> nlohmann::ordered_json & { return (n < nLeaves) ? inputs[n] : outputs[n - nLeaves]; };
+
+    // The witness of the next join is computed into a side buffer while the current join is being proven,
+    // whenever both of its inputs are already available
+    uint64_t witnessSize = CommitPolsStarks::numPols() * (1 << starksRecursive2->starkInfo.starkStruct.nBits) * sizeof(Goldilocks::Element);
+    void *pWitness = malloc(witnessSize);
+    void *pNextWitness = malloc(witnessSize);
+    if ((pWitness == NULL) || (pNextWitness == NULL))
+    {
+        cerr << "Error: Prover::genAggregatedProofTree() failed calling malloc() of size " << witnessSize << endl;
+        exitProcess();
+    }
+    vector<json> zkins(nJoins);
 
-    json2file(publicsJson, pProverRequest->publicsOutputFile());
+    genRecursive2Witness(node(joins[0].first), node(joins[0].second), zkins[0], pWitness);
+    for (uint64_t j = 0; j < nJoins; j++)
+    {
+        uint64_t next = j + 1;
+        bool bPrefetch = (next < nJoins) && nodeReady[joins[next].first] && nodeReady[joins[next].second];
+        thread witnessThread;
+        if (bPrefetch)
+        {
+            witnessThread = thread([&, next]() { genRecursive2Witness(node(joins[next].first), node(joins[next].second), zkins[next], pNextWitness); });
+        }
+
+        memcpy(pAddress, pWitness, witnessSize);
+        nlohmann::ordered_json jProofRecursive2;
+        genRecursive2Proof(zkins[j], outputs[j], jProofRecursive2);
+        nodeReady[nLeaves + j] = true;
+        zkins[j].clear();
+        cout << "Prover::genAggregatedProofTree() generated recursive2 proof " << j + 1 << " of " << nJoins << endl;
+
+        if (bPrefetch)
+        {
+            witnessThread.join();
+        }
+        else if (next < nJoins)
+        {
+            genRecursive2Witness(node(joins[next].first), node(joins[next].second), zkins[next], pNextWitness);
+        }
+        swap(pWitness, pNextWitness);
+    }
+    free(pWitness);
+    free(pNextWitness);
+
+    // Output is the root of the tree, as if it was generated by genAggregatedProof
+    pProverRequest->aggregatedProofOutput = outputs[nJoins - 1];
+
+    // Save output to file
+    if (config.saveOutputToFile)
+    {
+        json2file(pProverRequest->aggregatedProofOutput, pProverRequest->filePrefix + "aggregated_proof.output.json");
+    }
+
+    saveAggregatedProofPublics(pProverRequest);
 
     pProverRequest->result = ZKR_SUCCESS;
 
-    TimerStopAndLog(PROVER_AGGREGATED_PROOF);
+    TimerStopAndLog(PROVER_AGGREGATED_PROOF_TREE);
 }
 
 void Prover::genFinalProof(ProverRequest *pProverRequest)
@@ -726,10 +1012,15 @@ void Prover::genFinalProof(ProverRequest *pProverRequest)
     zkassert(pProverRequest != NULL);
     zkassert(pProverRequest->type == prt_genFinalProof);
 
+    ProverRequestTrace proverRequestTrace(*pProverRequest);
     TimerStart(PROVER_FINAL_PROOF);
 
     printMemoryInfo(true);
     printProcessInfo(true);
+    if (config.numaPolicy != "none")
+    {
+        numaPrintStats(__func__);
+    }
 
     // Save input to file
     if (config.saveInputToFile)
@@ -750,8 +1041,7 @@ void Prover::genFinalProof(ProverRequest *pProverRequest)
         publics[i] = Goldilocks::fromString(zkinFinal["publics"][i]);
     }
 
-    uint64_t polsSizeRecursiveF = starkRecursiveF.getTotalPolsSize();
-    void *pAddressRecursiveF = (void *)malloc(polsSizeRecursiveF);
+    // Only one final request runs at a time, so it has the recursiveF memory pool for itself
     CommitPolsStarks cmPolsRecursive2(pAddressRecursiveF, (1 << starkRecursiveF.starkInfo.starkStruct.nBits));
     CircomRecursiveF::getCommitedPols(&cmPolsRecursive2, config.recursivefVerifier, config.recursivefExec, zkinFinal, (1 << starkRecursiveF.starkInfo.starkStruct.nBits));
 
@@ -840,7 +1130,6 @@ void Prover::genFinalProof(ProverRequest *pProverRequest)
     /* Cleanup */
     /***********/
     free(pWitnessFinal);
-    free(pAddressRecursiveF);
 
     TimerStopAndLog(STARK_RECURSIVE_F_PROOF_BATCH_PROOF);
     TimerStopAndLog(PROVER_FINAL_PROOF);
@@ -851,10 +1140,15 @@ void Prover::execute(ProverRequest *pProverRequest)
     zkassert(!config.generateProof());
     zkassert(pProverRequest != NULL);
 
+    ProverRequestTrace proverRequestTrace(*pProverRequest);
     TimerStart(PROVER_EXECUTE);
 
     printMemoryInfo(true);
     printProcessInfo(true);
+    if (config.numaPolicy != "none")
+    {
+        numaPrintStats(__func__);
+    }
 
     zkassert(pProverRequest != NULL);
 
@@ -867,11 +1161,12 @@ void Prover::execute(ProverRequest *pProverRequest)
     // Save input to <timestamp>.input.json, as provided by client
     if (config.saveInputToFile)
     {
-        json inputJson;
-        pProverRequest->input.save(inputJson);
-        json2file(inputJson, pProverRequest->inputFile());
+        pProverRequest->input.saveFile(pProverRequest->inputFile(), config.saveInputInBinaryFormat);
     }
 
+    // Journal the database reads as they happen, if requested
+    pProverRequest->openDbReadLogJournal();
+
     /************/
     /* Executor */
     /************/
@@ -886,9 +1181,7 @@ void Prover::execute(ProverRequest *pProverRequest)
     // Save input to <timestamp>.input.json after execution including dbReadLog
     if (config.saveDbReadsToFile)
     {
-        json inputJsonEx;
-        pProverRequest->input.save(inputJsonEx, *pProverRequest->dbReadLog);
-        json2file(inputJsonEx, pProverRequest->inputDbFile());
+        pProverRequest->input.saveFile(pProverRequest->inputDbFile(), config.saveInputInBinaryFormat, *pProverRequest->dbReadLog);
     }
 
     TimerStopAndLog(PROVER_EXECUTE);
@@ -10,9 +10,11 @@
 #include "proof.hpp"
 #include "alt_bn128.hpp"
 #include "groth16.hpp"
+#include "prepared_zkey.hpp"
 #include "binfile_utils.hpp"
 #include "zkey_utils.hpp"
 #include "prover_request.hpp"
+#include "prover_scheduler.hpp"
 #include "poseidon_goldilocks.hpp"
 #include "executor/executor.hpp"
 #include "sm/pols_generated/constant_pols.hpp"
@@ -38,6 +40,7 @@ class Prover
     Starks *starksRecursive1;
     Starks *starksRecursive2;
 
+    std::unique_ptr<Groth16::PreparedZkey<AltBn128::Engine>> preparedZkey; // Must outlive groth16Prover
     std::unique_ptr<Groth16::Prover<AltBn128::Engine>> groth16Prover;
     std::unique_ptr<BinFileUtils::BinFile> zkey;
     std::unique_ptr<ZKeyUtils::Header> zkeyHeader;
@@ -46,18 +49,35 @@ class Prover
 public:
     unordered_map<string, ProverRequest *> requestsMap; // Map uuid -> ProveRequest pointer
 
-    vector<ProverRequest *> pendingRequests;   // Queue of pending requests
-    ProverRequest *pCurrentRequest;            // Request currently being processed by the prover thread in server mode
+    ProverScheduler scheduler;                 // Pending and running requests
     vector<ProverRequest *> completedRequests; // Map uuid -> ProveRequest pointer
+    uint64_t completedRequestsSize;            // Bytes retained by the completed requests
 
 private:
-    pthread_t proverPthread;  // Prover thread
-    pthread_t cleanerPthread; // Garbage collector
-    pthread_mutex_t mutex;    // Mutex to protect the requests queues
+    struct ProverWorker
+    {
+        Prover *pProver;
+        tProverRequestClass requestClass;
+    };
+    ProverWorker workers[prc_size];
+    pthread_t proverPthread[prc_size]; // Prover threads, one per request class
+    pthread_t cleanerPthread;          // Garbage collector
+    pthread_mutex_t mutex;             // Mutex to protect the requests queues
+    pthread_cond_t schedulerCond;      // Condition to wake up the prover threads when a request is submitted or a slot changes
     void *pAddress = NULL;
+    void *pAddressRecursiveF = NULL;   // Memory pool of the final requests, reused by all of them
+
+    zkresult checkAggregatedProofInputs(nlohmann::ordered_json &input1, nlohmann::ordered_json &input2);
+    void genRecursive2Witness(nlohmann::ordered_json &input1, nlohmann::ordered_json &input2, json &zkinInputRecursive2, void *pWitnessAddress);
+    void genRecursive2Proof(json &zkinInputRecursive2, nlohmann::ordered_json &output, nlohmann::ordered_json &jProofRecursive2);
+    void saveAggregatedProofPublics(ProverRequest *pProverRequest);
+
+    // Deletes the completed requests older than config.requestsPersistence and, while they retain
+    // more than config.requestsPersistenceSize, the oldest delivered ones; the prover must be locked
+    void cleanCompletedRequests(void);
+    void deleteCompletedRequest(uint64_t i);
 public:
     const Config &config;
-    sem_t pendingRequestSem; // Semaphore to wakeup prover thread when a new request is available
     string lastComputedRequestId;
     uint64_t lastComputedRequestEndTime;
 
@@ -69,6 +89,7 @@ public:
 
     void genBatchProof(ProverRequest *pProverRequest);
     void genAggregatedProof(ProverRequest *pProverRequest);
+    void genAggregatedProofTree(ProverRequest *pProverRequest); // Aggregates pProverRequest->aggregatedProofInputs into a single recursive2 proof
     void genFinalProof(ProverRequest *pProverRequest);
     void processBatch(ProverRequest *pProverRequest);
     void execute(ProverRequest *pProverRequest);
@@ -78,6 +99,9 @@ public:
 
     void lock(void) { pthread_mutex_lock(&mutex); };
     void unlock(void) { pthread_mutex_unlock(&mutex); };
+
+    friend void *proverThread(void *arg);
+    friend void *cleanerThread(void *arg);
 };
 
 void *proverThread(void *arg);
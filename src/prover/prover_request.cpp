@@ -1,18 +1,24 @@
 #include "prover_request.hpp"
 #include "utils.hpp"
 #include "exit_process.hpp"
+#include "memory_size.hpp"
 
 ProverRequest::ProverRequest (Goldilocks &fr, const Config &config, tProverRequestType type) :
     fr(fr),
     config(config),
     startTime(0),
     endTime(0),
+    queueWait(0),
+    runTime(0),
     type(type),
     input(fr),
     dbReadLog(NULL),
+    dbReadLogJournal(NULL),
     fullTracer(fr),
+    traceEvents(NULL),
     bCompleted(false),
     bCancelling(false),
+    bDelivered(false),
     result(ZKR_UNSPECIFIED)
 {
     sem_init(&completedSem, 0, 0);
@@ -37,10 +43,11 @@ ProverRequest::ProverRequest (Goldilocks &fr, const Config &config, tProverReque
     if (config.saveDbReadsToFile)
     {
         dbReadLog = new DatabaseMap();
-        if (config.saveDbReadsToFileOnChange)
-        {
-            dbReadLog->setOnChangeCallback(this, ProverRequest::onDBReadLogChangeCallback);
-        }
+    }
+
+    if (config.saveTraceEventsToFile)
+    {
+        traceEvents = new TraceEvents();
     }
 }
 
@@ -51,12 +58,12 @@ string ProverRequest::proofFile (void)
 
 string ProverRequest::inputFile (void)
 {
-    return filePrefix + to_string(input.publicInputsExtended.publicInputs.oldBatchNum) + "." + proverRequestType2string(type) + "_input.json";
+    return filePrefix + to_string(input.publicInputsExtended.publicInputs.oldBatchNum) + "." + proverRequestType2string(type) + (config.saveInputInBinaryFormat ? "_input.bin" : "_input.json");
 }
 
 string ProverRequest::inputDbFile (void)
 {
-    return filePrefix + to_string(input.publicInputsExtended.publicInputs.oldBatchNum) + "." + proverRequestType2string(type) + "_input_db.json";
+    return filePrefix + to_string(input.publicInputsExtended.publicInputs.oldBatchNum) + "." + proverRequestType2string(type) + (config.saveInputInBinaryFormat ? "_input_db.bin" : "_input_db.json");
 }
 
 string ProverRequest::publicsOutputFile (void)
@@ -64,15 +71,131 @@ string ProverRequest::publicsOutputFile (void)
     return filePrefix + to_string(input.publicInputsExtended.publicInputs.oldBatchNum) + "." + proverRequestType2string(type) + "_" + config.publicsOutput;
 }
 
-void ProverRequest::onDBReadLogChange(DatabaseMap *dbMap)
+string ProverRequest::inputDbJournalFile (void)
+{
+    return filePrefix + to_string(input.publicInputsExtended.publicInputs.oldBatchNum) + "." + proverRequestType2string(type) + "_input_db.journal";
+}
+
+void ProverRequest::openDbReadLogJournal (void)
+{
+    if (!config.saveDbReadsToFileOnChange || (dbReadLog == NULL) || (dbReadLogJournal != NULL))
+        return;
+
+    dbReadLogJournal = new DatabaseJournal();
+    dbReadLogJournal->open(inputDbJournalFile(), config.dbReadsJournalSyncPeriod);
+
+    // Journal the input without its database, which is replaced by the reads when converting it back
+    DatabaseMap emptyDB;
+    string inputBinary;
+    input.saveBinary(inputBinary, emptyDB);
+    dbReadLogJournal->addInput(inputBinary);
+
+    dbReadLog->setJournal(dbReadLogJournal);
+}
+
+string ProverRequest::traceEventsFile (void)
+{
+    return filePrefix + proverRequestType2string(type) + "_trace.json";
+}
+
+bool ProverRequest::startTrace (void)
+{
+    if ((traceEvents == NULL) || (TraceEvents::current() == traceEvents))
+        return false;
+
+    TraceEvents::setCurrent(traceEvents);
+    traceEvents->nameThread("PROVER_REQUEST_THREAD");
+    return true;
+}
+
+void ProverRequest::stopTrace (void)
+{
+    TraceEvents::setCurrent(NULL);
+
+    if (traceEvents == NULL)
+        return;
+
+    traceEvents->save(traceEventsFile());
+    delete traceEvents;
+    traceEvents = NULL;
+}
+
+static uint64_t publicInputsExtendedMemorySize (const PublicInputsExtended &publicInputsExtended)
+{
+    const PublicInputs &publicInputs = publicInputsExtended.publicInputs;
+    return memorySize(publicInputs.oldStateRoot) +
+           memorySize(publicInputs.oldAccInputHash) +
+           memorySize(publicInputs.batchL2Data) +
+           memorySize(publicInputs.globalExitRoot) +
+           memorySize(publicInputs.sequencerAddr) +
+           memorySize(publicInputs.aggregatorAddress) +
+           memorySize(publicInputsExtended.inputHash) +
+           memorySize(publicInputsExtended.newAccInputHash) +
+           memorySize(publicInputsExtended.newLocalExitRoot) +
+           memorySize(publicInputsExtended.newStateRoot);
+}
+
+uint64_t ProverRequest::memorySize (void)
 {
-    json inputJsonEx;
-    input.save(inputJsonEx, *dbMap);
-    json2file(inputJsonEx, inputDbFile());
+    uint64_t size = sizeof(ProverRequest);
+
+    // IDs and file names
+    size += ::memorySize(uuid) + ::memorySize(timestamp) + ::memorySize(filePrefix);
+
+    // Input
+    size += publicInputsExtendedMemorySize(input.publicInputsExtended);
+    size += ::memorySize(input.from) + ::memorySize(input.txHashToGenerateExecuteTrace) + ::memorySize(input.txHashToGenerateCallTrace);
+    size += ::memorySize(input.db) + ::memorySize(input.contractsBytecode);
+
+    // Proof inputs and outputs
+    size += jsonMemorySize(batchProofOutput);
+    size += jsonMemorySize(aggregatedProofInput1) + jsonMemorySize(aggregatedProofInput2) + jsonMemorySize(aggregatedProofOutput);
+    size += aggregatedProofInputs.capacity() * sizeof(nlohmann::ordered_json);
+    for (uint64_t i = 0; i < aggregatedProofInputs.size(); i++)
+        size += jsonMemorySize(aggregatedProofInputs[i]);
+    size += jsonMemorySize(finalProofInput);
+    size += ::memorySize(proof.proofA) + ::memorySize(proof.proofC) + publicInputsExtendedMemorySize(proof.publicInputsExtended);
+    size += proof.proofB.capacity() * sizeof(ProofX);
+    for (uint64_t i = 0; i < proof.proofB.size(); i++)
+        size += ::memorySize(proof.proofB[i].proof);
+
+    // Execution data
+    if (dbReadLog != NULL)
+        size += sizeof(DatabaseMap) + dbReadLog->memorySize();
+    size += fullTracer.memorySize();
+    size += ::memorySize(receipts) + ::memorySize(logs);
+
+    return size;
+}
+
+void ProverRequest::releaseInputs (void)
+{
+    // Swap with empty containers, since clear() keeps the capacity
+    DatabaseMap::MTMap().swap(input.db);
+    DatabaseMap::ProgramMap().swap(input.contractsBytecode);
+    aggregatedProofInput1 = nullptr;
+    aggregatedProofInput2 = nullptr;
+    vector<nlohmann::ordered_json>().swap(aggregatedProofInputs);
+    finalProofInput = nullptr;
+    if (dbReadLog != NULL)
+    {
+        delete dbReadLog;
+        dbReadLog = NULL;
+    }
+    if (dbReadLogJournal != NULL)
+    {
+        delete dbReadLogJournal;
+        dbReadLogJournal = NULL;
+    }
+    fullTracer.release();
 }
 
 ProverRequest::~ProverRequest()
 {
     if (dbReadLog != NULL)
         delete dbReadLog;
+    if (dbReadLogJournal != NULL)
+        delete dbReadLogJournal;
+    if (traceEvents != NULL)
+        delete traceEvents;
 }
\ No newline at end of file
@@ -2,12 +2,14 @@
 #define PROVER_REQUEST_HPP
 
 #include <semaphore.h>
+#include <sys/time.h>
 #include "input.hpp"
 #include "proof.hpp"
 #include "counters.hpp"
 #include "full_tracer.hpp"
 #include "database_map.hpp"
 #include "prover_request_type.hpp"
+#include "trace_events.hpp"
 
 using json = nlohmann::json;
 using ordered_json = nlohmann::ordered_json;
@@ -27,6 +29,12 @@ public:
     time_t startTime; // Time when the request started being processed
     time_t endTime; // Time when the request ended
 
+    /* Scheduling */
+    struct timeval submitTimeval; // Time when the request was submitted
+    struct timeval startTimeval; // Time when the request started being processed
+    uint64_t queueWait; // us spent waiting in the pending requests queue
+    uint64_t runTime; // us spent being processed
+
     /* Output files prefix */
     string filePrefix;
 
@@ -44,6 +52,9 @@ public:
     nlohmann::ordered_json aggregatedProofInput2;
     nlohmann::ordered_json aggregatedProofOutput;
 
+    /* genAggregatedProofTree input; the output is aggregatedProofOutput */
+    vector<nlohmann::ordered_json> aggregatedProofInputs;
+
     /* genFinalProof input */
     nlohmann::ordered_json finalProofInput;
 
@@ -53,11 +64,14 @@ public:
     /* Execution generated data */
     Counters counters; // Counters of the batch execution
     DatabaseMap *dbReadLog; // Database reads logs done during the execution (if enabled)
+    DatabaseJournal *dbReadLogJournal; // Append-only file journal of dbReadLog (if saveDbReadsToFileOnChange)
     FullTracer fullTracer; // Execution traces
+    TraceEvents *traceEvents; // Timeline of the processing of the request (if saveTraceEventsToFile)
 
     /* State */
     bool bCompleted;
     bool bCancelling; // set to true to request to cancel this request
+    bool bDelivered; // set to true when the result has been returned to the client
 
     /* Result */
     zkresult result;
@@ -70,11 +84,17 @@ public:
     ProverRequest (Goldilocks &fr, const Config &config, tProverRequestType type);
     ~ProverRequest();
 
+    /* Memory accounting */
+    uint64_t memorySize (void); // Bytes retained by this request, including the object itself
+    void releaseInputs (void); // Frees the input data and the execution traces, once the request has been processed
+
     /* Output file names */
     string proofFile (void);
     string inputFile (void);
     string inputDbFile (void);
+    string inputDbJournalFile (void);
     string publicsOutputFile (void);
+    string traceEventsFile (void);
 
     /* Block until completed */
     void waitForCompleted (const uint64_t timeoutInSeconds)
@@ -99,12 +119,26 @@ public:
         return (input.txHashToGenerateExecuteTrace.size() > 0) || (input.txHashToGenerateCallTrace.size() > 0);
     }
 
-    static void onDBReadLogChangeCallback(void *p, DatabaseMap *dbMap)
-    {
-        ((ProverRequest *)p) -> onDBReadLogChange(dbMap);
-    }
+    /* Adds the spans of the calling thread to traceEvents, if enabled; returns false if it was not
+       enabled or the thread was already traced */
+    bool startTrace (void);
+
+    /* Stops tracing the calling thread, and saves traceEvents to traceEventsFile() */
+    void stopTrace (void);
 
-    void onDBReadLogChange(DatabaseMap *dbMap);
+    /* Starts journaling dbReadLog into inputDbJournalFile(), if enabled; call once the input is loaded */
+    void openDbReadLogJournal (void);
+};
+
+/* Traces the calling thread into the timeline of a request until the end of the scope */
+class ProverRequestTrace
+{
+private:
+    ProverRequest &proverRequest;
+    bool bStarted;
+public:
+    ProverRequestTrace (ProverRequest &proverRequest) : proverRequest(proverRequest) { bStarted = proverRequest.startTrace(); };
+    ~ProverRequestTrace () { if (bStarted) proverRequest.stopTrace(); };
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <iostream>
+#include "prover_scheduler.hpp"
+#include "timer.hpp"
+#include "exit_process.hpp"
+#include "zkassert.hpp"
+#include "metrics.hpp"
+
+string proverRequestClass2string (tProverRequestClass requestClass)
+{
+    switch (requestClass)
+    {
+        case prc_zkevm: return "zkevm";
+        case prc_final: return "final";
+        default:
+            cerr << "Error: proverRequestClass2string() got invalid class=" << requestClass << endl;
+            exitProcess();
+            return "";
+    }
+}
+
+ProverScheduler::ProverScheduler (const Config &config) : config(config)
+{
+    for (uint64_t c = 0; c < prc_size; c++)
+    {
+        runningRequests[c] = NULL;
+        poolSize[c] = 0;
+        metrics[c] = {0, 0, 0, 0, 0};
+        string labels = "class=\"" + proverRequestClass2string((tProverRequestClass)c) + "\"";
+        queueWaitMetric[c] = ::metrics.histogram("zkprover_prover_queue_wait_seconds", labels);
+        runTimeMetric[c] = ::metrics.histogram("zkprover_prover_run_seconds", labels);
+    }
+}
+
+tProverRequestClass ProverScheduler::requestClass (tProverRequestType type)
+{
+    switch (type)
+    {
+        case prt_genBatchProof:
+        case prt_genAggregatedProof:
+        case prt_execute:
+            return prc_zkevm;
+        case prt_genFinalProof:
+            return prc_final;
+        default:
+            cerr << "Error: ProverScheduler::requestClass() got an invalid prover request type=" << type << endl;
+            exitProcess();
+            return prc_zkevm;
+    }
+}
+
+uint64_t ProverScheduler::priority (tProverRequestType type)
+{
+    switch (type)
+    {
+        case prt_genBatchProof:      return config.proverPriorityBatchProof;
+        case prt_genAggregatedProof: return config.proverPriorityAggregatedProof;
+        case prt_genFinalProof:      return config.proverPriorityFinalProof;
+        case prt_execute:            return config.proverPriorityExecute;
+        default:                     return 0;
+    }
+}
+
+double ProverScheduler::effectivePriority (ProverRequest *pProverRequest, const struct timeval &now)
+{
+    double result = priority(pProverRequest->type);
+    if (config.proverAgingPeriod > 0)
+    {
+        result += double(TimeDiff(pProverRequest->submitTimeval, now)) / 1000000 / config.proverAgingPeriod;
+    }
+    return result;
+}
+
+bool ProverScheduler::fits (tProverRequestClass requestClass)
+{
+    uint64_t used = 0;
+    bool bRunning = false;
+    for (uint64_t c = 0; c < prc_size; c++)
+    {
+        if (runningRequests[c] != NULL)
+        {
+            used += poolSize[c];
+            bRunning = true;
+        }
+    }
+
+    // A request always fits in an idle prover
+    if (!bRunning)
+        return true;
+
+    if (config.proverMemoryBudget == 0)
+        return false;
+
+    return used + poolSize[requestClass] <= config.proverMemoryBudget * 1024 * 1024;
+}
+
+void ProverScheduler::submit (ProverRequest *pProverRequest)
+{
+    // Check the type now, rather than when a worker finds it
+    requestClass(pProverRequest->type);
+
+    gettimeofday(&pProverRequest->submitTimeval, NULL);
+    pendingRequests.push_back(pProverRequest);
+}
+
+ProverRequest * ProverScheduler::next (tProverRequestClass requestClass)
+{
+    if (runningRequests[requestClass] != NULL)
+        return NULL;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    // Find the best pending request of this class; on ties, the first one found is the oldest
+    uint64_t best = pendingRequests.size();
+    double bestPriority = 0;
+    for (uint64_t i = 0; i < pendingRequests.size(); i++)
+    {
+        if (ProverScheduler::requestClass(pendingRequests[i]->type) != requestClass)
+            continue;
+        double p = effectivePriority(pendingRequests[i], now);
+        if ((best == pendingRequests.size()) || (p > bestPriority))
+        {
+            best = i;
+            bestPriority = p;
+        }
+    }
+    if (best == pendingRequests.size())
+        return NULL;
+
+    if (!fits(requestClass))
+        return NULL;
+
+    // Let a better request of another class with a free slot start first, since starting this one
+    // could leave no memory for it
+    for (uint64_t i = 0; i < pendingRequests.size(); i++)
+    {
+        tProverRequestClass otherClass = ProverScheduler::requestClass(pendingRequests[i]->type);
+        if ((otherClass == requestClass) || (runningRequests[otherClass] != NULL))
+            continue;
+        double p = effectivePriority(pendingRequests[i], now);
+        if ((p > bestPriority) || ((p == bestPriority) && (i < best)))
+            return NULL;
+    }
+
+    ProverRequest *pProverRequest = pendingRequests[best];
+    pendingRequests.erase(pendingRequests.begin() + best);
+    runningRequests[requestClass] = pProverRequest;
+
+    gettimeofday(&pProverRequest->startTimeval, NULL);
+    pProverRequest->startTime = pProverRequest->startTimeval.tv_sec;
+    pProverRequest->queueWait = TimeDiff(pProverRequest->submitTimeval, pProverRequest->startTimeval);
+
+    return pProverRequest;
+}
+
+void ProverScheduler::done (ProverRequest *pProverRequest)
+{
+    tProverRequestClass c = requestClass(pProverRequest->type);
+    zkassert(runningRequests[c] == pProverRequest);
+    runningRequests[c] = NULL;
+
+    struct timeval endTimeval;
+    gettimeofday(&endTimeval, NULL);
+    pProverRequest->endTime = endTimeval.tv_sec;
+    pProverRequest->runTime = TimeDiff(pProverRequest->startTimeval, endTimeval);
+
+    metrics[c].completed++;
+    metrics[c].totalQueueWait += pProverRequest->queueWait;
+    metrics[c].maxQueueWait = max(metrics[c].maxQueueWait, pProverRequest->queueWait);
+    metrics[c].totalRunTime += pProverRequest->runTime;
+    metrics[c].maxRunTime = max(metrics[c].maxRunTime, pProverRequest->runTime);
+    ::metrics.observe(queueWaitMetric[c], pProverRequest->queueWait);
+    ::metrics.observe(runTimeMetric[c], pProverRequest->runTime);
+}
+
+void ProverScheduler::printMetrics (void)
+{
+    for (uint64_t c = 0; c < prc_size; c++)
+    {
+        const ProverClassMetrics &m = metrics[c];
+        cout << "ProverScheduler class=" << proverRequestClass2string((tProverRequestClass)c)
+             << " running=" << ((runningRequests[c] != NULL) ? runningRequests[c]->uuid : "none")
+             << " completed=" << m.completed
+             << " queueWait(avg/max)=" << ((m.completed > 0) ? double(m.totalQueueWait) / m.completed / 1000000 : 0) << "/" << double(m.maxQueueWait) / 1000000 << " s"
+             << " runTime(avg/max)=" << ((m.completed > 0) ? double(m.totalRunTime) / m.completed / 1000000 : 0) << "/" << double(m.maxRunTime) / 1000000 << " s" << endl;
+    }
+    cout << "ProverScheduler pending=" << pendingRequests.size() << endl;
+}
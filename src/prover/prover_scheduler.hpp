@@ -0,0 +1,77 @@
+#ifndef PROVER_SCHEDULER_HPP
+#define PROVER_SCHEDULER_HPP
+
+#include <vector>
+#include <string>
+#include <sys/time.h>
+#include "config.hpp"
+#include "prover_request.hpp"
+
+using namespace std;
+
+// Prover request classes; each class has its own slot, worker thread and memory pool
+typedef enum
+{
+    prc_zkevm = 0, // Batch, aggregated and execute requests, using the zkevm committed polynomials buffer
+    prc_final = 1, // Final requests, using the recursiveF buffer and the Groth16 working set
+    prc_size = 2
+} tProverRequestClass;
+
+string proverRequestClass2string (tProverRequestClass requestClass);
+
+// Queue wait and run time of the completed requests of a class, in us
+struct ProverClassMetrics
+{
+    uint64_t completed;
+    uint64_t totalQueueWait;
+    uint64_t maxQueueWait;
+    uint64_t totalRunTime;
+    uint64_t maxRunTime;
+};
+
+// Decides which pending request runs next, and on which class slot.
+// Pending requests are served by priority, raised by one level per config.proverAgingPeriod seconds
+// of wait so that low priority requests do not starve, and by submission order on ties.
+// A request starts when the slot of its class is free and the pools of the running classes plus its
+// own fit in config.proverMemoryBudget; a budget of 0 runs one request at a time, as a single queue.
+// It is not thread safe: the owner must serialize the calls.
+class ProverScheduler
+{
+    const Config &config;
+    vector<ProverRequest *> pendingRequests; // In submission order
+    ProverRequest *runningRequests[prc_size];
+    uint64_t poolSize[prc_size]; // Bytes used by a running request of each class
+    ProverClassMetrics metrics[prc_size];
+    uint64_t queueWaitMetric[prc_size]; // Histograms of the metrics registry, per class
+    uint64_t runTimeMetric[prc_size];
+
+    uint64_t priority (tProverRequestType type);
+    double effectivePriority (ProverRequest *pProverRequest, const struct timeval &now);
+    bool fits (tProverRequestClass requestClass);
+
+public:
+    ProverScheduler (const Config &config);
+
+    static tProverRequestClass requestClass (tProverRequestType type);
+
+    void setPoolSize (tProverRequestClass requestClass, uint64_t size) { poolSize[requestClass] = size; };
+
+    // Adds a request to the pending requests
+    void submit (ProverRequest *pProverRequest);
+
+    // Returns the pending request that the worker of this class must start now, or NULL if none;
+    // the returned request is moved to the running slot of the class
+    ProverRequest * next (tProverRequestClass requestClass);
+
+    // Frees the slot of a request that has been processed, and accounts its metrics, also in the
+    // zkprover_prover_queue_wait_seconds and zkprover_prover_run_seconds histograms of the registry
+    void done (ProverRequest *pProverRequest);
+
+    const vector<ProverRequest *> & getPendingRequests (void) { return pendingRequests; };
+    ProverRequest * getRunningRequest (tProverRequestClass requestClass) { return runningRequests[requestClass]; };
+    const ProverClassMetrics & getMetrics (tProverRequestClass requestClass) { return metrics[requestClass]; };
+
+    void printMetrics (void);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include <omp.h>
+#include <iostream>
+#include <cstdlib>
+
+template <typename Curve>
+FixedBaseMultiexp<Curve>::FixedBaseMultiexp(Curve &_g, typename Curve::PointAffine *bases, uint32_t _n, uint32_t _scalarSize, uint32_t _bitsPerChunk) :
+    g(_g),
+    n(_n),
+    scalarSize(_scalarSize),
+    bitsPerChunk(_bitsPerChunk),
+    table(NULL),
+    tableAllocated(false)
+{
+    if (bitsPerChunk < FBME_MIN_CHUNK_SIZE_BITS || bitsPerChunk > FBME_MAX_CHUNK_SIZE_BITS) {
+        std::cerr << "Error: FixedBaseMultiexp() got invalid bitsPerChunk=" << bitsPerChunk << std::endl;
+        exit(-1);
+    }
+    nChunks = getNChunks(scalarSize, bitsPerChunk);
+
+    table = (typename Curve::PointAffine *)malloc(getTableSize(n, scalarSize, bitsPerChunk));
+    if (table == NULL) {
+        std::cerr << "Error: FixedBaseMultiexp() failed calling malloc() of size " << getTableSize(n, scalarSize, bitsPerChunk) << std::endl;
+        exit(-1);
+    }
+    tableAllocated = true;
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (uint32_t i=0; i<n; i++) {
+        typename Curve::Point p;
+        g.copy(table[i], bases[i]);
+        g.copy(p, bases[i]);
+        for (uint32_t k=1; k<nChunks; k++) {
+            for (uint32_t j=0; j<bitsPerChunk; j++) g.dbl(p, p);
+            g.copy(table[uint64_t(k)*n + i], p);
+        }
+    }
+}
+
+template <typename Curve>
+FixedBaseMultiexp<Curve>::FixedBaseMultiexp(Curve &_g, uint32_t _n, uint32_t _scalarSize, uint32_t _bitsPerChunk, typename Curve::PointAffine *_table) :
+    g(_g),
+    n(_n),
+    scalarSize(_scalarSize),
+    bitsPerChunk(_bitsPerChunk),
+    table(_table),
+    tableAllocated(false)
+{
+    if (bitsPerChunk < FBME_MIN_CHUNK_SIZE_BITS || bitsPerChunk > FBME_MAX_CHUNK_SIZE_BITS) {
+        std::cerr << "Error: FixedBaseMultiexp() got invalid bitsPerChunk=" << bitsPerChunk << std::endl;
+        exit(-1);
+    }
+    nChunks = getNChunks(scalarSize, bitsPerChunk);
+}
+
+template <typename Curve>
+FixedBaseMultiexp<Curve>::~FixedBaseMultiexp() {
+    if (tableAllocated) free(table);
+}
+
+template <typename Curve>
+uint32_t FixedBaseMultiexp<Curve>::getChunk(uint8_t *scalars, uint32_t scalarIdx, uint32_t chunkIdx) {
+    uint32_t bitStart = chunkIdx*bitsPerChunk;
+    uint32_t byteStart = bitStart/8;
+    uint32_t efectiveBitsPerChunk = bitsPerChunk;
+    if (byteStart > scalarSize-8) byteStart = scalarSize - 8;
+    if (bitStart + bitsPerChunk > scalarSize*8) efectiveBitsPerChunk = scalarSize*8 - bitStart;
+    uint32_t shift = bitStart - byteStart*8;
+    uint64_t v = *(uint64_t *)(scalars + uint64_t(scalarIdx)*scalarSize + byteStart);
+    v = v >> shift;
+    v = v & ( (1 << efectiveBitsPerChunk) - 1);
+    return uint32_t(v);
+}
+
+template <typename Curve>
+void FixedBaseMultiexp<Curve>::multiexp(typename Curve::Point &r, uint8_t *scalars) {
+    uint32_t nThreads = omp_get_max_threads();
+    uint64_t accsPerThread = 1 << bitsPerChunk;
+
+    typename Curve::Point *accs = new typename Curve::Point[nThreads*accsPerThread];
+    typename Curve::Point *threadResults = new typename Curve::Point[nThreads];
+    for (uint32_t i=0; i<nThreads; i++) g.copy(threadResults[i], g.zero());
+
+    #pragma omp parallel num_threads(nThreads)
+    {
+        uint32_t idThread = omp_get_thread_num();
+        typename Curve::Point *acc = &accs[idThread*accsPerThread];
+        for (uint64_t d=0; d<accsPerThread; d++) g.copy(acc[d], g.zero());
+
+        // Every (base, chunk) digit adds its precomputed shifted base to the bucket of the digit
+        #pragma omp for schedule(static)
+        for (uint32_t i=0; i<n; i++) {
+            for (uint32_t k=0; k<nChunks; k++) {
+                uint32_t chunkValue = getChunk(scalars, i, k);
+                if (chunkValue == 0) continue;
+                typename Curve::PointAffine &base = table[uint64_t(k)*n + i];
+                if (g.isZero(base)) continue;
+                g.add(acc[chunkValue], acc[chunkValue], base);
+            }
+        }
+
+        // sum(d*acc[d]) as a running sum from the highest bucket
+        typename Curve::Point running;
+        typename Curve::Point sum;
+        g.copy(running, g.zero());
+        g.copy(sum, g.zero());
+        for (uint64_t d=accsPerThread-1; d>0; d--) {
+            g.add(running, running, acc[d]);
+            g.add(sum, sum, running);
+        }
+        g.copy(threadResults[idThread], sum);
+    }
+
+    g.copy(r, threadResults[0]);
+    for (uint32_t i=1; i<nThreads; i++) g.add(r, r, threadResults[i]);
+
+    delete[] threadResults;
+    delete[] accs;
+}
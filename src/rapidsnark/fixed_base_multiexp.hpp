@@ -0,0 +1,47 @@
+#ifndef FIXED_BASE_MULTIEXP_HPP
+#define FIXED_BASE_MULTIEXP_HPP
+
+#include <cstdint>
+
+#define FBME_MIN_CHUNK_SIZE_BITS 2
+#define FBME_MAX_CHUNK_SIZE_BITS 20
+
+// Multiexponentiation over bases that never change, e.g. the zkey sections.
+// For every base B[i] the table stores 2^(k*bitsPerChunk)*B[i] for every chunk k, so a multiexp
+// is a single bucket pass over all (base, chunk) digits plus one bucket reduction per thread,
+// with no doublings between chunks.
+// The table needs nChunks times the memory of the bases.
+template <typename Curve>
+class FixedBaseMultiexp {
+
+    Curve &g;
+    uint32_t n;
+    uint32_t scalarSize;
+    uint32_t bitsPerChunk;
+    uint32_t nChunks;
+    typename Curve::PointAffine *table; // table[k*n + i] = 2^(k*bitsPerChunk) * bases[i]
+    bool tableAllocated;
+
+    uint32_t getChunk(uint8_t *scalars, uint32_t scalarIdx, uint32_t chunkIdx);
+
+public:
+
+    // Builds the table from the bases
+    FixedBaseMultiexp(Curve &_g, typename Curve::PointAffine *bases, uint32_t _n, uint32_t _scalarSize, uint32_t _bitsPerChunk);
+    // Uses an already built table, e.g. mapped from a prepared zkey file; the table is not freed
+    FixedBaseMultiexp(Curve &_g, uint32_t _n, uint32_t _scalarSize, uint32_t _bitsPerChunk, typename Curve::PointAffine *_table);
+    ~FixedBaseMultiexp();
+
+    static uint32_t getNChunks(uint32_t scalarSize, uint32_t bitsPerChunk) { return ((scalarSize*8 - 1) / bitsPerChunk) + 1; };
+    static uint64_t getTableSize(uint32_t n, uint32_t scalarSize, uint32_t bitsPerChunk) { return uint64_t(n) * getNChunks(scalarSize, bitsPerChunk) * sizeof(typename Curve::PointAffine); };
+
+    typename Curve::PointAffine *getTable(void) { return table; };
+    uint64_t getTableSize(void) { return getTableSize(n, scalarSize, bitsPerChunk); };
+
+    // r = sum(scalars[i]*bases[i]), with scalars of scalarSize bytes in regular (non Montgomery) form
+    void multiexp(typename Curve::Point &r, uint8_t *scalars);
+};
+
+#include "fixed_base_multiexp.c.hpp"
+
+#endif // FIXED_BASE_MULTIEXP_HPP
@@ -1,6 +1,9 @@
 #include <sodium.h>
 #include <sstream>
+#include <algorithm>
+#include <omp.h>
 #include "logger.hpp"
+#include "trace_events.hpp"
 
 using namespace CPlusPlusLogging;
 
@@ -45,10 +48,70 @@ std::unique_ptr<Prover<Engine>> makeProver(
     return std::unique_ptr< Prover<Engine> >(p);
 }
 
+template <typename Engine>
+void Prover<Engine>::precomputeTables(uint32_t bitsPerChunk) {
+    uint32_t sW = sizeof(typename Engine::FrElement);
+
+    LOG_TRACE("Start precomputing fixed-base tables");
+    fixedBaseWindowBits = bitsPerChunk;
+    fbA = new FixedBaseMultiexp<typename Engine::G1>(E.g1, pointsA, nVars, sW, bitsPerChunk);
+    fbB1 = new FixedBaseMultiexp<typename Engine::G1>(E.g1, pointsB1, nVars, sW, bitsPerChunk);
+    fbB2 = new FixedBaseMultiexp<typename Engine::G2>(E.g2, pointsB2, nVars, sW, bitsPerChunk);
+    fbC = new FixedBaseMultiexp<typename Engine::G1>(E.g1, pointsC, nVars-nPublic-1, sW, bitsPerChunk);
+    fbH = new FixedBaseMultiexp<typename Engine::G1>(E.g1, pointsH, domainSize, sW, bitsPerChunk);
+    LOG_TRACE("End precomputing fixed-base tables");
+}
+
+template <typename Engine>
+void Prover<Engine>::buildRowCoefs() {
+    u_int64_t nRows = 2*u_int64_t(domainSize);
+
+    LOG_TRACE("Start building constraint-major coefs");
+    rowStart = new u_int64_t[nRows+1];
+    rowCoefs = new RowCoef<Engine>[nCoefs];
+
+    // Count the coefficients of every row, then turn the counts into row offsets
+    #pragma omp parallel for
+    for (u_int64_t r=0; r<=nRows; r++) rowStart[r] = 0;
+    #pragma omp parallel for
+    for (u_int64_t i=0; i<nCoefs; i++) {
+        u_int64_t row = ((coefs[i].m == 0) ? 0 : domainSize) + coefs[i].c;
+        __atomic_fetch_add(&rowStart[row+1], 1, __ATOMIC_RELAXED);
+    }
+    for (u_int64_t r=0; r<nRows; r++) rowStart[r+1] += rowStart[r];
+
+    // Scatter the coefficients; the order inside a row does not matter, since they are only added up
+    u_int64_t *rowNext = new u_int64_t[nRows];
+    #pragma omp parallel for
+    for (u_int64_t r=0; r<nRows; r++) rowNext[r] = rowStart[r];
+    #pragma omp parallel for
+    for (u_int64_t i=0; i<nCoefs; i++) {
+        u_int64_t row = ((coefs[i].m == 0) ? 0 : domainSize) + coefs[i].c;
+        u_int64_t pos = __atomic_fetch_add(&rowNext[row], 1, __ATOMIC_RELAXED);
+        rowCoefs[pos].s = coefs[i].s;
+        E.fr.copy(rowCoefs[pos].coef, coefs[i].coef);
+    }
+    delete[] rowNext;
+    LOG_TRACE("End building constraint-major coefs");
+}
+
+template <typename Engine>
+void Prover<Engine>::shiftedFFT(typename Engine::FrElement *p, u_int32_t domainPower) {
+    fft->ifft(p, domainSize);
+    #pragma omp parallel for
+    for (u_int64_t i=0; i<domainSize; i++) {
+        E.fr.mul(p[i], p[i], fft->root(domainPower+1, i));
+    }
+    fft->fft(p, domainSize);
+}
+
 template <typename Engine>
 std::unique_ptr<Proof<Engine>> Prover<Engine>::prove(typename Engine::FrElement *wtns) {
     stringstream ss;
 
+    // Timeline of the request, if it is being traced; the sections below run in other threads
+    TraceEvents *pTraceEvents = TraceEvents::current();
+
     LOG_TRACE("Start Initializing a b c A");
     auto a = new typename Engine::FrElement[domainSize];
     ss << "a = " << (const void *)a << endl;
@@ -62,38 +125,20 @@ std::unique_ptr<Proof<Engine>> Prover<Engine>::prove(typename Engine::FrElement
 
     ss << "domainSize=" << domainSize;
     LOG_TRACE(ss.str().c_str());
-    #pragma omp parallel for
-    for (u_int32_t i=0; i<domainSize; i++) {
-        E.fr.copy(a[i], E.fr.zero());
-        E.fr.copy(b[i], E.fr.zero());
-        if (i==0) LOG_TRACE("E.fr.copy i=0");
-    }
 
     LOG_TRACE("Processing coefs");
-    #define NLOCKS 1024
-    omp_lock_t locks[NLOCKS];
-    for (int i=0; i<NLOCKS; i++) omp_init_lock(&locks[i]);
-    #pragma omp parallel for 
-    for (u_int64_t i=0; i<nCoefs; i++) {
-        typename Engine::FrElement *ab = (coefs[i].m == 0) ? a : b;
+    TraceSpan coefsSpan(pTraceEvents, "GROTH16_COEFS");
+    // Every row is owned by a single thread, so no locks are needed
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (u_int64_t r=0; r<2*u_int64_t(domainSize); r++) {
+        typename Engine::FrElement *ab = (r < domainSize) ? &a[r] : &b[r - domainSize];
         typename Engine::FrElement aux;
-
-        E.fr.mul(
-            aux,
-            wtns[coefs[i].s],
-            coefs[i].coef
-        );
-
-        omp_set_lock(&locks[coefs[i].c % NLOCKS]);
-        E.fr.add(
-            ab[coefs[i].c],
-            ab[coefs[i].c],
-            aux
-        );
-        omp_unset_lock(&locks[coefs[i].c % NLOCKS]);
+        E.fr.copy(*ab, E.fr.zero());
+        for (u_int64_t j=rowStart[r]; j<rowStart[r+1]; j++) {
+            E.fr.mul(aux, wtns[rowCoefs[j].s], rowCoefs[j].coef);
+            E.fr.add(*ab, *ab, aux);
+        }
     }
-    for (int i=0; i<NLOCKS; i++) omp_destroy_lock(&locks[i]);
-
 
     LOG_TRACE("Calculating c");
     #pragma omp parallel for
@@ -105,66 +150,103 @@ std::unique_ptr<Proof<Engine>> Prover<Engine>::prove(typename Engine::FrElement
         );
     }
 
+    coefsSpan.end();
+
     LOG_TRACE("Initializing fft");
     u_int32_t domainPower = fft->log2(domainSize);
 
-    LOG_TRACE("Start iFFT A");
-    fft->ifft(a, domainSize);
-    LOG_TRACE("a After ifft:");
-    LOG_DEBUG(E.fr.toString(a[0]).c_str());
-    LOG_DEBUG(E.fr.toString(a[1]).c_str());
-    LOG_TRACE("Start Shift A");
-    #pragma omp parallel for
-    for (u_int64_t i=0; i<domainSize; i++) {
-        E.fr.mul(a[i], a[i], fft->root(domainPower+1, i));
+    uint32_t sW = sizeof(wtns[0]);
+    typename Engine::G1Point pi_a;
+    typename Engine::G1Point pib1;
+    typename Engine::G2Point pi_b;
+    typename Engine::G1Point pi_c;
+
+    // The three iFFT/shift/FFT chains and the A, B1, B2 and C multiexps are independent, so they run
+    // as concurrent sections, each one with its share of the threads; only H depends on the FFTs
+    #define GROTH16_N_SECTIONS 7
+    int nThreads = omp_get_max_threads();
+    int sectionThreads = std::max(1, nThreads / GROTH16_N_SECTIONS);
+    int maxActiveLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(2);
+
+    LOG_TRACE("Start FFTs and Multiexps A B1 B2 C");
+    #pragma omp parallel sections num_threads(std::min(nThreads, GROTH16_N_SECTIONS))
+    {
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_FFT_A");
+            omp_set_num_threads(sectionThreads);
+            shiftedFFT(a, domainPower);
+        }
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_FFT_B");
+            omp_set_num_threads(sectionThreads);
+            shiftedFFT(b, domainPower);
+        }
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_FFT_C");
+            omp_set_num_threads(sectionThreads);
+            shiftedFFT(c, domainPower);
+        }
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_MULTIEXP_A");
+            omp_set_num_threads(sectionThreads);
+            if (fbA != NULL) fbA->multiexp(pi_a, (uint8_t *)wtns);
+            else E.g1.multiMulByScalar(pi_a, pointsA, (uint8_t *)wtns, sW, nVars);
+        }
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_MULTIEXP_B1");
+            omp_set_num_threads(sectionThreads);
+            if (fbB1 != NULL) fbB1->multiexp(pib1, (uint8_t *)wtns);
+            else E.g1.multiMulByScalar(pib1, pointsB1, (uint8_t *)wtns, sW, nVars);
+        }
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_MULTIEXP_B2");
+            omp_set_num_threads(sectionThreads);
+            if (fbB2 != NULL) fbB2->multiexp(pi_b, (uint8_t *)wtns);
+            else E.g2.multiMulByScalar(pi_b, pointsB2, (uint8_t *)wtns, sW, nVars);
+        }
+        #pragma omp section
+        {
+            TraceSpan span(pTraceEvents, "GROTH16_MULTIEXP_C");
+            omp_set_num_threads(sectionThreads);
+            if (fbC != NULL) fbC->multiexp(pi_c, (uint8_t *)((uint64_t)wtns + (nPublic +1)*sW));
+            else E.g1.multiMulByScalar(pi_c, pointsC, (uint8_t *)((uint64_t)wtns + (nPublic +1)*sW), sW, nVars-nPublic-1);
+        }
     }
-    LOG_TRACE("a After shift:");
-    LOG_DEBUG(E.fr.toString(a[0]).c_str());
-    LOG_DEBUG(E.fr.toString(a[1]).c_str());
-    LOG_TRACE("Start FFT A");
-    fft->fft(a, domainSize);
+
+    omp_set_max_active_levels(maxActiveLevels);
+    LOG_TRACE("End FFTs and Multiexps A B1 B2 C");
+
     LOG_TRACE("a After fft:");
     LOG_DEBUG(E.fr.toString(a[0]).c_str());
     LOG_DEBUG(E.fr.toString(a[1]).c_str());
-    LOG_TRACE("Start iFFT B");
-    fft->ifft(b, domainSize);
-    LOG_TRACE("b After ifft:");
-    LOG_DEBUG(E.fr.toString(b[0]).c_str());
-    LOG_DEBUG(E.fr.toString(b[1]).c_str());
-    LOG_TRACE("Start Shift B");
-    #pragma omp parallel for
-    for (u_int64_t i=0; i<domainSize; i++) {
-        E.fr.mul(b[i], b[i], fft->root(domainPower+1, i));
-    }
-    LOG_TRACE("b After shift:");
-    LOG_DEBUG(E.fr.toString(b[0]).c_str());
-    LOG_DEBUG(E.fr.toString(b[1]).c_str());
-    LOG_TRACE("Start FFT B");
-    fft->fft(b, domainSize);
     LOG_TRACE("b After fft:");
     LOG_DEBUG(E.fr.toString(b[0]).c_str());
     LOG_DEBUG(E.fr.toString(b[1]).c_str());
-
-    LOG_TRACE("Start iFFT C");
-    fft->ifft(c, domainSize);
-    LOG_TRACE("c After ifft:");
-    LOG_DEBUG(E.fr.toString(c[0]).c_str());
-    LOG_DEBUG(E.fr.toString(c[1]).c_str());
-    LOG_TRACE("Start Shift C");
-    #pragma omp parallel for
-    for (u_int64_t i=0; i<domainSize; i++) {
-        E.fr.mul(c[i], c[i], fft->root(domainPower+1, i));
-    }
-    LOG_TRACE("c After shift:");
-    LOG_DEBUG(E.fr.toString(c[0]).c_str());
-    LOG_DEBUG(E.fr.toString(c[1]).c_str());
-    LOG_TRACE("Start FFT C");
-    fft->fft(c, domainSize);
     LOG_TRACE("c After fft:");
     LOG_DEBUG(E.fr.toString(c[0]).c_str());
     LOG_DEBUG(E.fr.toString(c[1]).c_str());
+    std::ostringstream ss2;
+    ss2 << "pi_a: " << E.g1.toString(pi_a);
+    LOG_DEBUG(ss2);
+    std::ostringstream ss3;
+    ss3 << "pib1: " << E.g1.toString(pib1);
+    LOG_DEBUG(ss3);
+    std::ostringstream ss4;
+    ss4 << "pi_b: " << E.g2.toString(pi_b);
+    LOG_DEBUG(ss4);
+    std::ostringstream ss5;
+    ss5 << "pi_c: " << E.g1.toString(pi_c);
+    LOG_DEBUG(ss5);
 
     LOG_TRACE("Start ABC");
+    TraceSpan abcSpan(pTraceEvents, "GROTH16_ABC");
     #pragma omp parallel for
     for (u_int64_t i=0; i<domainSize; i++) {
         E.fr.mul(a[i], a[i], b[i]);
@@ -177,45 +259,20 @@ std::unique_ptr<Proof<Engine>> Prover<Engine>::prove(typename Engine::FrElement
 
     delete[] b;
     delete[] c;
+    abcSpan.end();
 
     LOG_TRACE("Start Multiexp H");
+    TraceSpan multiexpHSpan(pTraceEvents, "GROTH16_MULTIEXP_H");
     typename Engine::G1Point pih;
-    E.g1.multiMulByScalar(pih, pointsH, (uint8_t *)a, sizeof(a[0]), domainSize);
+    if (fbH != NULL) fbH->multiexp(pih, (uint8_t *)a);
+    else E.g1.multiMulByScalar(pih, pointsH, (uint8_t *)a, sizeof(a[0]), domainSize);
     std::ostringstream ss1;
     ss1 << "pih: " << E.g1.toString(pih);
     LOG_DEBUG(ss1);
+    multiexpHSpan.end();
 
     delete[] a;
 
-    LOG_TRACE("Start Multiexp A");
-    uint32_t sW = sizeof(wtns[0]);
-    typename Engine::G1Point pi_a;
-    E.g1.multiMulByScalar(pi_a, pointsA, (uint8_t *)wtns, sW, nVars);
-    std::ostringstream ss2;
-    ss2 << "pi_a: " << E.g1.toString(pi_a);
-    LOG_DEBUG(ss2);
-
-    LOG_TRACE("Start Multiexp B1");
-    typename Engine::G1Point pib1;
-    E.g1.multiMulByScalar(pib1, pointsB1, (uint8_t *)wtns, sW, nVars);
-    std::ostringstream ss3;
-    ss3 << "pib1: " << E.g1.toString(pib1);
-    LOG_DEBUG(ss3);
-
-    LOG_TRACE("Start Multiexp B2");
-    typename Engine::G2Point pi_b;
-    E.g2.multiMulByScalar(pi_b, pointsB2, (uint8_t *)wtns, sW, nVars);
-    std::ostringstream ss4;
-    ss4 << "pi_b: " << E.g2.toString(pi_b);
-    LOG_DEBUG(ss4);
-
-    LOG_TRACE("Start Multiexp C");
-    typename Engine::G1Point pi_c;
-    E.g1.multiMulByScalar(pi_c, pointsC, (uint8_t *)((uint64_t)wtns + (nPublic +1)*sW), sW, nVars-nPublic-1);
-    std::ostringstream ss5;
-    ss5 << "pi_c: " << E.g1.toString(pi_c);
-    LOG_DEBUG(ss5);
-
     typename Engine::FrElement r;
     typename Engine::FrElement s;
     typename Engine::FrElement rs;
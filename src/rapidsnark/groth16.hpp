@@ -7,6 +7,7 @@ using json = nlohmann::json;
 
 #include "binfile_utils.hpp"
 #include "fft.hpp"
+#include "fixed_base_multiexp.hpp"
 
 namespace Groth16 {
 
@@ -32,11 +33,23 @@ namespace Groth16 {
         u_int32_t s;
         typename Engine::FrElement coef;
     };
+
+    // Coefficient of the constraint-major layout, grouped by evaluation row
+    template <typename Engine>
+    struct RowCoef {
+        u_int32_t s;
+        typename Engine::FrElement coef;
+    };
 #pragma pack(pop)
 
+    template <typename Engine>
+    class PreparedZkey;
+
     template <typename Engine>
     class Prover {
 
+        friend class PreparedZkey<Engine>;
+
         Engine &E;
         u_int32_t nVars;
         u_int32_t nPublic;
@@ -55,6 +68,20 @@ namespace Groth16 {
         typename Engine::G1PointAffine *pointsH;
 
         FFT<typename Engine::Fr> *fft;
+
+        // Constraint-major copy of the coefs: the coefficients of row r (r = m*domainSize + c)
+        // are rowCoefs[rowStart[r]] .. rowCoefs[rowStart[r+1]-1]
+        u_int64_t *rowStart;
+        RowCoef<Engine> *rowCoefs;
+        bool rowCoefsOwned; // False if they point into a prepared zkey file
+
+        // Optional fixed-base tables of the zkey sections, see precomputeTables()
+        u_int32_t fixedBaseWindowBits;
+        FixedBaseMultiexp<typename Engine::G1> *fbA;
+        FixedBaseMultiexp<typename Engine::G1> *fbB1;
+        FixedBaseMultiexp<typename Engine::G2> *fbB2;
+        FixedBaseMultiexp<typename Engine::G1> *fbC;
+        FixedBaseMultiexp<typename Engine::G1> *fbH;
     public:
         Prover(
             Engine &_E, 
@@ -72,7 +99,9 @@ namespace Groth16 {
             typename Engine::G1PointAffine *_pointsB1,
             typename Engine::G2PointAffine *_pointsB2,
             typename Engine::G1PointAffine *_pointsC,
-            typename Engine::G1PointAffine *_pointsH
+            typename Engine::G1PointAffine *_pointsH,
+            u_int64_t *_rowStart = NULL,
+            RowCoef<Engine> *_rowCoefs = NULL
         ) : 
             E(_E), 
             nVars(_nVars),
@@ -89,16 +118,46 @@ namespace Groth16 {
             pointsB1(_pointsB1),
             pointsB2(_pointsB2),
             pointsC(_pointsC),
-            pointsH(_pointsH)
+            pointsH(_pointsH),
+            rowStart(_rowStart),
+            rowCoefs(_rowCoefs),
+            rowCoefsOwned(_rowStart == NULL),
+            fixedBaseWindowBits(0),
+            fbA(NULL),
+            fbB1(NULL),
+            fbB2(NULL),
+            fbC(NULL),
+            fbH(NULL)
         { 
             fft = new FFT<typename Engine::Fr>(domainSize*2);
+            if (rowCoefsOwned) buildRowCoefs();
         };
 
         ~Prover() {
             delete fft;
+            if (rowCoefsOwned) {
+                delete[] rowStart;
+                delete[] rowCoefs;
+            }
+            delete fbA;
+            delete fbB1;
+            delete fbB2;
+            delete fbC;
+            delete fbH;
         }
 
+        // Builds fixed-base tables with windows of bitsPerChunk bits for the A, B1, B2, C and H sections,
+        // trading nChunks times their memory for multiexps without doublings in prove()
+        void precomputeTables(uint32_t bitsPerChunk);
+
         std::unique_ptr<Proof<Engine>> prove(typename Engine::FrElement *wtns);
+
+        // Bytes of a prove() call besides the zkey: the witness and the a, b and c evaluations
+        u_int64_t getProveMemorySize() { return (u_int64_t(nVars) + 3*u_int64_t(domainSize))*sizeof(typename Engine::FrElement); };
+
+    private:
+        void buildRowCoefs();
+        void shiftedFFT(typename Engine::FrElement *p, u_int32_t domainPower);
     };
 
     template <typename Engine>
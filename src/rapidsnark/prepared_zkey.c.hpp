@@ -0,0 +1,314 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace Groth16 {
+
+// FNV-1a
+inline u_int64_t preparedZkeyHash(u_int64_t hash, const void *data, u_int64_t size) {
+    const u_int8_t *p = (const u_int8_t *)data;
+    for (u_int64_t i=0; i<size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Hash of a buffer 8 bytes at a time, with FNV-1a for the trailing bytes
+inline u_int64_t preparedZkeyHashWords(u_int64_t hash, const void *data, u_int64_t size) {
+    const u_int8_t *p = (const u_int8_t *)data;
+    u_int64_t nWords = size / sizeof(u_int64_t);
+    for (u_int64_t i=0; i<nWords; i++) {
+        u_int64_t word;
+        memcpy(&word, &p[i*sizeof(u_int64_t)], sizeof(u_int64_t));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return preparedZkeyHash(hash, &p[nWords*sizeof(u_int64_t)], size - nWords*sizeof(u_int64_t));
+}
+
+// Size, modification and change times and inode of a zkey, taken from an open descriptor
+inline void preparedZkeyStat(const struct stat &sb, u_int64_t &size, u_int64_t &mtime, u_int64_t &ctime, u_int64_t &inode) {
+    size = sb.st_size;
+    mtime = u_int64_t(sb.st_mtim.tv_sec)*1000000000ULL + sb.st_mtim.tv_nsec;
+    ctime = u_int64_t(sb.st_ctim.tv_sec)*1000000000ULL + sb.st_ctim.tv_nsec;
+    inode = sb.st_ino;
+}
+
+// Size, times and inode of a zkey; returns false if it cannot be read
+inline bool preparedZkeyIdentity(const std::string &zkeyFileName, u_int64_t &size, u_int64_t &mtime, u_int64_t &ctime, u_int64_t &inode) {
+    struct stat sb;
+    if (stat(zkeyFileName.c_str(), &sb) == -1) return false;
+    preparedZkeyStat(sb, size, mtime, ctime, inode);
+    return true;
+}
+
+// Size, times, inode and a checksum of the size and the whole content of a zkey, hashed in chunks
+// in parallel; returns false if it cannot be read
+inline bool preparedZkeyChecksum(const std::string &zkeyFileName, u_int64_t &size, u_int64_t &mtime, u_int64_t &ctime, u_int64_t &inode, u_int64_t &checksum) {
+    int fd = ::open(zkeyFileName.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        close(fd);
+        return false;
+    }
+    preparedZkeyStat(sb, size, mtime, ctime, inode);
+    checksum = preparedZkeyHash(0xcbf29ce484222325ULL, &size, sizeof(size));
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void *pZkey = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pZkey == MAP_FAILED) return false;
+    madvise(pZkey, size, MADV_SEQUENTIAL);
+
+    u_int64_t nChunks = (size + PREPARED_ZKEY_CHECKSUM_CHUNK - 1) / PREPARED_ZKEY_CHECKSUM_CHUNK;
+    std::vector<u_int64_t> chunkHashes(nChunks);
+    #pragma omp parallel for schedule(dynamic)
+    for (u_int64_t i=0; i<nChunks; i++) {
+        u_int64_t offset = i*PREPARED_ZKEY_CHECKSUM_CHUNK;
+        u_int64_t chunkSize = (offset + PREPARED_ZKEY_CHECKSUM_CHUNK <= size) ? PREPARED_ZKEY_CHECKSUM_CHUNK : size - offset;
+        chunkHashes[i] = preparedZkeyHashWords(0xcbf29ce484222325ULL, (u_int8_t *)pZkey + offset, chunkSize);
+    }
+    munmap(pZkey, size);
+
+    checksum = preparedZkeyHash(checksum, chunkHashes.data(), nChunks*sizeof(u_int64_t));
+    return true;
+}
+
+// Size that every section must have, given the dimensions of the header
+template <typename Engine>
+void preparedZkeySectionSizes(const PreparedZkeyHeader<Engine> &header, u_int64_t (&sizes)[pzs_nSections]) {
+    sizes[pzs_rowStart] = (2*u_int64_t(header.domainSize) + 1) * sizeof(u_int64_t);
+    sizes[pzs_rowCoefs] = header.nCoefs * sizeof(RowCoef<Engine>);
+    sizes[pzs_pointsA] = u_int64_t(header.nVars) * sizeof(typename Engine::G1PointAffine);
+    sizes[pzs_pointsB1] = u_int64_t(header.nVars) * sizeof(typename Engine::G1PointAffine);
+    sizes[pzs_pointsB2] = u_int64_t(header.nVars) * sizeof(typename Engine::G2PointAffine);
+    sizes[pzs_pointsC] = u_int64_t(header.nVars - header.nPublic - 1) * sizeof(typename Engine::G1PointAffine);
+    sizes[pzs_pointsH] = u_int64_t(header.domainSize) * sizeof(typename Engine::G1PointAffine);
+    u_int32_t bits = header.fixedBaseWindowBits;
+    u_int32_t sW = sizeof(typename Engine::FrElement);
+    sizes[pzs_tableA] = (bits == 0) ? 0 : FixedBaseMultiexp<typename Engine::G1>::getTableSize(header.nVars, sW, bits);
+    sizes[pzs_tableB1] = (bits == 0) ? 0 : FixedBaseMultiexp<typename Engine::G1>::getTableSize(header.nVars, sW, bits);
+    sizes[pzs_tableB2] = (bits == 0) ? 0 : FixedBaseMultiexp<typename Engine::G2>::getTableSize(header.nVars, sW, bits);
+    sizes[pzs_tableC] = (bits == 0) ? 0 : FixedBaseMultiexp<typename Engine::G1>::getTableSize(header.nVars - header.nPublic - 1, sW, bits);
+    sizes[pzs_tableH] = (bits == 0) ? 0 : FixedBaseMultiexp<typename Engine::G1>::getTableSize(header.domainSize, sW, bits);
+}
+
+template <typename Engine>
+PreparedZkey<Engine>::~PreparedZkey() {
+    munmap(pAddress, fileSize);
+}
+
+template <typename Engine>
+std::unique_ptr<PreparedZkey<Engine>> PreparedZkey<Engine>::open(const std::string &fileName, const std::string &zkeyFileName, u_int32_t fixedBaseWindowBits, bool bVerifyChecksum) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cout << "PreparedZkey::open() found no prepared zkey file " << fileName << std::endl;
+        return NULL;
+    }
+
+    struct stat sb;
+    if ((fstat(fd, &sb) == -1) || (u_int64_t(sb.st_size) < PREPARED_ZKEY_HEADER_SIZE)) {
+        std::cout << "PreparedZkey::open() found an invalid prepared zkey file " << fileName << std::endl;
+        close(fd);
+        return NULL;
+    }
+
+    void *pAddress = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pAddress == MAP_FAILED) {
+        std::cerr << "Error: PreparedZkey::open() failed calling mmap() of file " << fileName << " errno=" << errno << "=" << strerror(errno) << std::endl;
+        return NULL;
+    }
+    std::unique_ptr<PreparedZkey<Engine>> preparedZkey(new PreparedZkey<Engine>(pAddress, sb.st_size));
+    PreparedZkeyHeader<Engine> *header = preparedZkey->header;
+
+    // Check the file itself
+    bool bValid = (memcmp(header->magic, PREPARED_ZKEY_MAGIC, sizeof(header->magic)) == 0) &&
+                  (header->version == PREPARED_ZKEY_VERSION) &&
+                  (header->headerChecksum == preparedZkeyHash(0xcbf29ce484222325ULL, header, offsetof(PreparedZkeyHeader<Engine>, headerChecksum)));
+    u_int64_t sectionSizes[pzs_nSections];
+    if (bValid) {
+        bValid = (header->nVars > header->nPublic) &&
+                 ((header->fixedBaseWindowBits == 0) || ((header->fixedBaseWindowBits >= FBME_MIN_CHUNK_SIZE_BITS) && (header->fixedBaseWindowBits <= FBME_MAX_CHUNK_SIZE_BITS)));
+    }
+    if (bValid) {
+        preparedZkeySectionSizes(*header, sectionSizes);
+    }
+    for (u_int64_t i=0; bValid && (i<pzs_nSections); i++) {
+        bValid = (header->sectionSize[i] == sectionSizes[i]) &&
+                 (header->sectionOffset[i] % PREPARED_ZKEY_ALIGNMENT == 0) &&
+                 (header->sectionOffset[i] >= PREPARED_ZKEY_HEADER_SIZE) &&
+                 (header->sectionOffset[i] <= preparedZkey->fileSize) &&
+                 (header->sectionSize[i] <= preparedZkey->fileSize - header->sectionOffset[i]);
+    }
+    if (!bValid) {
+        std::cout << "PreparedZkey::open() found a corrupted prepared zkey file " << fileName << std::endl;
+        return NULL;
+    }
+
+    // Check that it belongs to the current zkey and configuration
+    u_int64_t zkeySize, zkeyMtime, zkeyCtime, zkeyInode, zkeyChecksum;
+    bValid = preparedZkeyIdentity(zkeyFileName, zkeySize, zkeyMtime, zkeyCtime, zkeyInode);
+    bValid = bValid &&
+             (zkeySize == header->zkeySize) &&
+             (zkeyMtime == header->zkeyMtime) &&
+             (zkeyCtime == header->zkeyCtime) &&
+             (zkeyInode == header->zkeyInode);
+    if (bValid && bVerifyChecksum) {
+        bValid = preparedZkeyChecksum(zkeyFileName, zkeySize, zkeyMtime, zkeyCtime, zkeyInode, zkeyChecksum) &&
+                 (zkeySize == header->zkeySize) &&
+                 (zkeyChecksum == header->zkeyChecksum);
+    }
+    if (!bValid) {
+        std::cout << "PreparedZkey::open() found a prepared zkey file " << fileName << " that does not match zkey " << zkeyFileName << std::endl;
+        return NULL;
+    }
+    if (header->fixedBaseWindowBits != fixedBaseWindowBits) {
+        std::cout << "PreparedZkey::open() found a prepared zkey file " << fileName << " with fixedBaseWindowBits=" << header->fixedBaseWindowBits << " instead of " << fixedBaseWindowBits << std::endl;
+        return NULL;
+    }
+
+    return preparedZkey;
+}
+
+template <typename Engine>
+bool PreparedZkey<Engine>::save(const std::string &fileName, const std::string &zkeyFileName, Prover<Engine> &prover) {
+    PreparedZkeyHeader<Engine> header;
+    memset((void *)&header, 0, sizeof(header));
+    memcpy(header.magic, PREPARED_ZKEY_MAGIC, sizeof(header.magic));
+    header.version = PREPARED_ZKEY_VERSION;
+    if (!preparedZkeyChecksum(zkeyFileName, header.zkeySize, header.zkeyMtime, header.zkeyCtime, header.zkeyInode, header.zkeyChecksum)) {
+        std::cerr << "Error: PreparedZkey::save() failed reading zkey " << zkeyFileName << std::endl;
+        return false;
+    }
+    header.nVars = prover.nVars;
+    header.nPublic = prover.nPublic;
+    header.domainSize = prover.domainSize;
+    header.nCoefs = prover.nCoefs;
+    header.fixedBaseWindowBits = 0;
+    memcpy((void *)&header.vk_alpha1, (void *)&prover.vk_alpha1, sizeof(header.vk_alpha1));
+    memcpy((void *)&header.vk_beta1, (void *)&prover.vk_beta1, sizeof(header.vk_beta1));
+    memcpy((void *)&header.vk_beta2, (void *)&prover.vk_beta2, sizeof(header.vk_beta2));
+    memcpy((void *)&header.vk_delta1, (void *)&prover.vk_delta1, sizeof(header.vk_delta1));
+    memcpy((void *)&header.vk_delta2, (void *)&prover.vk_delta2, sizeof(header.vk_delta2));
+
+    const void *sections[pzs_nSections] = {NULL};
+    sections[pzs_rowStart] = prover.rowStart;
+    header.sectionSize[pzs_rowStart] = (2*u_int64_t(prover.domainSize) + 1) * sizeof(u_int64_t);
+    sections[pzs_rowCoefs] = prover.rowCoefs;
+    header.sectionSize[pzs_rowCoefs] = prover.nCoefs * sizeof(RowCoef<Engine>);
+    sections[pzs_pointsA] = prover.pointsA;
+    header.sectionSize[pzs_pointsA] = u_int64_t(prover.nVars) * sizeof(typename Engine::G1PointAffine);
+    sections[pzs_pointsB1] = prover.pointsB1;
+    header.sectionSize[pzs_pointsB1] = u_int64_t(prover.nVars) * sizeof(typename Engine::G1PointAffine);
+    sections[pzs_pointsB2] = prover.pointsB2;
+    header.sectionSize[pzs_pointsB2] = u_int64_t(prover.nVars) * sizeof(typename Engine::G2PointAffine);
+    sections[pzs_pointsC] = prover.pointsC;
+    header.sectionSize[pzs_pointsC] = u_int64_t(prover.nVars - prover.nPublic - 1) * sizeof(typename Engine::G1PointAffine);
+    sections[pzs_pointsH] = prover.pointsH;
+    header.sectionSize[pzs_pointsH] = u_int64_t(prover.domainSize) * sizeof(typename Engine::G1PointAffine);
+    if (prover.fbA != NULL) {
+        header.fixedBaseWindowBits = prover.fixedBaseWindowBits;
+        sections[pzs_tableA] = prover.fbA->getTable();
+        header.sectionSize[pzs_tableA] = prover.fbA->getTableSize();
+        sections[pzs_tableB1] = prover.fbB1->getTable();
+        header.sectionSize[pzs_tableB1] = prover.fbB1->getTableSize();
+        sections[pzs_tableB2] = prover.fbB2->getTable();
+        header.sectionSize[pzs_tableB2] = prover.fbB2->getTableSize();
+        sections[pzs_tableC] = prover.fbC->getTable();
+        header.sectionSize[pzs_tableC] = prover.fbC->getTableSize();
+        sections[pzs_tableH] = prover.fbH->getTable();
+        header.sectionSize[pzs_tableH] = prover.fbH->getTableSize();
+    }
+
+    u_int64_t sectionSizes[pzs_nSections];
+    preparedZkeySectionSizes(header, sectionSizes);
+    if (memcmp(sectionSizes, header.sectionSize, sizeof(sectionSizes)) != 0) {
+        std::cerr << "Error: PreparedZkey::save() found section sizes that do not match the prover dimensions" << std::endl;
+        return false;
+    }
+
+    u_int64_t offset = PREPARED_ZKEY_HEADER_SIZE;
+    for (u_int64_t i=0; i<pzs_nSections; i++) {
+        header.sectionOffset[i] = offset;
+        offset += ((header.sectionSize[i] + PREPARED_ZKEY_ALIGNMENT - 1) / PREPARED_ZKEY_ALIGNMENT) * PREPARED_ZKEY_ALIGNMENT;
+    }
+    header.headerChecksum = preparedZkeyHash(0xcbf29ce484222325ULL, &header, offsetof(PreparedZkeyHeader<Engine>, headerChecksum));
+
+    // Write a temporary file and rename it, so that a partially written file is never mapped
+    std::string tmpFileName = fileName + ".tmp";
+    FILE *f = fopen(tmpFileName.c_str(), "wb");
+    if (f == NULL) {
+        std::cerr << "Error: PreparedZkey::save() failed opening file " << tmpFileName << " errno=" << errno << "=" << strerror(errno) << std::endl;
+        return false;
+    }
+    u_int8_t zeros[PREPARED_ZKEY_HEADER_SIZE] = {0};
+    bool bOk = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+               (fwrite(zeros, PREPARED_ZKEY_HEADER_SIZE - sizeof(header), 1, f) == 1);
+    for (u_int64_t i=0; bOk && (i<pzs_nSections); i++) {
+        if (header.sectionSize[i] == 0) continue;
+        u_int64_t padding = (PREPARED_ZKEY_ALIGNMENT - (header.sectionSize[i] % PREPARED_ZKEY_ALIGNMENT)) % PREPARED_ZKEY_ALIGNMENT;
+        bOk = (fwrite(sections[i], header.sectionSize[i], 1, f) == 1) &&
+              ((padding == 0) || (fwrite(zeros, padding, 1, f) == 1));
+    }
+    bOk = (fclose(f) == 0) && bOk;
+    if (!bOk || (rename(tmpFileName.c_str(), fileName.c_str()) != 0)) {
+        std::cerr << "Error: PreparedZkey::save() failed writing file " << fileName << " errno=" << errno << "=" << strerror(errno) << std::endl;
+        remove(tmpFileName.c_str());
+        return false;
+    }
+
+    std::cout << "PreparedZkey::save() wrote prepared zkey file " << fileName << " of size " << offset << " bytes" << std::endl;
+    return true;
+}
+
+template <typename Engine>
+std::unique_ptr<Prover<Engine>> PreparedZkey<Engine>::makeProver() {
+    Prover<Engine> *p = new Prover<Engine>(
+        Engine::engine,
+        header->nVars,
+        header->nPublic,
+        header->domainSize,
+        header->nCoefs,
+        header->vk_alpha1,
+        header->vk_beta1,
+        header->vk_beta2,
+        header->vk_delta1,
+        header->vk_delta2,
+        NULL, // The coefs are only used through the constraint-major copy
+        (typename Engine::G1PointAffine *)getSection(pzs_pointsA),
+        (typename Engine::G1PointAffine *)getSection(pzs_pointsB1),
+        (typename Engine::G2PointAffine *)getSection(pzs_pointsB2),
+        (typename Engine::G1PointAffine *)getSection(pzs_pointsC),
+        (typename Engine::G1PointAffine *)getSection(pzs_pointsH),
+        (u_int64_t *)getSection(pzs_rowStart),
+        (RowCoef<Engine> *)getSection(pzs_rowCoefs)
+    );
+
+    u_int32_t bits = header->fixedBaseWindowBits;
+    if (bits > 0) {
+        u_int32_t sW = sizeof(typename Engine::FrElement);
+        p->fixedBaseWindowBits = bits;
+        p->fbA = new FixedBaseMultiexp<typename Engine::G1>(p->E.g1, p->nVars, sW, bits, (typename Engine::G1PointAffine *)getSection(pzs_tableA));
+        p->fbB1 = new FixedBaseMultiexp<typename Engine::G1>(p->E.g1, p->nVars, sW, bits, (typename Engine::G1PointAffine *)getSection(pzs_tableB1));
+        p->fbB2 = new FixedBaseMultiexp<typename Engine::G2>(p->E.g2, p->nVars, sW, bits, (typename Engine::G2PointAffine *)getSection(pzs_tableB2));
+        p->fbC = new FixedBaseMultiexp<typename Engine::G1>(p->E.g1, p->nVars-p->nPublic-1, sW, bits, (typename Engine::G1PointAffine *)getSection(pzs_tableC));
+        p->fbH = new FixedBaseMultiexp<typename Engine::G1>(p->E.g1, p->domainSize, sW, bits, (typename Engine::G1PointAffine *)getSection(pzs_tableH));
+    }
+
+    return std::unique_ptr<Prover<Engine>>(p);
+}
+
+} // namespace
@@ -0,0 +1,99 @@
+#ifndef PREPARED_ZKEY_HPP
+#define PREPARED_ZKEY_HPP
+
+#include <string>
+#include <memory>
+
+#include "groth16.hpp"
+
+#define PREPARED_ZKEY_MAGIC "zkprep01"
+#define PREPARED_ZKEY_VERSION 3
+#define PREPARED_ZKEY_HEADER_SIZE 4096
+#define PREPARED_ZKEY_ALIGNMENT 64
+#define PREPARED_ZKEY_CHECKSUM_CHUNK (64*1024*1024) // Bytes of the zkey hashed by every thread at a time
+
+namespace Groth16 {
+
+    enum ePreparedZkeySection {
+        pzs_rowStart = 0,
+        pzs_rowCoefs,
+        pzs_pointsA,
+        pzs_pointsB1,
+        pzs_pointsB2,
+        pzs_pointsC,
+        pzs_pointsH,
+        pzs_tableA,
+        pzs_tableB1,
+        pzs_tableB2,
+        pzs_tableC,
+        pzs_tableH,
+        pzs_nSections
+    };
+
+    template <typename Engine>
+    struct PreparedZkeyHeader {
+        char magic[8];
+        u_int64_t version;
+        u_int64_t zkeySize;
+        u_int64_t zkeyMtime; // Nanoseconds
+        u_int64_t zkeyCtime; // Nanoseconds
+        u_int64_t zkeyInode;
+        u_int64_t zkeyChecksum;
+        u_int32_t nVars;
+        u_int32_t nPublic;
+        u_int32_t domainSize;
+        u_int32_t fixedBaseWindowBits; // 0 if the file has no fixed-base tables
+        u_int64_t nCoefs;
+        typename Engine::G1PointAffine vk_alpha1;
+        typename Engine::G1PointAffine vk_beta1;
+        typename Engine::G2PointAffine vk_beta2;
+        typename Engine::G1PointAffine vk_delta1;
+        typename Engine::G2PointAffine vk_delta2;
+        u_int64_t sectionOffset[pzs_nSections];
+        u_int64_t sectionSize[pzs_nSections];
+        u_int64_t headerChecksum; // Checksum of all the previous fields
+    };
+
+    // Prover-native copy of a zkey, written once and mapped on the following starts instead of
+    // loading the zkey: the points in Montgomery form as the engine uses them, the coefficients
+    // in the constraint-major layout of the Prover and, optionally, the fixed-base tables, each
+    // section aligned to PREPARED_ZKEY_ALIGNMENT bytes.
+    // The file is tied to its zkey by the zkey size, modification and change times and inode, so a
+    // replaced or modified zkey makes it stale and it is prepared again; a checksum of the whole zkey
+    // is computed when the file is saved, and only checked on open if verification is requested,
+    // since it reads the whole zkey. The size of every section is checked against the dimensions in
+    // the header before it is mapped.
+    template <typename Engine>
+    class PreparedZkey {
+
+        void *pAddress;
+        u_int64_t fileSize;
+        PreparedZkeyHeader<Engine> *header;
+
+        PreparedZkey(void *_pAddress, u_int64_t _fileSize) :
+            pAddress(_pAddress),
+            fileSize(_fileSize),
+            header((PreparedZkeyHeader<Engine> *)_pAddress) {};
+
+        void *getSection(ePreparedZkeySection section) { return (void *)((u_int64_t)pAddress + header->sectionOffset[section]); };
+
+    public:
+
+        ~PreparedZkey();
+
+        // Maps fileName if it was prepared from zkeyFileName with the same fixed-base window;
+        // returns NULL if the file does not exist or is stale; bVerifyChecksum also checks the
+        // checksum of the whole zkey
+        static std::unique_ptr<PreparedZkey<Engine>> open(const std::string &fileName, const std::string &zkeyFileName, u_int32_t fixedBaseWindowBits, bool bVerifyChecksum);
+
+        // Writes the prepared file of a prover built from zkeyFileName; returns false on failure
+        static bool save(const std::string &fileName, const std::string &zkeyFileName, Prover<Engine> &prover);
+
+        // Returns a prover that works on the mapped file, so it must not outlive this object
+        std::unique_ptr<Prover<Engine>> makeProver();
+    };
+}
+
+#include "prepared_zkey.c.hpp"
+
+#endif // PREPARED_ZKEY_HPP
@@ -1,6 +1,7 @@
 
 #include <nlohmann/json.hpp>
 #include "aggregator_client.hpp"
+#include "metrics.hpp"
 
 using namespace std;
 using json = nlohmann::json;
@@ -30,6 +31,8 @@ void AggregatorClient::waitForThread (void)
 
 bool AggregatorClient::GetStatus (::aggregator::v1::GetStatusResponse &getStatusResponse)
 {
+    MetricsHandlerTimer(Aggregator_GetStatus);
+
     // Lock the prover
     prover.lock();
 
@@ -37,14 +40,25 @@ bool AggregatorClient::GetStatus (::aggregator::v1::GetStatusResponse &getStatus
     getStatusResponse.set_last_computed_request_id(prover.lastComputedRequestId);
     getStatusResponse.set_last_computed_end_time(prover.lastComputedRequestEndTime);
 
-    // If computing, set the current request data
-    if ((prover.pCurrentRequest != NULL) || (prover.pendingRequests.size() > 0))
+    // If computing, set the current request data; if several requests are running, report the
+    // one that started first
+    ProverRequest *pRunningRequest = NULL;
+    for (uint64_t c = 0; c < prc_size; c++)
+    {
+        ProverRequest *pRequest = prover.scheduler.getRunningRequest((tProverRequestClass)c);
+        if ((pRequest != NULL) && ((pRunningRequest == NULL) || (pRequest->startTime < pRunningRequest->startTime)))
+        {
+            pRunningRequest = pRequest;
+        }
+    }
+    const vector<ProverRequest *> &pendingRequests = prover.scheduler.getPendingRequests();
+    if ((pRunningRequest != NULL) || (pendingRequests.size() > 0))
     {
         getStatusResponse.set_status(aggregator::v1::GetStatusResponse_Status_COMPUTING);
-        if (prover.pCurrentRequest != NULL)
+        if (pRunningRequest != NULL)
         {
-            getStatusResponse.set_current_computing_request_id(prover.pCurrentRequest->uuid);
-            getStatusResponse.set_current_computing_start_time(prover.pCurrentRequest->startTime);
+            getStatusResponse.set_current_computing_request_id(pRunningRequest->uuid);
+            getStatusResponse.set_current_computing_start_time(pRunningRequest->startTime);
         }
         else
         {
@@ -64,10 +78,24 @@ bool AggregatorClient::GetStatus (::aggregator::v1::GetStatusResponse &getStatus
     getStatusResponse.set_version_server("0.0.1");
 
     // Set the list of pending requests uuids
-    for (uint64_t i=0; i<prover.pendingRequests.size(); i++)
+    for (uint64_t i=0; i<pendingRequests.size(); i++)
+    {
+        getStatusResponse.add_pending_request_queue_ids(pendingRequests[i]->uuid);
+    }
+
+    // Surface the request counts through the metrics registry, served on /metrics, since the
+    // aggregator protocol has no fields for them; the queue wait and run time of every request
+    // class are accounted in the registry by the scheduler
+    static const uint64_t pendingRequestsMetric = metrics.gauge("zkprover_prover_pending_requests");
+    static const uint64_t runningRequestsMetric = metrics.gauge("zkprover_prover_running_requests");
+    uint64_t runningRequests = 0;
+    for (uint64_t c = 0; c < prc_size; c++)
     {
-        getStatusResponse.add_pending_request_queue_ids(prover.pendingRequests[i]->uuid);
+        if (prover.scheduler.getRunningRequest((tProverRequestClass)c) != NULL)
+            runningRequests++;
     }
+    metrics.set(pendingRequestsMetric, pendingRequests.size());
+    metrics.set(runningRequestsMetric, runningRequests);
 
     // Unlock the prover
     prover.unlock();
@@ -92,6 +120,8 @@ bool AggregatorClient::GetStatus (::aggregator::v1::GetStatusResponse &getStatus
 
 bool AggregatorClient::GenBatchProof (const aggregator::v1::GenBatchProofRequest &genBatchProofRequest, aggregator::v1::GenBatchProofResponse &genBatchProofResponse)
 {
+    MetricsHandlerTimer(Aggregator_GenBatchProof);
+
 #ifdef LOG_SERVICE
     cout << "AggregatorClient::GenBatchProof() called with request: " << genBatchProofRequest.DebugString() << endl;
 #endif
@@ -174,9 +204,8 @@ bool AggregatorClient::GenBatchProof (const aggregator::v1::GenBatchProofRequest
     pProverRequest->input.publicInputsExtended.publicInputs.aggregatorAddress.set_str(auxString, 16);
 
     // Parse keys map
-    google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> > db;
-    db = genBatchProofRequest.input().db();
-    google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> >::iterator it;
+    const google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> > &db = genBatchProofRequest.input().db();
+    google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> >::const_iterator it;
     for (it=db.begin(); it!=db.end(); it++)
     {
         if (it->first.size() > (64))
@@ -185,21 +214,13 @@ bool AggregatorClient::GenBatchProof (const aggregator::v1::GenBatchProofRequest
             genBatchProofResponse.set_result(aggregator::v1::Result::ERROR);
             return false;
         }
-        vector<Goldilocks::Element> dbValue;
-        string concatenatedValues = it->second;
-        if (concatenatedValues.size()%16!=0)
+        vector<Goldilocks::Element> &dbValue = pProverRequest->input.db[it->first];
+        if (!concatenatedString2fea(fr, it->second, dbValue))
         {
-            cerr << "Error: AggregatorClient::GenBatchProof() found invalid db value size: " << concatenatedValues.size() << endl;
+            cerr << "Error: AggregatorClient::GenBatchProof() found invalid db value size: " << it->second.size() << endl;
             genBatchProofResponse.set_result(aggregator::v1::Result::ERROR);
             return false;
         }
-        for (uint64_t i=0; i<concatenatedValues.size(); i+=16)
-        {
-            Goldilocks::Element fe;
-            string2fe(fr, concatenatedValues.substr(i, 16), fe);
-            dbValue.push_back(fe);
-        }
-        pProverRequest->input.db[it->first] = dbValue;
     }
 
     // Parse contracts data
@@ -237,6 +258,8 @@ bool AggregatorClient::GenBatchProof (const aggregator::v1::GenBatchProofRequest
 
 bool AggregatorClient::GenAggregatedProof (const aggregator::v1::GenAggregatedProofRequest &genAggregatedProofRequest, aggregator::v1::GenAggregatedProofResponse &genAggregatedProofResponse)
 {
+    MetricsHandlerTimer(Aggregator_GenAggregatedProof);
+
 #ifdef LOG_SERVICE
     cout << "AggregatorClient::GenAggregatedProof() called with request: " << genAggregatedProofRequest.DebugString() << endl;
 #endif
@@ -269,6 +292,8 @@ bool AggregatorClient::GenAggregatedProof (const aggregator::v1::GenAggregatedPr
 
 bool AggregatorClient::GenFinalProof (const aggregator::v1::GenFinalProofRequest &genFinalProofRequest, aggregator::v1::GenFinalProofResponse &genFinalProofResponse)
 {
+    MetricsHandlerTimer(Aggregator_GenFinalProof);
+
 #ifdef LOG_SERVICE
     cout << "AggregatorClient::GenFinalProof() called with request: " << genFinalProofRequest.DebugString() << endl;
 #endif
@@ -310,6 +335,8 @@ bool AggregatorClient::GenFinalProof (const aggregator::v1::GenFinalProofRequest
 
 bool AggregatorClient::Cancel (const aggregator::v1::CancelRequest &cancelRequest, aggregator::v1::CancelResponse &cancelResponse)
 {
+    MetricsHandlerTimer(Aggregator_Cancel);
+
     // Get the cancel request UUID
     string uuid = cancelRequest.id();
 
@@ -351,6 +378,8 @@ bool AggregatorClient::Cancel (const aggregator::v1::CancelRequest &cancelReques
 
 bool AggregatorClient::GetProof (const aggregator::v1::GetProofRequest &getProofRequest, aggregator::v1::GetProofResponse &getProofResponse)
 {
+    MetricsHandlerTimer(Aggregator_GetProof);
+
 #ifdef LOG_SERVICE
     cout << "AggregatorClient::GetProof() received request: " << getProofRequest.DebugString();
 #endif
@@ -385,6 +414,7 @@ bool AggregatorClient::GetProof (const aggregator::v1::GetProofRequest &getProof
         else
         {
             // Request is completed
+            pProverRequest->bDelivered = true;
             getProofResponse.set_id(uuid);
             if (pProverRequest->result != ZKR_SUCCESS)
             {
@@ -14,6 +14,12 @@ using grpc::Status;
 
 void ExecutorServer::run (void)
 {
+    if (config.executorServerAsync)
+    {
+        runAsync();
+        return;
+    }
+
     ServerBuilder builder;
     
     // Limit the maximum number of threads to avoid memory starvation
@@ -14,6 +14,7 @@ class ExecutorServer
 public:
     ExecutorServer(Goldilocks &fr, Prover &prover, Config &config) : fr(fr), prover(prover), config(config) {};
     void run (void);
+    void runAsync (void); // Completion queue server, used if config.executorServerAsync
     void runThread (void);
     void waitForThread (void);
 };
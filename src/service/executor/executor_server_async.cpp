@@ -0,0 +1,190 @@
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/ext/proto_server_reflection_plugin.h>
+#include <grpcpp/health_check_service_interface.h>
+#include <google/protobuf/arena.h>
+#include <semaphore.h>
+#include <deque>
+
+#include "config.hpp"
+#include "executor_server.hpp"
+#include "executor_service.hpp"
+#include "exit_process.hpp"
+#include "zkassert.hpp"
+
+using grpc::Server;
+using grpc::ServerBuilder;
+using grpc::ServerContext;
+using grpc::ServerCompletionQueue;
+using grpc::ServerAsyncResponseWriter;
+using grpc::Status;
+
+class ExecutorAsyncCall;
+
+// Shared state of the async executor server: the calls waiting for a worker, and how many
+// calls are being processed or waiting
+class ExecutorAsyncContext
+{
+public:
+    ExecutorServiceImpl &service;
+    executor::v1::ExecutorService::AsyncService &asyncService;
+    ServerCompletionQueue *cq;
+    const Config &config;
+
+    pthread_mutex_t mutex; // Mutex to protect the queue and the in-flight counter
+    sem_t queueSem; // Semaphore to wake up a worker when a call is queued
+    deque<ExecutorAsyncCall *> queue;
+    uint64_t inFlight;
+
+    ExecutorAsyncContext (ExecutorServiceImpl &service, executor::v1::ExecutorService::AsyncService &asyncService, ServerCompletionQueue *cq, const Config &config) :
+        service(service), asyncService(asyncService), cq(cq), config(config), inFlight(0)
+    {
+        pthread_mutex_init(&mutex, NULL);
+        sem_init(&queueSem, 0, 0);
+    };
+    void lock(void) { pthread_mutex_lock(&mutex); };
+    void unlock(void) { pthread_mutex_unlock(&mutex); };
+};
+
+// One ProcessBatch call, from the moment the server accepts it until its response is sent.
+// The request and the response, with all their nested messages, live in a per-call arena, so
+// that building a response with thousands of trace steps does not go through the global heap
+class ExecutorAsyncCall
+{
+    ExecutorAsyncContext &ctx;
+    google::protobuf::Arena arena;
+    ServerContext serverContext;
+    executor::v1::ProcessBatchRequest *request;
+    executor::v1::ProcessBatchResponse *response;
+    ServerAsyncResponseWriter<executor::v1::ProcessBatchResponse> responder;
+    enum { eRequested, eProcessing, eFinished } state;
+    bool bCounted; // True if the call is accounted in ctx.inFlight
+
+public:
+    ExecutorAsyncCall (ExecutorAsyncContext &ctx) : ctx(ctx), responder(&serverContext), state(eRequested), bCounted(false)
+    {
+        request = google::protobuf::Arena::CreateMessage<executor::v1::ProcessBatchRequest>(&arena);
+        response = google::protobuf::Arena::CreateMessage<executor::v1::ProcessBatchResponse>(&arena);
+        ctx.asyncService.RequestProcessBatch(&serverContext, request, &responder, ctx.cq, ctx.cq, this);
+    }
+
+    // Called by the completion queue thread when the call is accepted or its response is sent
+    void proceed (bool ok)
+    {
+        if (state == eRequested)
+        {
+            // The completion queue is shutting down
+            if (!ok)
+            {
+                delete this;
+                return;
+            }
+
+            // Be ready for the next call
+            new ExecutorAsyncCall(ctx);
+
+            // Queue the call for a worker, unless there are too many in flight already, in which
+            // case the client is told to back off
+            ctx.lock();
+            if ((ctx.config.executorServerMaxInFlight > 0) && (ctx.inFlight >= ctx.config.executorServerMaxInFlight))
+            {
+                ctx.unlock();
+                cerr << "Error: ExecutorAsyncCall::proceed() rejecting request since there are already " << ctx.config.executorServerMaxInFlight << " requests in flight" << endl;
+                state = eFinished;
+                responder.FinishWithError(Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "executor busy"), this);
+                return;
+            }
+            ctx.inFlight++;
+            bCounted = true;
+            state = eProcessing;
+            ctx.queue.push_back(this);
+            ctx.unlock();
+            sem_post(&ctx.queueSem);
+        }
+        else
+        {
+            zkassert(state == eFinished);
+            if (bCounted)
+            {
+                ctx.lock();
+                ctx.inFlight--;
+                ctx.unlock();
+            }
+            delete this;
+        }
+    }
+
+    // Called by a worker thread
+    void process (void)
+    {
+        Status status = ctx.service.ProcessBatch(&serverContext, request, response);
+        state = eFinished;
+        responder.Finish(*response, status, this);
+    }
+};
+
+void *executorAsyncWorkerThread (void *arg)
+{
+    ExecutorAsyncContext *pCtx = (ExecutorAsyncContext *)arg;
+    while (true)
+    {
+        sem_wait(&pCtx->queueSem);
+        pCtx->lock();
+        if (pCtx->queue.empty())
+        {
+            pCtx->unlock();
+            continue;
+        }
+        ExecutorAsyncCall *pCall = pCtx->queue.front();
+        pCtx->queue.pop_front();
+        pCtx->unlock();
+
+        pCall->process();
+    }
+    return NULL;
+}
+
+void ExecutorServer::runAsync (void)
+{
+    ServerBuilder builder;
+
+    ExecutorServiceImpl service(fr, config, prover);
+    executor::v1::ExecutorService::AsyncService asyncService;
+
+    std::string server_address("0.0.0.0:" + to_string(config.executorServerPort));
+
+    grpc::EnableDefaultHealthCheckService(true);
+    grpc::reflection::InitProtoReflectionServerBuilderPlugin();
+
+    // Listen on the given address without any authentication mechanism.
+    builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+
+    // Register "asyncService" as the instance through which we'll communicate with
+    // clients. In this case it corresponds to an *asynchronous* service.
+    builder.RegisterService(&asyncService);
+    std::unique_ptr<ServerCompletionQueue> cq = builder.AddCompletionQueue();
+
+    // Finally assemble the server.
+    std::unique_ptr<Server> server(builder.BuildAndStart());
+
+    std::cout << "Executor async server listening on " << server_address << " with " << config.maxExecutorThreads << " workers" << std::endl;
+
+    // Create the workers; they are the only threads that execute batches, so they bound the
+    // memory used by the executor regardless of how many requests arrive at once
+    ExecutorAsyncContext ctx(service, asyncService, cq.get(), config);
+    uint64_t nWorkers = (config.maxExecutorThreads > 0) ? config.maxExecutorThreads : 1;
+    vector<pthread_t> workers(nWorkers);
+    for (uint64_t i = 0; i < nWorkers; i++)
+    {
+        pthread_create(&workers[i], NULL, executorAsyncWorkerThread, &ctx);
+    }
+
+    // Accept the first call, and serve the completion queue events from this thread; they only
+    // queue calls and release the finished ones, so one thread is enough
+    new ExecutorAsyncCall(ctx);
+    void *tag;
+    bool ok;
+    while (cq->Next(&tag, &ok))
+    {
+        ((ExecutorAsyncCall *)tag)->proceed(ok);
+    }
+}
@@ -3,6 +3,8 @@
 #include "input.hpp"
 #include "proof.hpp"
 #include "full_tracer.hpp"
+#include "opcode_name.hpp"
+#include "metrics.hpp"
 
 #include <grpcpp/grpcpp.h>
 
@@ -13,6 +15,8 @@ using grpc::Status;
 
 ::grpc::Status ExecutorServiceImpl::ProcessBatch(::grpc::ServerContext* context, const ::executor::v1::ProcessBatchRequest* request, ::executor::v1::ProcessBatchResponse* response)
 {
+    MetricsHandlerTimer(Executor_ProcessBatch);
+
     TimerStart(EXECUTOR_PROCESS_BATCH);
 
 #ifdef LOG_SERVICE
@@ -120,9 +124,8 @@ using grpc::Status;
     proverRequest.input.publicInputsExtended.newBatchNum = 0;
 
     // Parse db map
-    google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> > db;
-    db = request->db();
-    google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> >::iterator it;
+    const google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> > &db = request->db();
+    google::protobuf::Map<std::__cxx11::basic_string<char>, std::__cxx11::basic_string<char> >::const_iterator it;
     for (it=db.begin(); it!=db.end(); it++)
     {
         if (it->first.size() > (64))
@@ -131,23 +134,13 @@ using grpc::Status;
             TimerStopAndLog(EXECUTOR_PROCESS_BATCH);
             return Status::CANCELLED;
         }
-        vector<Goldilocks::Element> dbValue;
-        string concatenatedValues = it->second;
-        if (concatenatedValues.size()%16!=0)
+        vector<Goldilocks::Element> &dbValue = proverRequest.input.db[it->first];
+        if (!concatenatedString2fea(fr, it->second, dbValue))
         {
-            cerr << "Error: ExecutorServiceImpl::ProcessBatch() found invalid db value size: " << concatenatedValues.size() << endl;
+            cerr << "Error: ExecutorServiceImpl::ProcessBatch() found invalid db value size: " << it->second.size() << endl;
             TimerStopAndLog(EXECUTOR_PROCESS_BATCH);
             return Status::CANCELLED;
         }
-        for (uint64_t i=0; i<concatenatedValues.size(); i+=16)
-        {
-            Goldilocks::Element fe;
-            string2fe(fr, concatenatedValues.substr(i, 16), fe);
-            dbValue.push_back(fe);
-        }
-        Goldilocks::Element fe;
-        string2fe(fr, it->first, fe);
-        proverRequest.input.db[it->first] = dbValue;
 #ifdef LOG_SERVICE_EXECUTOR_INPUT
         //cout << "input.db[" << it->first << "]: " << proverRequest.input.db[it->first] << endl;
 #endif
@@ -292,7 +285,7 @@ using grpc::Status;
         }
         if (proverRequest.input.txHashToGenerateCallTrace == responses[tx].tx_hash)
         {
-            executor::v1::CallTrace * pCallTrace = new executor::v1::CallTrace();
+            executor::v1::CallTrace * pCallTrace = pProcessTransactionResponse->mutable_call_trace(); // Built in place, on the arena of the response
             executor::v1::TransactionContext * pTransactionContext = pCallTrace->mutable_context();
             pTransactionContext->set_type(responses[tx].call_trace.context.type); // "CALL" or "CREATE"
             pTransactionContext->set_from(responses[tx].call_trace.context.from); // Sender of the transaction
@@ -331,7 +324,6 @@ using grpc::Status;
                 pContract->set_gas(responses[tx].call_trace.steps[step].contract.gas);
                 pTransactionStep->set_error(string2error(responses[tx].call_trace.steps[step].error));
             }
-            pProcessTransactionResponse->set_allocated_call_trace(pCallTrace);
         }
     }
 
@@ -376,36 +368,33 @@ using grpc::Status;
 
     if (config.opcodeTracer)
     {
-        map<uint8_t, vector<Opcode>> opcodeMap;
-        cout << "Received " << proverRequest.fullTracer.info.size() << " opcodes:" << endl;
-        for (uint64_t i=0; i<proverRequest.fullTracer.info.size(); i++)
+        map<uint8_t, vector<const OpcodeRecord *>> opcodeMap;
+        const vector<OpcodeRecord> &records = proverRequest.fullTracer.records;
+        cout << "Received " << records.size() << " opcodes:" << endl;
+        for (uint64_t i=0; i<records.size(); i++)
         {
-            if (opcodeMap.find(proverRequest.fullTracer.info[i].op) == opcodeMap.end())
-            {
-                vector<Opcode> aux;
-                opcodeMap[proverRequest.fullTracer.info[i].op] = aux;
-            }
-            opcodeMap[proverRequest.fullTracer.info[i].op].push_back(proverRequest.fullTracer.info[i]);
+            opcodeMap[records[i].name].push_back(&records[i]);
         }
-        map<uint8_t, vector<Opcode>>::iterator opcodeMapIt;
+        map<uint8_t, vector<const OpcodeRecord *>>::iterator opcodeMapIt;
         for (opcodeMapIt = opcodeMap.begin(); opcodeMapIt != opcodeMap.end(); opcodeMapIt++)
         {
-            cout << "    0x" << byte2string(opcodeMapIt->first) << "=" << opcodeMapIt->second[0].opcode << " called " << opcodeMapIt->second.size() << " times";
+            const OpcodeRecord &first = *opcodeMapIt->second[0];
+            cout << "    0x" << byte2string(first.op) << "=" << ((first.flags & OPCODE_RECORD_FLAG_NAME) ? opcodeName[first.name].pName : "?") << " called " << opcodeMapIt->second.size() << " times";
 
-            uint64_t opcodeTotalGas = 0;
+            int64_t opcodeTotalGas = 0;
             cout << " gas=";
             for (uint64_t i=0; i<opcodeMapIt->second.size(); i++)
             {
-                cout << opcodeMapIt->second[i].gas_cost << ",";
-                opcodeTotalGas += opcodeMapIt->second[i].gas_cost;
+                cout << opcodeMapIt->second[i]->gasCost << ",";
+                opcodeTotalGas += opcodeMapIt->second[i]->gasCost;
             }
 
             uint64_t opcodeTotalDuration = 0;
             cout << " duration=";
             for (uint64_t i=0; i<opcodeMapIt->second.size(); i++)
             {
-                cout << opcodeMapIt->second[i].duration << ",";
-                opcodeTotalDuration += opcodeMapIt->second[i].duration;
+                cout << opcodeMapIt->second[i]->duration << ",";
+                opcodeTotalDuration += opcodeMapIt->second[i]->duration;
             }
 
             cout << " TP=" << (double(opcodeTotalGas)*1000000)/double(opcodeTotalDuration) << "gas/s" << endl;
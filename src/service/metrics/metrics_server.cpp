@@ -0,0 +1,138 @@
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "metrics_server.hpp"
+#include "metrics.hpp"
+#include "exit_process.hpp"
+
+using namespace std;
+
+void MetricsServer::run (void)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        cerr << "Error: MetricsServer::run() failed calling socket() errno=" << errno << " " << strerror(errno) << endl;
+        exitProcess();
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(config.metricsServerPort);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        cerr << "Error: MetricsServer::run() failed calling bind() port=" << config.metricsServerPort << " errno=" << errno << " " << strerror(errno) << endl;
+        exitProcess();
+    }
+    if (listen(listener, 16) != 0)
+    {
+        cerr << "Error: MetricsServer::run() failed calling listen() errno=" << errno << " " << strerror(errno) << endl;
+        exitProcess();
+    }
+
+    cout << "Metrics server listening on 127.0.0.1:" << config.metricsServerPort << endl;
+
+    // Scrapes are infrequent and short, so they are served one at a time
+    while (true)
+    {
+        int connection = accept(listener, NULL, NULL);
+        if (connection < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            cerr << "Error: MetricsServer::run() failed calling accept() errno=" << errno << " " << strerror(errno) << endl;
+            break;
+        }
+
+        // Do not let a stalled client block the following scrapes
+        struct timeval timeout = {5, 0};
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        serve(connection);
+        close(connection);
+    }
+
+    close(listener);
+}
+
+void MetricsServer::serve (int connection)
+{
+    // Read the request line and headers; the request has no body
+    string request;
+    char buffer[1024];
+    while ((request.find("\r\n\r\n") == string::npos) && (request.size() < 8192))
+    {
+        ssize_t n = recv(connection, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+        {
+            return;
+        }
+        request.append(buffer, n);
+    }
+
+    string status;
+    string contentType = "text/plain; charset=utf-8";
+    string body;
+    if ((request.compare(0, 13, "GET /metrics ") == 0) || (request.compare(0, 13, "GET /metrics?") == 0))
+    {
+        status = "200 OK";
+        contentType = "text/plain; version=0.0.4; charset=utf-8";
+        body = metrics.prometheus();
+    }
+    else if (request.compare(0, 4, "GET ") == 0)
+    {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+    else
+    {
+        status = "405 Method Not Allowed";
+        body = "Method not allowed\n";
+    }
+
+    string response = "HTTP/1.1 " + status + "\r\n" +
+                      "Content-Type: " + contentType + "\r\n" +
+                      "Content-Length: " + to_string(body.size()) + "\r\n" +
+                      "Connection: close\r\n\r\n" + body;
+
+    const char *pData = response.c_str();
+    uint64_t pending = response.size();
+    while (pending > 0)
+    {
+        ssize_t n = send(connection, pData, pending, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return;
+        }
+        pData += n;
+        pending -= n;
+    }
+}
+
+void MetricsServer::runThread (void)
+{
+    pthread_create(&t, NULL, metricsServerThread, this);
+}
+
+void MetricsServer::waitForThread (void)
+{
+    pthread_join(t, NULL);
+}
+
+void* metricsServerThread (void* arg)
+{
+    MetricsServer *pServer = (MetricsServer *)arg;
+    pServer->run();
+    return NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <pthread.h>
+#include "config.hpp"
+
+/* Minimal HTTP server, listening only on the loopback interface, that returns the metrics registry in
+   Prometheus text exposition format on GET /metrics */
+class MetricsServer
+{
+private:
+    const Config &config;
+    pthread_t t;
+    void serve (int connection);
+public:
+    MetricsServer (const Config &config) : config(config) {};
+    void run (void);
+    void runThread (void);
+    void waitForThread (void);
+};
+
+void* metricsServerThread(void* arg);
+
+#endif
@@ -46,6 +46,20 @@ zkresult StateDB::get(const Goldilocks::Element (&root)[4], const Goldilocks::El
     return zkr;
 }
 
+zkresult StateDB::multiGet(const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, vector<mpz_class> &values, DatabaseMap *dbReadLog)
+{
+    lock_guard<recursive_mutex> guard(mlock);
+
+    return StateDBInterface::multiGet(root, keys, values, dbReadLog);
+}
+
+zkresult StateDB::multiSet(const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog)
+{
+    lock_guard<recursive_mutex> guard(mlock);
+
+    return StateDBInterface::multiSet(oldRoot, keys, values, persistent, newRoots, dbReadLog);
+}
+
 zkresult StateDB::setProgram(const Goldilocks::Element (&key)[4], const vector<uint8_t> &data, const bool persistent)
 {
     lock_guard<recursive_mutex> guard(mlock);
@@ -28,6 +28,10 @@ public:
     void loadDB2MemCache();
     void flush();
 
+    // Hold the lock across all the keys, so that no other client changes the database in between
+    zkresult multiGet(const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, vector<mpz_class> &values, DatabaseMap *dbReadLog);
+    zkresult multiSet(const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog);
+
     // Methods added for testing purposes
     void setAutoCommit(const bool autoCommit);
     void commit();
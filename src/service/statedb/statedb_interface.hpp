@@ -20,6 +20,44 @@ public:
     virtual void loadDB(const DatabaseMap::MTMap &input, const bool persistent) = 0;
     virtual void loadProgramDB(const DatabaseMap::ProgramMap &input, const bool persistent) = 0;
     virtual void flush() = 0;
+
+    // Gets the values of several keys of the same root; keys holds 4 field elements per key
+    virtual zkresult multiGet(const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, vector<mpz_class> &values, DatabaseMap *dbReadLog)
+    {
+        values.clear();
+        for (uint64_t i = 0; i + 4 <= keys.size(); i += 4)
+        {
+            Goldilocks::Element key[4] = {keys[i], keys[i + 1], keys[i + 2], keys[i + 3]};
+            mpz_class value;
+            zkresult zkr = get(root, key, value, NULL, dbReadLog);
+            if (zkr != ZKR_SUCCESS)
+                return zkr;
+            values.push_back(value);
+        }
+        return ZKR_SUCCESS;
+    };
+
+    // Sets several keys in sequence, each one on the root left by the previous one; keys holds 4
+    // field elements per key, and newRoots gets the 4 field elements of the root after every set
+    virtual zkresult multiSet(const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog)
+    {
+        newRoots.clear();
+        Goldilocks::Element root[4] = {oldRoot[0], oldRoot[1], oldRoot[2], oldRoot[3]};
+        for (uint64_t i = 0; (i + 1) * 4 <= keys.size() && i < values.size(); i++)
+        {
+            Goldilocks::Element key[4] = {keys[4 * i], keys[4 * i + 1], keys[4 * i + 2], keys[4 * i + 3]};
+            Goldilocks::Element newRoot[4];
+            zkresult zkr = set(root, key, values[i], persistent, newRoot, NULL, dbReadLog);
+            if (zkr != ZKR_SUCCESS)
+                return zkr;
+            for (uint64_t j = 0; j < 4; j++)
+            {
+                root[j] = newRoot[j];
+                newRoots.push_back(newRoot[j]);
+            }
+        }
+        return ZKR_SUCCESS;
+    };
 };
 
 #endif
\ No newline at end of file
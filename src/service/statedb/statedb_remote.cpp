@@ -5,6 +5,7 @@
 #include "statedb_utils.hpp"
 #include "statedb_remote.hpp"
 #include "zkresult.hpp"
+#include "timer.hpp"
 
 using namespace std;
 using json = nlohmann::json;
@@ -12,14 +13,59 @@ using json = nlohmann::json;
 StateDBRemote::StateDBRemote (Goldilocks &fr, const Config &config) : fr(fr), config(config)
 {
     // Create channel
-    std::shared_ptr<grpc_impl::Channel> channel = ::grpc::CreateChannel(config.stateDBURL, grpc::InsecureChannelCredentials());
+    channel = ::grpc::CreateChannel(config.stateDBURL, grpc::InsecureChannelCredentials());
 
     // Create stub (i.e. client)
     stub = new statedb::v1::StateDBService::Stub(channel);
+
+    // Create the stream on the same channel, used by get, set, multiGet and multiSet
+    if (config.stateDBStreaming)
+    {
+        pStreamClient = std::make_shared<StateDBStreamClient>(channel);
+    }
+    gettimeofday(&lastStreamCreation, NULL);
+}
+
+StateDBRemote::~StateDBRemote ()
+{
+    // Closes the stream, waiting for the server to finish it, and joins its thread
+    pStreamClient.reset();
+    delete stub;
+}
+
+bool StateDBRemote::streamCall (const StateDBStreamWriter &request, string &response)
+{
+    std::shared_ptr<StateDBStreamClient> pClient;
+    {
+        lock_guard<mutex> guard(streamMutex);
+        if (pStreamClient == NULL)
+            return false;
+
+        // Re-create the stream if it failed; the previous one is freed by its last user
+        if (pStreamClient->broken())
+        {
+            if (TimeDiff(lastStreamCreation) < STATEDB_STREAM_RECONNECT_PERIOD*1000000)
+                return false;
+            cout << "StateDBRemote::streamCall() re-creating the stream to " << config.stateDBURL << endl;
+            pStreamClient = std::make_shared<StateDBStreamClient>(channel);
+            gettimeofday(&lastStreamCreation, NULL);
+        }
+        pClient = pStreamClient;
+    }
+    return pClient->call(request.data, response);
 }
 
 zkresult StateDBRemote::set (const Goldilocks::Element (&oldRoot)[4], const Goldilocks::Element (&key)[4], const mpz_class &value, const bool persistent, Goldilocks::Element (&newRoot)[4], SmtSetResult *result, DatabaseMap *dbReadLog)
 {
+    StateDBStreamWriter streamRequest;
+    string streamResponse;
+    stateDBStreamSetRequest(fr, streamRequest, oldRoot, key, value, persistent, ((result != NULL) ? STATEDB_STREAM_FLAG_DETAILS : 0) | ((dbReadLog != NULL) ? STATEDB_STREAM_FLAG_DB_READ_LOG : 0));
+    if (streamCall(streamRequest, streamResponse))
+    {
+        StateDBStreamReader r(streamResponse);
+        return stateDBStreamSetResponse(fr, r, newRoot, result, dbReadLog);
+    }
+
     ::grpc::ClientContext context;
     ::statedb::v1::SetRequest request;
     ::statedb::v1::SetResponse response;
@@ -79,6 +125,15 @@ zkresult StateDBRemote::set (const Goldilocks::Element (&oldRoot)[4], const Gold
 
 zkresult StateDBRemote::get (const Goldilocks::Element (&root)[4], const Goldilocks::Element (&key)[4], mpz_class &value, SmtGetResult *result, DatabaseMap *dbReadLog)
 {
+    StateDBStreamWriter streamRequest;
+    string streamResponse;
+    stateDBStreamGetRequest(fr, streamRequest, root, key, ((result != NULL) ? STATEDB_STREAM_FLAG_DETAILS : 0) | ((dbReadLog != NULL) ? STATEDB_STREAM_FLAG_DB_READ_LOG : 0));
+    if (streamCall(streamRequest, streamResponse))
+    {
+        StateDBStreamReader r(streamResponse);
+        return stateDBStreamGetResponse(fr, r, value, result, dbReadLog);
+    }
+
     ::grpc::ClientContext context;
     ::statedb::v1::GetRequest request;
     ::statedb::v1::GetResponse response;
@@ -213,4 +268,34 @@ void StateDBRemote::flush()
     ::google::protobuf::Empty request;
     ::google::protobuf::Empty response;
     stub->Flush(&context, request, &response);
+}
+
+zkresult StateDBRemote::multiGet (const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, vector<mpz_class> &values, DatabaseMap *dbReadLog)
+{
+    StateDBStreamWriter streamRequest;
+    string streamResponse;
+    stateDBStreamMultiGetRequest(fr, streamRequest, root, keys, (dbReadLog != NULL) ? STATEDB_STREAM_FLAG_DB_READ_LOG : 0);
+    if (streamCall(streamRequest, streamResponse))
+    {
+        StateDBStreamReader r(streamResponse);
+        return stateDBStreamMultiGetResponse(fr, r, values, dbReadLog);
+    }
+
+    // Without a stream, get the keys one by one
+    return StateDBInterface::multiGet(root, keys, values, dbReadLog);
+}
+
+zkresult StateDBRemote::multiSet (const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog)
+{
+    StateDBStreamWriter streamRequest;
+    string streamResponse;
+    stateDBStreamMultiSetRequest(fr, streamRequest, oldRoot, keys, values, persistent, (dbReadLog != NULL) ? STATEDB_STREAM_FLAG_DB_READ_LOG : 0);
+    if (streamCall(streamRequest, streamResponse))
+    {
+        StateDBStreamReader r(streamResponse);
+        return stateDBStreamMultiSetResponse(fr, r, newRoots, dbReadLog);
+    }
+
+    // Without a stream, set the keys one by one
+    return StateDBInterface::multiSet(oldRoot, keys, values, persistent, newRoots, dbReadLog);
 }
\ No newline at end of file
@@ -6,21 +6,35 @@
 #include <grpcpp/client_context.h>
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
+#include <sys/time.h>
 #include "statedb.grpc.pb.h"
 #include "goldilocks_base_field.hpp"
 #include "smt.hpp"
 #include "statedb_interface.hpp"
+#include "statedb_stream_client.hpp"
 #include "zkresult.hpp"
 
+#define STATEDB_STREAM_RECONNECT_PERIOD 1 // Minimum seconds between re-creations of a broken stream
+
 class StateDBRemote : public StateDBInterface
 {
 private:
     Goldilocks &fr;
     const Config &config;
+    std::shared_ptr<grpc::Channel> channel;
     ::statedb::v1::StateDBService::Stub *stub;
+    std::shared_ptr<StateDBStreamClient> pStreamClient; // NULL if config.stateDBStreaming is false
+    mutex streamMutex; // Mutex to protect pStreamClient and lastStreamCreation
+    struct timeval lastStreamCreation;
+
+    // Sends a request on the stream; returns false if there is no stream or it failed, so that the
+    // caller must use the unary RPCs. A broken stream is re-created, at most once every
+    // STATEDB_STREAM_RECONNECT_PERIOD seconds
+    bool streamCall(const StateDBStreamWriter &request, string &response);
 
 public:
     StateDBRemote(Goldilocks &fr, const Config &config);
+    ~StateDBRemote();
 
     zkresult set(const Goldilocks::Element (&oldRoot)[4], const Goldilocks::Element (&key)[4], const mpz_class &value, const bool persistent, Goldilocks::Element (&newRoot)[4], SmtSetResult *result, DatabaseMap *dbReadLog);
     zkresult get(const Goldilocks::Element (&root)[4], const Goldilocks::Element (&key)[4], mpz_class &value, SmtGetResult *result, DatabaseMap *dbReadLog);
@@ -29,6 +43,8 @@ public:
     void loadDB(const DatabaseMap::MTMap &input, const bool persistent);
     void loadProgramDB(const DatabaseMap::ProgramMap &input, const bool persistent);
     void flush();
+    zkresult multiGet(const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, vector<mpz_class> &values, DatabaseMap *dbReadLog);
+    zkresult multiSet(const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog);
 };
 
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <grpcpp/health_check_service_interface.h>
 #include "statedb_server.hpp"
 #include "statedb_service.hpp"
+#include "statedb_stream_server.hpp"
 
 using grpc::Server;
 using grpc::ServerBuilder;
@@ -33,14 +34,25 @@ void StateDBServer::run (void)
     // clients. In this case it corresponds to an *synchronous* service.
     builder.RegisterService(&service);
 
+    // Register the streaming protocol, served asynchronously on the same database, so that remote
+    // executors can keep many requests in flight on a single call
+    grpc::AsyncGenericService streamService;
+    builder.RegisterAsyncGenericService(&streamService);
+    std::unique_ptr<grpc::ServerCompletionQueue> cq = builder.AddCompletionQueue();
+
     // Finally assemble the server.
     std::unique_ptr<Server> server(builder.BuildAndStart());
 
     std::cout << "StateDB server listening on " << server_address << std::endl;
 
+    StateDBStreamServer streamServer(fr, config, service.getStateDB(), streamService, cq.get());
+    streamServer.runThreads();
+
     // Wait for the server to shutdown. Note that some other thread must be
     // responsible for shutting down the server for this call to ever return.
     server->Wait();
+    cq->Shutdown();
+    streamServer.waitForThreads();
 }
 
 void StateDBServer::runThread (void)
@@ -6,6 +6,7 @@
 #include "definitions.hpp"
 #include "scalar.hpp"
 #include "zkresult.hpp"
+#include "metrics.hpp"
 #include <iomanip>
 
 using grpc::Server;
@@ -16,6 +17,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::Set(::grpc::ServerContext* context, const ::statedb::v1::SetRequest* request, ::statedb::v1::SetResponse* response)
 {
+    MetricsHandlerTimer(StateDB_Set);
+
     SmtSetResult r;
     try {
         Goldilocks::Element oldRoot[4];
@@ -99,6 +102,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::Get(::grpc::ServerContext* context, const ::statedb::v1::GetRequest* request, ::statedb::v1::GetResponse* response)
 {
+    MetricsHandlerTimer(StateDB_Get);
+
     SmtGetResult r;
     try
     {
@@ -174,6 +179,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::SetProgram(::grpc::ServerContext* context, const ::statedb::v1::SetProgramRequest* request, ::statedb::v1::SetProgramResponse* response)
 {
+    MetricsHandlerTimer(StateDB_SetProgram);
+
     try
     {
         Goldilocks::Element key[4];
@@ -214,6 +221,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::GetProgram(::grpc::ServerContext* context, const ::statedb::v1::GetProgramRequest* request, ::statedb::v1::GetProgramResponse* response)
 {
+    MetricsHandlerTimer(StateDB_GetProgram);
+
     string sData;
     try
     {
@@ -252,6 +261,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::LoadDB(::grpc::ServerContext* context, const ::statedb::v1::LoadDBRequest* request, ::google::protobuf::Empty* response)
 {
+    MetricsHandlerTimer(StateDB_LoadDB);
+
 #ifdef LOG_STATEDB_SERVICE
     cout << "StateDBServiceImpl::LoadDB called." << endl;
 #endif
@@ -274,6 +285,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::LoadProgramDB(::grpc::ServerContext* context, const ::statedb::v1::LoadProgramDBRequest* request, ::google::protobuf::Empty* response)
 {
+    MetricsHandlerTimer(StateDB_LoadProgramDB);
+
 #ifdef LOG_STATEDB_SERVICE
     cout << "StateDBServiceImpl::LoadProgramDB called." << endl;
 #endif
@@ -288,6 +301,8 @@ using grpc::Status;
 
 ::grpc::Status StateDBServiceImpl::Flush(::grpc::ServerContext* context, const ::google::protobuf::Empty* request, ::google::protobuf::Empty* response)
 {
+    MetricsHandlerTimer(StateDB_Flush);
+
 #ifdef LOG_STATEDB_SERVICE
     cout << "StateDBServiceImpl::Flush called." << endl;
 #endif
@@ -0,0 +1,441 @@
+#include "statedb_stream.hpp"
+#include "scalar.hpp"
+#include "zkassert.hpp"
+
+// Operations
+//
+//     get      request:  root:fea key:fea flags:u8
+//              response: value:scalar [details] [dbReadLog:mtMap]
+//              details:  root:fea key:fea siblings insKey:fea insValue:scalar isOld0:u8 value:scalar proofHashCounter:u64
+//
+//     set      request:  oldRoot:fea key:fea value:scalar persistent:u8 flags:u8
+//              response: newRoot:fea [details] [dbReadLog:mtMap]
+//              details:  oldRoot:fea key:fea newRoot:fea siblings insKey:fea insValue:scalar isOld0:u8 oldValue:scalar
+//                        newValue:scalar mode:str proofHashCounter:u64
+//
+//     multiGet request:  root:fea n:u32 key:fea[n] flags:u8
+//              response: n:u32 value:scalar[n] [dbReadLog:mtMap]
+//
+//     multiSet request:  oldRoot:fea persistent:u8 n:u32 (key:fea value:scalar)[n] flags:u8
+//              response: n:u32 newRoot:fea[n] [dbReadLog:mtMap]
+//
+// A multiSet stops at the first failed set, so it returns the new roots of the sets done until then.
+// The details are only returned by get and set, and only if the result is ZKR_SUCCESS; the
+// dbReadLog, if requested, is always returned.
+
+void StateDBStreamWriter::scalar (const mpz_class &value)
+{
+    size_t size = (mpz_sizeinbase(value.get_mpz_t(), 2) + 7) / 8;
+    if (value == 0) size = 0;
+    u32(size);
+    if (size == 0) return;
+    uint64_t offset = data.size();
+    data.resize(offset + size);
+    size_t written = 0;
+    mpz_export(&data[offset], &written, 1, 1, 1, 0, value.get_mpz_t());
+    zkassert(written == size);
+}
+
+void StateDBStreamWriter::siblings (Goldilocks &fr, const map<uint64_t, vector<Goldilocks::Element>> &value)
+{
+    u32(value.size());
+    for (auto it = value.begin(); it != value.end(); it++)
+    {
+        u64(it->first);
+        u32(it->second.size());
+        for (uint64_t i = 0; i < it->second.size(); i++)
+            fe(fr, it->second[i]);
+    }
+}
+
+void StateDBStreamWriter::mtMap (Goldilocks &fr, const DatabaseMap::MTMap &value)
+{
+    u32(value.size());
+    for (auto it = value.begin(); it != value.end(); it++)
+    {
+        str(it->first);
+        u32(it->second.size());
+        for (uint64_t i = 0; i < it->second.size(); i++)
+            fe(fr, it->second[i]);
+    }
+}
+
+void StateDBStreamReader::scalar (mpz_class &value)
+{
+    uint32_t size = u32();
+    value = 0;
+    if ((size == 0) || !check(size)) return;
+    mpz_import(value.get_mpz_t(), size, 1, 1, 1, 0, p);
+    p += size;
+}
+
+void StateDBStreamReader::str (string &value)
+{
+    uint32_t size = u32();
+    value.clear();
+    if (!check(size)) return;
+    value.assign((const char *)p, size);
+    p += size;
+}
+
+void StateDBStreamReader::siblings (Goldilocks &fr, map<uint64_t, vector<Goldilocks::Element>> &value)
+{
+    value.clear();
+    uint32_t n = u32();
+    for (uint32_t i = 0; (i < n) && !bError; i++)
+    {
+        uint64_t level = u64();
+        uint32_t size = u32();
+        if (!check(uint64_t(size) * 8)) return;
+        vector<Goldilocks::Element> &list = value[level];
+        list.resize(size);
+        for (uint32_t j = 0; j < size; j++)
+            fe(fr, list[j]);
+    }
+}
+
+void StateDBStreamReader::mtMap (Goldilocks &fr, DatabaseMap::MTMap &value)
+{
+    value.clear();
+    uint32_t n = u32();
+    for (uint32_t i = 0; (i < n) && !bError; i++)
+    {
+        string key;
+        str(key);
+        uint32_t size = u32();
+        if (!check(uint64_t(size) * 8)) return;
+        vector<Goldilocks::Element> &list = value[key];
+        list.resize(size);
+        for (uint32_t j = 0; j < size; j++)
+            fe(fr, list[j]);
+    }
+}
+
+bool StateDBStreamReader::record (uint64_t &id, string &body)
+{
+    if (bError || eof()) return false;
+    id = u64();
+    str(body);
+    return !bError;
+}
+
+/******************/
+/* Request coding */
+/******************/
+
+void stateDBStreamGetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&root)[4], const Goldilocks::Element (&key)[4], uint8_t flags)
+{
+    w.u8(sso_get);
+    w.fea(fr, root);
+    w.fea(fr, key);
+    w.u8(flags);
+}
+
+void stateDBStreamSetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&oldRoot)[4], const Goldilocks::Element (&key)[4], const mpz_class &value, const bool persistent, uint8_t flags)
+{
+    w.u8(sso_set);
+    w.fea(fr, oldRoot);
+    w.fea(fr, key);
+    w.scalar(value);
+    w.u8(persistent ? 1 : 0);
+    w.u8(flags);
+}
+
+void stateDBStreamMultiGetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, uint8_t flags)
+{
+    w.u8(sso_multiGet);
+    w.fea(fr, root);
+    w.u32(keys.size() / 4);
+    for (uint64_t i = 0; i < (keys.size() / 4) * 4; i++)
+        w.fe(fr, keys[i]);
+    w.u8(flags);
+}
+
+void stateDBStreamMultiSetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, uint8_t flags)
+{
+    uint64_t n = min(keys.size() / 4, values.size());
+    w.u8(sso_multiSet);
+    w.fea(fr, oldRoot);
+    w.u8(persistent ? 1 : 0);
+    w.u32(n);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        for (uint64_t j = 0; j < 4; j++)
+            w.fe(fr, keys[4 * i + j]);
+        w.scalar(values[i]);
+    }
+    w.u8(flags);
+}
+
+/*******************/
+/* Response coding */
+/*******************/
+
+// Reads the header of a response and checks that it belongs to the expected operation
+static bool readResponseHeader (StateDBStreamReader &r, tStateDBStreamOp op, zkresult &zkr)
+{
+    uint8_t responseOp = r.u8();
+    zkr = (zkresult)r.u32();
+    if (r.error() || (responseOp != op))
+    {
+        cerr << "Error: StateDB stream got an invalid response header op=" << uint64_t(responseOp) << " expected=" << uint64_t(op) << endl;
+        zkr = ZKR_INTERNAL_ERROR;
+        return false;
+    }
+    return true;
+}
+
+static zkresult readDbReadLog (Goldilocks &fr, StateDBStreamReader &r, DatabaseMap *dbReadLog, zkresult zkr)
+{
+    if (dbReadLog != NULL)
+    {
+        DatabaseMap::MTMap mtMap;
+        r.mtMap(fr, mtMap);
+        if (!r.error())
+            dbReadLog->add(mtMap);
+    }
+    if (r.error())
+    {
+        cerr << "Error: StateDB stream got a truncated response" << endl;
+        return ZKR_INTERNAL_ERROR;
+    }
+    return zkr;
+}
+
+zkresult stateDBStreamGetResponse (Goldilocks &fr, StateDBStreamReader &r, mpz_class &value, SmtGetResult *result, DatabaseMap *dbReadLog)
+{
+    zkresult zkr;
+    if (!readResponseHeader(r, sso_get, zkr)) return zkr;
+
+    r.scalar(value);
+    if ((result != NULL) && (zkr == ZKR_SUCCESS))
+    {
+        r.fea(fr, result->root);
+        r.fea(fr, result->key);
+        r.siblings(fr, result->siblings);
+        r.fea(fr, result->insKey);
+        r.scalar(result->insValue);
+        result->isOld0 = r.u8();
+        r.scalar(result->value);
+        result->proofHashCounter = r.u64();
+    }
+    return readDbReadLog(fr, r, dbReadLog, zkr);
+}
+
+zkresult stateDBStreamSetResponse (Goldilocks &fr, StateDBStreamReader &r, Goldilocks::Element (&newRoot)[4], SmtSetResult *result, DatabaseMap *dbReadLog)
+{
+    zkresult zkr;
+    if (!readResponseHeader(r, sso_set, zkr)) return zkr;
+
+    r.fea(fr, newRoot);
+    if ((result != NULL) && (zkr == ZKR_SUCCESS))
+    {
+        r.fea(fr, result->oldRoot);
+        r.fea(fr, result->key);
+        r.fea(fr, result->newRoot);
+        r.siblings(fr, result->siblings);
+        r.fea(fr, result->insKey);
+        r.scalar(result->insValue);
+        result->isOld0 = r.u8();
+        r.scalar(result->oldValue);
+        r.scalar(result->newValue);
+        r.str(result->mode);
+        result->proofHashCounter = r.u64();
+    }
+    return readDbReadLog(fr, r, dbReadLog, zkr);
+}
+
+zkresult stateDBStreamMultiGetResponse (Goldilocks &fr, StateDBStreamReader &r, vector<mpz_class> &values, DatabaseMap *dbReadLog)
+{
+    zkresult zkr;
+    if (!readResponseHeader(r, sso_multiGet, zkr)) return zkr;
+
+    uint32_t n = r.u32();
+    values.clear();
+    for (uint32_t i = 0; (i < n) && !r.error(); i++)
+    {
+        mpz_class value;
+        r.scalar(value);
+        values.push_back(value);
+    }
+    return readDbReadLog(fr, r, dbReadLog, zkr);
+}
+
+zkresult stateDBStreamMultiSetResponse (Goldilocks &fr, StateDBStreamReader &r, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog)
+{
+    zkresult zkr;
+    if (!readResponseHeader(r, sso_multiSet, zkr)) return zkr;
+
+    uint32_t n = r.u32();
+    newRoots.clear();
+    for (uint64_t i = 0; (i < uint64_t(n) * 4) && !r.error(); i++)
+    {
+        Goldilocks::Element fe;
+        r.fe(fr, fe);
+        newRoots.push_back(fe);
+    }
+    return readDbReadLog(fr, r, dbReadLog, zkr);
+}
+
+/**********/
+/* Server */
+/**********/
+
+static void writeResponseHeader (StateDBStreamWriter &w, tStateDBStreamOp op, zkresult zkr)
+{
+    w.u8(op);
+    w.u32(zkr);
+}
+
+void stateDBStreamProcess (Goldilocks &fr, StateDBInterface &stateDB, const string &request, string &response)
+{
+    StateDBStreamReader r(request);
+    StateDBStreamWriter w;
+
+    uint8_t op = r.u8();
+    switch (op)
+    {
+        case sso_get:
+        {
+            Goldilocks::Element root[4];
+            Goldilocks::Element key[4];
+            r.fea(fr, root);
+            r.fea(fr, key);
+            uint8_t flags = r.u8();
+            if (r.error()) break;
+
+            SmtGetResult result;
+            DatabaseMap dbReadLog;
+            mpz_class value;
+            zkresult zkr = stateDB.get(root, key, value, &result, (flags & STATEDB_STREAM_FLAG_DB_READ_LOG) ? &dbReadLog : NULL);
+
+            writeResponseHeader(w, sso_get, zkr);
+            w.scalar(value);
+            if ((flags & STATEDB_STREAM_FLAG_DETAILS) && (zkr == ZKR_SUCCESS))
+            {
+                w.fea(fr, result.root);
+                w.fea(fr, result.key);
+                w.siblings(fr, result.siblings);
+                w.fea(fr, result.insKey);
+                w.scalar(result.insValue);
+                w.u8(result.isOld0 ? 1 : 0);
+                w.scalar(result.value);
+                w.u64(result.proofHashCounter);
+            }
+            if (flags & STATEDB_STREAM_FLAG_DB_READ_LOG)
+                w.mtMap(fr, dbReadLog.getMTDB());
+            response.swap(w.data);
+            return;
+        }
+        case sso_set:
+        {
+            Goldilocks::Element oldRoot[4];
+            Goldilocks::Element key[4];
+            mpz_class value;
+            r.fea(fr, oldRoot);
+            r.fea(fr, key);
+            r.scalar(value);
+            bool persistent = r.u8();
+            uint8_t flags = r.u8();
+            if (r.error()) break;
+
+            SmtSetResult result;
+            DatabaseMap dbReadLog;
+            Goldilocks::Element newRoot[4] = {fr.zero(), fr.zero(), fr.zero(), fr.zero()};
+            zkresult zkr = stateDB.set(oldRoot, key, value, persistent, newRoot, &result, (flags & STATEDB_STREAM_FLAG_DB_READ_LOG) ? &dbReadLog : NULL);
+
+            writeResponseHeader(w, sso_set, zkr);
+            w.fea(fr, newRoot);
+            if ((flags & STATEDB_STREAM_FLAG_DETAILS) && (zkr == ZKR_SUCCESS))
+            {
+                w.fea(fr, result.oldRoot);
+                w.fea(fr, result.key);
+                w.fea(fr, result.newRoot);
+                w.siblings(fr, result.siblings);
+                w.fea(fr, result.insKey);
+                w.scalar(result.insValue);
+                w.u8(result.isOld0 ? 1 : 0);
+                w.scalar(result.oldValue);
+                w.scalar(result.newValue);
+                w.str(result.mode);
+                w.u64(result.proofHashCounter);
+            }
+            if (flags & STATEDB_STREAM_FLAG_DB_READ_LOG)
+                w.mtMap(fr, dbReadLog.getMTDB());
+            response.swap(w.data);
+            return;
+        }
+        case sso_multiGet:
+        {
+            Goldilocks::Element root[4];
+            r.fea(fr, root);
+            uint32_t n = r.u32();
+            vector<Goldilocks::Element> keys;
+            for (uint64_t i = 0; (i < uint64_t(n) * 4) && !r.error(); i++)
+            {
+                Goldilocks::Element fe;
+                r.fe(fr, fe);
+                keys.push_back(fe);
+            }
+            uint8_t flags = r.u8();
+            if (r.error()) break;
+
+            DatabaseMap dbReadLog;
+            vector<mpz_class> values;
+            zkresult zkr = stateDB.multiGet(root, keys, values, (flags & STATEDB_STREAM_FLAG_DB_READ_LOG) ? &dbReadLog : NULL);
+
+            writeResponseHeader(w, sso_multiGet, zkr);
+            w.u32(values.size());
+            for (uint64_t i = 0; i < values.size(); i++)
+                w.scalar(values[i]);
+            if (flags & STATEDB_STREAM_FLAG_DB_READ_LOG)
+                w.mtMap(fr, dbReadLog.getMTDB());
+            response.swap(w.data);
+            return;
+        }
+        case sso_multiSet:
+        {
+            Goldilocks::Element oldRoot[4];
+            r.fea(fr, oldRoot);
+            bool persistent = r.u8();
+            uint32_t n = r.u32();
+            vector<Goldilocks::Element> keys;
+            vector<mpz_class> values;
+            for (uint32_t i = 0; (i < n) && !r.error(); i++)
+            {
+                for (uint64_t j = 0; j < 4; j++)
+                {
+                    Goldilocks::Element fe;
+                    r.fe(fr, fe);
+                    keys.push_back(fe);
+                }
+                mpz_class value;
+                r.scalar(value);
+                values.push_back(value);
+            }
+            uint8_t flags = r.u8();
+            if (r.error()) break;
+
+            DatabaseMap dbReadLog;
+            vector<Goldilocks::Element> newRoots;
+            zkresult zkr = stateDB.multiSet(oldRoot, keys, values, persistent, newRoots, (flags & STATEDB_STREAM_FLAG_DB_READ_LOG) ? &dbReadLog : NULL);
+
+            writeResponseHeader(w, sso_multiSet, zkr);
+            w.u32(newRoots.size() / 4);
+            for (uint64_t i = 0; i < newRoots.size(); i++)
+                w.fe(fr, newRoots[i]);
+            if (flags & STATEDB_STREAM_FLAG_DB_READ_LOG)
+                w.mtMap(fr, dbReadLog.getMTDB());
+            response.swap(w.data);
+            return;
+        }
+        default:
+            break;
+    }
+
+    // The request could not be decoded; answer with the op it claimed to be, so that the client
+    // fails this request only
+    cerr << "Error: stateDBStreamProcess() got an invalid request op=" << uint64_t(op) << " size=" << request.size() << endl;
+    writeResponseHeader(w, (tStateDBStreamOp)op, ZKR_INTERNAL_ERROR);
+    response.swap(w.data);
+}
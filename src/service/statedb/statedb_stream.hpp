@@ -0,0 +1,115 @@
+#ifndef STATEDB_STREAM_HPP
+#define STATEDB_STREAM_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <gmpxx.h>
+#include "goldilocks_base_field.hpp"
+#include "database_map.hpp"
+#include "smt.hpp"
+#include "zkresult.hpp"
+#include "statedb_interface.hpp"
+
+using namespace std;
+
+// StateDB streaming protocol
+//
+// A bidirectional gRPC stream of raw byte messages, served next to the StateDBService unary RPCs.
+// Every message carries one or more records, so that a client can send several requests, and a
+// server several responses, in a single message:
+//
+//     record   := id:u64 length:u32 body[length]
+//     request  := op:u8 ...arguments of the operation
+//     response := op:u8 result:u32 ...results of the operation
+//
+// The id is chosen by the client and copied in the response, so responses may come back in any
+// order and many requests can be outstanding on the same stream.
+// Integers are little endian, field elements are their canonical u64, and scalars are a u32 byte
+// count followed by their big endian bytes. See statedb_stream.cpp for the arguments and results
+// of every operation.
+
+#define STATEDB_STREAM_METHOD "/statedb.v1.StateDBStreamService/Stream"
+
+typedef enum : uint8_t
+{
+    sso_get = 1,
+    sso_set = 2,
+    sso_multiGet = 3, // Get several keys of the same root
+    sso_multiSet = 4  // Set several keys in sequence, each one on the root left by the previous one
+} tStateDBStreamOp;
+
+// Request flags
+#define STATEDB_STREAM_FLAG_DETAILS 0x01     // Return the SMT get/set result details
+#define STATEDB_STREAM_FLAG_DB_READ_LOG 0x02 // Return the database reads
+
+// Size of the record header: id and length
+#define STATEDB_STREAM_RECORD_HEADER_SIZE 12
+
+class StateDBStreamWriter
+{
+public:
+    string data;
+
+    void u8 (uint8_t value) { data.push_back((char)value); };
+    void u32 (uint32_t value) { data.append((const char *)&value, sizeof(value)); };
+    void u64 (uint64_t value) { data.append((const char *)&value, sizeof(value)); };
+    void fe (Goldilocks &fr, const Goldilocks::Element &value) { u64(fr.toU64(value)); };
+    void fea (Goldilocks &fr, const Goldilocks::Element (&value)[4]) { for (uint64_t i = 0; i < 4; i++) fe(fr, value[i]); };
+    void scalar (const mpz_class &value);
+    void str (const string &value) { u32(value.size()); data.append(value); };
+    void siblings (Goldilocks &fr, const map<uint64_t, vector<Goldilocks::Element>> &value);
+    void mtMap (Goldilocks &fr, const DatabaseMap::MTMap &value);
+
+    // Appends a record with the given id and body
+    void record (uint64_t id, const string &body) { u64(id); u32(body.size()); data.append(body); };
+};
+
+// Reads fields in the writer format; a read past the end sets bError and returns zeros, so
+// callers can check for errors once, after reading the whole message
+class StateDBStreamReader
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    bool bError;
+
+    bool check (uint64_t size) { if (bError || (uint64_t)(end - p) < size) { bError = true; return false; } return true; };
+
+public:
+    StateDBStreamReader (const string &data) : p((const uint8_t *)data.data()), end((const uint8_t *)data.data() + data.size()), bError(false) {};
+    StateDBStreamReader (const uint8_t *data, uint64_t size) : p(data), end(data + size), bError(false) {};
+
+    bool error (void) { return bError; };
+    bool eof (void) { return p == end; };
+
+    uint8_t u8 (void) { if (!check(1)) return 0; return *p++; };
+    uint32_t u32 (void) { uint32_t value = 0; if (check(sizeof(value))) { memcpy(&value, p, sizeof(value)); p += sizeof(value); } return value; };
+    uint64_t u64 (void) { uint64_t value = 0; if (check(sizeof(value))) { memcpy(&value, p, sizeof(value)); p += sizeof(value); } return value; };
+    void fe (Goldilocks &fr, Goldilocks::Element &value) { value = fr.fromU64(u64()); };
+    void fea (Goldilocks &fr, Goldilocks::Element (&value)[4]) { for (uint64_t i = 0; i < 4; i++) fe(fr, value[i]); };
+    void scalar (mpz_class &value);
+    void str (string &value);
+    void siblings (Goldilocks &fr, map<uint64_t, vector<Goldilocks::Element>> &value);
+    void mtMap (Goldilocks &fr, DatabaseMap::MTMap &value);
+
+    // Reads the next record of a message; returns false at the end of the message or on error
+    bool record (uint64_t &id, string &body);
+};
+
+// Encoding of the requests, used by the client
+void stateDBStreamGetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&root)[4], const Goldilocks::Element (&key)[4], uint8_t flags);
+void stateDBStreamSetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&oldRoot)[4], const Goldilocks::Element (&key)[4], const mpz_class &value, const bool persistent, uint8_t flags);
+void stateDBStreamMultiGetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&root)[4], const vector<Goldilocks::Element> &keys, uint8_t flags);
+void stateDBStreamMultiSetRequest (Goldilocks &fr, StateDBStreamWriter &w, const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &keys, const vector<mpz_class> &values, const bool persistent, uint8_t flags);
+
+// Decoding of the responses, used by the client; they return ZKR_INTERNAL_ERROR if the response is malformed
+zkresult stateDBStreamGetResponse (Goldilocks &fr, StateDBStreamReader &r, mpz_class &value, SmtGetResult *result, DatabaseMap *dbReadLog);
+zkresult stateDBStreamSetResponse (Goldilocks &fr, StateDBStreamReader &r, Goldilocks::Element (&newRoot)[4], SmtSetResult *result, DatabaseMap *dbReadLog);
+zkresult stateDBStreamMultiGetResponse (Goldilocks &fr, StateDBStreamReader &r, vector<mpz_class> &values, DatabaseMap *dbReadLog);
+zkresult stateDBStreamMultiSetResponse (Goldilocks &fr, StateDBStreamReader &r, vector<Goldilocks::Element> &newRoots, DatabaseMap *dbReadLog);
+
+// Executes a request body on stateDB and returns the response body, used by the server
+void stateDBStreamProcess (Goldilocks &fr, StateDBInterface &stateDB, const string &request, string &response);
+
+#endif
@@ -0,0 +1,232 @@
+#include "statedb_stream_client.hpp"
+#include "statedb_utils.hpp"
+
+StateDBStreamClient::StateDBStreamClient (shared_ptr<grpc::Channel> channel) :
+    stub(channel),
+    nextId(0),
+    bStarted(false),
+    bWriting(false),
+    bBroken(false),
+    bClosing(false),
+    bFinished(false)
+{
+    startTag = {this, StateDBStreamClientTag::eStart};
+    readTag = {this, StateDBStreamClientTag::eRead};
+    writeTag = {this, StateDBStreamClientTag::eWrite};
+    writesDoneTag = {this, StateDBStreamClientTag::eWritesDone};
+    finishTag = {this, StateDBStreamClientTag::eFinish};
+
+    stream = stub.PrepareCall(&context, STATEDB_STREAM_METHOD, &cq);
+    if (stream == nullptr)
+    {
+        cerr << "Error: StateDBStreamClient::StateDBStreamClient() failed calling PrepareCall()" << endl;
+        bBroken = true;
+        bFinished = true;
+        cq.Shutdown();
+    }
+    else
+    {
+        stream->StartCall(&startTag);
+    }
+    pthread_create(&cqPthread, NULL, stateDBStreamClientCQThread, this);
+}
+
+StateDBStreamClient::~StateDBStreamClient ()
+{
+    // Half-close the stream, so that the server finishes it, which shuts down the completion queue;
+    // if it is not finished in time, cancel the call, which fails its pending operations
+    {
+        unique_lock<mutex> guard(mlock);
+        bClosing = true;
+        if (bStarted && !bWriting)
+        {
+            writesDone();
+        }
+        if (!cv.wait_for(guard, chrono::seconds(STATEDB_STREAM_CLOSE_TIMEOUT), [this]{ return bFinished; }))
+        {
+            context.TryCancel();
+        }
+    }
+    pthread_join(cqPthread, NULL);
+}
+
+void StateDBStreamClient::startWrite (void)
+{
+    string data;
+    data.swap(outBuffer.data);
+    string2byteBuffer(data, writeBuffer);
+    bWriting = true;
+    stream->Write(writeBuffer, &writeTag);
+}
+
+void StateDBStreamClient::writesDone (void)
+{
+    if (bBroken)
+        return;
+    bWriting = true;
+    stream->WritesDone(&writesDoneTag);
+}
+
+void StateDBStreamClient::fail (const string &reason)
+{
+    if (bBroken)
+        return;
+    if (!bClosing)
+    {
+        cerr << "Error: StateDBStreamClient " << reason << "; falling back to unary calls" << endl;
+    }
+    bBroken = true;
+    outBuffer.data.clear();
+    for (auto it = pendingRequests.begin(); it != pendingRequests.end(); it++)
+    {
+        if (it->second->bDone)
+            continue;
+        it->second->bFailed = true;
+        it->second->bDone = true;
+    }
+    cv.notify_all();
+}
+
+bool StateDBStreamClient::call (const string &request, string &response)
+{
+    unique_lock<mutex> guard(mlock);
+    if (bBroken)
+        return false;
+
+    PendingRequest pendingRequest = {"", false, false};
+    uint64_t id = nextId++;
+    pendingRequests[id] = &pendingRequest;
+    outBuffer.record(id, request);
+    if (bStarted && !bWriting)
+    {
+        startWrite();
+    }
+
+    bool bDone = cv.wait_for(guard, chrono::seconds(STATEDB_STREAM_CALL_TIMEOUT), [&pendingRequest]{ return pendingRequest.bDone; });
+    pendingRequests.erase(id);
+    if (!bDone)
+    {
+        // The stream is stuck; fail the rest of the requests and cancel it, so that it finishes
+        fail("got no response to request id=" + to_string(id) + " in " + to_string(STATEDB_STREAM_CALL_TIMEOUT) + " s");
+        context.TryCancel();
+        return false;
+    }
+    if (pendingRequest.bFailed)
+        return false;
+    response.swap(pendingRequest.response);
+    return true;
+}
+
+void StateDBStreamClient::proceed (StateDBStreamClientTag *pTag, bool ok)
+{
+    lock_guard<mutex> guard(mlock);
+    switch (pTag->type)
+    {
+        case StateDBStreamClientTag::eStart:
+        {
+            if (!ok)
+            {
+                fail("failed starting the stream");
+                stream->Finish(&status, &finishTag);
+                return;
+            }
+            bStarted = true;
+            stream->Read(&readBuffer, &readTag);
+            if (!outBuffer.data.empty())
+            {
+                startWrite();
+            }
+            else if (bClosing)
+            {
+                writesDone();
+            }
+            return;
+        }
+        case StateDBStreamClientTag::eRead:
+        {
+            if (!ok)
+            {
+                fail("stream closed by the server");
+                stream->Finish(&status, &finishTag);
+                return;
+            }
+            string message;
+            byteBuffer2string(readBuffer, message);
+            StateDBStreamReader r(message);
+            uint64_t id;
+            string body;
+            while (r.record(id, body))
+            {
+                auto it = pendingRequests.find(id);
+                if (it == pendingRequests.end())
+                {
+                    cerr << "Error: StateDBStreamClient::proceed() got a response with unknown id=" << id << endl;
+                    continue;
+                }
+                it->second->response.swap(body);
+                it->second->bDone = true;
+            }
+            if (r.error())
+            {
+                fail("got a malformed message");
+                context.TryCancel();
+            }
+            cv.notify_all();
+            stream->Read(&readBuffer, &readTag);
+            return;
+        }
+        case StateDBStreamClientTag::eWrite:
+        {
+            bWriting = false;
+            if (!ok)
+            {
+                // The read will fail too, and finish the stream
+                fail("failed writing to the stream");
+                return;
+            }
+            if (!bBroken && !outBuffer.data.empty())
+            {
+                startWrite();
+            }
+            else if (bClosing)
+            {
+                writesDone();
+            }
+            return;
+        }
+        case StateDBStreamClientTag::eWritesDone:
+        {
+            // The server finishes the stream once it has answered all the requests, and then the read
+            // fails; bWriting stays set, since nothing can be written after WritesDone()
+            if (!ok)
+            {
+                fail("failed closing the stream");
+            }
+            return;
+        }
+        case StateDBStreamClientTag::eFinish:
+        {
+            if (!status.ok())
+            {
+                cerr << "Error: StateDBStreamClient stream finished with code=" << status.error_code() << " message=" << status.error_message() << endl;
+            }
+            bFinished = true;
+            cv.notify_all();
+            cq.Shutdown();
+            return;
+        }
+    }
+}
+
+void* stateDBStreamClientCQThread (void* arg)
+{
+    StateDBStreamClient *pClient = (StateDBStreamClient *)arg;
+    void *tag;
+    bool ok;
+    while (pClient->getCQ().Next(&tag, &ok))
+    {
+        StateDBStreamClientTag *pTag = (StateDBStreamClientTag *)tag;
+        pTag->pClient->proceed(pTag, ok);
+    }
+    return NULL;
+}
@@ -0,0 +1,86 @@
+#ifndef STATEDB_STREAM_CLIENT_HPP
+#define STATEDB_STREAM_CLIENT_HPP
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include "statedb_stream.hpp"
+
+using namespace std;
+
+#define STATEDB_STREAM_CALL_TIMEOUT 60 // Seconds a request waits for its response; after it, the stream is considered broken
+#define STATEDB_STREAM_CLOSE_TIMEOUT 5 // Seconds the destructor waits for the server to finish the stream before cancelling it
+
+class StateDBStreamClient;
+
+// Completion queue tag of an operation of the stream
+struct StateDBStreamClientTag
+{
+    StateDBStreamClient *pClient;
+    enum { eStart, eRead, eWrite, eWritesDone, eFinish } type;
+};
+
+// Client side of the StateDB streaming protocol (see statedb_stream.hpp).
+// It keeps one stream open for the life of the client, and many threads can send requests on it at
+// the same time: every request gets an id, and its caller waits until the response with that id
+// arrives. There is at most one write in flight; the requests sent meanwhile are coalesced in the
+// next message. If the stream fails, or a request gets no response in STATEDB_STREAM_CALL_TIMEOUT
+// seconds, all the waiting and future requests fail, so that the caller can fall back to the unary
+// RPCs and create a new client. The destructor half-closes the stream and waits for the server to
+// finish it
+class StateDBStreamClient
+{
+    struct PendingRequest
+    {
+        string response;
+        bool bDone;
+        bool bFailed;
+    };
+
+    grpc::GenericStub stub;
+    grpc::ClientContext context;
+    grpc::CompletionQueue cq;
+    unique_ptr<grpc::GenericClientAsyncReaderWriter> stream;
+    grpc::Status status;
+    StateDBStreamClientTag startTag, readTag, writeTag, writesDoneTag, finishTag;
+    pthread_t cqPthread;
+
+    mutex mlock; // Protects the fields below
+    condition_variable cv; // Signaled when a response arrives or the stream fails
+    uint64_t nextId;
+    unordered_map<uint64_t, PendingRequest *> pendingRequests;
+    StateDBStreamWriter outBuffer; // Requests not yet written
+    grpc::ByteBuffer readBuffer;
+    grpc::ByteBuffer writeBuffer;
+    bool bStarted;
+    bool bWriting;
+    bool bBroken;
+    bool bClosing; // The destructor has been called
+    bool bFinished; // The completion queue has been shut down
+
+    // Must be called with the mutex locked
+    void startWrite (void);
+    void writesDone (void);
+    void fail (const string &reason);
+
+public:
+    StateDBStreamClient (shared_ptr<grpc::Channel> channel);
+    ~StateDBStreamClient ();
+
+    // Sends a request body and waits for its response body; returns false if the stream failed
+    bool call (const string &request, string &response);
+
+    // Returns true if the stream failed, so no more requests can be sent on it
+    bool broken (void) { lock_guard<mutex> guard(mlock); return bBroken; };
+
+    grpc::CompletionQueue & getCQ (void) { return cq; };
+
+    // Called by the completion queue thread
+    void proceed (StateDBStreamClientTag *pTag, bool ok);
+};
+
+void* stateDBStreamClientCQThread (void* arg);
+
+#endif
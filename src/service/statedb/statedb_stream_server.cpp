@@ -0,0 +1,315 @@
+#include "statedb_stream_server.hpp"
+#include "statedb_stream.hpp"
+#include "statedb_utils.hpp"
+#include "zkassert.hpp"
+
+using grpc::GenericServerContext;
+using grpc::GenericServerAsyncReaderWriter;
+using grpc::ByteBuffer;
+using grpc::Status;
+
+// Completion queue tag of an operation of a stream
+struct StateDBStreamTag
+{
+    StateDBStreamCall *pCall;
+    enum { eNewCall, eRead, eWrite, eFinish } type;
+};
+
+// One stream, from the moment the server accepts it until it is finished.
+// There is at most one read and one write outstanding, as gRPC requires; the responses produced
+// while a write is in flight are coalesced in the next message. The stream is finished once the
+// client has half-closed it, and all its records have been processed and their responses written.
+// A malformed message stops the reading: none of its records is processed, and the stream is
+// finished with INVALID_ARGUMENT once the records of the previous messages have been processed
+class StateDBStreamCall
+{
+    StateDBStreamServer &server;
+    GenericServerContext context;
+    GenericServerAsyncReaderWriter stream;
+    StateDBStreamTag newCallTag, readTag, writeTag, finishTag;
+
+    pthread_mutex_t mutex; // Mutex to protect the fields below, accessed by the workers
+    ByteBuffer readBuffer;
+    ByteBuffer writeBuffer;
+    StateDBStreamWriter pendingOutput; // Responses not yet written
+    uint64_t processing; // Records queued or being processed
+    bool bReadsDone;
+    bool bWriting;
+    bool bFinishing;
+    bool bBroken; // A write failed, so the client is gone
+    bool bInvalid; // A malformed message was received
+
+    void lock (void) { pthread_mutex_lock(&mutex); };
+    void unlock (void) { pthread_mutex_unlock(&mutex); };
+
+    // Must be called with the mutex locked
+    void startWrite (void)
+    {
+        string data;
+        data.swap(pendingOutput.data);
+        string2byteBuffer(data, writeBuffer);
+        bWriting = true;
+        stream.Write(writeBuffer, &writeTag);
+    }
+
+    // Must be called with the mutex locked
+    void finishIfDone (void)
+    {
+        if (bReadsDone && (processing == 0) && !bWriting && !bFinishing)
+        {
+            bFinishing = true;
+            stream.Finish(bInvalid ? Status(grpc::StatusCode::INVALID_ARGUMENT, "malformed message") : Status::OK, &finishTag);
+        }
+    }
+
+public:
+    StateDBStreamCall (StateDBStreamServer &server) :
+        server(server),
+        stream(&context),
+        processing(0),
+        bReadsDone(false),
+        bWriting(false),
+        bFinishing(false),
+        bBroken(false),
+        bInvalid(false)
+    {
+        newCallTag = {this, StateDBStreamTag::eNewCall};
+        readTag = {this, StateDBStreamTag::eRead};
+        writeTag = {this, StateDBStreamTag::eWrite};
+        finishTag = {this, StateDBStreamTag::eFinish};
+        pthread_mutex_init(&mutex, NULL);
+        server.service.RequestCall(&context, &stream, server.cq, server.cq, &newCallTag);
+    }
+
+    ~StateDBStreamCall ()
+    {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // Called by the completion queue thread
+    void proceed (StateDBStreamTag *pTag, bool ok)
+    {
+        switch (pTag->type)
+        {
+            case StateDBStreamTag::eNewCall:
+            {
+                // The completion queue is shutting down
+                if (!ok)
+                {
+                    delete this;
+                    return;
+                }
+
+                // Be ready for the next stream
+                new StateDBStreamCall(server);
+
+                if (context.method() != STATEDB_STREAM_METHOD)
+                {
+                    cerr << "Error: StateDBStreamCall::proceed() got an unknown method=" << context.method() << endl;
+                    lock();
+                    bFinishing = true;
+                    stream.Finish(Status(grpc::StatusCode::UNIMPLEMENTED, "unknown method"), &finishTag);
+                    unlock();
+                    return;
+                }
+
+                stream.Read(&readBuffer, &readTag);
+                return;
+            }
+            case StateDBStreamTag::eRead:
+            {
+                if (!ok)
+                {
+                    lock();
+                    bReadsDone = true;
+                    finishIfDone();
+                    unlock();
+                    return;
+                }
+
+                // Split the message into records and queue them for the workers
+                string message;
+                byteBuffer2string(readBuffer, message);
+                StateDBStreamReader r(message);
+                vector<StateDBStreamWork> records;
+                StateDBStreamWork record;
+                record.pCall = this;
+                while (r.record(record.id, record.body))
+                {
+                    records.push_back(record);
+                }
+                if (r.error())
+                {
+                    // Do not apply a part of the message, and stop reading
+                    cerr << "Error: StateDBStreamCall::proceed() got a malformed message of size=" << message.size() << "; finishing the stream" << endl;
+                    lock();
+                    bInvalid = true;
+                    bReadsDone = true;
+                    finishIfDone();
+                    unlock();
+                    return;
+                }
+
+                lock();
+                processing += records.size();
+                unlock();
+
+                server.lock();
+                for (uint64_t i = 0; i < records.size(); i++)
+                {
+                    server.work.push_back(records[i]);
+                }
+                server.unlock();
+                for (uint64_t i = 0; i < records.size(); i++)
+                {
+                    sem_post(&server.workSem);
+                }
+
+                stream.Read(&readBuffer, &readTag);
+                return;
+            }
+            case StateDBStreamTag::eWrite:
+            {
+                lock();
+                bWriting = false;
+                if (!ok)
+                {
+                    bBroken = true;
+                    pendingOutput.data.clear();
+                }
+                if (!pendingOutput.data.empty())
+                {
+                    startWrite();
+                }
+                finishIfDone();
+                unlock();
+                return;
+            }
+            case StateDBStreamTag::eFinish:
+            {
+                delete this;
+                return;
+            }
+        }
+    }
+
+    // Called by a worker thread
+    void process (uint64_t id, const string &body)
+    {
+        string response;
+        stateDBStreamProcess(server.fr, server.stateDB, body, response);
+
+        // No operation can be started once the completion queue is shut down
+        server.lock();
+        bool bStopping = server.bStopping;
+        server.unlock();
+
+        lock();
+        processing--;
+        if (!bBroken && !bStopping)
+        {
+            pendingOutput.record(id, response);
+            if (!bWriting)
+            {
+                startWrite();
+            }
+        }
+        finishIfDone();
+        unlock();
+    }
+};
+
+StateDBStreamServer::StateDBStreamServer (Goldilocks &fr, const Config &config, StateDBInterface &stateDB, grpc::AsyncGenericService &service, grpc::ServerCompletionQueue *cq) :
+    fr(fr),
+    config(config),
+    stateDB(stateDB),
+    service(service),
+    cq(cq),
+    bStopping(false)
+{
+    pthread_mutex_init(&mutex, NULL);
+    sem_init(&workSem, 0, 0);
+}
+
+StateDBStreamServer::~StateDBStreamServer ()
+{
+    sem_destroy(&workSem);
+    pthread_mutex_destroy(&mutex);
+}
+
+void StateDBStreamServer::runThreads (void)
+{
+    new StateDBStreamCall(*this);
+
+    pthread_create(&cqPthread, NULL, stateDBStreamCQThread, this);
+
+    uint64_t nWorkers = (config.maxStateDBThreads > 0) ? config.maxStateDBThreads : 1;
+    workerPthreads.resize(nWorkers);
+    for (uint64_t i = 0; i < nWorkers; i++)
+    {
+        pthread_create(&workerPthreads[i], NULL, stateDBStreamWorkerThread, this);
+    }
+}
+
+void StateDBStreamServer::waitForThreads (void)
+{
+    pthread_join(cqPthread, NULL);
+    for (uint64_t i = 0; i < workerPthreads.size(); i++)
+    {
+        pthread_join(workerPthreads[i], NULL);
+    }
+    workerPthreads.clear();
+}
+
+void StateDBStreamServer::stop (void)
+{
+    lock();
+    bStopping = true;
+    unlock();
+    for (uint64_t i = 0; i < workerPthreads.size(); i++)
+    {
+        sem_post(&workSem);
+    }
+}
+
+void* stateDBStreamCQThread (void* arg)
+{
+    StateDBStreamServer *pServer = (StateDBStreamServer *)arg;
+    void *tag;
+    bool ok;
+    while (pServer->cq->Next(&tag, &ok))
+    {
+        StateDBStreamTag *pTag = (StateDBStreamTag *)tag;
+        pTag->pCall->proceed(pTag, ok);
+    }
+    pServer->stop();
+    return NULL;
+}
+
+void* stateDBStreamWorkerThread (void* arg)
+{
+    StateDBStreamServer *pServer = (StateDBStreamServer *)arg;
+    while (true)
+    {
+        sem_wait(&pServer->workSem);
+        pServer->lock();
+        if (pServer->bStopping)
+        {
+            // The queued records are dropped, since their responses could not be written
+            pServer->work.clear();
+            pServer->unlock();
+            break;
+        }
+        if (pServer->work.empty())
+        {
+            pServer->unlock();
+            continue;
+        }
+        StateDBStreamWork w = pServer->work.front();
+        pServer->work.pop_front();
+        pServer->unlock();
+
+        w.pCall->process(w.id, w.body);
+    }
+    return NULL;
+}
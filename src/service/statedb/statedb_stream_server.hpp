@@ -0,0 +1,66 @@
+#ifndef STATEDB_STREAM_SERVER_HPP
+#define STATEDB_STREAM_SERVER_HPP
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/generic/async_generic_service.h>
+#include <semaphore.h>
+#include <deque>
+#include "goldilocks_base_field.hpp"
+#include "config.hpp"
+#include "statedb_interface.hpp"
+
+using namespace std;
+
+class StateDBStreamCall;
+
+// A request record received on a stream, waiting for a worker
+struct StateDBStreamWork
+{
+    StateDBStreamCall *pCall;
+    uint64_t id;
+    string body;
+};
+
+// Serves the StateDB streaming protocol (see statedb_stream.hpp) on a generic async service
+// registered in the same server as StateDBService.
+// One thread serves the completion queue, reading messages and splitting them into records, and a
+// pool of config.maxStateDBThreads workers executes the records and writes their responses back
+class StateDBStreamServer
+{
+public:
+    Goldilocks &fr;
+    const Config &config;
+    StateDBInterface &stateDB;
+    grpc::AsyncGenericService &service;
+    grpc::ServerCompletionQueue *cq;
+
+    pthread_mutex_t mutex; // Mutex to protect the work queue and bStopping
+    sem_t workSem; // Semaphore to wake up a worker when a record is queued, or when stopping
+    deque<StateDBStreamWork> work;
+    bool bStopping; // The completion queue has been shut down, so the workers must exit
+
+private:
+    pthread_t cqPthread;
+    vector<pthread_t> workerPthreads;
+
+public:
+    StateDBStreamServer (Goldilocks &fr, const Config &config, StateDBInterface &stateDB, grpc::AsyncGenericService &service, grpc::ServerCompletionQueue *cq);
+    ~StateDBStreamServer ();
+
+    // Starts accepting streams, and the completion queue and worker threads
+    void runThreads (void);
+
+    // Returns when the completion queue has been shut down and all the threads have exited
+    void waitForThreads (void);
+
+    // Called by the completion queue thread once the queue is drained; wakes up the workers to exit
+    void stop (void);
+
+    void lock (void) { pthread_mutex_lock(&mutex); };
+    void unlock (void) { pthread_mutex_unlock(&mutex); };
+};
+
+void* stateDBStreamCQThread (void* arg);
+void* stateDBStreamWorkerThread (void* arg);
+
+#endif
@@ -75,3 +75,22 @@ void grpc2programMap(Goldilocks &fr, const ::PROTOBUF_NAMESPACE_ID::Map<string,
 }
 
 
+
+void byteBuffer2string(const ::grpc::ByteBuffer &buffer, string &data)
+{
+    data.clear();
+    vector<::grpc::Slice> slices;
+    if (!buffer.Dump(&slices).ok()) return;
+    data.reserve(buffer.Length());
+    for (uint64_t i = 0; i < slices.size(); i++)
+    {
+        data.append((const char *)slices[i].begin(), slices[i].size());
+    }
+}
+
+void string2byteBuffer(const string &data, ::grpc::ByteBuffer &buffer)
+{
+    ::grpc::Slice slice(data);
+    ::grpc::ByteBuffer result(&slice, 1);
+    buffer.Swap(&result);
+}
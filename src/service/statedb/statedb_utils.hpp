@@ -2,6 +2,7 @@
 #define STATEDB_UTILS_HPP
 
 #include "statedb.grpc.pb.h"
+#include <grpcpp/support/byte_buffer.h>
 #include "goldilocks_base_field.hpp"
 #include <google/protobuf/port_def.inc>
 #include "database.hpp"
@@ -14,5 +15,7 @@ void mtMap2grpc(Goldilocks &fr, const DatabaseMap::MTMap &map, ::PROTOBUF_NAMESP
 void programMap2grpc(Goldilocks &fr, const DatabaseMap::ProgramMap &map, ::PROTOBUF_NAMESPACE_ID::Map<string, string> *grpcMap);
 void grpc2mtMap(Goldilocks &fr, const ::PROTOBUF_NAMESPACE_ID::Map<string, ::statedb::v1::FeList> &grpcMap, DatabaseMap::MTMap &map);
 void grpc2programMap(Goldilocks &fr, const ::PROTOBUF_NAMESPACE_ID::Map<string, string> &grpcMap, DatabaseMap::ProgramMap &map);
+void byteBuffer2string(const ::grpc::ByteBuffer &buffer, string &data);
+void string2byteBuffer(const string &data, ::grpc::ByteBuffer &buffer);
 
 #endif
@@ -12,6 +12,7 @@
 #include "timer.hpp"
 #include "time_metric.hpp"
 #include "eval_command.hpp"
+#include "memory_size.hpp"
 
 using namespace std;
 
@@ -324,9 +325,9 @@ void FullTracer::onError(Context &ctx, const RomCommand &cmd)
     }
     else
     {
-        if (info.size() > 0)
+        if (records.size() > 0)
         {
-            info[info.size() - 1].error = lastError;
+            records[records.size() - 1].error = errorIndex(lastError);
         }
 
         // Revert logs
@@ -507,6 +508,14 @@ void FullTracer::onProcessTx(Context &ctx, const RomCommand &cmd)
     response.call_trace.steps.clear();
     response.execution_trace.clear();
 
+    // Only the steps of the tx whose traces were requested are kept in detail
+    bTraceTx = ctx.proverRequest.generateCallTraces() &&
+               ( (response.tx_hash == ctx.proverRequest.input.txHashToGenerateExecuteTrace) ||
+                 (response.tx_hash == ctx.proverRequest.input.txHashToGenerateCallTrace) );
+    txFirstRecord = records.size();
+    extras.clear();
+    storageJournal.clear();
+
     // Create current tx object
     finalTrace.responses.push_back(response);
     txTime = getCurrentTime();
@@ -551,6 +560,16 @@ void FullTracer::onUpdateStorage(Context &ctx, const RomCommand &cmd)
 
     deltaStorage[depth][key] = value;
 
+    if (bTraceTx)
+    {
+        StorageJournalEntry entry;
+        entry.depth = depth;
+        entry.bReset = false;
+        entry.key = key;
+        entry.value = value;
+        storageJournal.push_back(entry);
+    }
+
 #ifdef LOG_FULL_TRACER
     cout << "FullTracer::onUpdateStorage() depth=" << depth << " key=" << key << " value=" << value << endl;
 #endif
@@ -616,41 +635,28 @@ void FullTracer::onFinishTx(Context &ctx, const RomCommand &cmd)
     response.state_root = Add0xIfMissing(auxScalar.get_str(16));
 
     // If processed opcodes
-    if (info.size() > 0)
+    if (records.size() > 0)
     {
-        Opcode lastOpcode = info[info.size() - 1];
+        const OpcodeRecord &lastOpcode = records[records.size() - 1];
 
         // set refunded gas
-        response.gas_refunded = lastOpcode.gas_refund;
-
-        // Set gas price of last opcode
-        if (info.size() >= 2)
-        {
-            Opcode beforeLastOpcode = info[info.size() - 2];
-            lastOpcode.gas_cost = beforeLastOpcode.gas - lastOpcode.gas;
-        }
+        response.gas_refunded = lastOpcode.gasRefund;
 
-        // Add last opcode
-        call_trace.push_back(lastOpcode);
-        execution_trace.push_back(lastOpcode);
-        if (call_trace.size() < info.size())
+        // Append processed opcodes to the transaction object, if requested
+        if (bTraceTx)
         {
-            call_trace.erase(call_trace.begin());
-            execution_trace.erase(execution_trace.begin());
+            materializeTx(finalTrace.responses[finalTrace.responses.size() - 1]);
         }
-
-        // Append processed opcodes to the transaction object
-        finalTrace.responses[finalTrace.responses.size() - 1].execution_trace = execution_trace;
-        finalTrace.responses[finalTrace.responses.size() - 1].call_trace.steps = call_trace;
         if (finalTrace.responses[finalTrace.responses.size() - 1].error == "")
         {
-            finalTrace.responses[finalTrace.responses.size() - 1].error = lastOpcode.error;
+            finalTrace.responses[finalTrace.responses.size() - 1].error = errorName(lastOpcode.error);
         }
     }
 
-    // Clean aux array for next iteration
-    call_trace.clear();
-    execution_trace.clear();
+    // Clean aux arrays for next iteration
+    bTraceTx = false;
+    extras.clear();
+    storageJournal.clear();
 
     // Append to response logs
     unordered_map<uint64_t, std::unordered_map<uint64_t, Log>>::iterator logIt;
@@ -751,11 +757,11 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&t, NULL);
 #endif
-    Opcode singleInfo;
+    OpcodeRecord record;
 
     if (ctx.proverRequest.input.bNoCounters)
     {
-        info.push_back(singleInfo);
+        records.push_back(record);
 #ifdef LOG_TIME_STATISTICS
         tms.add("onOpcode", TimeDiff(t));
 #endif
@@ -792,9 +798,15 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    // Get opcode name into singleInfo.opcode
-    singleInfo.opcode = opcodeName[codeId].pName;
+    // Get opcode name index into record.name
+    record.name = codeId;
+    record.flags |= OPCODE_RECORD_FLAG_NAME;
+    if (opIncContext.find(opcodeName[codeId].pName) != opIncContext.end())
+    {
+        record.flags |= OPCODE_RECORD_FLAG_INC_CONTEXT;
+    }
     codeId = opcodeName[codeId].codeID;
+    record.op = codeId;
 
 #ifdef LOG_TIME_STATISTICS
     tmsop.add("getCodeName", TimeDiff(top));
@@ -849,8 +861,8 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
     // Get stack address
     //uint64_t addr = offsetCtx + 0x10000;
 
-    vector<mpz_class> finalStack;
     /*
+    vector<mpz_class> finalStack;
     if (ctx.proverRequest.generateCallTraces())
     {
         uint16_t sp = fr.toU64(ctx.pols.SP[*ctx.pStep]);
@@ -879,10 +891,10 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
     // add info opcodes
     getVarFromCtx(ctx, true, ctx.rom.depthOffset, auxScalar);
     depth = auxScalar.get_ui();
-    singleInfo.depth = depth + 1;
-    singleInfo.pc = fr.toU64(ctx.pols.PC[*ctx.pStep]);
-    singleInfo.gas = fr.toU64(ctx.pols.GAS[*ctx.pStep]);
-    gettimeofday(&singleInfo.startTime, NULL);
+    record.depth = depth + 1;
+    record.pc = fr.toU64(ctx.pols.PC[*ctx.pStep]);
+    record.gas = fr.toU64(ctx.pols.GAS[*ctx.pStep]);
+    gettimeofday(&record.startTime, NULL);
 
 #ifdef LOG_TIME_STATISTICS
     tmsop.add("getDepth", TimeDiff(top));
@@ -890,29 +902,28 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    // cout << "singleInfo.remaining_gas=" << singleInfo.remaining_gas << endl;
-    if (info.size() > 0)
+    if (records.size() > 0)
     {
+        OpcodeRecord &prevRecord = records[records.size() - 1];
+
         // The gas cost of the opcode is gas before - gas after processing the opcode
-        info[info.size() - 1].gas_cost = int64_t(info[info.size() - 1].gas) - fr.toS64(ctx.pols.GAS[*ctx.pStep]);
-        // cout << "info[info.size() - 1].gas_cost=" << info[info.size() - 1].gas_cost << endl;
+        prevRecord.gasCost = int64_t(prevRecord.gas) - fr.toS64(ctx.pols.GAS[*ctx.pStep]);
 
         // If negative gasCost means gas has been added from a deeper context, we should recalculate
-        if (info[info.size() - 1].gas_cost < 0)
+        if (prevRecord.gasCost < 0)
         {
-            if (info.size() > 1)
+            if (records.size() > 1)
             {
-                Opcode beforePrevTrace = info[info.size() - 2];
-                info[info.size() - 1].gas_cost = beforePrevTrace.gas - info[info.size() - 1].gas;
+                prevRecord.gasCost = records[records.size() - 2].gas - prevRecord.gas;
             }
             else
             {
                 cout << "Warning: FullTracer::onOpcode() could not calculate prevTrace.gas_cost" << endl;
-                info[info.size() - 1].gas_cost = 0;
+                prevRecord.gasCost = 0;
             }
         }
 
-        info[info.size() - 1].duration = TimeDiff(info[info.size() - 1].startTime, singleInfo.startTime);
+        prevRecord.duration = TimeDiff(prevRecord.startTime, record.startTime);
     }
 
 #ifdef LOG_TIME_STATISTICS
@@ -924,11 +935,8 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
     if (ctx.proverRequest.generateCallTraces())
     {
         getVarFromCtx(ctx, false, ctx.rom.gasRefundOffset, auxScalar);
-        singleInfo.gas_refund = auxScalar.get_ui();
-
-        singleInfo.op = codeId;
+        record.gasRefund = auxScalar.get_ui();
     }
-    //singleInfo.error = "";
 
 #ifdef LOG_TIME_STATISTICS
     tmsop.add("getRefund", TimeDiff(top));
@@ -936,10 +944,11 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    if (ctx.proverRequest.generateCallTraces())
+    OpcodeExtra extra;
+    if (bTraceTx)
     {
         fea2scalar(ctx.fr, auxScalar, ctx.pols.SR0[*ctx.pStep], ctx.pols.SR1[*ctx.pStep], ctx.pols.SR2[*ctx.pStep], ctx.pols.SR3[*ctx.pStep], ctx.pols.SR4[*ctx.pStep], ctx.pols.SR5[*ctx.pStep], ctx.pols.SR6[*ctx.pStep], ctx.pols.SR7[*ctx.pStep]);
-        singleInfo.state_root = /*"0x" +*/ auxScalar.get_str(16);//Add0xIfMissing(auxScalar.get_str(16));
+        extra.stateRoot = /*"0x" +*/ auxScalar.get_str(16);//Add0xIfMissing(auxScalar.get_str(16));
     }
 
 #ifdef LOG_TIME_STATISTICS
@@ -949,18 +958,18 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
     gettimeofday(&top, NULL);
 #endif
     // Add contract info
-    if (ctx.proverRequest.generateCallTraces())
+    if (bTraceTx)
     {
         getVarFromCtx(ctx, false, ctx.rom.txDestAddrOffset, auxScalar);
-        singleInfo.contract.address = auxScalar.get_str(16);
+        extra.contractAddress = auxScalar.get_str(16);
 
         getVarFromCtx(ctx, false, ctx.rom.txSrcAddrOffset, auxScalar);
-        singleInfo.contract.caller = auxScalar.get_str(16);
+        extra.contractCaller = auxScalar.get_str(16);
 
         getVarFromCtx(ctx, false, ctx.rom.txValueOffset, auxScalar);
-        singleInfo.contract.value = auxScalar;
+        extra.contractValue = auxScalar;
 
-        getCalldataFromStack(ctx, 0, 0, singleInfo.contract.data);
+        getCalldataFromStack(ctx, 0, 0, extra.contractData);
     }
 
 #ifdef LOG_TIME_STATISTICS
@@ -969,15 +978,17 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    singleInfo.contract.gas = txGAS[depth];
+    record.contractGas = txGAS[depth];
 
-    if (ctx.proverRequest.generateCallTraces())
+    if (bTraceTx)
     {
-        singleInfo.storage = deltaStorage[depth];
+        // Instead of a copy of the storage deltas, keep a position in the journal to rebuild them
+        extra.storageDepth = depth;
+        extra.storageJournalSize = storageJournal.size();
 
         // Round up to next multiple of 32
         getVarFromCtx(ctx, false, ctx.rom.memLengthOffset, auxScalar);
-        singleInfo.memory_size = (auxScalar.get_ui() / 32) * 32;
+        record.memorySize = (auxScalar.get_ui() / 32) * 32;
     }
 
 #ifdef LOG_TIME_STATISTICS
@@ -986,32 +997,12 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    info.push_back(singleInfo);
-    fullStack.push_back(finalStack);
-
-    // build trace
-    uint64_t index = fullStack.size();
-
-    if (index > 1)
+    if (bTraceTx)
     {
-        Opcode singleCallTrace = info[index - 2];
-        /*if (ctx.proverRequest.generateCallTraces())
-        {
-            singleCallTrace.stack = finalStack;
-            singleCallTrace.memory = finalMemory;
-        }*/
-
-        Opcode singleExecuteTrace = info[index - 2];
-        singleCallTrace.storage.clear();
-        singleCallTrace.memory_size = 0;
-        singleExecuteTrace.contract.address.clear();
-        singleExecuteTrace.contract.caller.clear();
-        singleExecuteTrace.contract.data.clear();
-        singleExecuteTrace.contract.gas = 0;
-        singleExecuteTrace.contract.value = 0;
-        call_trace.push_back(singleCallTrace);
-        execution_trace.push_back(singleExecuteTrace);
+        extras.push_back(extra);
+        record.extra = extras.size();
     }
+    records.push_back(record);
 
 #ifdef LOG_TIME_STATISTICS
     tmsop.add("getMore2", TimeDiff(top));
@@ -1019,22 +1010,14 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    // Return data
-    singleInfo.return_data.clear();
-
     // Check previous step
-    if (info.size() >= 2)
+    if (records.size() >= 2)
     {
-        Opcode prevStep = info[info.size() - 2];
-        if (opIncContext.find(prevStep.opcode) != opIncContext.end())
+        if (records[records.size() - 2].flags & OPCODE_RECORD_FLAG_INC_CONTEXT)
         {
             // Set gasCall when depth has changed
             getVarFromCtx(ctx, true, ctx.rom.gasCallOffset, auxScalar);
             txGAS[depth] = auxScalar.get_ui();
-            if (ctx.proverRequest.generateCallTraces())
-            {
-                singleInfo.contract.gas = txGAS[depth];
-            }
         }
     }
 
@@ -1044,19 +1027,244 @@ void FullTracer::onOpcode(Context &ctx, const RomCommand &cmd)
 #ifdef LOG_TIME_STATISTICS
     gettimeofday(&top, NULL);
 #endif
-    if (opIncContext.find(singleInfo.opcode) != opIncContext.end())
+    if (record.flags & OPCODE_RECORD_FLAG_INC_CONTEXT)
     {
         unordered_map<string, string> auxMap;
         deltaStorage[depth + 1] = auxMap;
+
+        if (bTraceTx)
+        {
+            StorageJournalEntry entry;
+            entry.depth = depth + 1;
+            entry.bReset = true;
+            storageJournal.push_back(entry);
+        }
     }
 
 #ifdef LOG_TIME_STATISTICS
     tmsop.add("setDeltaStorage", TimeDiff(top));
 #endif
 #ifdef LOG_FULL_TRACER
-    cout << "FullTracer::onOpcode() codeId=" << to_string(codeId) << " opcode=" << singleInfo.opcode << endl;
+    cout << "FullTracer::onOpcode() codeId=" << to_string(codeId) << " opcode=" << opcodeName[record.name].pName << endl;
 #endif
 #ifdef LOG_TIME_STATISTICS
     tms.add("onOpcode", TimeDiff(t));
 #endif
 }
+
+uint32_t FullTracer::errorIndex (const string &error)
+{
+    if (error.empty())
+        return 0;
+
+    // There are only a few distinct errors, so a linear search is enough
+    for (uint64_t i = 0; i < errors.size(); i++)
+    {
+        if (errors[i] == error)
+            return i + 1;
+    }
+    errors.push_back(error);
+    return errors.size();
+}
+
+const string & FullTracer::errorName (uint32_t index)
+{
+    static const string noError;
+    if (index == 0)
+        return noError;
+    zkassert(index <= errors.size());
+    return errors[index - 1];
+}
+
+void FullTracer::materializeTx (Response &response)
+{
+    response.call_trace.steps.clear();
+    response.execution_trace.clear();
+
+    // Storage deltas of every depth, rebuilt by replaying the journal up to every opcode
+    unordered_map<uint64_t, unordered_map<string, string>> storage;
+    uint64_t journalPosition = 0;
+
+    for (uint64_t i = txFirstRecord; i < records.size(); i++)
+    {
+        const OpcodeRecord &record = records[i];
+        bool bLast = (i == records.size() - 1);
+
+        Opcode opcode;
+        opcode.gas = record.gas;
+        opcode.gas_cost = record.gasCost;
+        opcode.depth = record.depth;
+        opcode.pc = record.pc;
+        opcode.op = record.op;
+        opcode.opcode = (record.flags & OPCODE_RECORD_FLAG_NAME) ? opcodeName[record.name].pName : NULL;
+        opcode.gas_refund = record.gasRefund;
+        opcode.error = errorName(record.error);
+        opcode.contract.gas = record.contractGas;
+        opcode.memory_size = record.memorySize;
+        opcode.startTime = record.startTime;
+        opcode.duration = record.duration;
+
+        if (record.extra > 0)
+        {
+            const OpcodeExtra &extra = extras[record.extra - 1];
+            opcode.state_root = extra.stateRoot;
+            opcode.contract.address = extra.contractAddress;
+            opcode.contract.caller = extra.contractCaller;
+            opcode.contract.value = extra.contractValue;
+            opcode.contract.data = extra.contractData;
+
+            for (; journalPosition < extra.storageJournalSize; journalPosition++)
+            {
+                const StorageJournalEntry &entry = storageJournal[journalPosition];
+                if (entry.bReset)
+                    storage[entry.depth].clear();
+                else
+                    storage[entry.depth][entry.key] = entry.value;
+            }
+            opcode.storage = storage[extra.storageDepth];
+        }
+
+        // The gas cost of the last opcode is computed against the previous one
+        if (bLast && (records.size() >= 2))
+        {
+            opcode.gas_cost = records[i - 1].gas - record.gas;
+        }
+
+        // The call trace steps carry no storage nor memory size, and the execution trace steps no
+        // contract, except for the last opcode
+        Opcode executeStep = opcode;
+        if (!bLast)
+        {
+            opcode.storage.clear();
+            opcode.memory_size = 0;
+            executeStep.contract.address.clear();
+            executeStep.contract.caller.clear();
+            executeStep.contract.data.clear();
+            executeStep.contract.gas = 0;
+            executeStep.contract.value = 0;
+        }
+        response.call_trace.steps.push_back(opcode);
+        response.execution_trace.push_back(executeStep);
+    }
+}
+
+static uint64_t opcodeMemorySize (const Opcode &opcode)
+{
+    return memorySize(opcode.state_root) +
+           memorySize(opcode.error) +
+           memorySize(opcode.contract.address) +
+           memorySize(opcode.contract.caller) +
+           memorySize(opcode.contract.value) +
+           memorySize(opcode.contract.data) +
+           memorySize(opcode.stack) +
+           memorySize(opcode.memory) +
+           memorySize(opcode.storage) +
+           memorySize(opcode.return_data);
+}
+
+static uint64_t opcodesMemorySize (const vector<Opcode> &opcodes)
+{
+    uint64_t size = opcodes.capacity() * sizeof(Opcode);
+    for (uint64_t i = 0; i < opcodes.size(); i++)
+        size += opcodeMemorySize(opcodes[i]);
+    return size;
+}
+
+static uint64_t logMemorySize (const Log &log)
+{
+    return memorySize(log.address) +
+           memorySize(log.tx_hash) +
+           memorySize(log.batch_hash) +
+           memorySize(log.data) +
+           memorySize(log.topics);
+}
+
+static uint64_t logsMemorySize (const vector<Log> &logs)
+{
+    uint64_t size = logs.capacity() * sizeof(Log);
+    for (uint64_t i = 0; i < logs.size(); i++)
+        size += logMemorySize(logs[i]);
+    return size;
+}
+
+static uint64_t responseMemorySize (const Response &response)
+{
+    const TxTraceContext &context = response.call_trace.context;
+    return memorySize(context.type) +
+           memorySize(context.from) +
+           memorySize(context.to) +
+           memorySize(context.data) +
+           memorySize(context.value) +
+           memorySize(context.batch) +
+           memorySize(context.output) +
+           memorySize(context.gas_price) +
+           memorySize(context.old_state_root) +
+           memorySize(context.error) +
+           logsMemorySize(context.logs) +
+           opcodesMemorySize(response.call_trace.steps) +
+           memorySize(response.tx_hash) +
+           memorySize(response.rlp_tx) +
+           memorySize(response.return_value) +
+           memorySize(response.error) +
+           memorySize(response.create_address) +
+           memorySize(response.state_root) +
+           logsMemorySize(response.logs) +
+           opcodesMemorySize(response.execution_trace);
+}
+
+uint64_t FullTracer::memorySize (void) const
+{
+    uint64_t size = 0;
+
+    size += unorderedMapNodesSize(deltaStorage);
+    for (auto it = deltaStorage.begin(); it != deltaStorage.end(); it++)
+        size += ::memorySize(it->second);
+
+    size += ::memorySize(finalTrace.new_state_root) +
+            ::memorySize(finalTrace.new_local_exit_root) +
+            ::memorySize(finalTrace.newAccInputHash) +
+            ::memorySize(finalTrace.new_acc_input_hash) +
+            ::memorySize(finalTrace.error);
+    size += finalTrace.responses.capacity() * sizeof(Response);
+    for (uint64_t i = 0; i < finalTrace.responses.size(); i++)
+        size += responseMemorySize(finalTrace.responses[i]);
+
+    size += unorderedMapNodesSize(txGAS);
+    size += records.capacity() * sizeof(OpcodeRecord);
+    size += extras.capacity() * sizeof(OpcodeExtra);
+    for (uint64_t i = 0; i < extras.size(); i++)
+        size += ::memorySize(extras[i].stateRoot) +
+                ::memorySize(extras[i].contractAddress) +
+                ::memorySize(extras[i].contractCaller) +
+                ::memorySize(extras[i].contractValue) +
+                ::memorySize(extras[i].contractData);
+    size += storageJournal.capacity() * sizeof(StorageJournalEntry);
+    for (uint64_t i = 0; i < storageJournal.size(); i++)
+        size += ::memorySize(storageJournal[i].key) + ::memorySize(storageJournal[i].value);
+    size += ::memorySize(errors);
+
+    size += unorderedMapNodesSize(logs);
+    for (auto it = logs.begin(); it != logs.end(); it++)
+    {
+        size += unorderedMapNodesSize(it->second);
+        for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++)
+            size += logMemorySize(it2->second);
+    }
+
+    size += ::memorySize(lastError);
+
+    return size;
+}
+
+void FullTracer::release (void)
+{
+    // Swap with empty containers, since clear() keeps the capacity
+    unordered_map<uint64_t,unordered_map<string,string>>().swap(deltaStorage);
+    vector<Response>().swap(finalTrace.responses);
+    unordered_map<uint64_t,uint64_t>().swap(txGAS);
+    vector<OpcodeRecord>().swap(records);
+    vector<OpcodeExtra>().swap(extras);
+    vector<StorageJournalEntry>().swap(storageJournal);
+    vector<string>().swap(errors);
+    unordered_map<uint64_t,unordered_map<uint64_t,Log>>().swap(logs);
+}
@@ -49,6 +49,54 @@ public:
     Opcode() : gas(0), gas_cost(0), depth(0), pc(0), op(0), gas_refund(0), memory_size(0), startTime({0,0}), duration(0) {};
 };
 
+// Compact trace of an executed opcode, recorded for every opcode of the batch. The full Opcode
+// objects are only built, from these records, for the steps of the tx whose traces were requested
+#define OPCODE_RECORD_FLAG_NAME 0x01 // name is valid; not set when counters are not generated
+#define OPCODE_RECORD_FLAG_INC_CONTEXT 0x02 // The opcode opens a new context, e.g. CALL or CREATE
+
+class OpcodeRecord
+{
+public:
+    uint64_t gas;
+    int64_t gasCost;
+    uint64_t pc;
+    uint64_t gasRefund;
+    uint64_t contractGas;
+    uint64_t memorySize;
+    struct timeval startTime;
+    uint64_t duration;
+    uint32_t depth;
+    uint32_t error; // 1 + index in FullTracer::errors, or 0 if none
+    uint32_t extra; // 1 + index in FullTracer::extras, or 0 if none
+    uint8_t name; // Index in opcodeName
+    uint8_t op;
+    uint8_t flags;
+    OpcodeRecord() : gas(0), gasCost(0), pc(0), gasRefund(0), contractGas(0), memorySize(0), startTime({0,0}), duration(0), depth(0), error(0), extra(0), name(0), op(0), flags(0) {};
+};
+
+// Call trace data of an opcode of the traced tx
+class OpcodeExtra
+{
+public:
+    string stateRoot;
+    string contractAddress;
+    string contractCaller;
+    mpz_class contractValue;
+    string contractData;
+    uint64_t storageDepth; // Depth whose storage deltas the opcode sees
+    uint64_t storageJournalSize; // Storage journal entries recorded before the opcode
+};
+
+// Storage update, or reset of the storage deltas of a depth when a new context starts there
+class StorageJournalEntry
+{
+public:
+    uint64_t depth;
+    bool bReset;
+    string key;
+    string value;
+};
+
 class Log
 {
 public:
@@ -137,12 +185,14 @@ public:
     unordered_map<uint64_t,uint64_t> txGAS;
     uint64_t txCount;
     uint64_t txTime; // in us
-    vector<Opcode> info; // Opcode step traces of the all the processed tx
-    vector<vector<mpz_class>> fullStack;// Stack of the transaction
+    vector<OpcodeRecord> records; // Opcode step traces of all the processed txs
+    vector<OpcodeExtra> extras; // Call trace data of the opcodes of the traced tx
+    vector<StorageJournalEntry> storageJournal; // Storage deltas of the traced tx
+    vector<string> errors; // Distinct opcode errors, referenced by the records
+    uint64_t txFirstRecord; // Index of the first record of the current tx
+    bool bTraceTx; // The current tx is the one whose execute or call traces were requested
     uint64_t accBatchGas;
     unordered_map<uint64_t,unordered_map<uint64_t,Log>> logs;
-    vector<Opcode> call_trace; // TODO: Can we remove this attribute?
-    vector<Opcode> execution_trace; // TODO: Can we remove this attribute?
     string lastError;
 #ifdef LOG_TIME_STATISTICS
     TimeMetricStorage tms;
@@ -160,7 +210,16 @@ public:
     void onFinishBatch (Context &ctx, const RomCommand &cmd);
     void onOpcode (Context &ctx, const RomCommand &cmd);
 
-    FullTracer(Goldilocks &fr) : fr(fr), depth(1), initGas(0), txCount(0), txTime(0), accBatchGas(0) { };
+private:
+    uint32_t errorIndex (const string &error);
+    const string & errorName (uint32_t index);
+
+    // Builds the steps of the current tx from its records, in response.call_trace.steps and
+    // response.execution_trace
+    void materializeTx (Response &response);
+
+public:
+    FullTracer(Goldilocks &fr) : fr(fr), depth(1), initGas(0), txCount(0), txTime(0), txFirstRecord(0), bTraceTx(false), accBatchGas(0) { };
     ~FullTracer()
     {
 #ifdef LOG_TIME_STATISTICS
@@ -171,6 +230,12 @@ public:
     
     void handleEvent (Context &ctx, const RomCommand &cmd);
 
+    // Returns the heap bytes retained by the traces
+    uint64_t memorySize (void) const;
+
+    // Frees the traces, once they are no longer needed
+    void release (void);
+
     FullTracer & operator =(const FullTracer & other)
     {
         depth           = other.depth;
@@ -180,12 +245,14 @@ public:
         txGAS           = other.txGAS;
         txCount         = other.txCount;
         txTime          = other.txTime;
-        info            = other.info;
-        fullStack       = other.fullStack;
+        records         = other.records;
+        extras          = other.extras;
+        storageJournal  = other.storageJournal;
+        errors          = other.errors;
+        txFirstRecord   = other.txFirstRecord;
+        bTraceTx        = other.bTraceTx;
         accBatchGas     = other.accBatchGas;
         logs            = other.logs;
-        call_trace      = other.call_trace;
-        execution_trace = other.execution_trace;
         lastError       = other.lastError;
         return *this;
     }
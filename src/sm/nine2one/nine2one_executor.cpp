@@ -2,6 +2,7 @@
 #include "nine2one_executor.hpp"
 #include "zkassert.hpp"
 #include "utils.hpp"
+#include <string.h>
 
 /*
     This SM inserts 44 bits of 44 different Keccak-f inputs/outputs in the lower bits of a field element.
@@ -36,6 +37,34 @@
     etc.
 */
 
+/* Lookup table to expand a byte into 8 bytes, one per bit, least significant bit first */
+class ByteBitsTable
+{
+public:
+    uint64_t bits[256];
+    ByteBitsTable ()
+    {
+        for (uint64_t b=0; b<256; b++)
+        {
+            bits[b] = 0;
+            for (uint64_t k=0; k<8; k++)
+            {
+                bits[b] |= ((b >> k) & 1) << (8*k);
+            }
+        }
+    }
+};
+
+static const ByteBitsTable byteBitsTable;
+
+void bytes2Bits (const uint8_t *pBytes, uint64_t nBytes, uint8_t *pBits)
+{
+    for (uint64_t i=0; i<nBytes; i++)
+    {
+        memcpy(pBits + 8*i, &byteBitsTable.bits[pBytes[i]], 8);
+    }
+}
+
 void Nine2OneExecutor::execute (vector<Nine2OneExecutorInput> &input, Nine2OneCommitPols &pols, vector<vector<Goldilocks::Element>> &required)
 {
     /* Check input size (the number of keccaks blocks to process) is not bigger than
@@ -46,110 +75,107 @@ void Nine2OneExecutor::execute (vector<Nine2OneExecutorInput> &input, Nine2OneCo
         exitProcess();
     }
 
-    /* Evaluation counter.  The first position is skipped since it will contain the Zero^One gate in Keccak-f SM*/
-    uint64_t p = 1;
-
-    /* Accumulator field element */
-    Goldilocks::Element accField = fr.zero();
+    /* Every slot adds one required input for the keccak-f SM, in slot order */
+    uint64_t requiredOffset = required.size();
+    required.resize(requiredOffset + nSlots);
 
-    /* For every slot i */
-    for (uint64_t i=0; i<nSlots; i++)
+#pragma omp parallel
     {
-        vector<Goldilocks::Element> keccakFSlot;
+        /* Bits of the input and output states of the 44 blocks of the current slot */
+        vector<uint8_t> bitsBuffer(2*44*1600);
+        uint8_t (*bits)[44][1600] = (uint8_t (*)[44][1600])bitsBuffer.data();
 
-        /* For every input bit */
-        for (uint64_t j=0; j<1600; j++)
+        /* For every slot i */
+#pragma omp for schedule(static)
+        for (uint64_t i=0; i<nSlots; i++)
         {
-            /* For every field element bit */
-            for (uint64_t k=0; k<44; k++)
-            {
-                /* Get this input bit and store it in pols.bit[] */
-                pols.bit[p] = getBit(input, i*44 + k, false, j);
+            slotBits(input, i, bits);
 
-                /* Store the accumulated field in pols.field44[] */
-                pols.field44[p] = accField;
+            /* Evaluation counter.  The first position is skipped since it will contain the Zero^One gate in Keccak-f SM,
+               and every slot uses slotSize evaluations */
+            uint64_t p = 1 + i*slotSize;
 
-                /* Add this bit to accField, left-shifting the rest */
-                if (k == 0)
-                {
-                    accField = pols.bit[p];
-                }
-                else
-                {
-                    accField = fr.add( accField, fr.fromU64(fr.toU64(pols.bit[p]) << k) );
-                }
+            /* Accumulator field element */
+            uint64_t accField = 0;
 
-                /* Increment the pol evaluation counter */
-                p++;
-            }
-
-            /* Store the accField in the input vector for the keccak-f SM */
-            keccakFSlot.push_back(accField);
-        }
+            vector<Goldilocks::Element> &keccakFSlot = required[requiredOffset + i];
+            keccakFSlot.resize(1600);
 
-        /* For every output bit */
-        for (uint64_t j=0; j<1600; j++)
-        {
-            /* For every field element bit */
-            for (uint64_t k=0; k<44; k++)
+            /* For every input bit, and then for every output bit */
+            for (uint64_t isOut=0; isOut<2; isOut++)
             {
-                /* Get this output bit and store it in pols.bit[] */
-                pols.bit[p] = getBit(input, i*44 + k, true, j);
-
-                /* Store the accumulated field in pols.field44[] */
-                pols.field44[p] = accField;
-
-                /* Add this bit to accField, left-shifting the rest */
-                if (k == 0)
+                for (uint64_t j=0; j<1600; j++)
                 {
-                    accField = pols.bit[p];
+                    /* For every field element bit */
+                    for (uint64_t k=0; k<44; k++)
+                    {
+                        /* Get this bit and store it in pols.bit[] */
+                        uint64_t bit = bits[isOut][k][j];
+                        pols.bit[p] = fr.fromU64(bit);
+
+                        /* Store the accumulated field in pols.field44[] */
+                        pols.field44[p] = fr.fromU64(accField);
+
+                        /* Add this bit to accField, left-shifting the rest */
+                        if (k == 0)
+                        {
+                            accField = bit;
+                        }
+                        else
+                        {
+                            accField += bit << k;
+                        }
+
+                        /* Increment the pol evaluation counter */
+                        p++;
+                    }
+
+                    /* Store the accField in the input vector for the keccak-f SM */
+                    if (isOut == 0)
+                    {
+                        keccakFSlot[j] = fr.fromU64(accField);
+                    }
                 }
-                else
-                {
-                    accField = fr.add( accField, fr.fromU64((fr.toU64(pols.bit[p]) << k)) );
-                }
-
-                /* Increment the pol evaluation counter */
-                p++;
             }
-        }
-
-        /* Add the accumulated field elements as a required input for the keccak-f SM */
-        required.push_back(keccakFSlot);
 
-        /* Store the accumulated field into pols.field44[] */
-        pols.field44[p] = accField;
-        accField = fr.zero();
-        p++;
+            /* Store the accumulated field into pols.field44[] */
+            pols.field44[p] = fr.fromU64(accField);
+            p++;
 
-        /* Skip the rest of the gates of the keccak-f SM: slot size minus the consumed evaluations */
-        p += slotSize - (3200*44+1);
+            /* Sanity check */
+            zkassert(p <= N);
+        }
     }
 
-    /* Sanity check */
-    zkassert(p <= N);
-
     cout << "Nine2OneExecutor successfully processed " << input.size() << " Keccak hashes (" << (double(input.size())*slotSize*100)/(44*N) << "%)" << endl;
 }
 
-Goldilocks::Element Nine2OneExecutor::getBit (vector<Nine2OneExecutorInput> &input, uint64_t block, bool isOut, uint64_t pos)
+void Nine2OneExecutor::slotBits (vector<Nine2OneExecutorInput> &input, uint64_t slot, uint8_t (*bits)[44][1600])
 {
-    /* If we run out of input, simply return zero */
-    if (block >= input.size())
+    for (uint64_t isOut=0; isOut<2; isOut++)
     {
-        return fr.zero();
-    }
+        for (uint64_t k=0; k<44; k++)
+        {
+            uint64_t block = slot*44 + k;
 
-    /* Return the bit "pos" of the input or output part of the state */
-    return bitFromState(isOut ? input[block].st[1] : input[block].st[0], pos);
-}
+            /* If we run out of input, simply use zeros */
+            if (block >= input.size())
+            {
+                memset(bits[isOut][k], 0, 1600);
+                continue;
+            }
 
-Goldilocks::Element Nine2OneExecutor::bitFromState (uint64_t (&st)[5][5][2], uint64_t i)
-{
-    uint64_t y  = i/320;
-    uint64_t x  = (i%320)/64;
-    uint64_t z  = i%64;
-    uint64_t z1 = z/32; /* First 32 bits of z are stored in st[x][y][0], second 32 bits of z are stored in st[x][y][0] */
-    uint64_t z2 = z%32; /* z2 is the number of the bit: 0...32 */
-    return fr.fromU64((st[x][y][z1] >> z2) & 1);
+            /* State bit i is bit z=i%64 of lane x + 5*y, where the lane is split into 2 chunks of 32 bits */
+            uint64_t (&st)[5][5][2] = input[block].st[isOut];
+            uint64_t lanes[25];
+            for (uint64_t y=0; y<5; y++)
+            {
+                for (uint64_t x=0; x<5; x++)
+                {
+                    lanes[x + 5*y] = (st[x][y][0] & 0xFFFFFFFF) | (st[x][y][1] << 32);
+                }
+            }
+            bytes2Bits((const uint8_t *)lanes, 200, bits[isOut][k]);
+        }
+    }
 }
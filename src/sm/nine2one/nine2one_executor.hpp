@@ -21,6 +21,10 @@ public:
     uint64_t st[2][5][5][2];
 };
 
+/* Expands nBytes bytes into 8*nBytes bits, one bit per byte, least significant bit first,
+   using a lookup table instead of per-bit shifting */
+void bytes2Bits (const uint8_t *pBytes, uint64_t nBytes, uint8_t *pBits);
+
 class Nine2OneExecutor
 {
 private:
@@ -42,15 +46,12 @@ public:
         N(Nine2OneCommitPols::pilDegree()),
         nSlots((N-1)/slotSize) {};
 
-    /* Executor */
+    /* Executor; slots are independent, so they are executed in parallel */
     void execute (vector<Nine2OneExecutorInput> &input, Nine2OneCommitPols &pols, vector<vector<Goldilocks::Element>> &required);
 
 private:
-    /* Gets bit "i" from 1600-bits state */
-    Goldilocks::Element bitFromState (uint64_t (&st)[5][5][2], uint64_t i);
-
-    /* Gets bit "pos" from input vector position "block" */
-    Goldilocks::Element getBit (vector<Nine2OneExecutorInput> &input, uint64_t block, bool isOut, uint64_t pos);
+    /* Expands the input and output states of the 44 blocks of a slot into bits[isOut][k][i] = bit "i" of block "k" */
+    void slotBits (vector<Nine2OneExecutorInput> &input, uint64_t slot, uint8_t (*bits)[44][1600]);
 
 };
 
@@ -3,6 +3,7 @@
 #include "scalar.hpp"
 #include "utils.hpp"
 #include "goldilocks_precomputed.hpp"
+#include "Keccak-opt.hpp"
 
 using namespace std;
 
@@ -29,8 +30,22 @@ uint64_t PaddingKKExecutor::prepareInput (vector<PaddingKKExecutorInput> &input)
                 input[i].dataBytes.push_back(aux);
             }
         }
+    }
 
-        keccak256(input[i].dataBytes, input[i].hash);
+    // Hash all the inputs together, so that they are processed 4 by 4
+    vector<const uint8_t *> inputs(input.size());
+    vector<uint64_t> inputSizes(input.size());
+    vector<uint8_t[32]> hashes(input.size());
+    for (uint64_t i=0; i<input.size(); i++)
+    {
+        inputs[i] = input[i].dataBytes.data();
+        inputSizes[i] = input[i].dataBytes.size();
+    }
+    Keccak256Batch(input.size(), inputs.data(), inputSizes.data(), hashes.data());
+
+    for (uint64_t i=0; i<input.size(); i++)
+    {
+        ba2scalar(input[i].hash, hashes[i]);
 
         input[i].realLen = input[i].dataBytes.size();
 
@@ -2,75 +2,86 @@
 #include "sm/keccak_f/keccak.hpp"
 #include "timer.hpp"
 #include "definitions.hpp"
-#include "Keccak-more-compact.hpp"
+#include "Keccak-opt.hpp"
 
-uint64_t bitFromState (const uint64_t (&st)[5][5][2], uint64_t i)
+// Converts a state of 25 64-bit lanes into the [x][y][z/32] 32-bit words layout of the SM
+void lanes2State (const uint64_t (&lanes)[KECCAK_STATE_LANES], uint64_t (&st)[5][5][2])
 {
-    uint64_t y = i / 320;
-    uint64_t x = (i % 320) / 64;
-    uint64_t z = i % 64;
-    uint64_t z1 = z / 32;
-    uint64_t z2 = z%32;
-
-    return (st[x][y][z1] >> z2) & 1;
-}
-
-void setStateBit (uint64_t (&st)[5][5][2], uint64_t i, uint64_t b)
-{
-    uint64_t y = i/320;
-    uint64_t x = (i%320)/64;
-    uint64_t z = i%64;
-    uint64_t z1 = z/32;
-    uint64_t z2 = z%32;
-
-    st[x][y][z1] ^=  (b << z2);
-}
-
-uint8_t byteFromState (const uint64_t (&st)[5][5][2], uint64_t byte)
-{
-    uint64_t bit = byte*8;
-    uint64_t y = bit / 320;
-    uint64_t x = (bit % 320) / 64;
-    uint64_t z = bit % 64;
-    uint64_t z1 = z / 32;
-    uint64_t z2 = z%32;
-
-    return (st[x][y][z1] >> z2);
-}
-
-void setStateByte (uint64_t (&st)[5][5][2], uint64_t byte, uint8_t value)
-{
-    uint64_t bit = byte*8;
-    uint64_t y = bit/320;
-    uint64_t x = (bit%320)/64;
-    uint64_t z = bit%64;
-    uint64_t z1 = z/32;
-    uint64_t z2 = z%32;
-
-    st[x][y][z1] ^=  (uint64_t(value) << z2);
+    for (uint64_t y=0; y<5; y++)
+    {
+        for (uint64_t x=0; x<5; x++)
+        {
+            uint64_t lane = lanes[x + 5*y];
+            st[x][y][0] = lane & 0xFFFFFFFF;
+            st[x][y][1] = lane >> 32;
+        }
+    }
 }
 
-void callKeccakF (const uint64_t (&input)[5][5][2], uint64_t (&output)[5][5][2])
+// Computes the input (state XOR r) and output states of the permutations of all the used slots.
+// A connected slot continues the chain of permutations of the previous slot, while a not connected
+// one starts a new chain, so the chains are independent and their n-th permutations are computed
+// together, in batches of 4
+void PaddingKKBitExecutor::permuteSlots (vector<PaddingKKBitExecutorInput> &input, vector<KeccakLanes> &stateWithR, vector<KeccakLanes> &stateOut)
 {
-    
-    uint8_t s[200];
+    uint64_t nUsedSlots = input.size();
+    stateWithR.resize(nUsedSlots);
+    stateOut.resize(nUsedSlots);
 
-    // Convert input -> s
-    for (uint64_t i=0; i<200; i++)
+    // Find the first slot of every chain
+    vector<uint64_t> chains;
+    for (uint64_t i=0; i<nUsedSlots; i++)
     {
-        s[i] = byteFromState(input, i);
+        if ((i == 0) || !input[i].connected)
+        {
+            chains.push_back(i);
+        }
     }
 
-    // Call keccak (one single round)
-    KeccakF1600(s);
+    vector<KeccakLanes> batch;
+    vector<uint64_t> batchSlots;
+    for (uint64_t n=0; !chains.empty(); n++)
+    {
+        batch.resize(chains.size());
+        batchSlots.resize(chains.size());
+        uint64_t nBatch = 0;
+        for (uint64_t c=0; c<chains.size(); c++)
+        {
+            uint64_t i = chains[c] + n;
+            if ((i >= nUsedSlots) || ((n > 0) && !input[i].connected))
+            {
+                continue;
+            }
 
-    // Reset output
-    memset(output, 0, sizeof(output));
+            // stateWithR = previous state XOR r, where the previous state is zero at the start of a chain
+            if (n == 0)
+            {
+                memset(stateWithR[i].lanes, 0, sizeof(stateWithR[i].lanes));
+            }
+            else
+            {
+                memcpy(stateWithR[i].lanes, stateOut[i-1].lanes, sizeof(stateWithR[i].lanes));
+            }
+            for (uint64_t l=0; l<136/8; l++)
+            {
+                uint64_t r;
+                memcpy(&r, &input[i].r[l*8], 8);
+                stateWithR[i].lanes[l] ^= r;
+            }
 
-    // Convert s -> output
-    for (uint64_t i=0; i<200; i++)
-    {
-        setStateByte(output, i, s[i]);
+            memcpy(batch[nBatch].lanes, stateWithR[i].lanes, sizeof(batch[nBatch].lanes));
+            batchSlots[nBatch] = i;
+            chains[nBatch] = chains[c];
+            nBatch++;
+        }
+        chains.resize(nBatch);
+
+        KeccakF1600Batch(&batch[0].lanes, nBatch);
+
+        for (uint64_t b=0; b<nBatch; b++)
+        {
+            memcpy(stateOut[batchSlots[b]].lanes, batch[b].lanes, sizeof(stateOut[batchSlots[b]].lanes));
+        }
     }
 }
 
@@ -87,44 +98,74 @@ void PaddingKKBitExecutor::execute (vector<PaddingKKBitExecutorInput> &input, Pa
         exitProcess();
     }
 
-    uint64_t curInput = 0;
-    uint64_t p = 0;
     uint64_t pDone = 0;
-    //uint64_t v = 0;
 
     // Convert pols.sOutX to and array, for programming convenience
     CommitPol sOut[8] = { pols.sOut0, pols.sOut1, pols.sOut2, pols.sOut3, pols.sOut4, pols.sOut5, pols.sOut6, pols.sOut7 };
 
-    uint64_t curState[5][5][2];
-    bool bCurStateWritten = false;
+    // Compute all the permutations in advance, in batches of independent states
+#ifdef LOG_TIME_STATISTICS
+    gettimeofday(&t, NULL);
+#endif
+    vector<KeccakLanes> slotStateWithR;
+    vector<KeccakLanes> slotStateOut;
+    permuteSlots(input, slotStateWithR, slotStateOut);
+
+    // The unused slots permute the zero state
+    KeccakLanes zeroState;
+    memset(zeroState.lanes, 0, sizeof(zeroState.lanes));
+    KeccakLanes zeroStateOut = zeroState;
+    KeccakF1600Unrolled(zeroStateOut.lanes);
+#ifdef LOG_TIME_STATISTICS
+    keccakTime += TimeDiff(t);
+    keccakTimes += input.size() + 1;
+#endif
 
+    // Every slot uses the same number of evaluations: 136 bytes of r (8 bits + 1 latch each),
+    // the other 512 bits of the state, and the 256 bits of the hash plus 1
+    const uint64_t slotRows = 136*9 + 512 + 256 + 1;
+
+    // Every slot adds one required input for the Nine2One SM, in slot order
+    uint64_t requiredOffset = required.size();
+    required.resize(requiredOffset + nSlots);
+
+    // The slots are independent once the permutations are known, so they are executed in parallel;
+    // the first rows of every slot use the output state of the previous slot
+#pragma omp parallel for schedule(static)
     for (uint64_t i=0; i<nSlots; i++)
     {
-        bool connected = true;
-
-        uint64_t stateWithR[5][5][2];
-        if ((curInput>=input.size()) || (input[curInput].connected == false))
+        uint64_t p = i*slotRows;
+        bool connected = (i < input.size()) && input[i].connected;
+        const uint64_t (&stateWithRLanes)[KECCAK_STATE_LANES] = (i < input.size()) ? slotStateWithR[i].lanes : zeroState.lanes;
+        const uint64_t (&stateOutLanes)[KECCAK_STATE_LANES] = (i < input.size()) ? slotStateOut[i].lanes : zeroStateOut.lanes;
+        const uint64_t (&prevStateLanes)[KECCAK_STATE_LANES] = (i == 0) ? zeroState.lanes : (i - 1 < input.size()) ? slotStateOut[i-1].lanes : zeroStateOut.lanes;
+
+        // Expand r and the states into bits, one per byte
+        uint8_t rBits[136*8];
+        uint8_t prevStateBits[1600];
+        uint8_t stateOutBits[256];
+        if (i < input.size())
         {
-            connected = false;
-            memset(stateWithR, 0, sizeof(stateWithR));
+            bytes2Bits(input[i].r, 136, rBits);
         }
         else
         {
-            // Copy: stateWithR = curState;
-            memcpy(&stateWithR, &curState, sizeof(stateWithR));
+            memset(rBits, 0, sizeof(rBits));
         }
+        bytes2Bits((const uint8_t *)prevStateLanes, 200, prevStateBits);
+        bytes2Bits((const uint8_t *)stateOutLanes, 32, stateOutBits);
 
         for (uint64_t j=0; j<136; j++)
         {
-            uint8_t byte = (curInput < input.size()) ? input[curInput].r[j] : 0;
+            uint64_t r8 = 0;
             pols.r8[p] = fr.zero();
             for (uint64_t k=0; k<8; k++)
             {
-                uint64_t bit = (byte >> k) & 1;
-                setStateBit(stateWithR, j*8+k, bit);
+                uint64_t bit = rBits[j*8 + k];
                 pols.rBit[p] = fr.fromU64(bit);
-                pols.r8[p+1] = fr.fromU64( fr.toU64(pols.r8[p]) | ((uint64_t(bit) << k)) );
-                if (bCurStateWritten) pols.sOutBit[p] = fr.fromU64( bitFromState(curState, j*8 + k) );
+                r8 |= bit << k;
+                pols.r8[p+1] = fr.fromU64(r8);
+                if (i > 0) pols.sOutBit[p] = fr.fromU64(prevStateBits[j*8 + k]);
                 if (connected) pols.connected[p] = fr.one();
                 p++;
             }
@@ -132,66 +173,65 @@ void PaddingKKBitExecutor::execute (vector<PaddingKKBitExecutorInput> &input, Pa
             if (connected) pols.connected[p] = fr.one();
             p++;
         }
-        
+
         for (uint64_t j=0; j<512; j++)
         {
-            if (bCurStateWritten) pols.sOutBit[p] = fr.fromU64( bitFromState(curState, 136*8 + j) );
+            if (i > 0) pols.sOutBit[p] = fr.fromU64(prevStateBits[136*8 + j]);
             if (connected) pols.connected[p] = fr.one();
             p++;
         }
-#ifdef LOG_TIME_STATISTICS
-        gettimeofday(&t, NULL);
-#endif
-        callKeccakF(stateWithR, curState);
-        bCurStateWritten = true;
-#ifdef LOG_TIME_STATISTICS
-        keccakTime += TimeDiff(t);
-        keccakTimes+=1;
-#endif
-        Nine2OneExecutorInput nine2OneExecutorInput;
-        // Copy: nine2OneExecutorInput.st[0] = stateWithR
-        memcpy(&nine2OneExecutorInput.st[0], stateWithR, sizeof(nine2OneExecutorInput.st[0]));
-        // Copy: nine2OneExecutorInput.st[1] = curState
-        memcpy(&nine2OneExecutorInput.st[1], curState, sizeof(nine2OneExecutorInput.st[1]));
 
-        required.push_back(nine2OneExecutorInput);
+        Nine2OneExecutorInput &nine2OneExecutorInput = required[requiredOffset + i];
+        lanes2State(stateWithRLanes, nine2OneExecutorInput.st[0]);
+        lanes2State(stateOutLanes, nine2OneExecutorInput.st[1]);
 
+        uint64_t sOutAcc[8];
+        for (uint64_t k=0; k<8; k++)
+        {
+            sOutAcc[k] = fr.toU64(sOut[k][p]);
+        }
         for (uint64_t j=0; j<256; j++)
         {
-            pols.sOutBit[p] = fr.fromU64( bitFromState(curState, j) );
+            uint64_t sOutBit = stateOutBits[j];
+            pols.sOutBit[p] = fr.fromU64(sOutBit);
             if (connected) pols.connected[p] = fr.one();
 
             uint64_t bit = j%8;
             uint64_t byte = j/8;
             uint64_t chunk = 7 - byte/4;
             uint64_t byteInChunk = 3 - byte%4;
+            sOutAcc[chunk] |= sOutBit << (byteInChunk*8 + bit);
 
             for (uint64_t k=0; k<8; k++)
             {
-                if ( k == chunk) {
-                    sOut[k][p+1] = fr.fromU64( fr.toU64(sOut[k][p]) | (fr.toU64(pols.sOutBit[p]) << ( byteInChunk*8 + bit)) );
-                } else {
-                    sOut[k][p+1] = sOut[k][p];
-                }
+                sOut[k][p+1] = fr.fromU64(sOutAcc[k]);
             }
             p += 1;
         }
 
         if (connected) pols.connected[p] = fr.one();
         p++;
-
-        curInput++;
     }
 
+    uint64_t p = nSlots*slotRows;
     pDone = p;
 
     // Connect the last state with the first
+    uint8_t lastStateBits[1600];
+    if (nSlots > 0)
+    {
+        bytes2Bits((const uint8_t *)((nSlots - 1 < input.size()) ? slotStateOut[nSlots-1].lanes : zeroStateOut.lanes), 200, lastStateBits);
+    }
+    else
+    {
+        memset(lastStateBits, 0, sizeof(lastStateBits));
+    }
     uint64_t pp = 0;
     for (uint64_t j=0; j<136; j++)
     {
         for (uint64_t k=0; k<8; k++)
         {
-            pols.sOutBit[pp] = fr.fromU64( bitFromState(curState, j*8 + k) );
+            pols.sOutBit[pp] = fr.fromU64(lastStateBits[j*8 + k]);
             pp += 1;
         }
         pols.sOutBit[pp] = fr.zero();
@@ -200,7 +240,7 @@ void PaddingKKBitExecutor::execute (vector<PaddingKKBitExecutorInput> &input, Pa
 
     for (uint64_t j=0; j<512; j++)
     {
-        pols.sOutBit[pp] = fr.fromU64( bitFromState(curState, 136*8 + j) );
+        pols.sOutBit[pp] = fr.fromU64(lastStateBits[136*8 + j]);
         pp++;
     }
 
@@ -4,6 +4,7 @@
 #include <vector>
 #include "commit_pols.hpp"
 #include "sm/nine2one/nine2one_executor.hpp"
+#include "Keccak-opt.hpp"
 
 using namespace std;
 
@@ -15,6 +16,12 @@ public:
     PaddingKKBitExecutorInput() : connected(false) {};
 };
 
+// Keccak-f state, as 25 64-bit lanes
+struct KeccakLanes
+{
+    uint64_t lanes[KECCAK_STATE_LANES];
+};
+
 class PaddingKKBitExecutor
 {
 private:
@@ -28,6 +35,7 @@ public:
         N(PaddingKKBitCommitPols::pilDegree()),
         slotSize(155286),
         nSlots(44*((N-1)/slotSize)) {};
+    void permuteSlots (vector<PaddingKKBitExecutorInput> &input, vector<KeccakLanes> &stateWithR, vector<KeccakLanes> &stateOut);
     void execute (vector<PaddingKKBitExecutorInput> &input, PaddingKKBitCommitPols &pols, vector<Nine2OneExecutorInput> &required);
 };
 
@@ -25,6 +25,7 @@ public:
             std::memcpy(&mp[j][0], &pointer[nLinears + j * HASH_SIZE], HASH_SIZE * sizeof(Goldilocks::Element));
         }
     };
+    MerkleProof(uint64_t nLinears, uint64_t elementsTree) : v(nLinears, std::vector<Goldilocks::Element>(1, Goldilocks::zero())), mp(elementsTree, std::vector<Goldilocks::Element>(HASH_SIZE, Goldilocks::zero())){};
     ordered_json merkleProof2json()
     {
         ordered_json j = ordered_json::array();
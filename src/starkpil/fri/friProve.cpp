@@ -1,7 +1,7 @@
 #include "friProve.hpp"
 #include "timer.hpp"
 
-void FRIProve::prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transcript, Polinomial &friPol, uint64_t polBits, StarkInfo starkInfo)
+void FRIProve::prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transcript, Polinomial &friPol, uint64_t polBits, const StarkInfo &starkInfo)
 {
     //TimerStart(STARK_FRI_PROVE);
 
@@ -21,90 +21,13 @@ void FRIProve::prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transc
         uint64_t reductionBits = polBits - starkInfo.starkStruct.steps[si].nBits;
 
         pol2N = 1 << (polBits - reductionBits);
-        uint64_t nX = (1 << polBits) / pol2N;
 
         Polinomial pol2_e(pol2N, FIELD_EXTENSION);
 
         Polinomial special_x(1, FIELD_EXTENSION);
         transcript.getField(special_x.address());
 
-        Polinomial sinv(1, 1);
-        Polinomial wi(1, 1);
-
-        *sinv[0] = *polShiftInv[0];
-        *wi[0] = Goldilocks::inv(Goldilocks::w(polBits));
-
-        uint64_t nn = ((1 << polBits) / nX);
-        u_int64_t maxth = omp_get_max_threads();
-        if (maxth > nn)
-        {
-            maxth = nn;
-        }
-#pragma omp parallel num_threads(maxth)
-        {
-            u_int64_t nth = omp_get_num_threads();
-            u_int64_t thid = omp_get_thread_num();
-            u_int64_t chunk = nn / nth;
-            u_int64_t res = nn - nth * chunk;
-
-            // Evaluate bounds of the loop for the thread
-            uint64_t init = chunk * thid;
-            uint64_t end;
-            if (thid < res)
-            {
-                init += thid;
-                end = init + chunk + 1;
-            }
-            else
-            {
-                init += res;
-                end = init + chunk;
-            }
-            //  Evaluate the starting point for the sinv
-            Goldilocks::Element aux = *wi[0];
-            Goldilocks::Element sinv_ = *sinv[0];
-            for (uint64_t i = 0; i < chunk - 1; ++i)
-            {
-                aux = aux * (*wi[0]);
-            }
-            for (u_int64_t i = 0; i < thid; ++i)
-            {
-                sinv_ = sinv_ * aux;
-            }
-            u_int64_t ncor = res;
-            if (thid < res)
-            {
-                ncor = thid;
-            }
-            for (u_int64_t j = 0; j < ncor; ++j)
-            {
-                sinv_ = sinv_ * (*wi[0]);
-            }
-
-            for (uint64_t g = init; g < end; g++)
-            {
-                if (si == 0)
-                {
-                    Polinomial::copyElement(pol2_e, g, friPol, g);
-                }
-                else
-                {
-                    Polinomial ppar(nX, FIELD_EXTENSION);
-                    Polinomial ppar_c(nX, FIELD_EXTENSION);
-
-                    for (uint64_t i = 0; i < nX; i++)
-                    {
-                        Polinomial::copyElement(ppar, i, friPol, (i * pol2N) + g);
-                    }
-                    NTT_Goldilocks ntt(nX, 1);
-
-                    ntt.INTT(ppar_c.address(), ppar.address(), nX, FIELD_EXTENSION);
-                    polMulAxi(ppar_c, Goldilocks::one(), sinv_); // Multiplies coefs by 1, shiftInv, shiftInv^2, shiftInv^3, ......
-                    evalPol(pol2_e, g, ppar_c, special_x);
-                    sinv_ = sinv_ * (*wi[0]);
-                }
-            }
-        }
+        fold(si, friPol, pol2_e, polBits, *polShiftInv[0], special_x);
 
         if (si < starkInfo.starkStruct.steps.size() - 1)
         {
@@ -154,27 +77,7 @@ void FRIProve::prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transc
     uint64_t ys[starkInfo.starkStruct.nQueries];
     transcript.getPermutations(ys, starkInfo.starkStruct.nQueries, starkInfo.starkStruct.steps[0].nBits);
 
-    for (uint64_t si = 0; si < starkInfo.starkStruct.steps.size(); si++)
-    {
-        for (uint64_t i = 0; i < starkInfo.starkStruct.nQueries; i++)
-        {
-            if (si == 0)
-            {
-                queryPol(fproof, treesGL, ys[i], si);
-            }
-            else
-            {
-                queryPol(fproof, treesFRIGL[si], ys[i], si);
-            }
-        }
-        if (si < starkInfo.starkStruct.steps.size() - 1)
-        {
-            for (uint64_t i = 0; i < starkInfo.starkStruct.nQueries; i++)
-            {
-                ys[i] = ys[i] % (1 << starkInfo.starkStruct.steps[si + 1].nBits);
-            }
-        }
-    }
+    queryPols(fproof, treesGL, treesFRIGL, ys, starkInfo);
 
     while (!treesFRIGL.empty())
     {
@@ -188,6 +91,91 @@ void FRIProve::prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transc
     return;
 }
 
+// Folds friPol, of 2^polBits evaluations, into the pol2_e.degree() evaluations of pol2_e, at the point special_x
+void FRIProve::fold(uint64_t step, Polinomial &friPol, Polinomial &pol2_e, uint64_t polBits, Goldilocks::Element shiftInv, Polinomial &special_x)
+{
+    uint64_t pol2N = pol2_e.degree();
+    uint64_t nX = (1 << polBits) / pol2N;
+
+    Polinomial sinv(1, 1);
+    Polinomial wi(1, 1);
+
+    *sinv[0] = shiftInv;
+    *wi[0] = Goldilocks::inv(Goldilocks::w(polBits));
+
+    uint64_t nn = ((1 << polBits) / nX);
+    u_int64_t maxth = omp_get_max_threads();
+    if (maxth > nn)
+    {
+        maxth = nn;
+    }
+#pragma omp parallel num_threads(maxth)
+    {
+        u_int64_t nth = omp_get_num_threads();
+        u_int64_t thid = omp_get_thread_num();
+        u_int64_t chunk = nn / nth;
+        u_int64_t res = nn - nth * chunk;
+
+        // Evaluate bounds of the loop for the thread
+        uint64_t init = chunk * thid;
+        uint64_t end;
+        if (thid < res)
+        {
+            init += thid;
+            end = init + chunk + 1;
+        }
+        else
+        {
+            init += res;
+            end = init + chunk;
+        }
+        //  Evaluate the starting point for the sinv
+        Goldilocks::Element aux = *wi[0];
+        Goldilocks::Element sinv_ = *sinv[0];
+        for (uint64_t i = 0; i < chunk - 1; ++i)
+        {
+            aux = aux * (*wi[0]);
+        }
+        for (u_int64_t i = 0; i < thid; ++i)
+        {
+            sinv_ = sinv_ * aux;
+        }
+        u_int64_t ncor = res;
+        if (thid < res)
+        {
+            ncor = thid;
+        }
+        for (u_int64_t j = 0; j < ncor; ++j)
+        {
+            sinv_ = sinv_ * (*wi[0]);
+        }
+
+        for (uint64_t g = init; g < end; g++)
+        {
+            if (step == 0)
+            {
+                Polinomial::copyElement(pol2_e, g, friPol, g);
+            }
+            else
+            {
+                Polinomial ppar(nX, FIELD_EXTENSION);
+                Polinomial ppar_c(nX, FIELD_EXTENSION);
+
+                for (uint64_t i = 0; i < nX; i++)
+                {
+                    Polinomial::copyElement(ppar, i, friPol, (i * pol2N) + g);
+                }
+                NTT_Goldilocks ntt(nX, 1);
+
+                ntt.INTT(ppar_c.address(), ppar.address(), nX, FIELD_EXTENSION);
+                polMulAxi(ppar_c, Goldilocks::one(), sinv_); // Multiplies coefs by 1, shiftInv, shiftInv^2, shiftInv^3, ......
+                evalPol(pol2_e, g, ppar_c, special_x);
+                sinv_ = sinv_ * (*wi[0]);
+            }
+        }
+    }
+}
+
 void FRIProve::polMulAxi(Polinomial &pol, Goldilocks::Element init, Goldilocks::Element acc)
 {
     Goldilocks::Element r = init;
@@ -215,37 +203,77 @@ void FRIProve::evalPol(Polinomial &res, uint64_t res_idx, Polinomial &p, Polinom
     }
 }
 
-void FRIProve::queryPol(FRIProof &fproof, MerkleTreeGL *treesGL[5], uint64_t idx, uint64_t treeIdx)
+// Opening of a leaf requested by a FRI query, in the tree that has to provide it
+struct FRIQueryOpening
 {
-    vector<MerkleProof> vMkProof;
-    for (uint i = 0; i < 5; i++)
-    {
-        MerkleTreeGL *treesGLTmp = treesGL[i];
-        Goldilocks::Element buff[treesGLTmp->width + treesGLTmp->MerkleProofSize() * HASH_SIZE] = {Goldilocks::zero()};
-
-        treesGLTmp->getGroupProof(&buff[0], idx);
+    MerkleTreeGL *tree;
+    uint64_t leaf;
+    MerkleProof *mkProof;
+};
 
-        MerkleProof mkProof(treesGLTmp->width, treesGLTmp->MerkleProofSize(), &buff[0]);
-        vMkProof.push_back(mkProof);
-    }
-    fproof.proofs.fri.trees[treeIdx].polQueries.push_back(vMkProof);
-
-    return;
-}
-
-void FRIProve::queryPol(FRIProof &fproof, MerkleTreeGL *treeGL, uint64_t idx, uint64_t treeIdx)
+void FRIProve::queryPols(FRIProof &fproof, MerkleTreeGL **treesGL, std::vector<MerkleTreeGL *> &treesFRIGL, uint64_t *ys, const StarkInfo &starkInfo)
 {
-    vector<MerkleProof> vMkProof;
-
-    Goldilocks::Element buff[treeGL->width * treeGL->width + treeGL->MerkleProofSize() * HASH_SIZE] = {Goldilocks::zero()};
-    treeGL->getGroupProof(&buff[0], idx);
-
-    MerkleProof mkProof(treeGL->width, treeGL->MerkleProofSize(), &buff[0]);
-    vMkProof.push_back(mkProof);
+    uint64_t nQueries = starkInfo.starkStruct.nQueries;
+    uint64_t nSteps = starkInfo.starkStruct.steps.size();
+
+    // Allocate all the merkle proofs in the FRI proof, so that they can be filled concurrently,
+    // and collect the (tree, leaf) openings of every query of every step
+    std::vector<FRIQueryOpening> openings;
+    openings.reserve(nQueries * (nSteps + 4));
+    uint64_t idx[nQueries];
+    std::memcpy(idx, ys, nQueries * sizeof(uint64_t));
+    for (uint64_t si = 0; si < nSteps; si++)
+    {
+        MerkleTreeGL **trees = (si == 0) ? treesGL : &treesFRIGL[si];
+        uint64_t nTrees = (si == 0) ? 5 : 1;
+        std::vector<std::vector<MerkleProof>> &polQueries = fproof.proofs.fri.trees[si].polQueries;
+        uint64_t first = polQueries.size();
+        for (uint64_t i = 0; i < nQueries; i++)
+        {
+            std::vector<MerkleProof> vMkProof;
+            for (uint64_t t = 0; t < nTrees; t++)
+            {
+                vMkProof.push_back(MerkleProof(trees[t]->width, trees[t]->MerkleProofSize()));
+            }
+            polQueries.push_back(vMkProof);
+        }
+        for (uint64_t i = 0; i < nQueries; i++)
+        {
+            for (uint64_t t = 0; t < nTrees; t++)
+            {
+                openings.push_back({trees[t], idx[i], &polQueries[first + i][t]});
+            }
+        }
+        if (si < nSteps - 1)
+        {
+            for (uint64_t i = 0; i < nQueries; i++)
+            {
+                idx[i] = idx[i] % (1 << starkInfo.starkStruct.steps[si + 1].nBits);
+            }
+        }
+    }
 
-    fproof.proofs.fri.trees[treeIdx].polQueries.push_back(vMkProof);
+    // Sort by tree and leaf so that consecutive openings touch nearby rows and nodes
+    std::sort(openings.begin(), openings.end(), [](const FRIQueryOpening &a, const FRIQueryOpening &b)
+              { return (a.tree != b.tree) ? (std::less<MerkleTreeGL *>()(a.tree, b.tree)) : (a.leaf < b.leaf); });
 
-    return;
+#pragma omp parallel for schedule(dynamic, 16)
+    for (uint64_t o = 0; o < openings.size(); o++)
+    {
+        MerkleTreeGL *tree = openings[o].tree;
+        MerkleProof &mkProof = *openings[o].mkProof;
+        Goldilocks::Element *row = &tree->source[openings[o].leaf * tree->width];
+        for (uint64_t i = 0; i < tree->width; i++)
+        {
+            mkProof.v[i][0] = row[i];
+        }
+        Goldilocks::Element path[tree->MerkleProofSize() * HASH_SIZE + 1];
+        tree->getMerkleProof(path, openings[o].leaf);
+        for (uint64_t j = 0; j < mkProof.mp.size(); j++)
+        {
+            std::memcpy(&mkProof.mp[j][0], &path[j * HASH_SIZE], HASH_SIZE * sizeof(Goldilocks::Element));
+        }
+    }
 }
 
 void FRIProve::getTransposed(Polinomial &aux, Polinomial &pol, uint64_t trasposeBits)
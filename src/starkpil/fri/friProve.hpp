@@ -13,11 +13,11 @@
 class FRIProve
 {
 public:
-    static void prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transcript, Polinomial &friPol, uint64_t polBits, StarkInfo starkInfo);
+    static void prove(FRIProof &fproof, MerkleTreeGL **treesGL, Transcript transcript, Polinomial &friPol, uint64_t polBits, const StarkInfo &starkInfo);
+    static void fold(uint64_t step, Polinomial &friPol, Polinomial &pol2_e, uint64_t polBits, Goldilocks::Element shiftInv, Polinomial &special_x);
     static void polMulAxi(Polinomial &pol, Goldilocks::Element init, Goldilocks::Element acc);
     static void evalPol(Polinomial &res, uint64_t res_idx, Polinomial &p, Polinomial &x);
-    static void queryPol(FRIProof &fproof, MerkleTreeGL **treeGL, uint64_t idx, uint64_t treeIdx);
-    static void queryPol(FRIProof &fproof, MerkleTreeGL *treeGL, uint64_t idx, uint64_t treeIdx);
+    static void queryPols(FRIProof &fproof, MerkleTreeGL **treesGL, std::vector<MerkleTreeGL *> &treesFRIGL, uint64_t *ys, const StarkInfo &starkInfo);
     static void getTransposed(Polinomial &aux, Polinomial &pol, uint64_t trasposeBits);
 };
 
@@ -1,7 +1,7 @@
 #include "friProveC12.hpp"
 #include "timer.hpp"
 
-void FRIProveC12::prove(FRIProofC12 &fproof, MerkleTreeBN128 **trees, TranscriptBN128 transcript, Polinomial &friPol, uint64_t polBits, StarkInfo starkInfo)
+void FRIProveC12::prove(FRIProofC12 &fproof, MerkleTreeBN128 **trees, TranscriptBN128 transcript, Polinomial &friPol, uint64_t polBits, const StarkInfo &starkInfo)
 {
     TimerStart(STARK_FRI_PROVE);
 
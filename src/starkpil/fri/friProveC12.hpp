@@ -13,7 +13,7 @@
 class FRIProveC12
 {
 public:
-    static void prove(FRIProofC12 &fproof, MerkleTreeBN128 **trees, TranscriptBN128 transcript, Polinomial &friPol, uint64_t polBits, StarkInfo starkInfo);
+    static void prove(FRIProofC12 &fproof, MerkleTreeBN128 **trees, TranscriptBN128 transcript, Polinomial &friPol, uint64_t polBits, const StarkInfo &starkInfo);
     static void polMulAxi(Polinomial &pol, Goldilocks::Element init, Goldilocks::Element acc);
     static void evalPol(Polinomial &res, uint64_t res_idx, Polinomial &p, Polinomial &x);
     static void getTransposed(Polinomial &aux, Polinomial &pol2_e, uint64_t trasposeBits);
@@ -81,7 +81,7 @@ ordered_json proof2zkinStark(ordered_json &proof)
     return zkinOut;
 };
 
-ordered_json joinzkin(ordered_json &zkin1, ordered_json &zkin2, ordered_json &verKey)
+ordered_json joinzkin(ordered_json &zkin1, ordered_json &zkin2, const ordered_json &verKey)
 {
     ordered_json zkinOut = ordered_json::object();
 
@@ -7,6 +7,6 @@
 using ordered_json = nlohmann::ordered_json;
 
 ordered_json proof2zkinStark(ordered_json &fproof);
-ordered_json joinzkin(ordered_json &zkin1, ordered_json &zkin2, ordered_json &verKey);
+ordered_json joinzkin(ordered_json &zkin1, ordered_json &zkin2, const ordered_json &verKey);
 
 #endif
\ No newline at end of file
@@ -110,30 +110,31 @@ void MerkleTreeBN128::linearHash()
             }
         }
 
+        // Rows are hashed in groups of POSEIDON_OPT_BATCH, interleaving their permutations
+        uint64_t nGroups = (height + POSEIDON_OPT_BATCH - 1) / POSEIDON_OPT_BATCH;
 #pragma omp parallel for
-        for (uint64_t i = 0; i < height; i++)
+        for (uint64_t g = 0; g < nGroups; g++)
         {
-            uint pending = width;
-            Poseidon_opt p;
-            std::vector<RawFr::Element> elements(17);
+            uint64_t first = g * POSEIDON_OPT_BATCH;
+            uint64_t nRows = std::min((uint64_t)POSEIDON_OPT_BATCH, height - first);
+            RawFr::Element elements[POSEIDON_OPT_BATCH * 17];
+            uint64_t pending = width;
             while (pending > 0)
             {
-                std::memset(&elements[0], 0, 17 * sizeof(RawFr::Element));
-                if (pending >= 16)
+                uint64_t batch = (pending >= 16) ? 16 : pending;
+                std::memset(elements, 0, sizeof(elements));
+                for (uint64_t r = 0; r < nRows; r++)
                 {
-                    std::memcpy(&elements[1], &buff[i * width + width - pending], 16 * sizeof(RawFr::Element));
-                    std::memcpy(&elements[0], &nodes[i], sizeof(RawFr::Element));
-                    p.hash(elements, &nodes[i]);
-                    pending = pending - 16;
+                    uint64_t i = first + r;
+                    std::memcpy(&elements[r * (batch + 1)], &nodes[i], sizeof(RawFr::Element));
+                    std::memcpy(&elements[r * (batch + 1) + 1], &buff[i * width + width - pending], batch * sizeof(RawFr::Element));
                 }
-                else
+                Poseidon_opt::hashBatch(elements, batch + 1, nRows);
+                for (uint64_t r = 0; r < nRows; r++)
                 {
-                    std::vector<RawFr::Element> elements_last(pending + 1);
-                    std::memcpy(&elements_last[1], &buff[i * width + width - pending], pending * sizeof(RawFr::Element));
-                    std::memcpy(&elements_last[0], &nodes[i], sizeof(RawFr::Element));
-                    p.hash(elements_last, &nodes[i]);
-                    pending = 0;
+                    std::memcpy(&nodes[first + r], &elements[r * (batch + 1)], sizeof(RawFr::Element));
                 }
+                pending = pending - batch;
             }
         }
         free(buff);
@@ -164,16 +165,24 @@ void MerkleTreeBN128::merkelize()
     while (n256 > 1)
     {
         uint64_t batches = ceil((double)n256 / 16);
+        uint64_t numHashes = (batches == 1) ? n256 : 16;
+        uint64_t nGroups = (batches + POSEIDON_OPT_BATCH - 1) / POSEIDON_OPT_BATCH;
 #pragma omp parallel for
-        for (uint64_t i = 0; i < batches; i++)
+        for (uint64_t g = 0; g < nGroups; g++)
         {
-            Poseidon_opt p;
-            vector<RawFr::Element> elements(17);
-            std::memset(&elements[0], 0, 17 * sizeof(RawFr::Element));
-            uint numHashes = 16;
-            (batches == 1) ? numHashes = n256 : numHashes = 16;
-            std::memcpy(&elements[1], &cursor[i * 16], numHashes * sizeof(RawFr::Element));
-            p.hash(elements, &cursorNext[i]);
+            uint64_t first = g * POSEIDON_OPT_BATCH;
+            uint64_t nNodes = std::min((uint64_t)POSEIDON_OPT_BATCH, batches - first);
+            RawFr::Element elements[POSEIDON_OPT_BATCH * 17];
+            std::memset(elements, 0, sizeof(elements));
+            for (uint64_t k = 0; k < nNodes; k++)
+            {
+                std::memcpy(&elements[k * 17 + 1], &cursor[(first + k) * 16], numHashes * sizeof(RawFr::Element));
+            }
+            Poseidon_opt::hashBatch<17>(elements, nNodes);
+            for (uint64_t k = 0; k < nNodes; k++)
+            {
+                std::memcpy(&cursorNext[first + k], &elements[k * 17], sizeof(RawFr::Element));
+            }
         }
 
         n256 = nextN256;
@@ -1,6 +1,23 @@
 #include "merkleTreeGL.hpp"
 #include <cassert>
 #include <algorithm> // std::max
+#include "utils.hpp"
+
+MerkleTreeGL::MerkleTreeGL(uint64_t _height, uint64_t _width, Goldilocks::Element *_source, const std::string &nodesFile) : height(_height), width(_width), source(_source)
+{
+    if (source == NULL)
+    {
+        source = (Goldilocks::Element *)calloc(height * width, sizeof(Goldilocks::Element));
+        isSourceAllocated = true;
+    }
+    nodes = (Goldilocks::Element *)mapFile(nodesFile, getTreeNumElements() * sizeof(Goldilocks::Element), true);
+    isNodesMapped = true;
+}
+
+void MerkleTreeGL::unmapNodes()
+{
+    unmapFile(nodes, getTreeNumElements() * sizeof(Goldilocks::Element));
+}
 
 void MerkleTreeGL::getElement(Goldilocks::Element &element, uint64_t idx, uint64_t subIdx)
 {
@@ -11,16 +28,21 @@ void MerkleTreeGL::getElement(Goldilocks::Element &element, uint64_t idx, uint64
 
 void MerkleTreeGL::getGroupProof(Goldilocks::Element *proof, uint64_t idx)
 {
+    assert(idx < height);
 
-#pragma omp parallel for
-    for (uint64_t i = 0; i < width; i++)
-    {
-        getElement(proof[i], idx, i);
-    }
+    // The row is contiguous in source; it is too small to be worth a parallel region
+    std::memcpy(proof, &source[idx * width], width * sizeof(Goldilocks::Element));
 
     genMerkleProof(&proof[width], idx, 0, height * HASH_SIZE);
 }
 
+void MerkleTreeGL::getMerkleProof(Goldilocks::Element *proof, uint64_t idx)
+{
+    assert(idx < height);
+
+    genMerkleProof(proof, idx, 0, height * HASH_SIZE);
+}
+
 void MerkleTreeGL::genMerkleProof(Goldilocks::Element *proof, uint64_t idx, uint64_t offset, uint64_t n)
 {
     if (n <= HASH_SIZE)
@@ -34,12 +56,8 @@ void MerkleTreeGL::genMerkleProof(Goldilocks::Element *proof, uint64_t idx, uint
     genMerkleProof(&proof[HASH_SIZE], nextIdx, offset + nextN * 2, nextN);
 }
 
-void MerkleTreeGL::merkelize()
+void MerkleTreeGL::hashLeaf(Goldilocks::Element *hash, Goldilocks::Element *leaf, uint64_t width)
 {
-    if (height == 0)
-    {
-        return;
-    }
     uint64_t batch_size = std::max((uint64_t)8, (width + 3) / 4);
     uint64_t nbatches = 1;
     if (width > 0)
@@ -48,21 +66,57 @@ void MerkleTreeGL::merkelize()
     }
     uint64_t nlastb = width - (nbatches - 1) * batch_size;
 
+    Goldilocks::Element buff0[nbatches * CAPACITY];
+    for (uint64_t j = 0; j < nbatches; j++)
+    {
+        uint64_t nn = batch_size;
+        if (j == nbatches - 1)
+            nn = nlastb;
+        Goldilocks::Element buff1[batch_size];
+        std::memcpy(&buff1[0], &leaf[j * batch_size], nn * sizeof(Goldilocks::Element));
+        PoseidonGoldilocks::linear_hash(&buff0[j * CAPACITY], buff1, nn);
+    }
+    PoseidonGoldilocks::linear_hash(hash, buff0, nbatches * CAPACITY);
+}
+
+bool MerkleTreeGL::verifyMerkleProof(const Goldilocks::Element *root, Goldilocks::Element *leaf, uint64_t width, uint64_t idx, const Goldilocks::Element *proof, uint64_t proofSize)
+{
+    Goldilocks::Element value[CAPACITY];
+    hashLeaf(value, leaf, width);
+
+    for (uint64_t j = 0; j < proofSize; j++)
+    {
+        // Siblings are hashed in tree order: the node with the even index goes first
+        Goldilocks::Element pol_input[SPONGE_WIDTH];
+        std::memset(pol_input, 0, SPONGE_WIDTH * sizeof(Goldilocks::Element));
+        std::memcpy(&pol_input[(idx & 1) ? CAPACITY : 0], value, CAPACITY * sizeof(Goldilocks::Element));
+        std::memcpy(&pol_input[(idx & 1) ? 0 : CAPACITY], &proof[j * HASH_SIZE], CAPACITY * sizeof(Goldilocks::Element));
+        PoseidonGoldilocks::hash((Goldilocks::Element(&)[CAPACITY])value, pol_input);
+        idx = idx >> 1;
+    }
+
+    for (uint64_t i = 0; i < CAPACITY; i++)
+    {
+        if (Goldilocks::toU64(value[i]) != Goldilocks::toU64(root[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MerkleTreeGL::merkelize()
+{
+    if (height == 0)
+    {
+        return;
+    }
+
     // Hash the leaves
 #pragma omp parallel for
     for (uint64_t i = 0; i < height; i++)
     {
-        Goldilocks::Element buff0[nbatches * CAPACITY];
-        for (uint64_t j = 0; j < nbatches; j++)
-        {
-            uint64_t nn = batch_size;
-            if (j == nbatches - 1)
-                nn = nlastb;
-            Goldilocks::Element buff1[batch_size];
-            std::memcpy(&buff1[0], &source[i * width + j * batch_size], nn * sizeof(Goldilocks::Element));
-            PoseidonGoldilocks::linear_hash(&buff0[j * CAPACITY], buff1, nn);
-        }
-        PoseidonGoldilocks::linear_hash(&nodes[i * CAPACITY], buff0, nbatches * CAPACITY);
+        hashLeaf(&nodes[i * CAPACITY], &source[i * width], width);
     }
 
     // Build the merkle tree
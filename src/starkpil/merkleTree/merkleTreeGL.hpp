@@ -4,6 +4,7 @@
 #include "goldilocks_base_field.hpp"
 #include "poseidon_goldilocks.hpp"
 #include <math.h>
+#include <string>
 
 #define MERKLEHASHGL_ARITY 2
 class MerkleTreeGL
@@ -11,6 +12,7 @@ class MerkleTreeGL
 private:
     void linearHash();
     void getElement(Goldilocks::Element &element, uint64_t idx, uint64_t subIdx);
+    void unmapNodes();
     void genMerkleProof(Goldilocks::Element *proof, uint64_t idx, uint64_t offset, uint64_t n);
 
 public:
@@ -20,6 +22,7 @@ public:
     Goldilocks::Element *nodes;
     bool isSourceAllocated = false;
     bool isNodesAllocated = false;
+    bool isNodesMapped = false;
     MerkleTreeGL(){};
     MerkleTreeGL(Goldilocks::Element *tree)
     {
@@ -41,6 +44,8 @@ public:
         nodes = (Goldilocks::Element *)calloc(getTreeNumElements(), sizeof(Goldilocks::Element));
         isNodesAllocated = true;
     };
+    // Same as above, but the nodes are stored in a file mapped to memory, to let the OS page them out
+    MerkleTreeGL(uint64_t _height, uint64_t _width, Goldilocks::Element *_source, const std::string &nodesFile);
     ~MerkleTreeGL()
     {
         if (isSourceAllocated)
@@ -51,6 +56,10 @@ public:
         {
             free(nodes);
         }
+        if (isNodesMapped)
+        {
+            unmapNodes();
+        }
     };
     void copySource(Goldilocks::Element *_source)
     {
@@ -67,6 +76,13 @@ public:
         std::memcpy(root, &nodes[getTreeNumElements() - HASH_SIZE], HASH_SIZE * sizeof(Goldilocks::Element));
     }
     void getGroupProof(Goldilocks::Element *proof, uint64_t idx);
+    void getMerkleProof(Goldilocks::Element *proof, uint64_t idx);
+
+    // Hashes a leaf of width elements into its HASH_SIZE elements node, as merkelize() does
+    static void hashLeaf(Goldilocks::Element *hash, Goldilocks::Element *leaf, uint64_t width);
+
+    // Checks that the leaf of index idx and its merkle proof, of proofSize sibling nodes as returned by getMerkleProof(), hash to root
+    static bool verifyMerkleProof(const Goldilocks::Element *root, Goldilocks::Element *leaf, uint64_t width, uint64_t idx, const Goldilocks::Element *proof, uint64_t proofSize);
 
     uint64_t MerkleProofSize()
     {
@@ -4,7 +4,46 @@
 #include "goldilocks_base_field.hpp"
 #include "goldilocks_cubic_extension.hpp"
 #include "compare_fe.hpp"
+#include "exit_process.hpp"
 #include <math.h>       /* log2 */
+#include <algorithm>
+
+// Sorting entry used by calculateH1H2_parallel(): the value of a plookup row (dim elements, as u64)
+// followed by the row index, so that entries with equal values are ordered by row
+template <uint64_t dim>
+struct H1H2Entry
+{
+    uint64_t key[dim];
+    uint64_t idx;
+
+    inline bool keyLess(const H1H2Entry &b) const
+    {
+        for (uint64_t d = 0; d < dim; d++)
+        {
+            if (key[d] != b.key[d])
+                return key[d] < b.key[d];
+        }
+        return false;
+    }
+    inline bool keyEqual(const H1H2Entry &b) const
+    {
+        for (uint64_t d = 0; d < dim; d++)
+        {
+            if (key[d] != b.key[d])
+                return false;
+        }
+        return true;
+    }
+    inline bool operator<(const H1H2Entry &b) const
+    {
+        for (uint64_t d = 0; d < dim; d++)
+        {
+            if (key[d] != b.key[d])
+                return key[d] < b.key[d];
+        }
+        return idx < b.idx;
+    }
+};
 
 class Polinomial
 {
@@ -73,6 +112,7 @@ public:
     Goldilocks::Element *address(void) { return _pAddress; }
     uint64_t degree(void) { return _degree; }
     uint64_t dim(void) { return _dim; }
+    uint64_t offset(void) { return _offset; }
     uint64_t length(void) { return _degree * _dim; }
     uint64_t size(void) { return _degree * _dim * sizeof(Goldilocks::Element); }
 
@@ -580,6 +620,231 @@ public:
         // std::cout << "holu: " << id << " " << pos << " times: " << time2 - time1 << " " << time3 - time2 << " " << time4 - time3 << " " << h2.dim() << std::endl;
     }
 
+    // Returns the number of uint64_t of scratch buffer needed by calculateH1H2_parallel()
+    static uint64_t calculateH1H2_parallelBufferSize(uint64_t N, uint64_t dim)
+    {
+        return 4 * (dim + 1) * N + N + 1;
+    }
+
+    // Same result as calculateH1H2_opt1/opt3, but a single plookup is computed using all the threads:
+    // t and f rows are sorted in parallel, joined to count the occurrences of every t value, and h1/h2
+    // are written directly into their (strided) destination, so no column transposition is needed
+    static void calculateH1H2_parallel(Polinomial &h1, Polinomial &h2, Polinomial &fPol, Polinomial &tPol, uint64_t pNumber, uint64_t *buffer, uint64_t buffSize)
+    {
+        if (tPol.dim() == 1 && fPol.dim() == 1)
+        {
+            calculateH1H2_sorted<1>(h1, h2, fPol, tPol, pNumber, buffer, buffSize);
+        }
+        else
+        {
+            assert(tPol.dim() <= 3 && fPol.dim() <= 3);
+            calculateH1H2_sorted<3>(h1, h2, fPol, tPol, pNumber, buffer, buffSize);
+        }
+    }
+
+    // Sorts n entries using nChunks threads (power of 2): every thread sorts a chunk, and then chunks are merged by pairs
+    // Returns the address of the sorted entries, which can be either data or tmp
+    template <uint64_t dim>
+    static H1H2Entry<dim> *parallelSort(H1H2Entry<dim> *data, H1H2Entry<dim> *tmp, uint64_t n, uint64_t nChunks)
+    {
+        vector<uint64_t> bounds(nChunks + 1);
+        for (uint64_t c = 0; c <= nChunks; c++)
+        {
+            bounds[c] = (n * c) / nChunks;
+        }
+
+#pragma omp parallel for num_threads(nChunks)
+        for (uint64_t c = 0; c < nChunks; c++)
+        {
+            std::sort(&data[bounds[c]], &data[bounds[c + 1]]);
+        }
+
+        H1H2Entry<dim> *src = data;
+        H1H2Entry<dim> *dst = tmp;
+        for (uint64_t width = 1; width < nChunks; width *= 2)
+        {
+#pragma omp parallel for num_threads(nChunks / (2 * width))
+            for (uint64_t c = 0; c < nChunks; c += 2 * width)
+            {
+                uint64_t lo = bounds[c];
+                uint64_t mid = bounds[c + width];
+                uint64_t hi = bounds[c + 2 * width];
+                std::merge(&src[lo], &src[mid], &src[mid], &src[hi], &dst[lo]);
+            }
+            std::swap(src, dst);
+        }
+        return src;
+    }
+
+    template <uint64_t dim>
+    static void calculateH1H2_sorted(Polinomial &h1, Polinomial &h2, Polinomial &fPol, Polinomial &tPol, uint64_t pNumber, uint64_t *buffer, uint64_t buffSize)
+    {
+        uint64_t nT = tPol.degree();
+        uint64_t nF = fPol.degree();
+        zkassert(nF <= nT);
+        zkassert(nT + nF == 2 * h1.degree());
+        if (buffSize < calculateH1H2_parallelBufferSize(nT, dim))
+        {
+            cerr << "Error: calculateH1H2_sorted() buffer too small: buffSize=" << buffSize << " required=" << calculateH1H2_parallelBufferSize(nT, dim) << " plookup_number=" << pNumber << endl;
+            exitProcess();
+        }
+
+        uint64_t nThreads = 1;
+        while ((nThreads * 2 <= (uint64_t)omp_get_max_threads()) && (nThreads * 2 <= nT))
+        {
+            nThreads *= 2;
+        }
+
+        // Scratch areas
+        H1H2Entry<dim> *tEntries = (H1H2Entry<dim> *)buffer;
+        H1H2Entry<dim> *fEntries = &tEntries[nT];
+        H1H2Entry<dim> *tmp = &fEntries[nT];
+        H1H2Entry<dim> *uniq = &tmp[nT];
+        uint64_t *counter = (uint64_t *)&uniq[nT]; // nT + 1 elements
+
+        // Read the t and f rows from their original layout
+#pragma omp parallel for
+        for (uint64_t i = 0; i < nT; i++)
+        {
+            tEntries[i] = H1H2Entry<dim>{};
+            tPol.toVectorU64(i, tEntries[i].key);
+            tEntries[i].idx = i;
+        }
+#pragma omp parallel for
+        for (uint64_t i = 0; i < nF; i++)
+        {
+            fEntries[i] = H1H2Entry<dim>{};
+            fPol.toVectorU64(i, fEntries[i].key);
+            fEntries[i].idx = i;
+        }
+
+        H1H2Entry<dim> *tSorted = parallelSort<dim>(tEntries, tmp, nT, nThreads);
+        H1H2Entry<dim> *fSorted = parallelSort<dim>(fEntries, (tSorted == tmp) ? tEntries : tmp, nF, nThreads);
+
+        // Keep only the last (highest index) t row of every value
+        vector<uint64_t> threadCount(nThreads + 1, 0);
+#pragma omp parallel for num_threads(nThreads)
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            uint64_t init = (nT * th) / nThreads;
+            uint64_t end = (nT * (th + 1)) / nThreads;
+            uint64_t count = 0;
+            for (uint64_t i = init; i < end; i++)
+            {
+                if ((i == nT - 1) || !tSorted[i].keyEqual(tSorted[i + 1]))
+                    count++;
+            }
+            threadCount[th + 1] = count;
+        }
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            threadCount[th + 1] += threadCount[th];
+        }
+        uint64_t nUniq = threadCount[nThreads];
+#pragma omp parallel for num_threads(nThreads)
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            uint64_t init = (nT * th) / nThreads;
+            uint64_t end = (nT * (th + 1)) / nThreads;
+            uint64_t pos = threadCount[th];
+            for (uint64_t i = init; i < end; i++)
+            {
+                if ((i == nT - 1) || !tSorted[i].keyEqual(tSorted[i + 1]))
+                    uniq[pos++] = tSorted[i];
+            }
+        }
+
+        // Every t row appears once, plus once per matching f row
+#pragma omp parallel for
+        for (uint64_t i = 0; i < nT; i++)
+        {
+            counter[i] = 1;
+        }
+
+        // Join the sorted f values with the unique t values
+#pragma omp parallel for num_threads(nThreads)
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            uint64_t init = (nF * th) / nThreads;
+            uint64_t end = (nF * (th + 1)) / nThreads;
+            if (init == end)
+                continue;
+            uint64_t u = std::lower_bound(uniq, &uniq[nUniq], fSorted[init], [](const H1H2Entry<dim> &a, const H1H2Entry<dim> &b)
+                                          { return a.keyLess(b); }) -
+                         uniq;
+            uint64_t i = init;
+            while (i < end)
+            {
+                while ((u < nUniq) && uniq[u].keyLess(fSorted[i]))
+                    u++;
+                if ((u == nUniq) || !uniq[u].keyEqual(fSorted[i]))
+                {
+                    cerr << "Error: calculateH1H2() Number not included: w=" << fSorted[i].idx << " plookup_number=" << pNumber << "\nPol:" << Goldilocks::toString(fPol[fSorted[i].idx], 16) << endl;
+                    exit(-1);
+                }
+                uint64_t run = 0;
+                while ((i < end) && uniq[u].keyEqual(fSorted[i]))
+                {
+                    run++;
+                    i++;
+                }
+#pragma omp atomic
+                counter[uniq[u].idx] += run;
+            }
+        }
+
+        // Exclusive prefix sum of the counters: counter[id] becomes the first position of t[id] in the sorted sequence
+        vector<uint64_t> threadSum(nThreads + 1, 0);
+#pragma omp parallel for num_threads(nThreads)
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            uint64_t init = (nT * th) / nThreads;
+            uint64_t end = (nT * (th + 1)) / nThreads;
+            uint64_t sum = 0;
+            for (uint64_t i = init; i < end; i++)
+            {
+                sum += counter[i];
+            }
+            threadSum[th + 1] = sum;
+        }
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            threadSum[th + 1] += threadSum[th];
+        }
+#pragma omp parallel for num_threads(nThreads)
+        for (uint64_t th = 0; th < nThreads; th++)
+        {
+            uint64_t init = (nT * th) / nThreads;
+            uint64_t end = (nT * (th + 1)) / nThreads;
+            uint64_t acc = threadSum[th];
+            for (uint64_t i = init; i < end; i++)
+            {
+                uint64_t c = counter[i];
+                counter[i] = acc;
+                acc += c;
+            }
+        }
+        counter[nT] = threadSum[nThreads];
+        zkassert(counter[nT] == nT + nF);
+
+        // Scatter the sorted sequence: even positions go to h1, odd positions go to h2
+#pragma omp parallel for
+        for (uint64_t id = 0; id < nT; id++)
+        {
+            for (uint64_t pos = counter[id]; pos < counter[id + 1]; pos++)
+            {
+                if ((pos & 1) == 0)
+                {
+                    Polinomial::copyElement(h1, pos >> 1, tPol, id);
+                }
+                else
+                {
+                    Polinomial::copyElement(h2, pos >> 1, tPol, id);
+                }
+            }
+        }
+    }
+
     static void calculateZ(Polinomial &z, Polinomial &num, Polinomial &den)
     {
         uint64_t size = num.degree();
@@ -716,6 +981,43 @@ public:
         Polinomial::copyElement(res, 0, z, 0);
     }
 
+    // pol[k] = base^k for every k < pol.degree()
+    // Every thread computes base^init by square-and-multiply and then the consecutive powers of its chunk
+    inline static void buildPowers(Polinomial &pol, Polinomial &base)
+    {
+        uint64_t size = pol.degree();
+        uint64_t nThreads = omp_get_max_threads();
+        uint64_t chunk = (size + nThreads - 1) / nThreads;
+
+#pragma omp parallel for num_threads(nThreads)
+        for (uint64_t thread_idx = 0; thread_idx < nThreads; thread_idx++)
+        {
+            uint64_t init = thread_idx * chunk;
+            uint64_t end = std::min(size, init + chunk);
+            if (init >= end)
+            {
+                continue;
+            }
+
+            Polinomial sq(1, 3);
+            Polinomial::copyElement(sq, 0, base, 0);
+            Goldilocks3::one((Goldilocks3::Element &)*pol[init]);
+            for (uint64_t e = init; e > 0; e >>= 1)
+            {
+                if (e & 1)
+                {
+                    Polinomial::mulElement(pol, init, pol, init, sq, 0);
+                }
+                Polinomial::mulElement(sq, 0, sq, 0, sq, 0);
+            }
+
+            for (uint64_t k = init + 1; k < end; k++)
+            {
+                Polinomial::mulElement(pol, k, pol, k - 1, base, 0);
+            }
+        }
+    }
+
     static inline void mulAddElement_adim3(Goldilocks::Element *out, Goldilocks::Element *in_a, Polinomial &in_b, uint64_t idx_b)
     {
         if (in_b.dim() == 1)
@@ -9,7 +9,7 @@
 #define NUM_CHALLENGES 8
 
 StarkRecursiveF::StarkRecursiveF(const Config &config) : config(config),
-                                                         starkInfo(config, config.recursivefStarkInfo),
+                                                         starkInfo(StarkRegistry::getStarkInfo(config, config.recursivefStarkInfo)),
                                                          zi(config.generateProof() ? starkInfo.starkStruct.nBits : 0,
                                                             config.generateProof() ? starkInfo.starkStruct.nBitsExt : 0),
                                                          N(config.generateProof() ? 1 << starkInfo.starkStruct.nBits : 0),
@@ -214,15 +214,14 @@ void StarkRecursiveF::genProof(void *pAddress, FRIProofC12 &proof, Goldilocks::E
     TimerStopAndLog(STARK_RECURSIVE_F_STEP_2_CALCULATE_EXPS);
 
     TimerStart(STARK_RECURSIVE_F_STEP_2_CALCULATEH1H2);
-#pragma omp parallel for
     for (uint64_t i = 0; i < starkInfo.puCtx.size(); i++)
     {
-        Polinomial fPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].fExpId)]);
-        Polinomial tPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].tExpId)]);
+        Polinomial fPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].fExpId)));
+        Polinomial tPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].tExpId)));
         Polinomial h1 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2]);
         Polinomial h2 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2 + 1]);
 
-        Polinomial::calculateH1H2(h1, h2, fPol, tPol);
+        Polinomial::calculateH1H2_parallel(h1, h2, fPol, tPol, i, (uint64_t *)pBuffer, starkInfo.mapSectionsN.section[eSection::cm1_n] * NExtended * FIELD_EXTENSION);
     }
     numCommited = numCommited + starkInfo.puCtx.size() * 2;
     TimerStopAndLog(STARK_RECURSIVE_F_STEP_2_CALCULATEH1H2);
@@ -257,24 +256,24 @@ void StarkRecursiveF::genProof(void *pAddress, FRIProofC12 &proof, Goldilocks::E
 
     for (uint64_t i = 0; i < starkInfo.puCtx.size(); i++)
     {
-        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].numId)]);
-        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].denId)]);
+        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].numId)));
+        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].denId)));
         Polinomial z = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited++]);
         Polinomial::calculateZ(z, pNum, pDen);
     }
 
     for (uint64_t i = 0; i < starkInfo.peCtx.size(); i++)
     {
-        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.peCtx[i].numId)]);
-        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.peCtx[i].denId)]);
+        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.peCtx[i].numId)));
+        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.peCtx[i].denId)));
         Polinomial z = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited++]);
         Polinomial::calculateZ(z, pNum, pDen);
     }
 
     for (uint64_t i = 0; i < starkInfo.ciCtx.size(); i++)
     {
-        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.ciCtx[i].numId)]);
-        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.ciCtx[i].denId)]);
+        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.ciCtx[i].numId)));
+        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.ciCtx[i].denId)));
         Polinomial z = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited++]);
         Polinomial::calculateZ(z, pNum, pDen);
     }
@@ -356,18 +355,12 @@ void StarkRecursiveF::genProof(void *pAddress, FRIProofC12 &proof, Goldilocks::E
     Polinomial wxis(1, 3);
     Polinomial c_w(1, 3);
 
-    Goldilocks3::one((Goldilocks3::Element &)*LEv[0]);
-    Goldilocks3::one((Goldilocks3::Element &)*LpEv[0]);
-
     Polinomial::divElement(xis, 0, challenges, 7, (Goldilocks::Element &)Goldilocks::shift());
     Polinomial::mulElement(c_w, 0, challenges, 7, (Goldilocks::Element &)Goldilocks::w(starkInfo.starkStruct.nBits));
     Polinomial::divElement(wxis, 0, c_w, 0, (Goldilocks::Element &)Goldilocks::shift());
 
-    for (uint64_t k = 1; k < N; k++)
-    {
-        Polinomial::mulElement(LEv, k, LEv, k - 1, xis, 0);
-        Polinomial::mulElement(LpEv, k, LpEv, k - 1, wxis, 0);
-    }
+    Polinomial::buildPowers(LEv, xis);
+    Polinomial::buildPowers(LpEv, wxis);
     ntt.INTT(LEv.address(), LEv.address(), N, 3);
     ntt.INTT(LpEv.address(), LpEv.address(), N, 3);
     TimerStopAndLog(STARK_RECURSIVE_F_STEP_5_LEv_LpEv);
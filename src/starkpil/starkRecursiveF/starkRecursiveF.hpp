@@ -2,6 +2,7 @@
 #define STARK_RECURSIVE_FINAL_HPP
 
 #include "stark_info.hpp"
+#include "stark_registry.hpp"
 #include "transcriptBN128.hpp"
 #include "zhInv.hpp"
 #include "merklehash_goldilocks.hpp"
@@ -27,7 +28,7 @@ class StarkRecursiveF
     const Config &config;
 
 public:
-    StarkInfo starkInfo;
+    const StarkInfo &starkInfo;
 
 private:
     void *pConstPolsAddress;
@@ -451,7 +451,7 @@ void StarkInfo::load(json j)
 
 }
 
-void StarkInfo::getPol(void *pAddress, uint64_t idPol, PolInfo &polInfo)
+void StarkInfo::getPol(void *pAddress, uint64_t idPol, PolInfo &polInfo) const
 {
     polInfo.map = varPolMap[idPol];
     polInfo.N = mapDeg.section[polInfo.map.section];
@@ -461,14 +461,14 @@ void StarkInfo::getPol(void *pAddress, uint64_t idPol, PolInfo &polInfo)
     polInfo.pAddress = ((Goldilocks::Element *)pAddress) + polInfo.offset;
 }
 
-uint64_t StarkInfo::getPolSize(uint64_t polId)
+uint64_t StarkInfo::getPolSize(uint64_t polId) const
 {
     VarPolMap p = varPolMap[polId];
     uint64_t N = mapDeg.section[p.section];
     return N * p.dim * sizeof(Goldilocks::Element);
 }
 
-Polinomial StarkInfo::getPolinomial(Goldilocks::Element *pAddress, uint64_t idPol)
+Polinomial StarkInfo::getPolinomial(Goldilocks::Element *pAddress, uint64_t idPol) const
 {
     VarPolMap polInfo = varPolMap[idPol];
     uint64_t dim = polInfo.dim;
@@ -315,13 +315,13 @@ public:
     void load (json j);
 
     /* Returns information about a polynomial specified by its ID */
-    void getPol(void * pAddress, uint64_t idPol, PolInfo &polInfo);
+    void getPol(void * pAddress, uint64_t idPol, PolInfo &polInfo) const;
 
     /* Returns the size of a polynomial specified by its ID */
-    uint64_t getPolSize(uint64_t polId);
+    uint64_t getPolSize(uint64_t polId) const;
 
     /* Returns a polynomial specified by its ID */
-    Polinomial getPolinomial(Goldilocks::Element *pAddress, uint64_t idPol);
+    Polinomial getPolinomial(Goldilocks::Element *pAddress, uint64_t idPol) const;
 
     /* Returns the size of the constant tree data/file */
     uint64_t getConstTreeSizeInBytes (void) const
@@ -0,0 +1,51 @@
+#include <map>
+#include <memory>
+#include <mutex>
+#include "stark_registry.hpp"
+#include "utils.hpp"
+#include "timer.hpp"
+#include "exit_process.hpp"
+
+static mutex registryMutex;
+static map<string, unique_ptr<StarkInfo>> starkInfos;
+static map<string, unique_ptr<VerKey>> verKeys;
+
+VerKey::VerKey(const string &file)
+{
+    TimerStart(VERKEY_LOAD);
+    file2json(file, verKeyJson);
+    if (!verKeyJson.contains("constRoot") || !verKeyJson["constRoot"].is_array() || (verKeyJson["constRoot"].size() != VERKEY_CONST_ROOT_SIZE))
+    {
+        cerr << "Error: VerKey::VerKey() found invalid constRoot in file " << file << endl;
+        exitProcess();
+    }
+    for (uint64_t i = 0; i < VERKEY_CONST_ROOT_SIZE; i++)
+    {
+        uint64_t value = verKeyJson["constRoot"][i];
+        constRoot[i] = Goldilocks::fromU64(value);
+        constRootString[i] = to_string(value);
+    }
+    TimerStopAndLog(VERKEY_LOAD);
+}
+
+const StarkInfo &StarkRegistry::getStarkInfo(const Config &config, const string &file)
+{
+    lock_guard<mutex> guard(registryMutex);
+    unique_ptr<StarkInfo> &pStarkInfo = starkInfos[file];
+    if (pStarkInfo == NULL)
+    {
+        pStarkInfo.reset(new StarkInfo(config, file));
+    }
+    return *pStarkInfo;
+}
+
+const VerKey &StarkRegistry::getVerKey(const string &file)
+{
+    lock_guard<mutex> guard(registryMutex);
+    unique_ptr<VerKey> &pVerKey = verKeys[file];
+    if (pVerKey == NULL)
+    {
+        pVerKey.reset(new VerKey(file));
+    }
+    return *pVerKey;
+}
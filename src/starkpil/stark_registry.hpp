@@ -0,0 +1,38 @@
+#ifndef STARK_REGISTRY_HPP
+#define STARK_REGISTRY_HPP
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include "config.hpp"
+#include "stark_info.hpp"
+#include "goldilocks_base_field.hpp"
+
+using ordered_json = nlohmann::ordered_json;
+using namespace std;
+
+#define VERKEY_CONST_ROOT_SIZE 4
+
+/* VerKey class contains the contents of a verification key file, e.g. recursive2.verkey.json,
+   together with its constRoot already converted to the types used by the prover */
+
+class VerKey
+{
+public:
+    ordered_json verKeyJson;
+    Goldilocks::Element constRoot[VERKEY_CONST_ROOT_SIZE];
+    string constRootString[VERKEY_CONST_ROOT_SIZE]; // Decimal strings, as written in publics and zkin files
+
+    VerKey(const string &file);
+};
+
+/* StarkRegistry keeps one parsed, immutable instance of every stark info and verification key file,
+   loaded on first use and shared by reference by all the Starks objects and proof requests */
+
+class StarkRegistry
+{
+public:
+    static const StarkInfo &getStarkInfo(const Config &config, const string &file);
+    static const VerKey &getVerKey(const string &file);
+};
+
+#endif
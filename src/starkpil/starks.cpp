@@ -1,5 +1,71 @@
+#include <immintrin.h>
 #include "starks.hpp"
 
+/* Goldilocks arithmetic on 4 elements per __m256i for evmap(), on the raw (non-Montgomery) representation of
+   Goldilocks::Element; results are canonical (< p) */
+#define EVMAP_P 0xFFFFFFFF00000001ULL
+#define EVMAP_EPSILON 0xFFFFFFFFULL // 2^64 mod p
+
+// Lane mask of a < b, unsigned
+static inline __m256i evmapLess (__m256i a, __m256i b)
+{
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+}
+
+static inline __m256i evmapCanonical (__m256i a)
+{
+    const __m256i pMinusOne = _mm256_set1_epi64x((long long)(EVMAP_P - 1));
+    const __m256i epsilon = _mm256_set1_epi64x(EVMAP_EPSILON);
+    return _mm256_blendv_epi8(a, _mm256_add_epi64(a, epsilon), evmapLess(pMinusOne, a));
+}
+
+// a + b, for canonical a and b
+static inline __m256i evmapAdd (__m256i a, __m256i b)
+{
+    const __m256i pMinusOne = _mm256_set1_epi64x((long long)(EVMAP_P - 1));
+    const __m256i epsilon = _mm256_set1_epi64x(EVMAP_EPSILON);
+    __m256i s = _mm256_add_epi64(a, b);
+    __m256i reduce = _mm256_or_si256(evmapLess(s, a), evmapLess(pMinusOne, s));
+    return _mm256_blendv_epi8(s, _mm256_add_epi64(s, epsilon), reduce);
+}
+
+// a - b, for canonical a and b
+static inline __m256i evmapSub (__m256i a, __m256i b)
+{
+    const __m256i epsilon = _mm256_set1_epi64x(EVMAP_EPSILON);
+    __m256i d = _mm256_sub_epi64(a, b);
+    return _mm256_blendv_epi8(d, _mm256_sub_epi64(d, epsilon), evmapLess(a, b));
+}
+
+// a * b, for any a and b: 128 bits product from 32 bits products, reduced with 2^64 = 2^32 - 1 and 2^96 = -1
+static inline __m256i evmapMul (__m256i a, __m256i b)
+{
+    const __m256i mask32 = _mm256_set1_epi64x(0xFFFFFFFFULL);
+    const __m256i epsilon = _mm256_set1_epi64x(EVMAP_EPSILON);
+    __m256i aH = _mm256_srli_epi64(a, 32);
+    __m256i bH = _mm256_srli_epi64(b, 32);
+    __m256i ll = _mm256_mul_epu32(a, b);
+    __m256i lh = _mm256_mul_epu32(a, bH);
+    __m256i hl = _mm256_mul_epu32(aH, b);
+    __m256i hh = _mm256_mul_epu32(aH, bH);
+    __m256i t = _mm256_add_epi64(_mm256_srli_epi64(ll, 32), _mm256_add_epi64(_mm256_and_si256(lh, mask32), _mm256_and_si256(hl, mask32)));
+    __m256i lo = _mm256_or_si256(_mm256_and_si256(ll, mask32), _mm256_slli_epi64(t, 32));
+    __m256i hi = _mm256_add_epi64(_mm256_add_epi64(hh, _mm256_srli_epi64(t, 32)), _mm256_add_epi64(_mm256_srli_epi64(lh, 32), _mm256_srli_epi64(hl, 32)));
+
+    __m256i hiHi = _mm256_srli_epi64(hi, 32);
+    __m256i hiLo = _mm256_and_si256(hi, mask32);
+    __m256i t0 = _mm256_sub_epi64(lo, hiHi);
+    t0 = _mm256_blendv_epi8(t0, _mm256_sub_epi64(t0, epsilon), evmapLess(lo, hiHi));
+    __m256i t1 = _mm256_sub_epi64(_mm256_slli_epi64(hiLo, 32), hiLo);
+    __m256i r = _mm256_add_epi64(t0, t1);
+    r = _mm256_blendv_epi8(r, _mm256_add_epi64(r, epsilon), evmapLess(r, t0));
+    return evmapCanonical(r);
+}
+
+// Rows of LEv and LpEv that evmap() transposes into lanes at a time; every polynomial is accumulated over all of them
+#define EVMAP_TILE_ROWS 64
+
 void Starks::genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps *steps)
 {
     // Initialize vars
@@ -41,7 +107,7 @@ void Starks::genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps
     //--------------------------------
     TimerStart(STARK_STEP_1);
     TimerStart(STARK_STEP_1_LDE_AND_MERKLETREE);
-    ntt.extendPol(p_cm1_2ns, p_cm1_n, NExtended, N, starkInfo.mapSectionsN.section[eSection::cm1_n], pBuffer);
+    extendPol(p_cm1_2ns, p_cm1_n, starkInfo.mapSectionsN.section[eSection::cm1_n]);
     treesGL[0]->merkelize();
     treesGL[0]->getRoot(root0.address());
     std::cout << "MerkleTree rootGL 0: [ " << root0.toString(4) << " ]" << std::endl;
@@ -65,49 +131,26 @@ void Starks::genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps
     }
     TimerStopAndLog(STARK_STEP_2_CALCULATE_EXPS);
 
-    TimerStart(STARK_STEP_2_CALCULATEH1H2_TRANSPOSE);
-    Polinomial *transPols = transposeH1H2Columns(pAddress, numCommited, pBuffer);
-    TimerStopAndLog(STARK_STEP_2_CALCULATEH1H2_TRANSPOSE);
     TimerStart(STARK_STEP_2_CALCULATEH1H2);
 
-    uint64_t nthreads = starkInfo.puCtx.size();
-    if (nthreads == 0)
-    {
-        nthreads += 1;
-    }
-    uint64_t buffSize = 8 * starkInfo.puCtx.size() * N;
-    assert(buffSize <= starkInfo.mapSectionsN.section[eSection::cm3_2ns] * NExtended);
-    uint64_t *mam = (uint64_t *)pAddress;
-    uint64_t *pbufferH = &mam[starkInfo.mapOffsets.section[eSection::cm3_2ns]];
-    uint64_t buffSizeThread = buffSize / nthreads;
-
-#pragma omp parallel for num_threads(nthreads)
+    // Every plookup is computed using all the threads, reading and writing the committed layout in place;
+    // the NTT scratch area (pBuffer) is not in use at this point, so it is used as sorting buffer
+    uint64_t buffSize = starkInfo.mapSectionsN.section[eSection::cm1_n] * N * FIELD_EXTENSION;
     for (uint64_t i = 0; i < starkInfo.puCtx.size(); i++)
     {
-        int indx1 = 4 * i;
-        if (transPols[indx1 + 2].dim() == 1)
-        {
-            uint64_t buffSizeThreadValues = 3 * N;
-            uint64_t buffSizeThreadKeys = buffSizeThread - buffSizeThreadValues;
-            Polinomial::calculateH1H2_opt1(transPols[indx1 + 2], transPols[indx1 + 3], transPols[indx1], transPols[indx1 + 1], i, &pbufferH[omp_get_thread_num() * buffSizeThread], buffSizeThreadKeys, buffSizeThreadValues);
-        }
-        else
-        {
-            assert(transPols[indx1 + 2].dim() == 3);
-            uint64_t buffSizeThreadValues = 5 * N;
-            uint64_t buffSizeThreadKeys = buffSizeThread - buffSizeThreadValues;
-            Polinomial::calculateH1H2_opt3(transPols[indx1 + 2], transPols[indx1 + 3], transPols[indx1], transPols[indx1 + 1], i, &pbufferH[omp_get_thread_num() * buffSizeThread], buffSizeThreadKeys, buffSizeThreadValues);
-        }
+        Polinomial fPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].fExpId)));
+        Polinomial tPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].tExpId)));
+        Polinomial h1 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2]);
+        Polinomial h2 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2 + 1]);
+
+        Polinomial::calculateH1H2_parallel(h1, h2, fPol, tPol, i, (uint64_t *)pBuffer, buffSize);
     }
+    numCommited = numCommited + starkInfo.puCtx.size() * 2;
     TimerStopAndLog(STARK_STEP_2_CALCULATEH1H2);
 
-    TimerStart(STARK_STEP_2_CALCULATEH1H2_TRANSPOSE_2);
-    transposeH1H2Rows(pAddress, numCommited, transPols);
-    TimerStopAndLog(STARK_STEP_2_CALCULATEH1H2_TRANSPOSE_2);
-
     TimerStart(STARK_STEP_2_LDE_AND_MERKLETREE);
 
-    ntt.extendPol(p_cm2_2ns, p_cm2_n, NExtended, N, starkInfo.mapSectionsN.section[eSection::cm2_n], pBuffer);
+    extendPol(p_cm2_2ns, p_cm2_n, starkInfo.mapSectionsN.section[eSection::cm2_n]);
     treesGL[1]->merkelize();
     treesGL[1]->getRoot(root1.address());
     std::cout << "MerkleTree rootGL 1: [ " << root1.toString(4) << " ]" << std::endl;
@@ -157,7 +200,7 @@ void Starks::genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps
     }
     TimerStopAndLog(STARK_STEP_3_CALCULATE_EXPS_2);
     TimerStart(STARK_STEP_3_LDE_AND_MERKLETREE);
-    ntt.extendPol(p_cm3_2ns, p_cm3_n, NExtended, N, starkInfo.mapSectionsN.section[eSection::cm3_n], pBuffer);
+    extendPol(p_cm3_2ns, p_cm3_n, starkInfo.mapSectionsN.section[eSection::cm3_n]);
     treesGL[2]->merkelize();
     treesGL[2]->getRoot(root2.address());
     std::cout << "MerkleTree rootGL 2: [ " << root2.toString(4) << " ]" << std::endl;
@@ -239,24 +282,18 @@ void Starks::genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps
     Polinomial wxis(1, 3);
     Polinomial c_w(1, 3);
 
-    Goldilocks3::one((Goldilocks3::Element &)*LEv[0]);
-    Goldilocks3::one((Goldilocks3::Element &)*LpEv[0]);
-
     Polinomial::divElement(xis, 0, challenges, 7, (Goldilocks::Element &)Goldilocks::shift());
     Polinomial::mulElement(c_w, 0, challenges, 7, (Goldilocks::Element &)Goldilocks::w(starkInfo.starkStruct.nBits));
     Polinomial::divElement(wxis, 0, c_w, 0, (Goldilocks::Element &)Goldilocks::shift());
 
-    for (uint64_t k = 1; k < N; k++)
-    {
-        Polinomial::mulElement(LEv, k, LEv, k - 1, xis, 0);
-        Polinomial::mulElement(LpEv, k, LpEv, k - 1, wxis, 0);
-    }
+    Polinomial::buildPowers(LEv, xis);
+    Polinomial::buildPowers(LpEv, wxis);
     ntt.INTT(LEv.address(), LEv.address(), N, 3);
     ntt.INTT(LpEv.address(), LpEv.address(), N, 3);
     TimerStopAndLog(STARK_STEP_5_LEv_LpEv);
 
     TimerStart(STARK_STEP_5_EVMAP);
-    evmap(pAddress, evals, LEv, LpEv);
+    evmap(evals, LEv, LpEv);
     TimerStopAndLog(STARK_STEP_5_EVMAP);
     TimerStart(STARK_STEP_5_XDIVXSUB);
 
@@ -316,58 +353,6 @@ void Starks::genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps
     TimerStopAndLog(STARK_STEP_FRI);
 }
 
-Polinomial *Starks::transposeH1H2Columns(void *pAddress, uint64_t &numCommited, Goldilocks::Element *pBuffer)
-{
-    Goldilocks::Element *mem = (Goldilocks::Element *)pAddress;
-
-    u_int64_t stride_pol0 = N * FIELD_EXTENSION + 8;
-    uint64_t tot_pols0 = 4 * starkInfo.puCtx.size();
-    Polinomial *transPols = new Polinomial[tot_pols0];
-
-    assert(starkInfo.mapSectionsN.section[eSection::cm1_n] * NExtended * FIELD_EXTENSION >= 3 * tot_pols0 * N);
-
-    // #pragma omp parallel for
-    for (uint64_t i = 0; i < starkInfo.puCtx.size(); i++)
-    {
-        Polinomial fPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].fExpId)]);
-        Polinomial tPol = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].tExpId)]);
-        Polinomial h1 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2]);
-        Polinomial h2 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2 + 1]);
-
-        uint64_t indx = i * 4;
-        transPols[indx].potConstruct(&(pBuffer[indx * stride_pol0]), fPol.degree(), fPol.dim(), fPol.dim());
-        Polinomial::copy(transPols[indx], fPol);
-        indx++;
-        transPols[indx].potConstruct(&(pBuffer[indx * stride_pol0]), tPol.degree(), tPol.dim(), tPol.dim());
-        Polinomial::copy(transPols[indx], tPol);
-        indx++;
-
-        transPols[indx].potConstruct(&(pBuffer[indx * stride_pol0]), h1.degree(), h1.dim(), h1.dim());
-        indx++;
-
-        transPols[indx].potConstruct(&(pBuffer[indx * stride_pol0]), h2.degree(), h2.dim(), h2.dim());
-    }
-    return transPols;
-}
-void Starks::transposeH1H2Rows(void *pAddress, uint64_t &numCommited, Polinomial *transPols)
-{
-    Goldilocks::Element *mem = (Goldilocks::Element *)pAddress;
-
-    for (uint64_t i = 0; i < starkInfo.puCtx.size(); i++)
-    {
-        int indx1 = 4 * i + 2;
-        int indx2 = 4 * i + 3;
-        Polinomial h1 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2]);
-        Polinomial h2 = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i * 2 + 1]);
-        Polinomial::copy(h1, transPols[indx1]);
-        Polinomial::copy(h2, transPols[indx2]);
-    }
-    if (starkInfo.puCtx.size() > 0)
-    {
-        delete[] transPols;
-    }
-    numCommited = numCommited + starkInfo.puCtx.size() * 2;
-}
 Polinomial *Starks::transposeZColumns(void *pAddress, uint64_t &numCommited, Goldilocks::Element *pBuffer)
 {
     Goldilocks::Element *mem = (Goldilocks::Element *)pAddress;
@@ -386,8 +371,8 @@ Polinomial *Starks::transposeZColumns(void *pAddress, uint64_t &numCommited, Gol
     // #pragma omp parallel for (better without)
     for (uint64_t i = 0; i < starkInfo.puCtx.size(); i++)
     {
-        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].numId)]);
-        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.puCtx[i].denId)]);
+        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].numId)));
+        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.puCtx[i].denId)));
         Polinomial z = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i]);
         u_int64_t indx = i * 3;
         newpols_[indx].potConstruct(&(pBuffer[indx * stride_pol_]), pNum.degree(), pNum.dim(), pNum.dim());
@@ -407,8 +392,8 @@ Polinomial *Starks::transposeZColumns(void *pAddress, uint64_t &numCommited, Gol
     u_int64_t offset = 3 * starkInfo.puCtx.size();
     for (uint64_t i = 0; i < starkInfo.peCtx.size(); i++)
     {
-        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.peCtx[i].numId)]);
-        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.peCtx[i].denId)]);
+        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.peCtx[i].numId)));
+        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.peCtx[i].denId)));
         Polinomial z = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i]);
         u_int64_t indx = 3 * i + offset;
         newpols_[indx].potConstruct(&(pBuffer[indx * stride_pol_]), pNum.degree(), pNum.dim(), pNum.dim());
@@ -429,8 +414,8 @@ Polinomial *Starks::transposeZColumns(void *pAddress, uint64_t &numCommited, Gol
     for (uint64_t i = 0; i < starkInfo.ciCtx.size(); i++)
     {
 
-        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.ciCtx[i].numId)]);
-        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol[to_string(starkInfo.ciCtx[i].denId)]);
+        Polinomial pNum = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.ciCtx[i].numId)));
+        Polinomial pDen = starkInfo.getPolinomial(mem, starkInfo.exp2pol.at(to_string(starkInfo.ciCtx[i].denId)));
         Polinomial z = starkInfo.getPolinomial(mem, starkInfo.cm_n[numCommited + i]);
         u_int64_t indx = 3 * i + offset;
 
@@ -466,117 +451,243 @@ void Starks::transposeZRows(void *pAddress, uint64_t &numCommited, Polinomial *t
         delete[] transPols;
     }
 }
-void Starks::evmap(void *pAddress, Polinomial &evals, Polinomial &LEv, Polinomial &LpEv)
+void Starks::extendPol(Goldilocks::Element *dst, Goldilocks::Element *src, uint64_t nCols)
+{
+    if (!config.lowMemoryProver)
+    {
+        ntt.extendPol(dst, src, NExtended, N, nCols, pBuffer);
+        return;
+    }
+
+    // Extend the section in blocks of columns, so that only a tile of (N + 2*NExtended) x tileCols elements
+    // lives in RAM, while the file-backed source and destination sections are accessed row by row
+    uint64_t tileCols = (config.lowMemoryProverTileSize << 20) / ((N + 2 * NExtended) * sizeof(Goldilocks::Element));
+    tileCols = std::max<uint64_t>(1, std::min(tileCols, nCols));
+
+    Goldilocks::Element *tileIn = (Goldilocks::Element *)malloc(N * tileCols * sizeof(Goldilocks::Element));
+    Goldilocks::Element *tileOut = (Goldilocks::Element *)malloc(NExtended * tileCols * sizeof(Goldilocks::Element));
+    Goldilocks::Element *tileBuffer = (Goldilocks::Element *)malloc(NExtended * tileCols * sizeof(Goldilocks::Element));
+    if (tileIn == NULL || tileOut == NULL || tileBuffer == NULL)
+    {
+        cerr << "Error: Starks::extendPol() failed calling malloc() for " << tileCols << " columns" << endl;
+        exit(-1);
+    }
+
+    for (uint64_t c0 = 0; c0 < nCols; c0 += tileCols)
+    {
+        uint64_t nc = std::min(tileCols, nCols - c0);
+
+#pragma omp parallel for
+        for (uint64_t i = 0; i < N; i++)
+        {
+            std::memcpy(&tileIn[i * nc], &src[i * nCols + c0], nc * sizeof(Goldilocks::Element));
+        }
+
+        ntt.extendPol(tileOut, tileIn, NExtended, N, nc, tileBuffer);
+
+#pragma omp parallel for
+        for (uint64_t i = 0; i < NExtended; i++)
+        {
+            std::memcpy(&dst[i * nCols + c0], &tileOut[i * nc], nc * sizeof(Goldilocks::Element));
+        }
+    }
+
+    free(tileIn);
+    free(tileOut);
+    free(tileBuffer);
+}
+
+void Starks::buildEvmapGroups(void)
 {
-    Goldilocks::Element *mem = (Goldilocks::Element *)pAddress;
-    uint64_t extendBits = starkInfo.starkStruct.nBitsExt - starkInfo.starkStruct.nBits;
-    u_int64_t size_eval = starkInfo.evMap.size();
     // Order polinomials by address, note that there are collisions!
-    map<uintptr_t, vector<uint>> map_offsets;
-    for (uint64_t i = 0; i < size_eval; i++)
+    // Every (dim, prime) pair gets its own group so that the inner loops of evmap() have no branches
+    map<uintptr_t, vector<uint64_t>> map_offsets[2][2];
+    Polinomial *pols = new Polinomial[starkInfo.evMap.size()];
+    for (uint64_t i = 0; i < starkInfo.evMap.size(); i++)
     {
         EvMap ev = starkInfo.evMap[i];
         if (ev.type == EvMap::eType::_const)
         {
-            map_offsets[reinterpret_cast<std::uintptr_t>(&((Goldilocks::Element *)pConstPols2ns->address())[ev.id])].push_back(i);
+            pols[i].potConstruct(&((Goldilocks::Element *)pConstPols2ns->address())[ev.id], pConstPols2ns->degree(), 1, pConstPols2ns->numPols());
         }
         else if (ev.type == EvMap::eType::cm)
         {
-            Polinomial pol = starkInfo.getPolinomial(mem, starkInfo.cm_2ns[ev.id]);
-            map_offsets[reinterpret_cast<std::uintptr_t>(pol.address())].push_back(i);
+            pols[i] = starkInfo.getPolinomial(mem, starkInfo.cm_2ns[ev.id]);
         }
         else if (ev.type == EvMap::eType::q)
         {
-            Polinomial pol = starkInfo.getPolinomial(mem, starkInfo.qs[ev.id]);
-            map_offsets[reinterpret_cast<std::uintptr_t>(pol.address())].push_back(i);
+            pols[i] = starkInfo.getPolinomial(mem, starkInfo.qs[ev.id]);
         }
         else
         {
             throw std::invalid_argument("Invalid ev type: " + ev.type);
         }
+        map_offsets[pols[i].dim() == 1 ? 0 : 1][ev.prime ? 1 : 0][reinterpret_cast<std::uintptr_t>(pols[i].address())].push_back(i);
     }
-    Polinomial *ordPols = new Polinomial[size_eval];
-    vector<bool> isPrime(size_eval);
-    vector<uint> indx(size_eval);
-    //   build and store ordered polinomials that need to be computed
-    uint kk = 0;
-    for (std::map<uintptr_t, std::vector<uint>>::const_iterator it = map_offsets.begin(); it != map_offsets.end(); ++it)
+
+    for (uint64_t d = 0; d < 2; d++)
     {
-        for (std::vector<uint>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+        for (uint64_t p = 0; p < 2; p++)
         {
-            EvMap ev = starkInfo.evMap[*it2];
-            if (ev.type == EvMap::eType::_const)
-            {
-                ordPols[kk].potConstruct(&((Goldilocks::Element *)pConstPols2ns->address())[ev.id], pConstPols2ns->degree(), 1, pConstPols2ns->numPols());
-            }
-            else if (ev.type == EvMap::eType::cm)
+            if (map_offsets[d][p].empty())
             {
-                ordPols[kk] = starkInfo.getPolinomial(mem, starkInfo.cm_2ns[ev.id]);
+                continue;
             }
-            else if (ev.type == EvMap::eType::q)
+            EvmapGroup group;
+            group.dim = (d == 0) ? 1 : FIELD_EXTENSION;
+            group.prime = (p == 1);
+            for (std::map<uintptr_t, std::vector<uint64_t>>::const_iterator it = map_offsets[d][p].begin(); it != map_offsets[d][p].end(); ++it)
             {
-                ordPols[kk] = starkInfo.getPolinomial(mem, starkInfo.qs[ev.id]);
+                for (std::vector<uint64_t>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+                {
+                    group.pols.push_back(pols[*it2].address());
+                    group.offsets.push_back(pols[*it2].offset());
+                    evmapIndx.push_back(*it2);
+                }
             }
-            isPrime[kk] = ev.prime;
-            indx[kk] = *it2;
-            ++kk;
+            evmapGroups.push_back(group);
         }
     }
-    assert(kk == size_eval);
-    // Build buffer for partial results of the matrix-vector product (columns distribution)  .
-    int num_threads = omp_get_max_threads();
-    Goldilocks::Element **evals_acc = (Goldilocks::Element **)malloc(num_threads * sizeof(Goldilocks::Element *));
-    for (int i = 0; i < num_threads; ++i)
+    assert(evmapIndx.size() == starkInfo.evMap.size());
+    delete[] pols;
+
+    // The kernel of evmap() processes 4 rows at a time
+    if (N % 4 != 0)
+    {
+        cerr << "Error: Starks::buildEvmapGroups() requires N to be a multiple of 4, N=" << N << endl;
+        exit(-1);
+    }
+
+    // Buffer for partial results of the matrix-vector product (rows distribution), one slice per thread
+    evmapNThreads = omp_get_max_threads();
+    evmapAcc = (Goldilocks::Element *)malloc(evmapNThreads * starkInfo.evMap.size() * FIELD_EXTENSION * 4 * sizeof(Goldilocks::Element));
+    if (evmapAcc == NULL)
     {
-        evals_acc[i] = (Goldilocks::Element *)malloc(size_eval * FIELD_EXTENSION * sizeof(Goldilocks::Element));
+        cerr << "Error: Starks::buildEvmapGroups() failed calling malloc() of size " << evmapNThreads * starkInfo.evMap.size() * FIELD_EXTENSION * 4 * sizeof(Goldilocks::Element) << endl;
+        exit(-1);
     }
-#pragma omp parallel
+}
+
+/* The rows are split in tiles of EVMAP_TILE_ROWS, distributed among the threads. The LEv and LpEv values of a
+   tile are transposed once into vectors of 4 consecutive rows, and then every polynomial, column after column,
+   is accumulated over the whole tile in registers, 4 rows per AVX2 multiply-accumulate; the accumulators of a
+   polynomial are only loaded and stored once per tile */
+void Starks::evmap(Polinomial &evals, Polinomial &LEv, Polinomial &LpEv)
+{
+    uint64_t extendBits = starkInfo.starkStruct.nBitsExt - starkInfo.starkStruct.nBits;
+    uint64_t size_eval = starkInfo.evMap.size();
+    uint64_t nGroups = evmapGroups.size();
+    uint64_t tileRows = std::min<uint64_t>(EVMAP_TILE_ROWS, N);
+    uint64_t tileSteps = tileRows / 4;
+    uint64_t nTiles = N / tileRows;
+    uint64_t sliceSize = size_eval * FIELD_EXTENSION * 4;
+
+#pragma omp parallel num_threads(evmapNThreads)
     {
-        int thread_idx = omp_get_thread_num();
-        for (uint64_t i = 0; i < size_eval * FIELD_EXTENSION; ++i)
+        uint64_t thread_idx = omp_get_thread_num();
+        Goldilocks::Element *acc = &evmapAcc[thread_idx * sliceSize];
+
+        // L[prime][step]: L0, L1, L2, L0+L1, L0+L2 and L1+L2 of the 4 rows of every step of the tile
+        __m256i L[2][EVMAP_TILE_ROWS / 4][6];
+
+        // Clear every slice, also the ones of threads that may not join this team
+#pragma omp for schedule(static)
+        for (uint64_t i = 0; i < evmapNThreads * sliceSize; ++i)
         {
-            evals_acc[thread_idx][i] = Goldilocks::zero();
+            evmapAcc[i] = Goldilocks::zero();
         }
-#pragma omp for
-        for (uint64_t k = 0; k < N; k++)
+
+#pragma omp for schedule(static)
+        for (uint64_t tile = 0; tile < nTiles; tile++)
         {
-            Goldilocks::Element *LpEv_ = &(LpEv[k][0]);
-            Goldilocks::Element *LEv_ = &(LEv[k][0]);
-            for (uint64_t i = 0; i < size_eval; i++)
+            uint64_t k0 = tile * tileRows;
+            for (uint64_t p = 0; p < 2; p++)
             {
-                Polinomial::mulAddElement_adim3(&(evals_acc[thread_idx][i * FIELD_EXTENSION]), isPrime[i] ? LpEv_ : LEv_, ordPols[i], k << extendBits);
+                Polinomial &LPol = (p == 0) ? LEv : LpEv;
+                for (uint64_t s = 0; s < tileSteps; s++)
+                {
+                    uint64_t k = k0 + 4 * s;
+                    for (uint64_t c = 0; c < FIELD_EXTENSION; c++)
+                    {
+                        L[p][s][c] = evmapCanonical(_mm256_set_epi64x(LPol[k + 3][c].fe, LPol[k + 2][c].fe, LPol[k + 1][c].fe, LPol[k][c].fe));
+                    }
+                    L[p][s][3] = evmapAdd(L[p][s][0], L[p][s][1]);
+                    L[p][s][4] = evmapAdd(L[p][s][0], L[p][s][2]);
+                    L[p][s][5] = evmapAdd(L[p][s][1], L[p][s][2]);
+                }
             }
-        }
-#pragma omp for
-        for (uint64_t i = 0; i < size_eval; ++i)
-        {
-            Goldilocks::Element sum0 = Goldilocks::zero();
-            Goldilocks::Element sum1 = Goldilocks::zero();
-            Goldilocks::Element sum2 = Goldilocks::zero();
-            int offset = i * FIELD_EXTENSION;
-            for (int k = 0; k < num_threads; ++k)
+
+            Goldilocks::Element *acc_g = acc;
+            for (uint64_t g = 0; g < nGroups; g++)
             {
-                sum0 = sum0 + evals_acc[k][offset];
-                sum1 = sum1 + evals_acc[k][offset + 1];
-                sum2 = sum2 + evals_acc[k][offset + 2];
+                EvmapGroup &group = evmapGroups[g];
+                __m256i(*Lg)[6] = L[group.prime ? 1 : 0];
+                uint64_t nPols = group.pols.size();
+                Goldilocks::Element *const *pols = group.pols.data();
+                const uint64_t *offsets = group.offsets.data();
+                for (uint64_t j = 0; j < nPols; j++)
+                {
+                    // Elements between consecutive rows of the polynomial, and between consecutive steps
+                    uint64_t rowStride = offsets[j] << extendBits;
+                    uint64_t stepStride = 4 * rowStride;
+                    __m256i vindex = _mm256_set_epi64x(3 * rowStride, 2 * rowStride, rowStride, 0);
+                    const long long *v = (const long long *)&pols[j][(k0 << extendBits) * offsets[j]];
+
+                    __m256i *acc_j = (__m256i *)&acc_g[j * FIELD_EXTENSION * 4];
+                    __m256i acc0 = _mm256_loadu_si256(&acc_j[0]);
+                    __m256i acc1 = _mm256_loadu_si256(&acc_j[1]);
+                    __m256i acc2 = _mm256_loadu_si256(&acc_j[2]);
+                    if (group.dim == 1)
+                    {
+                        for (uint64_t s = 0; s < tileSteps; s++)
+                        {
+                            __m256i v0 = _mm256_i64gather_epi64(&v[s * stepStride], vindex, 8);
+                            acc0 = evmapAdd(acc0, evmapMul(Lg[s][0], v0));
+                            acc1 = evmapAdd(acc1, evmapMul(Lg[s][1], v0));
+                            acc2 = evmapAdd(acc2, evmapMul(Lg[s][2], v0));
+                        }
+                    }
+                    else
+                    {
+                        for (uint64_t s = 0; s < tileSteps; s++)
+                        {
+                            __m256i v0 = evmapCanonical(_mm256_i64gather_epi64(&v[s * stepStride], vindex, 8));
+                            __m256i v1 = evmapCanonical(_mm256_i64gather_epi64(&v[s * stepStride + 1], vindex, 8));
+                            __m256i v2 = evmapCanonical(_mm256_i64gather_epi64(&v[s * stepStride + 2], vindex, 8));
+                            __m256i A = evmapMul(Lg[s][3], evmapAdd(v0, v1));
+                            __m256i B = evmapMul(Lg[s][4], evmapAdd(v0, v2));
+                            __m256i C = evmapMul(Lg[s][5], evmapAdd(v1, v2));
+                            __m256i D = evmapMul(Lg[s][0], v0);
+                            __m256i E = evmapMul(Lg[s][1], v1);
+                            __m256i F = evmapMul(Lg[s][2], v2);
+                            __m256i G = evmapSub(D, E);
+                            acc0 = evmapAdd(acc0, evmapSub(evmapAdd(C, G), F));
+                            acc1 = evmapAdd(acc1, evmapSub(evmapSub(evmapSub(evmapAdd(A, C), E), E), D));
+                            acc2 = evmapAdd(acc2, evmapSub(B, G));
+                        }
+                    }
+                    _mm256_storeu_si256(&acc_j[0], acc0);
+                    _mm256_storeu_si256(&acc_j[1], acc1);
+                    _mm256_storeu_si256(&acc_j[2], acc2);
+                }
+                acc_g += nPols * FIELD_EXTENSION * 4;
             }
-            evals_acc[0][offset] = sum0;
-            evals_acc[0][offset + 1] = sum1;
-            evals_acc[0][offset + 2] = sum2;
         }
-#pragma omp single
+
+        // Reduce the lanes and the partial results of every thread, and store them in evMap order
+#pragma omp for schedule(static)
         for (uint64_t i = 0; i < size_eval; ++i)
         {
-            int offset = i * FIELD_EXTENSION;
-            (evals[indx[i]])[0] = evals_acc[0][offset];
-            (evals[indx[i]])[1] = evals_acc[0][offset + 1];
-            (evals[indx[i]])[2] = evals_acc[0][offset + 2];
+            for (uint64_t c = 0; c < FIELD_EXTENSION; c++)
+            {
+                Goldilocks::Element sum = Goldilocks::zero();
+                for (uint64_t t = 0; t < evmapNThreads; ++t)
+                {
+                    Goldilocks::Element *lanes = &evmapAcc[t * sliceSize + (i * FIELD_EXTENSION + c) * 4];
+                    sum = sum + ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+                }
+                evals[evmapIndx[i]][c] = sum;
+            }
         }
     }
-    delete[] ordPols;
-    for (int i = 0; i < num_threads; ++i)
-    {
-        free(evals_acc[i]);
-    }
-    free(evals_acc);
-}
\ No newline at end of file
+}
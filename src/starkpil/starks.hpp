@@ -12,6 +12,8 @@
 #include "transcript.hpp"
 #include "zhInv.hpp"
 #include "steps.hpp"
+#include "numa_policy.hpp"
+#include "stark_registry.hpp"
 
 #define STARK_C12_A_NUM_TREES 5
 #define NUM_CHALLENGES 8
@@ -24,11 +26,20 @@ struct StarkFiles
     std::string zkevmStarkInfo;
 };
 
+// Polynomials opened by Starks::evmap() that share dimension and evaluation point (xi or w*xi)
+struct EvmapGroup
+{
+    uint64_t dim;
+    bool prime;
+    vector<Goldilocks::Element *> pols; // address of the first evaluation, sorted
+    vector<uint64_t> offsets;           // distance between consecutive evaluations
+};
+
 class Starks
 {
 public:
     const Config &config;
-    StarkInfo starkInfo;
+    const StarkInfo &starkInfo;
 
 private:
     void *pConstPolsAddress;
@@ -65,9 +76,17 @@ private:
 
     Polinomial x;
 
+    vector<EvmapGroup> evmapGroups;
+    vector<uint64_t> evmapIndx; // evMap index of every polynomial, in group order
+    uint64_t evmapNThreads;
+    Goldilocks::Element *evmapAcc; // Per thread, 4 lanes of every component of every evaluation
+
+    void buildEvmapGroups(void);
+    void extendPol(Goldilocks::Element *dst, Goldilocks::Element *src, uint64_t nCols);
+
 public:
     Starks(const Config &config, StarkFiles starkFiles, void *_pAddress) : config(config),
-                                                                           starkInfo(config, starkFiles.zkevmStarkInfo),
+                                                                           starkInfo(StarkRegistry::getStarkInfo(config, starkFiles.zkevmStarkInfo)),
                                                                            starkFiles(starkFiles),
                                                                            zi(config.generateProof() ? starkInfo.starkStruct.nBits : 0,
                                                                               config.generateProof() ? starkInfo.starkStruct.nBitsExt : 0),
@@ -132,9 +151,25 @@ public:
 
         // Initialize and allocate ConstantPols2ns
         TimerStart(LOAD_CONST_POLS_2NS_TO_MEMORY);
-        pConstPolsAddress2ns = (void *)calloc(starkInfo.nConstants * (1 << starkInfo.starkStruct.nBitsExt), sizeof(Goldilocks::Element));
+        // In low memory mode, the extended constant polynomials are read from the mapped constants tree instead of copied
+        if (config.lowMemoryProver && config.mapConstantsTreeFile)
+        {
+            pConstPolsAddress2ns = (uint8_t *)pConstTreeAddress + 2 * sizeof(Goldilocks::Element);
+        }
+        else
+        {
+            pConstPolsAddress2ns = (void *)calloc(starkInfo.nConstants * (1 << starkInfo.starkStruct.nBitsExt), sizeof(Goldilocks::Element));
+            numaPlace(pConstPolsAddress2ns, starkInfo.nConstants * (1 << starkInfo.starkStruct.nBitsExt) * sizeof(Goldilocks::Element));
+
+            // Copy by rows with the same static partition used by the kernels, so that pages are first touched by their users
+            Goldilocks::Element *pConstTreeSource = (Goldilocks::Element *)pConstTreeAddress + 2;
+#pragma omp parallel for schedule(static)
+            for (uint64_t i = 0; i < NExtended; i++)
+            {
+                std::memcpy(&((Goldilocks::Element *)pConstPolsAddress2ns)[i * starkInfo.nConstants], &pConstTreeSource[i * starkInfo.nConstants], starkInfo.nConstants * sizeof(Goldilocks::Element));
+            }
+        }
         pConstPols2ns = new ConstantPolsStarks(pConstPolsAddress2ns, (1 << starkInfo.starkStruct.nBitsExt), starkInfo.nConstants);
-        std::memcpy(pConstPolsAddress2ns, (uint8_t *)pConstTreeAddress + 2 * sizeof(Goldilocks::Element), starkInfo.nConstants * (1 << starkInfo.starkStruct.nBitsExt) * sizeof(Goldilocks::Element));
 
         TimerStopAndLog(LOAD_CONST_POLS_2NS_TO_MEMORY);
 
@@ -178,12 +213,33 @@ public:
         }
 
         TimerStart(MERKLE_TREE_ALLOCATION);
-        treesGL[0] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm1_n], p_cm1_2ns);
-        treesGL[1] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm2_n], p_cm2_2ns);
-        treesGL[2] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm3_n], p_cm3_2ns);
-        treesGL[3] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm4_2ns], cm4_2ns);
+        if (config.lowMemoryProver)
+        {
+            // Store the tree nodes in files named after the stark info file
+            string treeFile = starkFiles.zkevmStarkInfo.substr(starkFiles.zkevmStarkInfo.find_last_of('/') + 1);
+            treeFile = config.lowMemoryProverPath + "/" + treeFile.substr(0, treeFile.find_last_of('.')) + ".tree";
+            treesGL[0] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm1_n], p_cm1_2ns, treeFile + "1");
+            treesGL[1] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm2_n], p_cm2_2ns, treeFile + "2");
+            treesGL[2] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm3_n], p_cm3_2ns, treeFile + "3");
+            treesGL[3] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm4_2ns], cm4_2ns, treeFile + "4");
+        }
+        else
+        {
+            treesGL[0] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm1_n], p_cm1_2ns);
+            treesGL[1] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm2_n], p_cm2_2ns);
+            treesGL[2] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm3_n], p_cm3_2ns);
+            treesGL[3] = new MerkleTreeGL(NExtended, starkInfo.mapSectionsN.section[eSection::cm4_2ns], cm4_2ns);
+            for (uint64_t i = 0; i < 4; i++)
+            {
+                numaPlace(treesGL[i]->nodes, treesGL[i]->getTreeNumElements() * sizeof(Goldilocks::Element));
+            }
+        }
         treesGL[4] = new MerkleTreeGL((Goldilocks::Element *)pConstTreeAddress);
         TimerStopAndLog(MERKLE_TREE_ALLOCATION);
+
+        TimerStart(EVMAP_GROUPS_ALLOCATION);
+        buildEvmapGroups();
+        TimerStopAndLog(EVMAP_GROUPS_ALLOCATION);
     };
     ~Starks()
     {
@@ -192,7 +248,10 @@ public:
 
         delete pConstPols;
         delete pConstPols2ns;
-        free(pConstPolsAddress2ns);
+        if (!(config.lowMemoryProver && config.mapConstantsTreeFile))
+        {
+            free(pConstPolsAddress2ns);
+        }
 
         if (config.mapConstPolsFile)
         {
@@ -215,15 +274,15 @@ public:
         {
             delete treesGL[i];
         }
+
+        free(evmapAcc);
     };
 
     void genProof(FRIProof &proof, Goldilocks::Element *publicInputs, Steps *steps);
 
-    Polinomial *transposeH1H2Columns(void *pAddress, uint64_t &numCommited, Goldilocks::Element *pBuffer);
-    void transposeH1H2Rows(void *pAddress, uint64_t &numCommited, Polinomial *transPols);
     Polinomial *transposeZColumns(void *pAddress, uint64_t &numCommited, Goldilocks::Element *pBuffer);
     void transposeZRows(void *pAddress, uint64_t &numCommited, Polinomial *transPols);
-    void evmap(void *pAddress, Polinomial &evals, Polinomial &LEv, Polinomial &LpEv);
+    void evmap(Polinomial &evals, Polinomial &LEv, Polinomial &LpEv);
 };
 
 #endif // STARKS_H
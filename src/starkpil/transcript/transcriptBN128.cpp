@@ -80,11 +80,11 @@ void TranscriptBN128::_updateState()
         pending.push_back(RawFr::field.zero());
     }
 
-    Poseidon_opt p;
-    out.insert(out.end(), state.begin(), state.end());
-    out.insert(out.end(), pending.begin(), pending.end());
-
-    p.hash(out);
+    RawFr::Element inputs[17];
+    std::memcpy(&inputs[0], &state[0], sizeof(RawFr::Element));
+    std::memcpy(&inputs[1], &pending[0], 16 * sizeof(RawFr::Element));
+    Poseidon_opt::hashBatch<17>(inputs, 1);
+    out.insert(out.end(), inputs, inputs + 17);
 
     state[0] = out[0];
     out3.clear();
@@ -6,6 +6,7 @@
 #include "definitions.hpp"
 #include "zkresult.hpp"
 #include "utils.hpp"
+#include "metrics.hpp"
 
 // Create static Database::dbCache object. This will be used to store DB records in memory
 // and it will be shared for all the instances of Database class. DatabaseMap class is thread-safe
@@ -49,9 +50,14 @@ zkresult Database::read(const string &_key, vector<Goldilocks::Element> &value,
     string key = NormalizeToNFormat(_key, 64);
     key = stringToLower(key);
 
+    static const uint64_t cacheHitMetric = metrics.counter("zkprover_statedb_cache_total", "table=\"nodes\",result=\"hit\"");
+    static const uint64_t cacheMissMetric = metrics.counter("zkprover_statedb_cache_total", "table=\"nodes\",result=\"miss\"");
+
     // If the key is found in local database (cached) simply return it
     if (Database::dbCache.findMT(key, value))
     {
+        metrics.add(cacheHitMetric);
+
         // Add to the read log
         if (dbReadLog != NULL) dbReadLog->add(key, value);
 
@@ -59,6 +65,8 @@ zkresult Database::read(const string &_key, vector<Goldilocks::Element> &value,
     }
     else if (useRemoteDB)
     {
+        metrics.add(cacheMissMetric);
+
         // Otherwise, read it remotelly
         string sData;
         r = readRemote(config.dbNodesTableName, key, sData);
@@ -177,6 +185,10 @@ zkresult Database::readRemote(const string tableName, const string &key, string
         cout << "   Database::readRemote() table=" << tableName << " key=" << key << endl;
     }
 
+    static const uint64_t nodesMetric = metrics.histogram("zkprover_statedb_db_seconds", "op=\"read\",table=\"nodes\"");
+    static const uint64_t programMetric = metrics.histogram("zkprover_statedb_db_seconds", "op=\"read\",table=\"program\"");
+    MetricsTimer metricsTimer((tableName == config.dbProgramTableName) ? programMetric : nodesMetric);
+
     try
     {
         // Start a transaction.
@@ -222,6 +234,10 @@ zkresult Database::readRemote(const string tableName, const string &key, string
 
 zkresult Database::writeRemote(const string tableName, const string &key, const string &value)
 {
+    static const uint64_t nodesMetric = metrics.histogram("zkprover_statedb_db_seconds", "op=\"write\",table=\"nodes\"");
+    static const uint64_t programMetric = metrics.histogram("zkprover_statedb_db_seconds", "op=\"write\",table=\"program\"");
+    MetricsTimer metricsTimer((tableName == config.dbProgramTableName) ? programMetric : nodesMetric);
+
     try
     {
         string query = "INSERT INTO " + tableName + " ( hash, data ) VALUES ( E\'\\\\x" + key + "\', E\'\\\\x" + value + "\' ) " +
@@ -319,9 +335,14 @@ zkresult Database::getProgram(const string &_key, vector<uint8_t> &data, Databas
     string key = NormalizeToNFormat(_key, 64);
     key = stringToLower(key);
 
+    static const uint64_t cacheHitMetric = metrics.counter("zkprover_statedb_cache_total", "table=\"program\",result=\"hit\"");
+    static const uint64_t cacheMissMetric = metrics.counter("zkprover_statedb_cache_total", "table=\"program\",result=\"miss\"");
+
     // If the key is found in local database (cached) simply return it
     if (Database::dbCache.findProgram(key, data))
     {
+        metrics.add(cacheHitMetric);
+
         // Add to the read log
         if (dbReadLog != NULL) dbReadLog->add(key, data);
 
@@ -329,6 +350,8 @@ zkresult Database::getProgram(const string &_key, vector<uint8_t> &data, Databas
     }
     else if (useRemoteDB)
     {
+        metrics.add(cacheMissMetric);
+
         // Otherwise, read it remotelly
         string sData;
         r = readRemote(config.dbProgramTableName, key, sData);
@@ -366,17 +389,13 @@ zkresult Database::getProgram(const string &_key, vector<uint8_t> &data, Databas
 
 void Database::string2fea(const string os, vector<Goldilocks::Element> &fea)
 {
-    Goldilocks::Element fe;
-    for (uint64_t i = 0; i < os.size(); i += 16)
+    vector<Goldilocks::Element> values;
+    if (!concatenatedString2fea(fr, os, values))
     {
-        if (i + 16 > os.size())
-        {
-            cerr << "Error: Database::string2fea() found incorrect DATA column size: " << os.size() << endl;
-            exitProcess();
-        }
-        string2fe(fr, os.substr(i, 16), fe);
-        fea.push_back(fe);
+        cerr << "Error: Database::string2fea() found incorrect DATA column size: " << os.size() << endl;
+        exitProcess();
     }
+    fea.insert(fea.end(), values.begin(), values.end());
 }
 
 void Database::string2ba(const string os, vector<uint8_t> &data)
@@ -0,0 +1,252 @@
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include "database_journal.hpp"
+#include "database_map.hpp"
+#include "scalar.hpp"
+#include "utils.hpp"
+#include "exit_process.hpp"
+
+static void appendU64 (string &s, uint64_t value)
+{
+    s.append((const char *)&value, 8);
+}
+
+void DatabaseJournal::open (const string &_fileName, uint64_t _syncPeriod)
+{
+    lock_guard<mutex> guard(mlock);
+
+    if (fd >= 0)
+    {
+        cerr << "Error: DatabaseJournal::open() called when already open with file " << fileName << endl;
+        exitProcess();
+    }
+
+    fileName = _fileName;
+    syncPeriod = _syncPeriod;
+    unsyncedRecords = 0;
+
+    fd = ::open(fileName.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_APPEND, 0666);
+    if (fd < 0)
+    {
+        cerr << "Error: DatabaseJournal::open() failed opening file " << fileName << endl;
+        exitProcess();
+    }
+
+    // Write the header
+    uint8_t header[8];
+    memcpy(header, DATABASE_JOURNAL_MAGIC, 4);
+    uint32_t version = DATABASE_JOURNAL_VERSION;
+    memcpy(header + 4, &version, 4);
+    if (write(fd, header, 8) != 8)
+    {
+        cerr << "Error: DatabaseJournal::open() failed writing the header of file " << fileName << endl;
+        exitProcess();
+    }
+}
+
+void DatabaseJournal::close (void)
+{
+    lock_guard<mutex> guard(mlock);
+
+    if (fd < 0)
+        return;
+
+    fdatasync(fd);
+    ::close(fd);
+    fd = -1;
+}
+
+void DatabaseJournal::append (uint64_t type, const string &key, uint64_t size, const uint8_t *pPayload, uint64_t payloadSize)
+{
+    // Must be called with the mutex locked
+    if (fd < 0)
+        return;
+
+    // Build the record in one buffer, so that it is appended with a single write
+    record.clear();
+    appendU64(record, type);
+    uint8_t keyBytes[32] = {0};
+    if (key.size() > 0)
+    {
+        uint64_t keyBytesSize = 32;
+        string2ba(NormalizeToNFormat(key, 64), keyBytes, keyBytesSize);
+    }
+    record.append((const char *)keyBytes, 32);
+    appendU64(record, size);
+    record.append((const char *)pPayload, payloadSize);
+    if (record.size() % 8 != 0)
+    {
+        record.append(8 - (record.size() % 8), 0);
+    }
+
+    // A failure to write the journal must not stop the execution; stop journaling instead
+    if (write(fd, record.c_str(), record.size()) != (ssize_t)record.size())
+    {
+        cerr << "Error: DatabaseJournal::append() failed writing to file " << fileName << "; closing the journal" << endl;
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+
+    unsyncedRecords++;
+    if ((syncPeriod > 0) && (unsyncedRecords >= syncPeriod))
+    {
+        fdatasync(fd);
+        unsyncedRecords = 0;
+    }
+}
+
+void DatabaseJournal::addInput (const string &inputBinary)
+{
+    lock_guard<mutex> guard(mlock);
+
+    append(DATABASE_JOURNAL_INPUT, "", inputBinary.size(), (const uint8_t *)inputBinary.c_str(), inputBinary.size());
+}
+
+void DatabaseJournal::add (const string &key, const vector<Goldilocks::Element> &value)
+{
+    lock_guard<mutex> guard(mlock);
+
+    // Values that fit use the fixed-size payload
+    uint64_t nValues = value.size();
+    uint64_t payload[DATABASE_JOURNAL_MT_VALUES] = {0};
+    vector<uint64_t> longPayload;
+    uint64_t *pPayload = payload;
+    if (nValues > DATABASE_JOURNAL_MT_VALUES)
+    {
+        longPayload.resize(nValues);
+        pPayload = longPayload.data();
+    }
+    for (uint64_t i=0; i<nValues; i++)
+    {
+        pPayload[i] = Goldilocks::toU64(value[i]);
+    }
+    if (nValues <= DATABASE_JOURNAL_MT_VALUES)
+    {
+        append(DATABASE_JOURNAL_MT, key, nValues, (const uint8_t *)payload, sizeof(payload));
+    }
+    else
+    {
+        append(DATABASE_JOURNAL_MT_LONG, key, nValues, (const uint8_t *)pPayload, nValues*8);
+    }
+}
+
+void DatabaseJournal::add (const string &key, const vector<uint8_t> &value)
+{
+    lock_guard<mutex> guard(mlock);
+
+    append(DATABASE_JOURNAL_PROGRAM, key, value.size(), value.data(), value.size());
+}
+
+zkresult DatabaseJournal::load (const string &fileName, string &inputBinary, DatabaseMap &dbMap)
+{
+    uint64_t size = fileSize(fileName);
+    if (size < 8)
+    {
+        cerr << "Error: DatabaseJournal::load() found a missing or too short file " << fileName << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+    const uint8_t *pData = (const uint8_t *)mapFile(fileName, size, false);
+
+    uint32_t version;
+    memcpy(&version, pData + 4, 4);
+    if ((memcmp(pData, DATABASE_JOURNAL_MAGIC, 4) != 0) || (version != DATABASE_JOURNAL_VERSION))
+    {
+        cerr << "Error: DatabaseJournal::load() found an invalid header in file " << fileName << endl;
+        unmapFile((void *)pData, size);
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+
+    static const char hexChars[] = "0123456789abcdef";
+    bool bInput = false;
+    uint64_t nRecords = 0;
+    uint64_t offset = 8;
+    while (offset + 48 <= size)
+    {
+        uint64_t type, recordSize;
+        memcpy(&type, pData + offset, 8);
+        string key(64, '0');
+        for (uint64_t i=0; i<32; i++)
+        {
+            key[2*i] = hexChars[pData[offset + 8 + i] >> 4];
+            key[2*i + 1] = hexChars[pData[offset + 8 + i] & 0x0F];
+        }
+        memcpy(&recordSize, pData + offset + 40, 8);
+        const uint8_t *pPayload = pData + offset + 48;
+
+        // Calculate the payload size, and stop at a truncated record
+        uint64_t payloadSize;
+        switch (type)
+        {
+            case DATABASE_JOURNAL_MT:      payloadSize = 8*DATABASE_JOURNAL_MT_VALUES; break;
+            case DATABASE_JOURNAL_MT_LONG: payloadSize = (recordSize < size/8) ? 8*recordSize : size; break;
+            case DATABASE_JOURNAL_PROGRAM:
+            case DATABASE_JOURNAL_INPUT:   payloadSize = (recordSize < size) ? ((recordSize + 7)/8)*8 : size; break;
+            default:
+            {
+                cerr << "Error: DatabaseJournal::load() found an invalid record type=" << type << " at offset=" << offset << " of file " << fileName << endl;
+                unmapFile((void *)pData, size);
+                return ZKR_INPUT_INVALID_FORMAT;
+            }
+        }
+        if (offset + 48 + payloadSize > size)
+        {
+            break;
+        }
+
+        switch (type)
+        {
+            case DATABASE_JOURNAL_MT:
+            case DATABASE_JOURNAL_MT_LONG:
+            {
+                if ((type == DATABASE_JOURNAL_MT) && (recordSize > DATABASE_JOURNAL_MT_VALUES))
+                {
+                    cerr << "Error: DatabaseJournal::load() found a record with invalid size=" << recordSize << " at offset=" << offset << " of file " << fileName << endl;
+                    unmapFile((void *)pData, size);
+                    return ZKR_INPUT_INVALID_FORMAT;
+                }
+                vector<Goldilocks::Element> value(recordSize);
+                for (uint64_t i=0; i<recordSize; i++)
+                {
+                    uint64_t u64;
+                    memcpy(&u64, pPayload + 8*i, 8);
+                    value[i] = Goldilocks::fromU64(u64);
+                }
+                dbMap.add(key, value);
+                break;
+            }
+            case DATABASE_JOURNAL_PROGRAM:
+            {
+                dbMap.add(key, vector<uint8_t>(pPayload, pPayload + recordSize));
+                break;
+            }
+            case DATABASE_JOURNAL_INPUT:
+            {
+                inputBinary.assign((const char *)pPayload, recordSize);
+                bInput = true;
+                break;
+            }
+        }
+
+        offset += 48 + payloadSize;
+        nRecords++;
+    }
+
+    if (offset != size)
+    {
+        cout << "Warning: DatabaseJournal::load() ignored a truncated record at offset=" << offset << " of file " << fileName << endl;
+    }
+    cout << "DatabaseJournal::load() read " << nRecords << " records from file " << fileName << endl;
+
+    unmapFile((void *)pData, size);
+
+    if (!bInput)
+    {
+        cerr << "Error: DatabaseJournal::load() found no input record in file " << fileName << endl;
+        return ZKR_INPUT_INVALID_FORMAT;
+    }
+
+    return ZKR_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#ifndef DATABASE_JOURNAL_HPP
+#define DATABASE_JOURNAL_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include "goldilocks_base_field.hpp"
+#include "zkresult.hpp"
+
+using namespace std;
+
+class DatabaseMap;
+
+/* Append-only binary journal of the database reads of an execution
+   Every entry added to the read log is appended to the file as it happens, so the file is valid
+   after a crash without rewriting it. All integers are little endian.
+     Header: magic "ZKDJ" (4 B), version (u32)
+     Records: type (u64), key (32 B), size (u64), followed by the payload:
+       DATABASE_JOURNAL_MT: size values (u64), in a fixed-size payload of 12 values, unused set to zero
+       DATABASE_JOURNAL_MT_LONG: size values (u64), for values longer than 12
+       DATABASE_JOURNAL_PROGRAM: size bytes, padded with zeros to a multiple of 8
+       DATABASE_JOURNAL_INPUT: size bytes of the batch input in binary format, padded as above; key is zero
+   A record truncated by a crash at the end of the file is ignored when reading it back */
+
+#define DATABASE_JOURNAL_MAGIC "ZKDJ"
+#define DATABASE_JOURNAL_VERSION 1
+#define DATABASE_JOURNAL_MT_VALUES 12
+
+#define DATABASE_JOURNAL_MT 1
+#define DATABASE_JOURNAL_MT_LONG 2
+#define DATABASE_JOURNAL_PROGRAM 3
+#define DATABASE_JOURNAL_INPUT 4
+
+class DatabaseJournal
+{
+private:
+    mutex mlock; // Protects the fields below
+    int fd;
+    string fileName;
+    uint64_t syncPeriod; // Records between fsync calls; 0 means only when closing
+    uint64_t unsyncedRecords;
+    string record; // Buffer to build the record being appended
+
+    void append (uint64_t type, const string &key, uint64_t size, const uint8_t *pPayload, uint64_t payloadSize);
+
+public:
+    DatabaseJournal () : fd(-1), syncPeriod(0), unsyncedRecords(0) {};
+    ~DatabaseJournal () { close(); };
+
+    // Creates the journal file, truncating it if it exists
+    void open (const string &fileName, uint64_t syncPeriod);
+    void close (void);
+
+    // Append records
+    void addInput (const string &inputBinary);
+    void add (const string &key, const vector<Goldilocks::Element> &value);
+    void add (const string &key, const vector<uint8_t> &value);
+
+    // Reads a journal file back into the input, in binary format, and the database reads
+    static zkresult load (const string &fileName, string &inputBinary, DatabaseMap &dbMap);
+};
+
+#endif
@@ -1,12 +1,14 @@
 #include "database_map.hpp"
 #include "utils.hpp"
 #include "scalar.hpp"
+#include "memory_size.hpp"
 
 void DatabaseMap::add(const string key, vector<Goldilocks::Element> value)
 {
     lock_guard<recursive_mutex> guard(mlock);
 
     mtDB[key] = value;
+    if (pJournal != NULL) pJournal->add(key, value);
     if (callbackOnChange) onChangeCallback();
 }
 
@@ -15,6 +17,7 @@ void DatabaseMap::add(const string key, vector<uint8_t> value)
     lock_guard<recursive_mutex> guard(mlock);
 
     programDB[key] = value;
+    if (pJournal != NULL) pJournal->add(key, value);
     if (callbackOnChange) onChangeCallback();
 }
 
@@ -22,7 +25,11 @@ void DatabaseMap::add(MTMap &db)
 {
     lock_guard<recursive_mutex> guard(mlock);
 
-    mtDB.insert(db.begin(), db.end());
+    // Existing entries are kept, so only the inserted ones are journaled
+    for (MTMap::const_iterator it = db.begin(); it != db.end(); it++)
+    {
+        if (mtDB.insert(*it).second && (pJournal != NULL)) pJournal->add(it->first, it->second);
+    }
     if (callbackOnChange) onChangeCallback();
 }
 
@@ -30,7 +37,11 @@ void DatabaseMap::add(ProgramMap &db)
 {
     lock_guard<recursive_mutex> guard(mlock);
 
-    programDB.insert(db.begin(), db.end());
+    // Existing entries are kept, so only the inserted ones are journaled
+    for (ProgramMap::const_iterator it = db.begin(); it != db.end(); it++)
+    {
+        if (programDB.insert(*it).second && (pJournal != NULL)) pJournal->add(it->first, it->second);
+    }
     if (callbackOnChange) onChangeCallback();
 }
 
@@ -78,6 +89,21 @@ DatabaseMap::ProgramMap DatabaseMap::getProgramDB()
     return programDB;
 }
 
+uint64_t DatabaseMap::memorySize()
+{
+    lock_guard<recursive_mutex> guard(mlock);
+
+    return ::memorySize(mtDB) + ::memorySize(programDB);
+}
+
+void DatabaseMap::clear()
+{
+    lock_guard<recursive_mutex> guard(mlock);
+
+    mtDB.clear();
+    programDB.clear();
+}
+
 void DatabaseMap::setOnChangeCallback(void *instance, onChangeCallbackFunctionPtr function)
 {
     lock_guard<recursive_mutex> guard(mlock);
@@ -90,6 +116,13 @@ void DatabaseMap::setOnChangeCallback(void *instance, onChangeCallbackFunctionPt
     } else callbackOnChange = false;
 }
 
+void DatabaseMap::setJournal(DatabaseJournal *journal)
+{
+    lock_guard<recursive_mutex> guard(mlock);
+
+    pJournal = journal;
+}
+
 void DatabaseMap::onChangeCallback()
 {
     cbFunction(cbInstance, this);
@@ -5,6 +5,7 @@
 #include "goldilocks_base_field.hpp"
 #include <nlohmann/json.hpp>
 #include <mutex>
+#include "database_journal.hpp"
 
 using namespace std;
 using json = nlohmann::json;
@@ -27,6 +28,7 @@ private:
     bool callbackOnChange = false;
     onChangeCallbackFunctionPtr cbFunction = NULL;
     void *cbInstance = NULL;
+    DatabaseJournal *pJournal = NULL; // If set, every added entry is also appended to it
 
     void onChangeCallback();
 
@@ -40,7 +42,10 @@ public:
     bool findProgram(const string key, vector<uint8_t> &value);
     MTMap getMTDB();
     ProgramMap getProgramDB();
+    uint64_t memorySize(); // Heap bytes retained by the maps
+    void clear(); // Removes all the entries, without calling the on change callback
     void setOnChangeCallback(void *instance, onChangeCallbackFunctionPtr function);
+    void setJournal(DatabaseJournal *journal);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#ifndef MEMORY_SIZE_HPP
+#define MEMORY_SIZE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <gmpxx.h>
+#include <nlohmann/json.hpp>
+
+using namespace std;
+
+// Heap bytes owned by common containers, as laid out by libstdc++, to account the memory retained
+// by long-lived objects; the size of the object itself is not included, since it is accounted by
+// its owner
+
+// Bytes of a short string stored inside the string object itself
+#define MEMORY_SIZE_SSO_CAPACITY 15
+
+// Bytes of the header of a node of a std::map (color, parent, left and right) and of a node of
+// a std::unordered_map (next pointer), excluding the value and the cached hash
+#define MEMORY_SIZE_MAP_NODE_HEADER 32
+#define MEMORY_SIZE_UNORDERED_MAP_NODE_HEADER 8
+
+inline uint64_t memorySize (const string &s)
+{
+    return (s.capacity() > MEMORY_SIZE_SSO_CAPACITY) ? s.capacity() + 1 : 0;
+}
+
+inline uint64_t memorySize (const mpz_class &n)
+{
+    return n.get_mpz_t()->_mp_alloc * sizeof(mp_limb_t);
+}
+
+template <typename T>
+uint64_t memorySize (const vector<T> &v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+inline uint64_t memorySize (const vector<string> &v)
+{
+    uint64_t size = v.capacity() * sizeof(string);
+    for (uint64_t i = 0; i < v.size(); i++)
+        size += memorySize(v[i]);
+    return size;
+}
+
+inline uint64_t memorySize (const vector<mpz_class> &v)
+{
+    uint64_t size = v.capacity() * sizeof(mpz_class);
+    for (uint64_t i = 0; i < v.size(); i++)
+        size += memorySize(v[i]);
+    return size;
+}
+
+// Bytes of the buckets and nodes of an unordered map, without what its keys and values point to
+template <typename K, typename V, typename H, typename E, typename A>
+uint64_t unorderedMapNodesSize (const unordered_map<K, V, H, E, A> &m)
+{
+    return m.bucket_count() * sizeof(void *) + m.size() * (MEMORY_SIZE_UNORDERED_MAP_NODE_HEADER + sizeof(pair<const K, V>) + sizeof(size_t));
+}
+
+inline uint64_t memorySize (const unordered_map<string, string> &m)
+{
+    uint64_t size = unorderedMapNodesSize(m);
+    for (auto it = m.begin(); it != m.end(); it++)
+        size += memorySize(it->first) + memorySize(it->second);
+    return size;
+}
+
+template <typename V>
+uint64_t memorySize (const unordered_map<string, vector<V>> &m)
+{
+    uint64_t size = unorderedMapNodesSize(m);
+    for (auto it = m.begin(); it != m.end(); it++)
+        size += memorySize(it->first) + memorySize(it->second);
+    return size;
+}
+
+// Bytes of the entries of a json object, without what their keys and values point to
+template <typename K, typename V, typename C, typename A>
+uint64_t jsonObjectEntriesSize (const map<K, V, C, A> &m)
+{
+    return m.size() * (MEMORY_SIZE_MAP_NODE_HEADER + sizeof(typename map<K, V, C, A>::value_type));
+}
+
+template <typename K, typename V, typename C, typename A>
+uint64_t jsonObjectEntriesSize (const nlohmann::ordered_map<K, V, C, A> &m)
+{
+    return m.capacity() * sizeof(typename nlohmann::ordered_map<K, V, C, A>::value_type);
+}
+
+// Works for json and ordered_json
+template <typename BasicJsonType>
+uint64_t jsonMemorySize (const BasicJsonType &j)
+{
+    switch (j.type())
+    {
+        case nlohmann::json::value_t::object:
+        {
+            const typename BasicJsonType::object_t &object = j.template get_ref<const typename BasicJsonType::object_t &>();
+            uint64_t size = sizeof(object) + jsonObjectEntriesSize(object);
+            for (auto it = object.begin(); it != object.end(); it++)
+                size += memorySize(it->first) + jsonMemorySize(it->second);
+            return size;
+        }
+        case nlohmann::json::value_t::array:
+        {
+            const typename BasicJsonType::array_t &array = j.template get_ref<const typename BasicJsonType::array_t &>();
+            uint64_t size = sizeof(array) + array.capacity() * sizeof(BasicJsonType);
+            for (uint64_t i = 0; i < array.size(); i++)
+                size += jsonMemorySize(array[i]);
+            return size;
+        }
+        case nlohmann::json::value_t::string:
+        {
+            const typename BasicJsonType::string_t &s = j.template get_ref<const typename BasicJsonType::string_t &>();
+            return sizeof(s) + memorySize(s);
+        }
+        case nlohmann::json::value_t::binary:
+        {
+            const typename BasicJsonType::binary_t &b = j.template get_ref<const typename BasicJsonType::binary_t &>();
+            return sizeof(b) + b.capacity();
+        }
+        default:
+            return 0;
+    }
+}
+
+#endif
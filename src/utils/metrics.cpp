@@ -0,0 +1,404 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include "metrics.hpp"
+#include "exit_process.hpp"
+
+Metrics metrics;
+
+/* MetricsHistogram */
+
+uint64_t MetricsHistogram::bucket (uint64_t value)
+{
+    if (value < METRICS_HISTOGRAM_SUB_BUCKETS)
+    {
+        return value;
+    }
+    uint64_t exponent = 63 - __builtin_clzll(value);
+    uint64_t subBucket = (value >> (exponent - 3)) & (METRICS_HISTOGRAM_SUB_BUCKETS - 1);
+    return (exponent - 2)*METRICS_HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+uint64_t MetricsHistogram::bucketUpperBound (uint64_t bucket)
+{
+    if (bucket < METRICS_HISTOGRAM_SUB_BUCKETS)
+    {
+        return bucket + 1;
+    }
+    uint64_t exponent = bucket/METRICS_HISTOGRAM_SUB_BUCKETS + 2;
+    uint64_t subBucket = bucket%METRICS_HISTOGRAM_SUB_BUCKETS;
+    if ((exponent == 63) && (subBucket == METRICS_HISTOGRAM_SUB_BUCKETS - 1))
+    {
+        return UINT64_MAX;
+    }
+    return (METRICS_HISTOGRAM_SUB_BUCKETS + subBucket + 1) << (exponent - 3);
+}
+
+void MetricsHistogram::observe (uint64_t value)
+{
+    count++;
+    sum += value;
+    buckets[bucket(value)]++;
+}
+
+void MetricsHistogram::merge (const MetricsHistogram &other)
+{
+    count += other.count;
+    sum += other.sum;
+    for (uint64_t i=0; i<METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+uint64_t MetricsHistogram::percentile (double fraction) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint64_t target = fraction*count;
+    uint64_t accumulated = 0;
+    for (uint64_t i=0; i<METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        accumulated += buckets[i];
+        if ((accumulated > target) || (accumulated == count))
+        {
+            return bucketUpperBound(i);
+        }
+    }
+    return UINT64_MAX;
+}
+
+/* MetricsThreadBuffer */
+
+MetricsThreadBuffer::~MetricsThreadBuffer ()
+{
+    for (uint64_t i=0; i<histograms.size(); i++)
+    {
+        if (histograms[i] != NULL)
+        {
+            delete histograms[i];
+        }
+    }
+}
+
+void MetricsThreadBuffer::merge (vector<uint64_t> &totalCounters, vector<MetricsHistogram *> &totalHistograms)
+{
+    lock_guard<mutex> guard(mlock);
+
+    for (uint64_t i=0; i<counters.size(); i++)
+    {
+        totalCounters[i] += counters[i];
+    }
+    for (uint64_t i=0; i<histograms.size(); i++)
+    {
+        if (histograms[i] == NULL)
+        {
+            continue;
+        }
+        if (totalHistograms[i] == NULL)
+        {
+            totalHistograms[i] = new MetricsHistogram();
+        }
+        totalHistograms[i]->merge(*histograms[i]);
+    }
+}
+
+// Retires the buffer of the calling thread into the registry totals when the thread ends
+class MetricsThreadBufferOwner
+{
+public:
+    MetricsThreadBuffer *pThreadBuffer;
+    MetricsThreadBufferOwner () : pThreadBuffer(NULL) {};
+    ~MetricsThreadBufferOwner ()
+    {
+        if (pThreadBuffer != NULL)
+        {
+            metrics.retire(pThreadBuffer);
+        }
+    }
+};
+
+static thread_local MetricsThreadBufferOwner threadBufferOwner;
+
+/* Metrics */
+
+uint64_t Metrics::registerMetric (const string &name, const string &labels, tMetricType type)
+{
+    lock_guard<mutex> guard(mlock);
+
+    string key = name + "{" + labels + "}";
+    map<string, uint64_t>::const_iterator it = ids.find(key);
+    if (it != ids.end())
+    {
+        if (descriptors[it->second].type != type)
+        {
+            cerr << "Error: Metrics::registerMetric() found metric " << key << " already registered with a different type" << endl;
+            exitProcess();
+        }
+        return it->second;
+    }
+
+    // All the series of a family must have the same type
+    for (uint64_t i=0; i<descriptors.size(); i++)
+    {
+        if ((descriptors[i].name == name) && (descriptors[i].type != type))
+        {
+            cerr << "Error: Metrics::registerMetric() found family " << name << " already registered with a different type" << endl;
+            exitProcess();
+        }
+    }
+
+    MetricDescriptor descriptor;
+    descriptor.name = name;
+    descriptor.labels = labels;
+    descriptor.type = type;
+    uint64_t id = descriptors.size();
+    descriptors.push_back(descriptor);
+    ids[key] = id;
+    gauges.push_back(0);
+    retiredCounters.push_back(0);
+    retiredHistograms.push_back(NULL);
+    return id;
+}
+
+uint64_t Metrics::counter (const string &name, const string &labels)
+{
+    return registerMetric(name, labels, mt_counter);
+}
+
+uint64_t Metrics::gauge (const string &name, const string &labels)
+{
+    return registerMetric(name, labels, mt_gauge);
+}
+
+uint64_t Metrics::histogram (const string &name, const string &labels)
+{
+    return registerMetric(name, labels, mt_histogram);
+}
+
+MetricsThreadBuffer &Metrics::threadBuffer (void)
+{
+    if (threadBufferOwner.pThreadBuffer == NULL)
+    {
+        MetricsThreadBuffer *pThreadBuffer = new MetricsThreadBuffer();
+        lock_guard<mutex> guard(mlock);
+        threadBuffers.push_back(pThreadBuffer);
+        threadBufferOwner.pThreadBuffer = pThreadBuffer;
+    }
+    return *threadBufferOwner.pThreadBuffer;
+}
+
+void Metrics::add (uint64_t counterId, uint64_t value)
+{
+    MetricsThreadBuffer &buffer = threadBuffer();
+    lock_guard<mutex> guard(buffer.mlock);
+    if (counterId >= buffer.counters.size())
+    {
+        buffer.counters.resize(counterId + 1, 0);
+    }
+    buffer.counters[counterId] += value;
+}
+
+void Metrics::set (uint64_t gaugeId, int64_t value)
+{
+    lock_guard<mutex> guard(mlock);
+    gauges[gaugeId] = value;
+}
+
+void Metrics::observe (uint64_t histogramId, uint64_t us)
+{
+    MetricsThreadBuffer &buffer = threadBuffer();
+    lock_guard<mutex> guard(buffer.mlock);
+    if (histogramId >= buffer.histograms.size())
+    {
+        buffer.histograms.resize(histogramId + 1, NULL);
+    }
+    if (buffer.histograms[histogramId] == NULL)
+    {
+        buffer.histograms[histogramId] = new MetricsHistogram();
+    }
+    buffer.histograms[histogramId]->observe(us);
+}
+
+void Metrics::retire (MetricsThreadBuffer *pThreadBuffer)
+{
+    lock_guard<mutex> guard(mlock);
+    pThreadBuffer->merge(retiredCounters, retiredHistograms);
+    threadBuffers.erase(remove(threadBuffers.begin(), threadBuffers.end(), pThreadBuffer), threadBuffers.end());
+    delete pThreadBuffer;
+}
+
+void Metrics::snapshot (vector<MetricDescriptor> &snapshotDescriptors, vector<int64_t> &snapshotGauges, vector<uint64_t> &snapshotCounters, vector<MetricsHistogram *> &snapshotHistograms)
+{
+    lock_guard<mutex> guard(mlock);
+
+    snapshotDescriptors = descriptors;
+    snapshotGauges = gauges;
+    snapshotCounters = retiredCounters;
+    snapshotHistograms.assign(descriptors.size(), NULL);
+    for (uint64_t i=0; i<retiredHistograms.size(); i++)
+    {
+        if (retiredHistograms[i] != NULL)
+        {
+            snapshotHistograms[i] = new MetricsHistogram(*retiredHistograms[i]);
+        }
+    }
+    for (uint64_t i=0; i<threadBuffers.size(); i++)
+    {
+        threadBuffers[i]->merge(snapshotCounters, snapshotHistograms);
+    }
+}
+
+// Returns the metric ids sorted by family name and labels, since the series of a family must be exported together
+static vector<uint64_t> sortedIds (const vector<MetricDescriptor> &descriptors)
+{
+    vector<uint64_t> result(descriptors.size());
+    for (uint64_t i=0; i<result.size(); i++)
+    {
+        result[i] = i;
+    }
+    sort(result.begin(), result.end(), [&descriptors](uint64_t a, uint64_t b)
+    {
+        if (descriptors[a].name != descriptors[b].name)
+            return descriptors[a].name < descriptors[b].name;
+        return descriptors[a].labels < descriptors[b].labels;
+    });
+    return result;
+}
+
+static string seriesName (const string &name, const string &labels, const string &extraLabel = "")
+{
+    string allLabels = labels;
+    if (extraLabel.size() > 0)
+    {
+        allLabels += (allLabels.size() > 0 ? "," : "") + extraLabel;
+    }
+    if (allLabels.size() == 0)
+    {
+        return name;
+    }
+    return name + "{" + allLabels + "}";
+}
+
+string Metrics::prometheus (void)
+{
+    vector<MetricDescriptor> snapshotDescriptors;
+    vector<int64_t> snapshotGauges;
+    vector<uint64_t> snapshotCounters;
+    vector<MetricsHistogram *> snapshotHistograms;
+    snapshot(snapshotDescriptors, snapshotGauges, snapshotCounters, snapshotHistograms);
+
+    static const char * typeNames[] = { "counter", "gauge", "histogram" };
+
+    ostringstream os;
+    vector<uint64_t> order = sortedIds(snapshotDescriptors);
+    string lastName;
+    for (uint64_t o=0; o<order.size(); o++)
+    {
+        uint64_t i = order[o];
+        const MetricDescriptor &descriptor = snapshotDescriptors[i];
+        if (descriptor.name != lastName)
+        {
+            os << "# TYPE " << descriptor.name << " " << typeNames[descriptor.type] << "\n";
+            lastName = descriptor.name;
+        }
+        switch (descriptor.type)
+        {
+            case mt_counter:
+                os << seriesName(descriptor.name, descriptor.labels) << " " << snapshotCounters[i] << "\n";
+                break;
+            case mt_gauge:
+                os << seriesName(descriptor.name, descriptor.labels) << " " << snapshotGauges[i] << "\n";
+                break;
+            case mt_histogram:
+            {
+                MetricsHistogram empty;
+                const MetricsHistogram &histogram = (snapshotHistograms[i] != NULL) ? *snapshotHistograms[i] : empty;
+
+                // Buckets of powers of 4 us, from 1 us to 4^18 us (~19 hours); a bucket counts the
+                // observations below its bound, at the resolution of the histogram buckets
+                uint64_t b = 0;
+                uint64_t accumulated = 0;
+                for (uint64_t e=0; e<=36; e+=2)
+                {
+                    uint64_t bound = uint64_t(1) << e;
+                    while ((b < METRICS_HISTOGRAM_BUCKETS) && (MetricsHistogram::bucketUpperBound(b) <= bound))
+                    {
+                        accumulated += histogram.buckets[b];
+                        b++;
+                    }
+                    os << seriesName(descriptor.name + "_bucket", descriptor.labels, "le=\"" + to_string(double(bound)/1000000) + "\"") << " " << accumulated << "\n";
+                }
+                os << seriesName(descriptor.name + "_bucket", descriptor.labels, "le=\"+Inf\"") << " " << histogram.count << "\n";
+                os << seriesName(descriptor.name + "_sum", descriptor.labels) << " " << double(histogram.sum)/1000000 << "\n";
+                os << seriesName(descriptor.name + "_count", descriptor.labels) << " " << histogram.count << "\n";
+                break;
+            }
+        }
+    }
+
+    for (uint64_t i=0; i<snapshotHistograms.size(); i++)
+    {
+        if (snapshotHistograms[i] != NULL)
+        {
+            delete snapshotHistograms[i];
+        }
+    }
+
+    return os.str();
+}
+
+void Metrics::print (void)
+{
+    vector<MetricDescriptor> snapshotDescriptors;
+    vector<int64_t> snapshotGauges;
+    vector<uint64_t> snapshotCounters;
+    vector<MetricsHistogram *> snapshotHistograms;
+    snapshot(snapshotDescriptors, snapshotGauges, snapshotCounters, snapshotHistograms);
+
+    cout << "Metrics::print():" << endl;
+    vector<uint64_t> order = sortedIds(snapshotDescriptors);
+    for (uint64_t o=0; o<order.size(); o++)
+    {
+        uint64_t i = order[o];
+        const MetricDescriptor &descriptor = snapshotDescriptors[i];
+        cout << "    " << seriesName(descriptor.name, descriptor.labels);
+        switch (descriptor.type)
+        {
+            case mt_counter:
+                cout << " = " << snapshotCounters[i] << endl;
+                break;
+            case mt_gauge:
+                cout << " = " << snapshotGauges[i] << endl;
+                break;
+            case mt_histogram:
+            {
+                if (snapshotHistograms[i] == NULL)
+                {
+                    cout << " count=0" << endl;
+                    break;
+                }
+                const MetricsHistogram &histogram = *snapshotHistograms[i];
+                cout << " count=" << histogram.count
+                     << " avg=" << histogram.sum/histogram.count << "us"
+                     << " p50<" << histogram.percentile(0.5) << "us"
+                     << " p99<" << histogram.percentile(0.99) << "us"
+                     << " max<" << histogram.percentile(1) << "us" << endl;
+                delete snapshotHistograms[i];
+                break;
+            }
+        }
+    }
+}
+
+/* MetricsTimer */
+
+MetricsTimer::~MetricsTimer ()
+{
+    struct timeval endTime;
+    gettimeofday(&endTime, NULL);
+    int64_t us = (int64_t(endTime.tv_sec) - int64_t(startTime.tv_sec))*1000000 + (int64_t(endTime.tv_usec) - int64_t(startTime.tv_usec));
+    metrics.observe(histogramId, (us > 0) ? us : 0);
+}
@@ -0,0 +1,122 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <sys/time.h>
+
+using namespace std;
+
+/* Metrics registry: named counters, gauges and latency histograms, exported in Prometheus text format
+   A metric is registered once, by family name and labels (e.g. "timer=\"STARK_PROOF\""), and then
+   updated through its id. Counters and histograms are updated in per-thread buffers, so updating
+   them does not contend with other threads; the buffers are merged when the metrics are exported */
+
+/* Histogram buckets are log-linear, like HDR histograms: values below 8 have their own bucket, and
+   every power of 2 above them is split in 8 sub-buckets, so the relative error is below 12.5% */
+#define METRICS_HISTOGRAM_SUB_BUCKETS 8
+#define METRICS_HISTOGRAM_BUCKETS (62*METRICS_HISTOGRAM_SUB_BUCKETS)
+
+enum tMetricType
+{
+    mt_counter = 0,
+    mt_gauge = 1,
+    mt_histogram = 2
+};
+
+class MetricsHistogram
+{
+public:
+    uint64_t count;
+    uint64_t sum;
+    uint64_t buckets[METRICS_HISTOGRAM_BUCKETS];
+
+    MetricsHistogram () : count(0), sum(0), buckets{} {};
+    void observe (uint64_t value);
+    void merge (const MetricsHistogram &other);
+
+    // Returns the value below which the given fraction (0...1) of the observations are, at bucket resolution
+    uint64_t percentile (double fraction) const;
+
+    static uint64_t bucket (uint64_t value);
+    static uint64_t bucketUpperBound (uint64_t bucket); // Exclusive
+};
+
+// Counters and histograms updated by one thread
+class MetricsThreadBuffer
+{
+public:
+    mutex mlock; // Taken by the owner thread to update it, and by the exporter to merge it
+    vector<uint64_t> counters; // Indexed by metric id
+    vector<MetricsHistogram *> histograms; // Indexed by metric id, allocated on first use
+    ~MetricsThreadBuffer ();
+    void merge (vector<uint64_t> &totalCounters, vector<MetricsHistogram *> &totalHistograms);
+};
+
+class MetricDescriptor
+{
+public:
+    string name;
+    string labels;
+    tMetricType type;
+};
+
+class Metrics
+{
+private:
+    mutex mlock; // Protects the fields below
+    vector<MetricDescriptor> descriptors; // Indexed by metric id
+    map<string, uint64_t> ids; // name{labels} -> metric id
+    vector<int64_t> gauges; // Indexed by metric id
+    vector<MetricsThreadBuffer *> threadBuffers; // Buffers of the running threads
+    vector<uint64_t> retiredCounters; // Totals of the threads that have ended
+    vector<MetricsHistogram *> retiredHistograms;
+
+    uint64_t registerMetric (const string &name, const string &labels, tMetricType type);
+    MetricsThreadBuffer &threadBuffer (void);
+
+    // Returns a snapshot of the descriptors, gauges and merged counters and histograms
+    void snapshot (vector<MetricDescriptor> &snapshotDescriptors, vector<int64_t> &snapshotGauges, vector<uint64_t> &snapshotCounters, vector<MetricsHistogram *> &snapshotHistograms);
+
+public:
+    // Register a metric, or return the id of the already registered one with the same name and labels
+    uint64_t counter (const string &name, const string &labels = "");
+    uint64_t gauge (const string &name, const string &labels = "");
+    uint64_t histogram (const string &name, const string &labels = ""); // Values in us, exported in seconds
+
+    // Update a metric
+    void add (uint64_t counterId, uint64_t value = 1);
+    void set (uint64_t gaugeId, int64_t value);
+    void observe (uint64_t histogramId, uint64_t us);
+
+    // Called by a thread buffer when its thread ends
+    void retire (MetricsThreadBuffer *pThreadBuffer);
+
+    // Returns the metrics in Prometheus text exposition format
+    string prometheus (void);
+
+    // Prints a summary of the metrics: counters, gauges, and count and percentiles of the histograms
+    void print (void);
+};
+
+// Process-wide metrics registry
+extern Metrics metrics;
+
+// Observes the time elapsed since its creation into a histogram when it goes out of scope
+class MetricsTimer
+{
+private:
+    uint64_t histogramId;
+    struct timeval startTime;
+public:
+    MetricsTimer (uint64_t histogramId) : histogramId(histogramId) { gettimeofday(&startTime, NULL); };
+    ~MetricsTimer ();
+};
+
+// Measures the duration of a gRPC handler, from this point to the end of the scope
+#define MetricsHandlerTimer(method) static const uint64_t method##_metricId = metrics.histogram("zkprover_grpc_handler_seconds", "method=\"" #method "\""); MetricsTimer method##_metricsTimer(method##_metricId)
+
+#endif
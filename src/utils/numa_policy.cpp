@@ -0,0 +1,196 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <omp.h>
+#include "numa_policy.hpp"
+#include "timer.hpp"
+
+using namespace std;
+
+// Memory policy modes, as defined in linux/mempolicy.h
+#define NUMA_MPOL_BIND 2
+#define NUMA_MPOL_INTERLEAVE 3
+
+enum eNumaPolicy
+{
+    numa_none = 0,
+    numa_first_touch = 1,
+    numa_interleave = 2,
+    numa_bind = 3
+};
+
+static eNumaPolicy numaPolicy = numa_none;
+static uint64_t numaBindNode = 0;
+static uint64_t nNodes = 1;
+
+struct NumaNodeStats
+{
+    uint64_t localNode;
+    uint64_t otherNode;
+    uint64_t memUsed; // kB
+};
+
+static mutex statsMutex;
+static vector<NumaNodeStats> lastStats;
+static struct timeval lastStatsTime;
+
+void numaInit(const Config &config)
+{
+    if (config.numaPolicy == "none")
+        numaPolicy = numa_none;
+    else if (config.numaPolicy == "firstTouch")
+        numaPolicy = numa_first_touch;
+    else if (config.numaPolicy == "interleave")
+        numaPolicy = numa_interleave;
+    else if (config.numaPolicy == "bind")
+        numaPolicy = numa_bind;
+    else
+    {
+        cerr << "Error: numaInit() found invalid numaPolicy=" << config.numaPolicy << endl;
+        exit(-1);
+    }
+    numaBindNode = config.numaBindNode;
+
+    // Count the nodes exposed by sysfs
+    nNodes = 0;
+    while (access(("/sys/devices/system/node/node" + to_string(nNodes)).c_str(), F_OK) == 0)
+    {
+        nNodes++;
+    }
+    if (nNodes == 0)
+    {
+        nNodes = 1;
+    }
+
+    if (numaPolicy == numa_bind && numaBindNode >= nNodes)
+    {
+        cerr << "Error: numaInit() found numaBindNode=" << numaBindNode << " but there are only " << nNodes << " nodes" << endl;
+        exit(-1);
+    }
+
+    // Pin OpenMP threads, so that first touch placement is preserved across parallel regions;
+    // explicit environment settings take precedence
+    if (numaPolicy != numa_none)
+    {
+        setenv("OMP_PROC_BIND", (numaPolicy == numa_bind) ? "close" : "spread", 0);
+        setenv("OMP_PLACES", "cores", 0);
+    }
+
+    cout << "numaInit() found " << nNodes << " NUMA nodes, policy=" << config.numaPolicy << ", OMP_PROC_BIND=" << (getenv("OMP_PROC_BIND") ? getenv("OMP_PROC_BIND") : "") << ", OMP_PLACES=" << (getenv("OMP_PLACES") ? getenv("OMP_PLACES") : "") << endl;
+}
+
+uint64_t numaNodes(void)
+{
+    return nNodes;
+}
+
+void numaPlace(void *pAddress, uint64_t size)
+{
+    if ((numaPolicy != numa_interleave && numaPolicy != numa_bind) || pAddress == NULL || size == 0)
+        return;
+
+    // mbind() requires a page aligned range
+    uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    uint64_t start = (uint64_t)pAddress & ~(pageSize - 1);
+    uint64_t end = ((uint64_t)pAddress + size + pageSize - 1) & ~(pageSize - 1);
+
+    unsigned long nodeMask[16] = {0};
+    uint64_t maxNode = sizeof(nodeMask) * 8;
+    int mode;
+    if (numaPolicy == numa_interleave)
+    {
+        mode = NUMA_MPOL_INTERLEAVE;
+        for (uint64_t i = 0; i < nNodes && i < maxNode; i++)
+            nodeMask[i / 64] |= (1UL << (i % 64));
+    }
+    else
+    {
+        mode = NUMA_MPOL_BIND;
+        nodeMask[numaBindNode / 64] |= (1UL << (numaBindNode % 64));
+    }
+
+    if (syscall(SYS_mbind, start, end - start, mode, nodeMask, maxNode, 0) != 0)
+    {
+        cerr << "Error: numaPlace() failed calling mbind() of size " << size << " errno=" << errno << "=" << strerror(errno) << endl;
+    }
+}
+
+void numaFirstTouch(void *pAddress, uint64_t nRows, uint64_t rowSize)
+{
+#pragma omp parallel for schedule(static)
+    for (uint64_t i = 0; i < nRows; i++)
+    {
+        memset((uint8_t *)pAddress + i * rowSize, 0, rowSize);
+    }
+}
+
+static void numaReadStats(vector<NumaNodeStats> &stats)
+{
+    stats.resize(nNodes);
+    for (uint64_t n = 0; n < nNodes; n++)
+    {
+        string nodePath = "/sys/devices/system/node/node" + to_string(n);
+        stats[n] = {0, 0, 0};
+
+        ifstream numastat(nodePath + "/numastat");
+        string label;
+        uint64_t value;
+        while (numastat >> label >> value)
+        {
+            if (label == "local_node")
+                stats[n].localNode = value;
+            else if (label == "other_node")
+                stats[n].otherNode = value;
+        }
+
+        ifstream meminfo(nodePath + "/meminfo");
+        string line;
+        while (getline(meminfo, line))
+        {
+            // Format: "Node 0 MemUsed:        123456 kB"
+            if (line.find("MemUsed:") != string::npos)
+            {
+                stringstream ss(line.substr(line.find("MemUsed:") + 8));
+                ss >> stats[n].memUsed;
+            }
+        }
+    }
+}
+
+void numaPrintStats(const string &label)
+{
+    lock_guard<mutex> guard(statsMutex);
+
+    vector<NumaNodeStats> stats;
+    numaReadStats(stats);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    double seconds = lastStats.empty() ? 0 : double(TimeDiff(lastStatsTime, now)) / 1000000;
+
+    cout << "NUMA STATS " << label << endl;
+    for (uint64_t n = 0; n < nNodes; n++)
+    {
+        uint64_t local = stats[n].localNode - (lastStats.empty() ? 0 : lastStats[n].localNode);
+        uint64_t remote = stats[n].otherNode - (lastStats.empty() ? 0 : lastStats[n].otherNode);
+        cout << "    node" << n << ": memUsed=" << stats[n].memUsed / 1024 << " MB"
+             << ", localPages=" << local << ", remotePages=" << remote;
+        if (seconds > 0)
+        {
+            cout << ", local=" << double(local * pageSize) / (1024 * 1024) / seconds << " MB/s"
+                 << ", remote=" << double(remote * pageSize) / (1024 * 1024) / seconds << " MB/s";
+        }
+        cout << endl;
+    }
+
+    lastStats = stats;
+    lastStatsTime = now;
+}
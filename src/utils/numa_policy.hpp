@@ -0,0 +1,33 @@
+#ifndef NUMA_POLICY_HPP
+#define NUMA_POLICY_HPP
+
+#include <cstdint>
+#include <string>
+#include "config.hpp"
+
+// NUMA placement of the big prover buffers, as configured by Config::numaPolicy:
+//   "none"       : the OS decides, as usual
+//   "firstTouch" : buffers are initialized by the same static row partition the parallel kernels use
+//   "interleave" : buffer pages are interleaved across all nodes
+//   "bind"       : buffer pages are bound to node Config::numaBindNode
+// Any policy other than "none" also sets OMP_PROC_BIND/OMP_PLACES, unless already set, so that
+// every OpenMP thread keeps working on the memory it touched first
+
+// Detects the NUMA nodes and sets the thread affinity; must be called before the first parallel region
+void numaInit(const Config &config);
+
+// Number of NUMA nodes found by numaInit()
+uint64_t numaNodes(void);
+
+// Applies the configured interleave/bind policy to a buffer that has not been touched yet
+void numaPlace(void *pAddress, uint64_t size);
+
+// Zeroes a row-major matrix of nRows rows of rowSize bytes in parallel, with the static row partition of the
+// "#pragma omp parallel for" loops over rows of the STARK kernels, so that with the firstTouch policy the
+// pages of every row block end up on the node of the thread that later processes it
+void numaFirstTouch(void *pAddress, uint64_t nRows, uint64_t rowSize);
+
+// Prints, per node, the memory in use and the page allocation counters (local vs remote) since the previous call
+void numaPrintStats(const std::string &label);
+
+#endif
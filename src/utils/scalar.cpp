@@ -4,7 +4,7 @@
 #include <vector>
 #include <algorithm>
 #include "scalar.hpp"
-#include "XKCP/Keccak-more-compact.hpp"
+#include "XKCP/Keccak-opt.hpp"
 #include "config.hpp"
 #include "utils.hpp"
 
@@ -219,12 +219,12 @@ string stringToLower (const string &s)
 
 void keccak256(const uint8_t *pInputData, uint64_t inputDataSize, uint8_t *pOutputData, uint64_t outputDataSize)
 {
-    Keccak(1088, 512, pInputData, inputDataSize, 0x1, pOutputData, outputDataSize);
+    Keccak256Sponge(pInputData, inputDataSize, pOutputData, outputDataSize);
 }
 
 void keccak256 (const uint8_t *pInputData, uint64_t inputDataSize, uint8_t (&hash)[32])
 {
-    Keccak(1088, 512, pInputData, inputDataSize, 0x1, hash, 32);
+    Keccak256Sponge(pInputData, inputDataSize, hash, 32);
 }
 
 void keccak256 (const uint8_t *pInputData, uint64_t inputDataSize, mpz_class &hash)
@@ -246,13 +246,7 @@ string keccak256 (const uint8_t *pInputData, uint64_t inputDataSize)
 
 void keccak256 (const vector<uint8_t> &input, mpz_class &hash)
 {
-    string baString;
-    uint64_t inputSize = input.size();
-    for (uint64_t i=0; i<inputSize; i++)
-    {
-        baString.push_back(input[i]);
-    }
-    keccak256((uint8_t *)baString.c_str(), baString.size(), hash);
+    keccak256(input.data(), input.size(), hash);
 }
 
 /* Byte to/from char conversion */
@@ -369,6 +363,37 @@ string ba2string (const string &baString)
     return result;
 }
 
+/* Concatenated values string to field element array conversion */
+
+bool concatenatedString2fea (Goldilocks &fr, const string &s, vector<Goldilocks::Element> &fea)
+{
+    if (s.size()%16 != 0)
+    {
+        return false;
+    }
+
+    // Decode every value directly from the chars, avoiding a substring and a string parsing per value
+    const char *p = s.c_str();
+    uint64_t nValues = s.size()/16;
+    fea.resize(nValues);
+    for (uint64_t i=0; i<nValues; i++)
+    {
+        uint64_t value = 0;
+        for (uint64_t c=0; c<16; c++)
+        {
+            char ch = p[16*i + c];
+            uint64_t nibble;
+            if (ch >= '0' && ch <= '9') nibble = ch - '0';
+            else if (ch >= 'a' && ch <= 'f') nibble = ch - 'a' + 10;
+            else if (ch >= 'A' && ch <= 'F') nibble = ch - 'A' + 10;
+            else return false;
+            value = (value << 4) | nibble;
+        }
+        fea[i] = fr.fromU64(value);
+    }
+    return true;
+}
+
 /* Byte array of exactly 2 bytes conversion */
 
 void ba2u16 (const uint8_t *pData, uint16_t &n)
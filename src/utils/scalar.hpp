@@ -276,6 +276,11 @@ string   ba2string (const uint8_t *pData, uint64_t dataSize);
 void     ba2string (const string &baString, string &textString);
 string   ba2string (const string &baString);
 
+/* Concatenated values string to field element array conversion
+   s is a sequence of 16-char hex values, without "0x", as in the db maps of the gRPC services;
+   returns false if its size is not a multiple of 16 or it contains non-hex chars */
+bool concatenatedString2fea (Goldilocks &fr, const string &s, vector<Goldilocks::Element> &fea);
+
 /* Byte array of exactly 2 bytes conversion */
 void ba2u16(const uint8_t *pData, uint16_t &n);
 void ba2u32(const uint8_t *pData, uint32_t &n);
@@ -5,6 +5,8 @@
 #include <sys/time.h>
 #include <string>
 #include "definitions.hpp"
+#include "metrics.hpp"
+#include "trace_events.hpp"
 
 // Returns the time difference in us
 uint64_t TimeDiff(const struct timeval &startTime, const struct timeval &endTime);
@@ -14,10 +16,14 @@ uint64_t TimeDiff(const struct timeval &startTime); // End time is now
 std::string DateAndTime(struct timeval &tv);
 
 #ifdef LOG_TIME
+// Every timer also feeds the zkprover_timer_seconds histogram of the metrics registry, labeled with its name
+#define TimerMetric(name) { static const uint64_t name##_metricId = metrics.histogram("zkprover_timer_seconds", "timer=\"" #name "\""); metrics.observe(name##_metricId, TimeDiff(name##_start, name##_stop)); }
+// and adds a span to the timeline of the calling thread, if it is being traced
+#define TimerTrace(name) { TraceEvents *name##_pTraceEvents = TraceEvents::current(); if (name##_pTraceEvents != NULL) name##_pTraceEvents->add(#name, name##_start, name##_stop); }
 #define TimerStart(name) struct timeval name##_start; gettimeofday(&name##_start,NULL); cout << DateAndTime(name##_start) << " --> " + string(#name) + " starting..." << endl
-#define TimerStop(name) struct timeval name##_stop; gettimeofday(&name##_stop,NULL); cout << DateAndTime(name##_stop) << " <-- " + string(#name) + " done" << endl
+#define TimerStop(name) struct timeval name##_stop; gettimeofday(&name##_stop,NULL); TimerMetric(name); TimerTrace(name); cout << DateAndTime(name##_stop) << " <-- " + string(#name) + " done" << endl
 #define TimerLog(name) cout << DateAndTime(name##_stop) << " " + string(#name) + ": " << double(TimeDiff(name##_start, name##_stop))/1000000 << " s" << endl
-#define TimerStopAndLog(name) struct timeval name##_stop; gettimeofday(&name##_stop,NULL); cout << DateAndTime(name##_stop) << " <-- " + string(#name) + " done: " << double(TimeDiff(name##_start, name##_stop))/1000000 << " s" << endl
+#define TimerStopAndLog(name) struct timeval name##_stop; gettimeofday(&name##_stop,NULL); TimerMetric(name); TimerTrace(name); cout << DateAndTime(name##_stop) << " <-- " + string(#name) + " done: " << double(TimeDiff(name##_start, name##_stop))/1000000 << " s" << endl
 #else
 #define TimerStart(name)
 #define TimerStop(name)
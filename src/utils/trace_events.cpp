@@ -0,0 +1,94 @@
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sstream>
+#include "trace_events.hpp"
+#include "utils.hpp"
+
+static thread_local TraceEvents *pCurrentTraceEvents = NULL;
+
+void TraceEvents::setCurrent (TraceEvents *pTraceEvents)
+{
+    pCurrentTraceEvents = pTraceEvents;
+}
+
+TraceEvents * TraceEvents::current (void)
+{
+    return pCurrentTraceEvents;
+}
+
+static uint64_t threadId (void)
+{
+    return syscall(SYS_gettid);
+}
+
+static uint64_t timeval2us (const struct timeval &tv)
+{
+    return uint64_t(tv.tv_sec)*1000000 + tv.tv_usec;
+}
+
+void TraceEvents::add (const string &name, const struct timeval &start, const struct timeval &stop)
+{
+    TraceEvent event;
+    event.name = name;
+    event.tid = threadId();
+    event.ts = timeval2us(start);
+    uint64_t end = timeval2us(stop);
+    event.dur = (end > event.ts) ? end - event.ts : 0;
+
+    lock_guard<mutex> guard(mlock);
+    events.push_back(event);
+}
+
+void TraceEvents::nameThread (const string &name)
+{
+    uint64_t tid = threadId();
+
+    lock_guard<mutex> guard(mlock);
+    threadNames.push_back(pair<uint64_t, string>(tid, name));
+}
+
+vector<TraceEvent> TraceEvents::getEvents (void)
+{
+    lock_guard<mutex> guard(mlock);
+    return events;
+}
+
+static string escapeJson (const string &s)
+{
+    string result;
+    for (uint64_t i=0; i<s.size(); i++)
+    {
+        if ((s[i] == '"') || (s[i] == '\\'))
+        {
+            result += '\\';
+        }
+        result += s[i];
+    }
+    return result;
+}
+
+void TraceEvents::save (const string &fileName)
+{
+    uint64_t pid = getpid();
+
+    ostringstream os;
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    lock_guard<mutex> guard(mlock);
+    bool bFirst = true;
+    for (uint64_t i=0; i<threadNames.size(); i++)
+    {
+        os << (bFirst ? "\n" : ",\n");
+        bFirst = false;
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << threadNames[i].first << ",\"args\":{\"name\":\"" << escapeJson(threadNames[i].second) << "\"}}";
+    }
+    for (uint64_t i=0; i<events.size(); i++)
+    {
+        os << (bFirst ? "\n" : ",\n");
+        bFirst = false;
+        os << "{\"name\":\"" << escapeJson(events[i].name) << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << events[i].tid << ",\"ts\":" << events[i].ts << ",\"dur\":" << events[i].dur << "}";
+    }
+    os << "\n]}\n";
+
+    string2file(os.str(), fileName);
+}
@@ -0,0 +1,76 @@
+#ifndef TRACE_EVENTS_HPP
+#define TRACE_EVENTS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <sys/time.h>
+
+using namespace std;
+
+/* Timeline of the spans of a request, saved in the Chrome trace-event json format, which can be
+   opened in Perfetto or chrome://tracing. Every span is a complete event ("ph":"X") of the thread
+   that ran it; nesting is shown from the time ranges of the spans of every thread.
+   The timeline of the calling thread is set with setCurrent(); threads that work for a request,
+   e.g. the state machine threads, must set it too, and spans of OpenMP sections get it explicitly */
+
+class TraceEvent
+{
+public:
+    string name;
+    uint64_t tid;
+    uint64_t ts; // Start, in us since the epoch
+    uint64_t dur; // Duration, in us
+};
+
+class TraceEvents
+{
+private:
+    mutex mlock; // Protects the fields below
+    vector<TraceEvent> events;
+    vector<pair<uint64_t, string>> threadNames; // Thread id -> name
+public:
+    // Adds a span of the calling thread
+    void add (const string &name, const struct timeval &start, const struct timeval &stop);
+
+    // Names the calling thread in the timeline
+    void nameThread (const string &name);
+
+    // Returns the spans added so far
+    vector<TraceEvent> getEvents (void);
+
+    // Saves the timeline in trace-event json format
+    void save (const string &fileName);
+
+    // Timeline the spans of the calling thread are added to, or NULL if it is not traced
+    static void setCurrent (TraceEvents *pTraceEvents);
+    static TraceEvents * current (void);
+};
+
+// Adds a span to a timeline, from its creation to the end of the scope or to end(); does nothing if the timeline is NULL
+class TraceSpan
+{
+private:
+    TraceEvents *pTraceEvents;
+    const char *pName;
+    struct timeval start;
+public:
+    TraceSpan (TraceEvents *pTraceEvents, const char *pName) : pTraceEvents(pTraceEvents), pName(pName)
+    {
+        if (pTraceEvents != NULL) gettimeofday(&start, NULL);
+    };
+    ~TraceSpan () { end(); };
+
+    // Ends the span before the end of the scope
+    void end (void)
+    {
+        if (pTraceEvents == NULL) return;
+        struct timeval stop;
+        gettimeofday(&stop, NULL);
+        pTraceEvents->add(pName, start, stop);
+        pTraceEvents = NULL;
+    };
+};
+
+#endif
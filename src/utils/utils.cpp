@@ -356,6 +356,29 @@ bool fileExists (const string &fileName)
     return (iResult == 0);
 }
 
+uint64_t fileSize (const string &fileName)
+{
+    struct stat fileStat;
+    int iResult = stat( fileName.c_str(), &fileStat);
+    if (iResult != 0)
+    {
+        return 0;
+    }
+    return fileStat.st_size;
+}
+
+void string2file (const string &s, const string &fileName)
+{
+    ofstream outputStream(fileName, ios::out | ios::binary);
+    if (!outputStream.good())
+    {
+        cerr << "Error: string2file() failed creating output file " << fileName << endl;
+        exitProcess();
+    }
+    outputStream.write(s.c_str(), s.size());
+    outputStream.close();
+}
+
 void ensureDirectoryExists (const string &fileName)
 {
     string command = "[ -d " + fileName + " ] && echo \"Directory already exists\" || mkdir -p " + fileName;
@@ -66,6 +66,12 @@ void file2json(const string &fileName, ordered_json &j);
 // Returns if file exists
 bool fileExists (const string &fileName);
 
+// Returns the size of a file, or 0 if it does not exist
+uint64_t fileSize (const string &fileName);
+
+// Writes a string, e.g. binary data, into a file
+void string2file (const string &s, const string &fileName);
+
 // Ensure directory exists
 void ensureDirectoryExists (const string &fileName);
 
@@ -0,0 +1,47 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "config.hpp"
+#include "goldilocks_base_field.hpp"
+
+using namespace std;
+
+/* zkProverBench options, parsed from the command line before passing the rest to Google Benchmark:
+     --min_bits=n, --max_bits=n: range of log2 sizes (rows, keys, actions) every benchmark is run with
+     --threads=t1,t2,...: OpenMP thread counts every parallel benchmark is run with (default: all cores)
+     --cols=n: number of columns of the NTT and merkle tree benchmarks, and of stage 1 columns of the synthetic PIL
+     --config=file: optional configuration file, e.g. to set keccakScriptFile or storageRomFile
+     --tmp_path=folder: folder of the synthetic stark files generated by the benchmarks
+     --no_sm: skip the state machine benchmarks, that need CommitPols::pilSize() bytes of memory */
+class BenchOptions
+{
+public:
+    uint64_t minBits;
+    uint64_t maxBits;
+    vector<uint64_t> threads;
+    uint64_t cols;
+    string configFile;
+    string tmpPath;
+    bool bSM;
+    BenchOptions() : minBits(12), maxBits(16), cols(16), tmpPath("/tmp"), bSM(true) {};
+};
+
+extern BenchOptions benchOptions;
+extern Config benchConfig;
+
+/* Registers a benchmark for every size in [minBits, maxBits] and, if bParallel, for every thread count
+   The function gets the log2 size in state.range(0); the thread count is set before calling it */
+void benchRegister (const string &name, void (*function)(benchmark::State &), uint64_t minBits, uint64_t maxBits, bool bParallel = true);
+
+// Fills size field elements with pseudo random values, the same ones for the same seed
+void benchRandomFill (Goldilocks::Element *pData, uint64_t size, uint64_t seed);
+
+// Register the benchmarks of every module
+void registerStarkBenchs (void);
+void registerStateDBBenchs (void);
+void registerSMBenchs (void);
+
+#endif
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <string.h>
+#include <random>
+#include <omp.h>
+#include "bench.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+BenchOptions benchOptions;
+Config benchConfig;
+
+void benchRegister (const string &name, void (*function)(benchmark::State &), uint64_t minBits, uint64_t maxBits, bool bParallel)
+{
+    benchmark::internal::Benchmark *pBenchmark = benchmark::RegisterBenchmark(name.c_str(), [function](benchmark::State &state)
+    {
+        omp_set_num_threads(state.range(1));
+        function(state);
+    });
+    pBenchmark->ArgNames({"bits", "threads"})->Unit(benchmark::kMillisecond)->UseRealTime();
+    for (uint64_t bits = minBits; bits <= maxBits; bits++)
+    {
+        if (bParallel)
+        {
+            for (uint64_t i = 0; i < benchOptions.threads.size(); i++)
+            {
+                pBenchmark->Args({(int64_t)bits, (int64_t)benchOptions.threads[i]});
+            }
+        }
+        else
+        {
+            pBenchmark->Args({(int64_t)bits, 1});
+        }
+    }
+}
+
+void benchRandomFill (Goldilocks::Element *pData, uint64_t size, uint64_t seed)
+{
+    mt19937_64 generator(seed);
+    for (uint64_t i = 0; i < size; i++)
+    {
+        pData[i] = Goldilocks::fromU64(generator() >> 1); // Below the prime, so the element is canonical
+    }
+}
+
+static bool parseOption (const char *arg, const char *name, string &value)
+{
+    uint64_t length = strlen(name);
+    if ((strncmp(arg, name, length) != 0) || (arg[length] != '='))
+        return false;
+    value = arg + length + 1;
+    return true;
+}
+
+int main (int argc, char **argv)
+{
+    // Parse our options, and leave the rest for Google Benchmark
+    int benchArgc = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        string value;
+        if (parseOption(argv[i], "--min_bits", value))
+        {
+            benchOptions.minBits = stoull(value);
+        }
+        else if (parseOption(argv[i], "--max_bits", value))
+        {
+            benchOptions.maxBits = stoull(value);
+        }
+        else if (parseOption(argv[i], "--threads", value))
+        {
+            size_t start = 0;
+            while (start < value.size())
+            {
+                size_t end = value.find(',', start);
+                if (end == string::npos)
+                    end = value.size();
+                benchOptions.threads.push_back(stoull(value.substr(start, end - start)));
+                start = end + 1;
+            }
+        }
+        else if (parseOption(argv[i], "--cols", value))
+        {
+            benchOptions.cols = stoull(value);
+        }
+        else if (parseOption(argv[i], "--config", value))
+        {
+            benchOptions.configFile = value;
+        }
+        else if (parseOption(argv[i], "--tmp_path", value))
+        {
+            benchOptions.tmpPath = value;
+        }
+        else if (strcmp(argv[i], "--no_sm") == 0)
+        {
+            benchOptions.bSM = false;
+        }
+        else
+        {
+            argv[benchArgc++] = argv[i];
+        }
+    }
+    if (benchOptions.threads.empty())
+    {
+        benchOptions.threads.push_back(omp_get_max_threads());
+    }
+    if ((benchOptions.minBits < 1) || (benchOptions.minBits > benchOptions.maxBits) || (benchOptions.maxBits > 30) || (benchOptions.cols == 0))
+    {
+        cerr << "Error: zkProverBench invalid options min_bits=" << benchOptions.minBits << " max_bits=" << benchOptions.maxBits << " cols=" << benchOptions.cols << endl;
+        return -1;
+    }
+    for (uint64_t i = 0; i < benchOptions.threads.size(); i++)
+    {
+        if (benchOptions.threads[i] == 0)
+        {
+            cerr << "Error: zkProverBench invalid option threads=0" << endl;
+            return -1;
+        }
+    }
+
+    // The configuration only provides file names and defaults; no runtime files are needed by default
+    json configJson;
+    if (benchOptions.configFile.size() > 0)
+    {
+        file2json(benchOptions.configFile, configJson);
+    }
+    benchConfig.load(configJson);
+    benchConfig.runFileGenBatchProof = true; // Starks and the state machines only initialize when generating proofs
+    benchConfig.databaseURL = "local";
+    benchConfig.mapConstPolsFile = false;
+    benchConfig.mapConstantsTreeFile = false;
+    benchConfig.lowMemoryProver = false;
+
+    registerStarkBenchs();
+    registerStateDBBenchs();
+    if (benchOptions.bSM)
+    {
+        registerSMBenchs();
+    }
+
+    benchmark::Initialize(&benchArgc, argv);
+    if (benchmark::ReportUnrecognizedArguments(benchArgc, argv))
+    {
+        return -1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
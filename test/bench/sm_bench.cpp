@@ -0,0 +1,439 @@
+#include <sys/mman.h>
+#include <memory>
+#include <random>
+#include "bench.hpp"
+#include "utils.hpp"
+#include "scalar.hpp"
+#include "commit_pols.hpp"
+#include "binary_executor.hpp"
+#include "binary_defines.hpp"
+#include "arith_executor.hpp"
+#include "mem_align_executor.hpp"
+#include "memory_executor.hpp"
+#include "padding_kk_executor.hpp"
+#include "padding_kkbit_executor.hpp"
+#include "nine2one_executor.hpp"
+#include "keccak_f_executor.hpp"
+#include "padding_pg_executor.hpp"
+#include "poseidon_g_executor.hpp"
+#include "poseidon_g_permutation.hpp"
+#include "storage_executor.hpp"
+#include "smt.hpp"
+#include "smt_action_list.hpp"
+#include "database.hpp"
+
+using namespace std;
+
+/* All the state machines write their committed polynomials into the same CommitPols buffer, as the prover does.
+   Committed polynomials are interleaved row by row, so every execution touches the whole buffer: it is allocated
+   once, with CommitPols::pilSize() bytes, and reused by all the benchmarks without being cleared */
+static CommitPols * benchCommitPols (benchmark::State &state)
+{
+    static unique_ptr<CommitPols> pCommitPols;
+    static bool bFailed = false;
+    if ((pCommitPols == NULL) && !bFailed)
+    {
+        void * pAddress = mmap(NULL, CommitPols::pilSize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (pAddress == MAP_FAILED)
+        {
+            bFailed = true;
+        }
+        else
+        {
+            pCommitPols.reset(new CommitPols(pAddress, CommitPols::pilDegree()));
+        }
+    }
+    if (bFailed)
+    {
+        state.SkipWithError("failed allocating CommitPols::pilSize() bytes");
+    }
+    return pCommitPols.get();
+}
+
+// Skips the benchmark if the requested size does not fit in the state machine
+static bool benchFits (benchmark::State &state, uint64_t size, uint64_t capacity)
+{
+    if (size > capacity)
+    {
+        state.SkipWithError(("size=" + to_string(size) + " exceeds the state machine capacity=" + to_string(capacity)).c_str());
+        return false;
+    }
+    return true;
+}
+
+static mpz_class random256 (mt19937_64 &generator)
+{
+    mpz_class result = 0;
+    for (uint64_t i = 0; i < 4; i++)
+    {
+        result = (result << 64) + mpz_class(generator());
+    }
+    return result;
+}
+
+static string randomHex (mt19937_64 &generator, uint64_t nBytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    string result;
+    result.reserve(nBytes * 2);
+    for (uint64_t i = 0; i < nBytes; i++)
+    {
+        uint64_t byte = generator() & 0xFF;
+        result.push_back(digits[byte >> 4]);
+        result.push_back(digits[byte & 0xF]);
+    }
+    return result;
+}
+
+// Binary: 2^bits ADD, SUB, LT and EQ actions on random 256 bits operands
+static void BM_SM_Binary (benchmark::State &state)
+{
+    uint64_t nActions = 1 << state.range(0);
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nActions, CommitPols::pilDegree() / LATCH_SIZE))
+        return;
+
+    Goldilocks fr;
+    BinaryExecutor binaryExecutor(fr, benchConfig);
+    mt19937_64 generator(20);
+    vector<BinaryAction> actions(nActions);
+    static const uint64_t opcodes[4] = {0, 1, 2, 4}; // ADD, SUB, LT, EQ
+    for (uint64_t i = 0; i < nActions; i++)
+    {
+        BinaryAction &action = actions[i];
+        action.a = random256(generator);
+        action.b = (i % 8 == 7) ? action.a : random256(generator);
+        action.opcode = opcodes[i % 4];
+        action.type = 1;
+        switch (action.opcode)
+        {
+            case 0: action.c = (action.a + action.b) & ScalarMask256; break;
+            case 1: action.c = (action.a - action.b + ScalarTwoTo256) & ScalarMask256; break;
+            case 2: action.c = (action.a < action.b) ? 1 : 0; break;
+            default: action.c = (action.a == action.b) ? 1 : 0; break;
+        }
+    }
+
+    for (auto _ : state)
+    {
+        binaryExecutor.execute(actions, pCommitPols->Binary);
+    }
+    state.SetItemsProcessed(state.iterations() * nActions);
+}
+
+// Arith: 2^bits x1*y1 + x2 = y2*2^256 + y3 actions on random 256 bits operands
+static void BM_SM_Arith (benchmark::State &state)
+{
+    uint64_t nActions = 1 << state.range(0);
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nActions, CommitPols::pilDegree() / 32))
+        return;
+
+    Goldilocks fr;
+    ArithExecutor arithExecutor(fr, benchConfig);
+    mt19937_64 generator(21);
+    vector<ArithAction> actions(nActions);
+    for (uint64_t i = 0; i < nActions; i++)
+    {
+        ArithAction &action = actions[i];
+        action.x1 = random256(generator);
+        action.y1 = random256(generator);
+        action.x2 = random256(generator);
+        mpz_class result = action.x1 * action.y1 + action.x2;
+        action.y2 = result >> 256;
+        action.y3 = result & ScalarMask256;
+        action.x3 = 0;
+        action.selEq0 = 1;
+    }
+
+    for (auto _ : state)
+    {
+        arithExecutor.execute(actions, pCommitPols->Arith);
+    }
+    state.SetItemsProcessed(state.iterations() * nActions);
+}
+
+// MemAlign: 2^bits unaligned 256 bits reads at random offsets
+static void BM_SM_MemAlign (benchmark::State &state)
+{
+    uint64_t nActions = 1 << state.range(0);
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nActions, CommitPols::pilDegree() / 32))
+        return;
+
+    Goldilocks fr;
+    MemAlignExecutor memAlignExecutor(fr, benchConfig);
+    mt19937_64 generator(22);
+    vector<MemAlignAction> actions(nActions);
+    for (uint64_t i = 0; i < nActions; i++)
+    {
+        MemAlignAction &action = actions[i];
+        action.m0 = random256(generator);
+        action.m1 = random256(generator);
+        action.offset = generator() % 32;
+        uint64_t shift = action.offset * 8;
+        action.v = ((action.m0 << shift) & ScalarMask256) | ((action.m1 >> (256 - shift)) & (ScalarMask256 >> (256 - shift)));
+        action.w0 = 0;
+        action.w1 = 0;
+        action.wr8 = 0;
+        action.wr256 = 0;
+    }
+
+    for (auto _ : state)
+    {
+        memAlignExecutor.execute(actions, pCommitPols->MemAlign);
+    }
+    state.SetItemsProcessed(state.iterations() * nActions);
+}
+
+// Memory: 2^bits random reads and writes over 2^(bits-2) addresses
+static void BM_SM_Memory (benchmark::State &state)
+{
+    uint64_t nAccesses = 1 << state.range(0);
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nAccesses, CommitPols::pilDegree()))
+        return;
+
+    Goldilocks fr;
+    MemoryExecutor memoryExecutor(fr, benchConfig);
+    mt19937_64 generator(23);
+    uint64_t nAddresses = (nAccesses >= 4) ? nAccesses / 4 : 1;
+    vector<MemoryAccess> accesses(nAccesses);
+    for (uint64_t i = 0; i < nAccesses; i++)
+    {
+        MemoryAccess &access = accesses[i];
+        access.bIsWrite = (generator() & 1) == 1;
+        access.address = generator() % nAddresses;
+        access.pc = i;
+        Goldilocks::Element *fe[8] = {&access.fe0, &access.fe1, &access.fe2, &access.fe3, &access.fe4, &access.fe5, &access.fe6, &access.fe7};
+        for (uint64_t j = 0; j < 8; j++)
+        {
+            *fe[j] = fr.fromU64(generator() & 0xFFFFFFFF);
+        }
+    }
+
+    for (auto _ : state)
+    {
+        memoryExecutor.execute(accesses, pCommitPols->Mem);
+    }
+    state.SetItemsProcessed(state.iterations() * nAccesses);
+}
+
+/* Keccak chain: 2^bits bytes of random data, in messages of up to 256 bytes, hashed by PaddingKK, whose required
+   inputs feed PaddingKKBit, then Nine2One, then KeccakF; the benchmark of every state machine gets its inputs by
+   executing the previous ones once before timing */
+enum eKeccakStage { kkPaddingKK = 0, kkPaddingKKBit = 1, kkNine2One = 2, kkKeccakF = 3 };
+
+static void keccakChain (benchmark::State &state, eKeccakStage stage)
+{
+    uint64_t nBytes = 1 << state.range(0);
+    uint64_t messageSize = (nBytes < 256) ? nBytes : 256;
+    uint64_t nMessages = nBytes / messageSize;
+    uint64_t nBlocks = nMessages * (messageSize / 136 + 1); // Every message is padded to a whole number of 136 bytes blocks
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nBlocks, 44 * (CommitPols::pilDegree() / 155286)))
+        return;
+    if ((stage == kkKeccakF) && !fileExists(benchConfig.keccakScriptFile))
+    {
+        state.SkipWithError(("missing keccakScriptFile=" + benchConfig.keccakScriptFile).c_str());
+        return;
+    }
+
+    Goldilocks fr;
+    PaddingKKExecutor paddingKKExecutor(fr);
+    PaddingKKBitExecutor paddingKKBitExecutor(fr);
+    Nine2OneExecutor nine2OneExecutor(fr);
+    mt19937_64 generator(24);
+    vector<PaddingKKExecutorInput> paddingKKInput(nMessages);
+    for (uint64_t i = 0; i < nMessages; i++)
+    {
+        paddingKKInput[i].data = randomHex(generator, messageSize);
+    }
+
+    // Execute the previous state machines, to get the input of the benchmarked one
+    vector<PaddingKKBitExecutorInput> paddingKKBitInput;
+    vector<Nine2OneExecutorInput> nine2OneInput;
+    vector<vector<Goldilocks::Element>> keccakFInput;
+    if (stage > kkPaddingKK)
+    {
+        vector<PaddingKKExecutorInput> input = paddingKKInput;
+        paddingKKExecutor.execute(input, pCommitPols->PaddingKK, paddingKKBitInput);
+    }
+    if (stage > kkPaddingKKBit)
+    {
+        paddingKKBitExecutor.execute(paddingKKBitInput, pCommitPols->PaddingKKBit, nine2OneInput);
+    }
+    if (stage > kkNine2One)
+    {
+        nine2OneExecutor.execute(nine2OneInput, pCommitPols->Nine2One, keccakFInput);
+    }
+    unique_ptr<KeccakFExecutor> pKeccakFExecutor;
+    if (stage == kkKeccakF)
+    {
+        pKeccakFExecutor.reset(new KeccakFExecutor(fr, benchConfig));
+    }
+
+    for (auto _ : state)
+    {
+        switch (stage)
+        {
+            case kkPaddingKK:
+            {
+                // Executors consume their inputs, so every iteration works on a fresh copy
+                state.PauseTiming();
+                vector<PaddingKKExecutorInput> input = paddingKKInput;
+                vector<PaddingKKBitExecutorInput> required;
+                state.ResumeTiming();
+                paddingKKExecutor.execute(input, pCommitPols->PaddingKK, required);
+                break;
+            }
+            case kkPaddingKKBit:
+            {
+                vector<Nine2OneExecutorInput> required;
+                paddingKKBitExecutor.execute(paddingKKBitInput, pCommitPols->PaddingKKBit, required);
+                break;
+            }
+            case kkNine2One:
+            {
+                vector<vector<Goldilocks::Element>> required;
+                nine2OneExecutor.execute(nine2OneInput, pCommitPols->Nine2One, required);
+                break;
+            }
+            case kkKeccakF:
+            {
+                pKeccakFExecutor->execute(keccakFInput, pCommitPols->KeccakF);
+                break;
+            }
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * nBytes);
+}
+
+static void BM_SM_PaddingKK (benchmark::State &state) { keccakChain(state, kkPaddingKK); }
+static void BM_SM_PaddingKKBit (benchmark::State &state) { keccakChain(state, kkPaddingKKBit); }
+static void BM_SM_Nine2One (benchmark::State &state) { keccakChain(state, kkNine2One); }
+static void BM_SM_KeccakF (benchmark::State &state) { keccakChain(state, kkKeccakF); }
+
+// PaddingPG: 2^bits bytes of random data, in messages of up to 256 bytes
+static void BM_SM_PaddingPG (benchmark::State &state)
+{
+    uint64_t nBytes = 1 << state.range(0);
+    uint64_t messageSize = (nBytes < 256) ? nBytes : 256;
+    uint64_t nMessages = nBytes / messageSize;
+    uint64_t nPaddedBytes = nMessages * (messageSize / 56 + 1) * 56; // Every message is padded to a whole number of 56 bytes blocks
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nPaddedBytes, CommitPols::pilDegree()))
+        return;
+
+    Goldilocks fr;
+    PoseidonGoldilocks poseidon;
+    PaddingPGExecutor paddingPGExecutor(fr, poseidon);
+    mt19937_64 generator(25);
+    vector<PaddingPGExecutorInput> paddingPGInput(nMessages);
+    for (uint64_t i = 0; i < nMessages; i++)
+    {
+        paddingPGInput[i].data = randomHex(generator, messageSize);
+    }
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        vector<PaddingPGExecutorInput> input = paddingPGInput;
+        vector<array<Goldilocks::Element, 17>> required;
+        state.ResumeTiming();
+        paddingPGExecutor.execute(input, pCommitPols->PaddingPG, required);
+    }
+    state.SetBytesProcessed(state.iterations() * nBytes);
+}
+
+// PoseidonG: 2^bits permutations of random inputs
+static void BM_SM_PoseidonG (benchmark::State &state)
+{
+    uint64_t nHashes = 1 << state.range(0);
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nHashes, CommitPols::pilDegree() / 31))
+        return;
+
+    Goldilocks fr;
+    PoseidonGoldilocks poseidon;
+    PoseidonGExecutor poseidonGExecutor(fr, poseidon);
+    vector<array<Goldilocks::Element, 17>> input(nHashes);
+    for (uint64_t i = 0; i < nHashes; i++)
+    {
+        Goldilocks::Element in[12];
+        Goldilocks::Element hash[4];
+        benchRandomFill(in, 12, 26 + i);
+        poseidon.hash(hash, in);
+        for (uint64_t j = 0; j < 12; j++)
+            input[i][j] = in[j];
+        for (uint64_t j = 0; j < 4; j++)
+            input[i][12 + j] = hash[j];
+        input[i][16] = fr.fromU64(POSEIDONG_PERMUTATION1_ID);
+    }
+
+    for (auto _ : state)
+    {
+        poseidonGExecutor.execute(input, pCommitPols->PoseidonG);
+    }
+    state.SetItemsProcessed(state.iterations() * nHashes);
+}
+
+/* Storage: 2^bits SMT set actions inserting random keys into an empty tree of the in-memory database;
+   an action takes a few hundred rows at most, depending on the tree depth */
+static void BM_SM_Storage (benchmark::State &state)
+{
+    uint64_t nActions = 1 << state.range(0);
+    CommitPols *pCommitPols = benchCommitPols(state);
+    if ((pCommitPols == NULL) || !benchFits(state, nActions, CommitPols::pilDegree() / 512))
+        return;
+    if (!fileExists(benchConfig.storageRomFile))
+    {
+        state.SkipWithError(("missing storageRomFile=" + benchConfig.storageRomFile).c_str());
+        return;
+    }
+
+    Goldilocks fr;
+    PoseidonGoldilocks poseidon;
+    StorageExecutor storageExecutor(fr, poseidon, benchConfig);
+    Smt smt(fr);
+    Database db(fr);
+    db.init(benchConfig);
+    SmtActionList actionList;
+    Goldilocks::Element root[4] = {fr.zero(), fr.zero(), fr.zero(), fr.zero()};
+    Goldilocks::Element key[4];
+    for (uint64_t i = 0; i < nActions; i++)
+    {
+        SmtSetResult setResult;
+        benchRandomFill(key, 4, 27 + i);
+        if (smt.set(db, root, key, mpz_class(i + 1), false, setResult) != ZKR_SUCCESS)
+        {
+            state.SkipWithError("failed calling Smt::set()");
+            return;
+        }
+        for (uint64_t j = 0; j < 4; j++)
+            root[j] = setResult.newRoot[j];
+        actionList.addSetAction(setResult);
+    }
+
+    for (auto _ : state)
+    {
+        vector<array<Goldilocks::Element, 17>> required;
+        storageExecutor.execute(actionList.action, pCommitPols->Storage, required);
+    }
+    state.SetItemsProcessed(state.iterations() * nActions);
+}
+
+void registerSMBenchs (void)
+{
+    benchRegister("SM_Binary", BM_SM_Binary, benchOptions.minBits, benchOptions.maxBits);
+    benchRegister("SM_Arith", BM_SM_Arith, benchOptions.minBits, benchOptions.maxBits);
+    benchRegister("SM_MemAlign", BM_SM_MemAlign, benchOptions.minBits, benchOptions.maxBits, false);
+    benchRegister("SM_Memory", BM_SM_Memory, benchOptions.minBits, benchOptions.maxBits, false);
+    benchRegister("SM_PaddingKK", BM_SM_PaddingKK, benchOptions.minBits, benchOptions.maxBits, false);
+    benchRegister("SM_PaddingKKBit", BM_SM_PaddingKKBit, benchOptions.minBits, benchOptions.maxBits);
+    benchRegister("SM_Nine2One", BM_SM_Nine2One, benchOptions.minBits, benchOptions.maxBits);
+    benchRegister("SM_KeccakF", BM_SM_KeccakF, benchOptions.minBits, benchOptions.maxBits);
+    benchRegister("SM_PaddingPG", BM_SM_PaddingPG, benchOptions.minBits, benchOptions.maxBits, false);
+    benchRegister("SM_PoseidonG", BM_SM_PoseidonG, benchOptions.minBits, benchOptions.maxBits, false);
+    benchRegister("SM_Storage", BM_SM_Storage, benchOptions.minBits, benchOptions.maxBits, false);
+}
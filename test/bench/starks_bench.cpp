@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <random>
+#include <map>
+#include <memory>
+#include "bench.hpp"
+#include "synthetic_stark.hpp"
+#include "synthetic_steps.hpp"
+#include "starks.hpp"
+#include "merkleTreeBN128.hpp"
+#include "trace_events.hpp"
+
+using namespace std;
+
+// NTT_Goldilocks::extendPol() of cols columns of 2^bits rows into 2^(bits+1) rows, as in the STARK LDE
+static void BM_NTT_ExtendPol (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    uint64_t NExtended = N << 1;
+    uint64_t cols = benchOptions.cols;
+    vector<Goldilocks::Element> input(N * cols);
+    vector<Goldilocks::Element> output(NExtended * cols);
+    vector<Goldilocks::Element> buffer(NExtended * cols);
+    benchRandomFill(input.data(), input.size(), 1);
+    NTT_Goldilocks ntt(N);
+
+    for (auto _ : state)
+    {
+        ntt.extendPol(output.data(), input.data(), NExtended, N, cols, buffer.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * N * cols);
+}
+
+// NTT_Goldilocks::INTT() of cols columns of 2^bits rows
+static void BM_NTT_INTT (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    uint64_t cols = benchOptions.cols;
+    vector<Goldilocks::Element> input(N * cols);
+    vector<Goldilocks::Element> output(N * cols);
+    benchRandomFill(input.data(), input.size(), 2);
+    NTT_Goldilocks ntt(N);
+
+    for (auto _ : state)
+    {
+        ntt.INTT(output.data(), input.data(), N, cols);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * N * cols);
+}
+
+// MerkleTreeGL::merkelize() of 2^bits leaves of cols elements
+static void BM_MerkleTreeGL_Merkelize (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    uint64_t cols = benchOptions.cols;
+    MerkleTreeGL tree(N, cols, NULL);
+    benchRandomFill(tree.source, N * cols, 3);
+
+    for (auto _ : state)
+    {
+        tree.merkelize();
+        benchmark::DoNotOptimize(tree.nodes);
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+    state.SetBytesProcessed(state.iterations() * N * cols * sizeof(Goldilocks::Element));
+}
+
+// MerkleTreeBN128::merkelize() of 2^bits leaves of cols elements
+static void BM_MerkleTreeBN128_Merkelize (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    uint64_t cols = benchOptions.cols;
+    vector<Goldilocks::Element> source(N * cols);
+    benchRandomFill(source.data(), source.size(), 4);
+    MerkleTreeBN128 tree(N, cols, source.data());
+
+    for (auto _ : state)
+    {
+        tree.merkelize();
+        benchmark::DoNotOptimize(tree.nodes);
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+    state.SetBytesProcessed(state.iterations() * N * cols * sizeof(Goldilocks::Element));
+}
+
+// Polinomial::calculateZ() of a grand product of 2^bits rows, whose denominator is a permutation of the numerator
+static void BM_Polinomial_CalculateZ (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    Polinomial num(N, FIELD_EXTENSION);
+    Polinomial den(N, FIELD_EXTENSION);
+    Polinomial z(N, FIELD_EXTENSION);
+    benchRandomFill(num.address(), N * FIELD_EXTENSION, 5);
+    for (uint64_t i = 0; i < N; i++)
+    {
+        Polinomial::copyElement(den, i, num, N - 1 - i);
+    }
+
+    for (auto _ : state)
+    {
+        Polinomial::calculateZ(z, num, den);
+        benchmark::DoNotOptimize(z.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+/* Builds a plookup of 2^bits rows and dimension dim: t has distinct random values, and every f value
+   is one of the t values */
+static void buildPlookup (Polinomial &fPol, Polinomial &tPol, uint64_t seed)
+{
+    uint64_t N = tPol.degree();
+    uint64_t dim = tPol.dim();
+    benchRandomFill(tPol.address(), N * dim, seed);
+    mt19937_64 generator(seed);
+    for (uint64_t i = 0; i < N; i++)
+    {
+        Polinomial::copyElement(fPol, i, tPol, generator() % N);
+    }
+}
+
+// Polinomial::calculateH1H2_opt1() of a plookup of dimension 1, with the buffer sizes used by the prover
+static void BM_Polinomial_CalculateH1H2_opt1 (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    Polinomial fPol(N, 1), tPol(N, 1), h1(N, 1), h2(N, 1);
+    buildPlookup(fPol, tPol, 6);
+    vector<uint64_t> buffer(8 * N);
+
+    for (auto _ : state)
+    {
+        Polinomial::calculateH1H2_opt1(h1, h2, fPol, tPol, 0, buffer.data(), 5 * N, 3 * N);
+        benchmark::DoNotOptimize(h2.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+// Polinomial::calculateH1H2_opt3() of a plookup of dimension 3, with the buffer sizes used by the prover
+static void BM_Polinomial_CalculateH1H2_opt3 (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    Polinomial fPol(N, FIELD_EXTENSION), tPol(N, FIELD_EXTENSION), h1(N, FIELD_EXTENSION), h2(N, FIELD_EXTENSION);
+    buildPlookup(fPol, tPol, 7);
+    vector<uint64_t> buffer(8 * N);
+
+    for (auto _ : state)
+    {
+        Polinomial::calculateH1H2_opt3(h1, h2, fPol, tPol, 0, buffer.data(), 3 * N, 5 * N);
+        benchmark::DoNotOptimize(h2.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+// Polinomial::calculateH1H2_parallel(), used by Starks::genProof(), of a plookup of dimension 3
+static void BM_Polinomial_CalculateH1H2_parallel (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    Polinomial fPol(N, FIELD_EXTENSION), tPol(N, FIELD_EXTENSION), h1(N, FIELD_EXTENSION), h2(N, FIELD_EXTENSION);
+    buildPlookup(fPol, tPol, 8);
+    uint64_t buffSize = Polinomial::calculateH1H2_parallelBufferSize(N, FIELD_EXTENSION);
+    vector<uint64_t> buffer(buffSize);
+
+    for (auto _ : state)
+    {
+        Polinomial::calculateH1H2_parallel(h1, h2, fPol, tPol, 0, buffer.data(), buffSize);
+        benchmark::DoNotOptimize(h2.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+// Polinomial::batchInverseParallel() of 2^bits extension field elements
+static void BM_Polinomial_BatchInverseParallel (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    Polinomial src(N, FIELD_EXTENSION);
+    Polinomial res(N, FIELD_EXTENSION);
+    benchRandomFill(src.address(), N * FIELD_EXTENSION, 9);
+
+    for (auto _ : state)
+    {
+        Polinomial::batchInverseParallel(res, src);
+        benchmark::DoNotOptimize(res.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+// Synthetic PIL of 2^nBits rows with cols stage 1 columns, generated once per size; its files are removed at exit
+static SyntheticStark &getSyntheticStark (uint64_t nBits)
+{
+    static map<uint64_t, unique_ptr<SyntheticStark>> syntheticStarks;
+    if (syntheticStarks.find(nBits) == syntheticStarks.end())
+    {
+        syntheticStarks[nBits] = unique_ptr<SyntheticStark>(new SyntheticStark(nBits, benchOptions.cols, 8));
+        syntheticStarks[nBits]->generate(benchOptions.tmpPath);
+    }
+    return *syntheticStarks[nBits];
+}
+
+// Starks::evmap() of the synthetic PIL of 2^bits rows
+static void BM_Starks_Evmap (benchmark::State &state)
+{
+    uint64_t nBits = state.range(0);
+    uint64_t N = 1 << nBits;
+    SyntheticStark &syntheticStark = getSyntheticStark(nBits);
+
+    const StarkInfo &starkInfo = StarkRegistry::getStarkInfo(benchConfig, syntheticStark.files.zkevmStarkInfo);
+    uint64_t memSize = SyntheticStark::memSize(starkInfo);
+    Goldilocks::Element *pAddress = (Goldilocks::Element *)malloc(memSize * sizeof(Goldilocks::Element));
+    if (pAddress == NULL)
+    {
+        state.SkipWithError("failed allocating the committed polynomials");
+        return;
+    }
+    benchRandomFill(pAddress, starkInfo.mapTotalN, 10);
+    Starks starks(benchConfig, syntheticStark.files, pAddress);
+
+    Polinomial evals(starkInfo.evMap.size(), FIELD_EXTENSION);
+    Polinomial LEv(N, FIELD_EXTENSION);
+    Polinomial LpEv(N, FIELD_EXTENSION);
+    benchRandomFill(LEv.address(), N * FIELD_EXTENSION, 11);
+    benchRandomFill(LpEv.address(), N * FIELD_EXTENSION, 12);
+
+    for (auto _ : state)
+    {
+        starks.evmap(evals, LEv, LpEv);
+        benchmark::DoNotOptimize(evals.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N * starkInfo.evMap.size());
+    free(pAddress);
+}
+
+// Spans of Starks::genProof() reported by BM_Starks_GenProof
+static const char *genProofSteps[] = {"STARK_INITIALIZATION", "STARK_STEP_1", "STARK_STEP_2", "STARK_STEP_3", "STARK_STEP_4", "STARK_STEP_5", "STARK_STEP_FRI"};
+
+/* Starks::genProof() of the synthetic PIL of 2^bits rows, from the stage 1 witness to the FRI queries;
+   the average time of every step, in seconds, is reported as a counter, taken from the spans of their
+   timers, and the first proof is checked with the synthetic verifier (not timed) */
+static void BM_Starks_GenProof (benchmark::State &state)
+{
+    uint64_t nBits = state.range(0);
+    uint64_t N = 1 << nBits;
+    SyntheticStark &syntheticStark = getSyntheticStark(nBits);
+
+    const StarkInfo &starkInfo = StarkRegistry::getStarkInfo(benchConfig, syntheticStark.files.zkevmStarkInfo);
+    uint64_t memSize = SyntheticStark::memSize(starkInfo);
+    Goldilocks::Element *pAddress = (Goldilocks::Element *)malloc(memSize * sizeof(Goldilocks::Element));
+    if (pAddress == NULL)
+    {
+        state.SkipWithError("failed allocating the committed polynomials");
+        return;
+    }
+    syntheticStark.generateWitness(pAddress, starkInfo);
+    Starks starks(benchConfig, syntheticStark.files, pAddress);
+    SyntheticSteps syntheticSteps(starkInfo);
+    uint64_t polBits = starkInfo.starkStruct.steps[starkInfo.starkStruct.steps.size() - 1].nBits;
+    Goldilocks::Element publicInputs[1];
+
+    TraceEvents traceEvents;
+    bool bVerified = false;
+    for (auto _ : state)
+    {
+        FRIProof proof((1 << polBits), FIELD_EXTENSION, starkInfo.starkStruct.steps.size(), starkInfo.evMap.size(), starkInfo.nPublics);
+        TraceEvents::setCurrent(&traceEvents);
+        starks.genProof(proof, publicInputs, &syntheticSteps);
+        TraceEvents::setCurrent(NULL);
+
+        if (!bVerified)
+        {
+            state.PauseTiming();
+            bVerified = syntheticStark.verify(starkInfo, proof);
+            state.ResumeTiming();
+            if (!bVerified)
+            {
+                state.SkipWithError("the proof does not verify");
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+
+    vector<TraceEvent> events = traceEvents.getEvents();
+    for (uint64_t s = 0; s < sizeof(genProofSteps) / sizeof(genProofSteps[0]); s++)
+    {
+        uint64_t dur = 0;
+        for (uint64_t e = 0; e < events.size(); e++)
+        {
+            if (events[e].name == genProofSteps[s])
+            {
+                dur += events[e].dur;
+            }
+        }
+        state.counters[genProofSteps[s]] = benchmark::Counter(double(dur) / 1000000, benchmark::Counter::kAvgIterations);
+    }
+    free(pAddress);
+}
+
+// FRIProve::fold() of a 2^bits evaluations polynomial into 2^(bits-4) evaluations
+static void BM_FRI_Fold (benchmark::State &state)
+{
+    uint64_t polBits = state.range(0);
+    uint64_t N = 1 << polBits;
+    uint64_t reductionBits = std::min<uint64_t>(4, polBits);
+    Polinomial friPol(N, FIELD_EXTENSION);
+    Polinomial pol2_e(N >> reductionBits, FIELD_EXTENSION);
+    Polinomial special_x(1, FIELD_EXTENSION);
+    benchRandomFill(friPol.address(), N * FIELD_EXTENSION, 13);
+    benchRandomFill(special_x.address(), FIELD_EXTENSION, 14);
+    Goldilocks::Element shiftInv = Goldilocks::inv(Goldilocks::shift());
+
+    for (auto _ : state)
+    {
+        FRIProve::fold(1, friPol, pol2_e, polBits, shiftInv, special_x);
+        benchmark::DoNotOptimize(pol2_e.address());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+// Transcript::put() of 2^bits elements, followed by the challenges and query permutations a prover gets
+static void BM_Transcript (benchmark::State &state)
+{
+    uint64_t N = 1 << state.range(0);
+    vector<Goldilocks::Element> input(N);
+    benchRandomFill(input.data(), N, 15);
+    Goldilocks::Element challenge[FIELD_EXTENSION];
+    uint64_t queries[128];
+
+    for (auto _ : state)
+    {
+        Transcript transcript;
+        transcript.put(input.data(), N);
+        transcript.getField(challenge);
+        transcript.getPermutations(queries, 128, state.range(0));
+        benchmark::DoNotOptimize(queries);
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+void registerStarkBenchs (void)
+{
+    uint64_t minBits = benchOptions.minBits;
+    uint64_t maxBits = benchOptions.maxBits;
+    benchRegister("NTT_ExtendPol", BM_NTT_ExtendPol, minBits, maxBits);
+    benchRegister("NTT_INTT", BM_NTT_INTT, minBits, maxBits);
+    benchRegister("MerkleTreeGL_Merkelize", BM_MerkleTreeGL_Merkelize, minBits, maxBits);
+    benchRegister("MerkleTreeBN128_Merkelize", BM_MerkleTreeBN128_Merkelize, minBits, maxBits);
+    benchRegister("Polinomial_CalculateZ", BM_Polinomial_CalculateZ, minBits, maxBits, false);
+    benchRegister("Polinomial_CalculateH1H2_opt1", BM_Polinomial_CalculateH1H2_opt1, minBits, maxBits, false);
+    benchRegister("Polinomial_CalculateH1H2_opt3", BM_Polinomial_CalculateH1H2_opt3, minBits, maxBits, false);
+    benchRegister("Polinomial_CalculateH1H2_parallel", BM_Polinomial_CalculateH1H2_parallel, minBits, maxBits);
+    benchRegister("Polinomial_BatchInverseParallel", BM_Polinomial_BatchInverseParallel, minBits, maxBits);
+    benchRegister("Starks_Evmap", BM_Starks_Evmap, minBits, maxBits);
+    benchRegister("Starks_GenProof", BM_Starks_GenProof, minBits, maxBits);
+    benchRegister("FRI_Fold", BM_FRI_Fold, minBits, maxBits);
+    benchRegister("Transcript", BM_Transcript, minBits, maxBits, false);
+}
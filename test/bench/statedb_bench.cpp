@@ -0,0 +1,107 @@
+#include <array>
+#include <random>
+#include "bench.hpp"
+#include "smt.hpp"
+#include "database.hpp"
+
+using namespace std;
+
+typedef array<Goldilocks::Element, 4> BenchKey;
+
+static void randomKeys (vector<BenchKey> &keys, uint64_t nKeys, uint64_t seed)
+{
+    keys.resize(nKeys);
+    benchRandomFill(keys[0].data(), nKeys * 4, seed);
+}
+
+// Builds a state tree of nKeys random keys in the in-memory database, and returns its root
+static zkresult buildTree (Goldilocks &fr, Smt &smt, Database &db, const vector<BenchKey> &keys, Goldilocks::Element (&root)[4])
+{
+    SmtSetResult setResult;
+    for (uint64_t i = 0; i < 4; i++)
+        root[i] = fr.zero();
+    for (uint64_t i = 0; i < keys.size(); i++)
+    {
+        Goldilocks::Element key[4] = {keys[i][0], keys[i][1], keys[i][2], keys[i][3]};
+        zkresult zkr = smt.set(db, root, key, mpz_class(i + 1), true, setResult);
+        if (zkr != ZKR_SUCCESS)
+            return zkr;
+        for (uint64_t j = 0; j < 4; j++)
+            root[j] = setResult.newRoot[j];
+    }
+    return ZKR_SUCCESS;
+}
+
+// Smt::set() of new keys into a tree of 2^bits keys
+static void BM_Smt_Set (benchmark::State &state)
+{
+    Goldilocks fr;
+    Smt smt(fr);
+    Database db(fr);
+    db.init(benchConfig);
+    vector<BenchKey> keys;
+    randomKeys(keys, 1 << state.range(0), 16);
+    Goldilocks::Element root[4];
+    if (buildTree(fr, smt, db, keys, root) != ZKR_SUCCESS)
+    {
+        state.SkipWithError("failed building the tree");
+        return;
+    }
+
+    vector<BenchKey> newKeys;
+    randomKeys(newKeys, 1 << 16, 17);
+    SmtSetResult setResult;
+    uint64_t i = 0;
+    for (auto _ : state)
+    {
+        BenchKey &newKey = newKeys[i % newKeys.size()];
+        Goldilocks::Element key[4] = {newKey[0], newKey[1], newKey[2], newKey[3]};
+        if (smt.set(db, root, key, mpz_class(i + 1), true, setResult) != ZKR_SUCCESS)
+        {
+            state.SkipWithError("failed calling Smt::set()");
+            break;
+        }
+        for (uint64_t j = 0; j < 4; j++)
+            root[j] = setResult.newRoot[j];
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Smt::get() of random existing keys of a tree of 2^bits keys
+static void BM_Smt_Get (benchmark::State &state)
+{
+    Goldilocks fr;
+    Smt smt(fr);
+    Database db(fr);
+    db.init(benchConfig);
+    vector<BenchKey> keys;
+    randomKeys(keys, 1 << state.range(0), 18);
+    Goldilocks::Element root[4];
+    if (buildTree(fr, smt, db, keys, root) != ZKR_SUCCESS)
+    {
+        state.SkipWithError("failed building the tree");
+        return;
+    }
+
+    mt19937_64 generator(19);
+    SmtGetResult getResult;
+    for (auto _ : state)
+    {
+        BenchKey &existingKey = keys[generator() % keys.size()];
+        Goldilocks::Element key[4] = {existingKey[0], existingKey[1], existingKey[2], existingKey[3]};
+        if (smt.get(db, root, key, getResult) != ZKR_SUCCESS)
+        {
+            state.SkipWithError("failed calling Smt::get()");
+            break;
+        }
+        benchmark::DoNotOptimize(getResult.value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void registerStateDBBenchs (void)
+{
+    benchRegister("Smt_Set", BM_Smt_Set, benchOptions.minBits, benchOptions.maxBits, false);
+    benchRegister("Smt_Get", BM_Smt_Get, benchOptions.minBits, benchOptions.maxBits, false);
+}
@@ -0,0 +1,316 @@
+#include <unistd.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include "synthetic_stark.hpp"
+#include "bench.hpp"
+#include "utils.hpp"
+
+static const char *sectionNames[eSectionMax] = {"cm1_n", "cm1_2ns", "cm2_n", "cm2_2ns", "cm3_n", "cm3_2ns", "cm4_n", "cm4_2ns", "tmpExp_n", "q_2ns", "f_2ns"};
+
+// Order of the sections in memory, as laid out by pil-stark
+static const eSection sectionOrder[eSectionMax] = {cm1_n, cm2_n, cm3_n, cm4_n, tmpExp_n, cm1_2ns, cm2_2ns, cm3_2ns, cm4_2ns, q_2ns, f_2ns};
+
+static json emptyStep (void)
+{
+    json step;
+    step["tmpUsed"] = 0;
+    step["first"] = json::array();
+    step["i"] = json::array();
+    step["last"] = json::array();
+    return step;
+}
+
+SyntheticStark::~SyntheticStark ()
+{
+    if (files.zkevmStarkInfo.size() > 0)
+    {
+        unlink(files.zkevmStarkInfo.c_str());
+        unlink(files.zkevmConstPols.c_str());
+        unlink(files.zkevmConstantsTree.c_str());
+    }
+}
+
+// Polynomial of the varPolMap, before its position in its section is known
+struct SyntheticPolDecl
+{
+    eSection section;
+    uint64_t dim;
+};
+
+json SyntheticStark::starkInfoJson (void)
+{
+    uint64_t N = 1 << nBits;
+    uint64_t NExtended = 1 << nBitsExt;
+    json j;
+
+    j["starkStruct"]["nBits"] = nBits;
+    j["starkStruct"]["nBitsExt"] = nBitsExt;
+    j["starkStruct"]["nQueries"] = 32;
+    j["starkStruct"]["verificationHashType"] = "GL";
+    j["starkStruct"]["steps"] = json::array();
+    for (int64_t stepBits = nBitsExt; stepBits > 4; stepBits -= 4)
+    {
+        json step;
+        step["nBits"] = stepBits;
+        j["starkStruct"]["steps"].push_back(step);
+    }
+
+    vector<SyntheticPolDecl> pols;
+    auto addPol = [&pols](eSection section, uint64_t dim) -> uint64_t
+    {
+        pols.push_back({section, dim});
+        return pols.size() - 1;
+    };
+
+    // Every committed polynomial has an entry in its _n section (cm_n) and another one in its _2ns section (cm_2ns)
+    j["cm_n"] = json::array();
+    j["cm_2ns"] = json::array();
+    for (uint64_t i = 0; i < nCm1 + syntheticCmMax; i++)
+    {
+        uint64_t stage = (i < nCm1) ? 1 : (i < nCm1 + syntheticZPu) ? 2 : 3;
+        uint64_t dim = (stage == 3) ? FIELD_EXTENSION : 1;
+        j["cm_n"].push_back(addPol((stage == 1) ? cm1_n : (stage == 2) ? cm2_n : cm3_n, dim));
+        j["cm_2ns"].push_back(addPol((stage == 1) ? cm1_2ns : (stage == 2) ? cm2_2ns : cm3_2ns, dim));
+    }
+
+    // The plookup f is a committed polynomial; the rest of the expressions are calculated in tmpExp_n
+    uint64_t nExps = syntheticExpMax + 2; // Plus the quotient and the FRI polynomials
+    j["tmpExp_n"] = json::array();
+    j["exp2pol"] = json::object();
+    for (uint64_t e = 0; e < syntheticExpMax; e++)
+    {
+        uint64_t polId = (e == syntheticExpF) ? uint64_t(j["cm_n"][syntheticF]) : addPol(tmpExp_n, (e == syntheticExpT) ? 1 : FIELD_EXTENSION);
+        j["exp2pol"][to_string(e)] = polId;
+        j["tmpExp_n"].push_back((e == syntheticExpF) ? json(nullptr) : json(polId));
+    }
+
+    // The quotient polynomial, split in qDeg polynomials of degree N
+    j["qs"] = json::array();
+    for (uint64_t i = 0; i < SYNTHETIC_QDEG; i++)
+    {
+        j["qs"].push_back(addPol(cm4_2ns, FIELD_EXTENSION));
+    }
+
+    // Dimension 1 polynomials go first in their section, followed by the dimension 3 ones
+    uint64_t sectionsN1[eSectionMax] = {0};
+    uint64_t sectionsN3[eSectionMax] = {0};
+    for (uint64_t i = 0; i < pols.size(); i++)
+    {
+        (pols[i].dim == 1 ? sectionsN1 : sectionsN3)[pols[i].section]++;
+    }
+    sectionsN3[q_2ns] = 1; // Quotient polynomial
+    sectionsN3[f_2ns] = 1; // FRI polynomial
+
+    uint64_t positionsN1[eSectionMax] = {0};
+    uint64_t positionsN3[eSectionMax] = {0};
+    json mapSections[eSectionMax];
+    j["varPolMap"] = json::array();
+    for (uint64_t i = 0; i < pols.size(); i++)
+    {
+        eSection section = pols[i].section;
+        json pol;
+        pol["section"] = sectionNames[section];
+        pol["dim"] = pols[i].dim;
+        pol["sectionPos"] = (pols[i].dim == 1) ? positionsN1[section]++ : sectionsN1[section] + FIELD_EXTENSION * positionsN3[section]++;
+        mapSections[section].push_back(i);
+        j["varPolMap"].push_back(pol);
+    }
+
+    uint64_t offset = 0;
+    for (uint64_t i = 0; i < eSectionMax; i++)
+    {
+        eSection section = sectionOrder[i];
+        uint64_t deg = (section == cm1_n || section == cm2_n || section == cm3_n || section == cm4_n || section == tmpExp_n) ? N : NExtended;
+        uint64_t sectionN = sectionsN1[section] + FIELD_EXTENSION * sectionsN3[section];
+        j["mapDeg"][sectionNames[section]] = deg;
+        j["mapOffsets"][sectionNames[section]] = offset;
+        j["mapSections"][sectionNames[section]] = mapSections[section].is_null() ? json::array() : mapSections[section];
+        j["mapSectionsN"][sectionNames[section]] = sectionN;
+        j["mapSectionsN1"][sectionNames[section]] = sectionsN1[section];
+        j["mapSectionsN3"][sectionNames[section]] = sectionsN3[section];
+        offset += deg * sectionN;
+    }
+    j["mapTotalN"] = offset;
+
+    j["nConstants"] = nConstants;
+    j["nPublics"] = 0;
+    j["nCm1"] = nCm1;
+    j["nCm2"] = syntheticZPu - syntheticH1;
+    j["nCm3"] = syntheticCmMax - syntheticZPu;
+    j["nCm4"] = SYNTHETIC_QDEG;
+    j["qDeg"] = SYNTHETIC_QDEG;
+    j["qDim"] = FIELD_EXTENSION;
+    j["friExpId"] = nExps - 1;
+    j["nExps"] = nExps;
+
+    json puCtx;
+    puCtx["tExpId"] = syntheticExpT;
+    puCtx["fExpId"] = syntheticExpF;
+    puCtx["h1Id"] = nCm1 + syntheticH1;
+    puCtx["h2Id"] = nCm1 + syntheticH2;
+    puCtx["zId"] = nCm1 + syntheticZPu;
+    puCtx["c1Id"] = 0;
+    puCtx["numId"] = syntheticExpPuNum;
+    puCtx["denId"] = syntheticExpPuDen;
+    puCtx["c2Id"] = 0;
+    j["puCtx"] = json::array({puCtx});
+
+    json peCtx;
+    peCtx["tExpId"] = syntheticExpPeDen;
+    peCtx["fExpId"] = syntheticExpPeNum;
+    peCtx["zId"] = nCm1 + syntheticZPe;
+    peCtx["c1Id"] = 0;
+    peCtx["numId"] = syntheticExpPeNum;
+    peCtx["denId"] = syntheticExpPeDen;
+    peCtx["c2Id"] = 0;
+    j["peCtx"] = json::array({peCtx});
+
+    json ciCtx;
+    ciCtx["zId"] = nCm1 + syntheticZCi;
+    ciCtx["numId"] = syntheticExpCiNum;
+    ciCtx["denId"] = syntheticExpCiDen;
+    ciCtx["c1Id"] = 0;
+    ciCtx["c2Id"] = 0;
+    j["ciCtx"] = json::array({ciCtx});
+
+    // Committed polynomials are opened at xi and w*xi, constant polynomials at xi (T also at w*xi), and the quotient polynomials at xi
+    j["evMap"] = json::array();
+    for (uint64_t i = 0; i < nCm1 + syntheticCmMax; i++)
+    {
+        for (uint64_t prime = 0; prime < 2; prime++)
+        {
+            json ev;
+            ev["type"] = "cm";
+            ev["id"] = i;
+            ev["prime"] = (prime == 1);
+            j["evMap"].push_back(ev);
+        }
+    }
+    for (uint64_t i = 0; i < nConstants; i++)
+    {
+        for (uint64_t prime = 0; prime < ((i == syntheticT) ? 2 : 1); prime++)
+        {
+            json ev;
+            ev["type"] = "const";
+            ev["id"] = i;
+            ev["prime"] = (prime == 1);
+            j["evMap"].push_back(ev);
+        }
+    }
+    for (uint64_t i = 0; i < SYNTHETIC_QDEG; i++)
+    {
+        json ev;
+        ev["type"] = "q";
+        ev["id"] = i;
+        ev["prime"] = false;
+        j["evMap"].push_back(ev);
+    }
+
+    // The steps are implemented by SyntheticSteps
+    j["step2prev"] = emptyStep();
+    j["step3prev"] = emptyStep();
+    j["step3"] = emptyStep();
+    j["step42ns"] = emptyStep();
+    j["step52ns"] = emptyStep();
+    j["exps_n"] = json::array();
+    j["q_2ns"] = json::array();
+    j["cm4_n"] = json::array();
+    j["cm4_2ns"] = json::array();
+
+    return j;
+}
+
+void SyntheticStark::generateTable (vector<Goldilocks::Element> &table)
+{
+    table.resize(1 << nBits);
+    benchRandomFill(table.data(), table.size(), 1);
+}
+
+void SyntheticStark::generateConstants (void)
+{
+    uint64_t N = 1 << nBits;
+    uint64_t NExtended = 1 << nBitsExt;
+
+    // Constant polynomials, row by row; S is the permutation of ID that swaps every pair of rows
+    Goldilocks::Element *pConstPols = (Goldilocks::Element *)mapFile(files.zkevmConstPols, N * nConstants * sizeof(Goldilocks::Element), true);
+    benchRandomFill(pConstPols, N * nConstants, 0);
+    vector<Goldilocks::Element> table;
+    generateTable(table);
+    vector<Goldilocks::Element> ID(N);
+    ID[0] = Goldilocks::one();
+    for (uint64_t i = 1; i < N; i++)
+    {
+        ID[i] = ID[i - 1] * Goldilocks::w(nBits);
+    }
+#pragma omp parallel for
+    for (uint64_t i = 0; i < N; i++)
+    {
+        Goldilocks::Element *row = &pConstPols[i * nConstants];
+        row[syntheticL1] = (i == 0) ? Goldilocks::one() : Goldilocks::zero();
+        row[syntheticT] = table[i];
+        row[syntheticID] = ID[i];
+        row[syntheticS] = ID[i ^ 1];
+    }
+
+    // Constants tree: width, height, extended constant polynomials and merkle tree nodes
+    MerkleTreeGL tree(NExtended, nConstants, NULL);
+    uint64_t treeSize = MERKLEHASHGOLDILOCKS_HEADER_SIZE + NExtended * nConstants + tree.getTreeNumElements();
+    Goldilocks::Element *pConstTree = (Goldilocks::Element *)mapFile(files.zkevmConstantsTree, treeSize * sizeof(Goldilocks::Element), true);
+    pConstTree[0] = Goldilocks::fromU64(nConstants);
+    pConstTree[1] = Goldilocks::fromU64(NExtended);
+    NTT_Goldilocks ntt(N);
+    ntt.extendPol(tree.source, pConstPols, NExtended, N, nConstants);
+    tree.merkelize();
+    tree.getRoot(constRoot);
+    memcpy(&pConstTree[MERKLEHASHGOLDILOCKS_HEADER_SIZE], tree.source, NExtended * nConstants * sizeof(Goldilocks::Element));
+    memcpy(&pConstTree[MERKLEHASHGOLDILOCKS_HEADER_SIZE + NExtended * nConstants], tree.nodes, tree.getTreeNumElements() * sizeof(Goldilocks::Element));
+
+    unmapFile(pConstPols, N * nConstants * sizeof(Goldilocks::Element));
+    unmapFile(pConstTree, treeSize * sizeof(Goldilocks::Element));
+}
+
+void SyntheticStark::generate (const string &folder)
+{
+    string prefix = folder + "/zkprover_bench_" + getUUID() + "_" + to_string(nBits) + ".";
+    files.zkevmStarkInfo = prefix + "starkinfo.json";
+    files.zkevmConstPols = prefix + "const";
+    files.mapConstPolsFile = false;
+    files.zkevmConstantsTree = prefix + "consttree";
+
+    json2file(starkInfoJson(), files.zkevmStarkInfo);
+    generateConstants();
+}
+
+uint64_t SyntheticStark::memSize (const StarkInfo &starkInfo)
+{
+    // Same size allocated by the prover: the polynomials, plus a buffer used by the NTTs and the plookups
+    return starkInfo.mapTotalN + starkInfo.mapSectionsN.section[eSection::cm1_n] * (1 << starkInfo.starkStruct.nBits) * FIELD_EXTENSION;
+}
+
+void SyntheticStark::generateWitness (Goldilocks::Element *pAddress, const StarkInfo &starkInfo)
+{
+    uint64_t N = 1 << nBits;
+    Goldilocks::Element *pCm1 = &pAddress[starkInfo.mapOffsets.section[eSection::cm1_n]];
+    benchRandomFill(pCm1, N * nCm1, 2);
+
+    // f takes random values of T, permB takes the values of permA in a random order,
+    // and conn has the same value in every pair of rows swapped by S
+    vector<Goldilocks::Element> table;
+    generateTable(table);
+    vector<uint64_t> permutation(N);
+    iota(permutation.begin(), permutation.end(), 0);
+    shuffle(permutation.begin(), permutation.end(), mt19937_64(3));
+    mt19937_64 generator(4);
+    for (uint64_t i = 0; i < N; i++)
+    {
+        Goldilocks::Element *row = &pCm1[i * nCm1];
+        row[syntheticF] = table[generator() % N];
+        row[syntheticPermB] = pCm1[permutation[i] * nCm1 + syntheticPermA];
+        if (i & 1)
+        {
+            row[syntheticConn] = pCm1[(i - 1) * nCm1 + syntheticConn];
+        }
+        row[syntheticASquare] = row[syntheticA] * row[syntheticA];
+    }
+}
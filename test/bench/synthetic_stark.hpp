@@ -0,0 +1,114 @@
+#ifndef SYNTHETIC_STARK_HPP
+#define SYNTHETIC_STARK_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "starks.hpp"
+
+using json = nlohmann::json;
+using namespace std;
+
+/* SyntheticStark generates the files that a Starks object loads (stark info, constant polynomials and
+   constants tree) for a synthetic PIL of 2^nBits rows, so that the STARK code can be benchmarked without
+   the zkevm runtime files, together with a witness that satisfies it and a verifier of its proofs.
+   The PIL has nCm1 stage 1 committed columns of dimension 1 and nConstants constant columns:
+     - f is looked up in the constant table T (plookup), whose h1 and h2 are the stage 2 columns
+     - permB is a permutation of permA (permutation check)
+     - conn is connected to itself by the permutation S of the identity ID (connection check)
+     - aSquare = a * a
+     - the rest of the columns are random and only committed and opened
+   The grand products of the plookup, the permutation and the connection are the stage 3 columns zPu,
+   zPe and zCi, of dimension 3, and imNum and imDen are intermediate polynomials that keep the plookup
+   constraint of degree 2; the quotient polynomial is split in qDeg = 2 stage 4 columns.
+   Committed columns are opened at xi and w*xi, constant columns at xi (and T also at w*xi), and the
+   quotient columns at xi. The steps of the PIL are implemented by SyntheticSteps */
+
+// Stage 1 committed columns with a role in the constraints; the rest, up to nCm1, are random
+enum eSyntheticCm1
+{
+    syntheticF = 0,
+    syntheticPermA = 1,
+    syntheticPermB = 2,
+    syntheticConn = 3,
+    syntheticA = 4,
+    syntheticASquare = 5
+};
+
+// Constant columns with a role in the constraints; the rest, up to nConstants, are random
+enum eSyntheticConst
+{
+    syntheticL1 = 0,
+    syntheticT = 1,
+    syntheticID = 2,
+    syntheticS = 3
+};
+
+// Committed columns of the later stages, by cm id relative to nCm1
+enum eSyntheticCm
+{
+    syntheticH1 = 0,
+    syntheticH2 = 1,
+    syntheticZPu = 2,
+    syntheticZPe = 3,
+    syntheticZCi = 4,
+    syntheticImNum = 5,
+    syntheticImDen = 6,
+    syntheticCmMax = 7
+};
+
+// Expressions stored in tmpExp_n, by exp id
+enum eSyntheticExp
+{
+    syntheticExpF = 0, // The committed column f
+    syntheticExpT = 1,
+    syntheticExpPuNum = 2,
+    syntheticExpPuDen = 3,
+    syntheticExpPeNum = 4,
+    syntheticExpPeDen = 5,
+    syntheticExpCiNum = 6,
+    syntheticExpCiDen = 7,
+    syntheticExpMax = 8
+};
+
+#define SYNTHETIC_MIN_CM1 10 // Starks uses a buffer of 3*N*nCm1 elements for the LDE of the stage 3 columns and the plookups
+#define SYNTHETIC_MIN_CONSTANTS 4
+#define SYNTHETIC_QDEG 2
+
+class SyntheticStark
+{
+public:
+    uint64_t nBits;
+    uint64_t nBitsExt;
+    uint64_t nCm1;
+    uint64_t nConstants;
+    StarkFiles files;
+    Goldilocks::Element constRoot[HASH_SIZE]; // Root of the constants tree, set by generate()
+
+    SyntheticStark (uint64_t nBits, uint64_t nCm1, uint64_t nConstants) :
+        nBits(nBits),
+        nBitsExt(nBits + 1),
+        nCm1(std::max<uint64_t>(nCm1, SYNTHETIC_MIN_CM1)),
+        nConstants(std::max<uint64_t>(nConstants, SYNTHETIC_MIN_CONSTANTS)) {};
+    ~SyntheticStark ();
+
+    // Writes the files in folder, and sets files to their names
+    void generate (const string &folder);
+
+    // Fills the stage 1 committed polynomials of pAddress with a witness that satisfies the PIL
+    void generateWitness (Goldilocks::Element *pAddress, const StarkInfo &starkInfo);
+
+    // Checks a proof generated by Starks::genProof() with SyntheticSteps; returns false and logs the reason if it is not valid
+    bool verify (const StarkInfo &starkInfo, FRIProof &proof);
+
+    // Returns the number of field elements to allocate for the Starks committed polynomials (pAddress)
+    static uint64_t memSize (const StarkInfo &starkInfo);
+
+private:
+    json starkInfoJson (void);
+    void generateConstants (void);
+    void generateTable (vector<Goldilocks::Element> &table);
+};
+
+#endif
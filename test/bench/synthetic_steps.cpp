@@ -0,0 +1,370 @@
+#include "synthetic_steps.hpp"
+
+// Reads the value of row i of a polynomial into an extension field element
+static inline void getValue (Goldilocks3::Element &e, Goldilocks::Element *pols, const SyntheticPol &pol, uint64_t i)
+{
+    Goldilocks::Element *p = &pols[pol.offset + i * pol.stride];
+    if (pol.dim == 1)
+    {
+        syntheticToExt(e, p[0]);
+    }
+    else
+    {
+        e[0] = p[0];
+        e[1] = p[1];
+        e[2] = p[2];
+    }
+}
+
+static inline void setValue (Goldilocks::Element *pols, const SyntheticPol &pol, uint64_t i, const Goldilocks3::Element &e)
+{
+    Goldilocks::Element *p = &pols[pol.offset + i * pol.stride];
+    p[0] = e[0];
+    p[1] = e[1];
+    p[2] = e[2];
+}
+
+// acc = acc * v + term
+static inline void horner (Goldilocks3::Element &acc, const Goldilocks3::Element &v, const Goldilocks3::Element &term)
+{
+    Goldilocks3::Element aux;
+    Goldilocks3::mul(aux, acc, v);
+    Goldilocks3::add(acc, aux, term);
+}
+
+// Grand product terms of the permutation (v+gamma) and of the connection (v+beta*sigma+gamma)
+static inline void permutationTerm (Goldilocks3::Element &r, const Goldilocks3::Element &v, const Goldilocks3::Element &gamma)
+{
+    Goldilocks3::add(r, v, gamma);
+}
+
+static inline void connectionTerm (Goldilocks3::Element &r, const Goldilocks3::Element &v, const Goldilocks3::Element &sigma, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta)
+{
+    Goldilocks3::Element betaSigma, sum;
+    Goldilocks3::mul(betaSigma, beta, sigma);
+    Goldilocks3::add(sum, v, betaSigma);
+    Goldilocks3::add(r, sum, gamma);
+}
+
+// L1*(z-1): the grand product starts at 1
+static inline void firstRowConstraint (Goldilocks3::Element &e, const Goldilocks3::Element &L1, const Goldilocks3::Element &z)
+{
+    Goldilocks3::Element one, aux;
+    syntheticToExt(one, Goldilocks::one());
+    Goldilocks3::sub(aux, z, one);
+    Goldilocks3::mul(e, L1, aux);
+}
+
+// z'*den - z*num: the grand product accumulates num/den
+static inline void grandProductConstraint (Goldilocks3::Element &e, const Goldilocks3::Element &z, const Goldilocks3::Element &zNext, const Goldilocks3::Element &num, const Goldilocks3::Element &den)
+{
+    Goldilocks3::Element aux1, aux2;
+    Goldilocks3::mul(aux1, zNext, den);
+    Goldilocks3::mul(aux2, z, num);
+    Goldilocks3::sub(e, aux1, aux2);
+}
+
+SyntheticSteps::SyntheticSteps (const StarkInfo &starkInfo) :
+    N(1 << starkInfo.starkStruct.nBits),
+    NExtended(1 << starkInfo.starkStruct.nBitsExt),
+    extendBits(starkInfo.starkStruct.nBitsExt - starkInfo.starkStruct.nBits),
+    nCm1(starkInfo.nCm1)
+{
+    for (uint64_t i = 0; i < starkInfo.cm_n.size(); i++)
+    {
+        cm_n.push_back(getPol(starkInfo, starkInfo.cm_n[i]));
+        cm_2ns.push_back(getPol(starkInfo, starkInfo.cm_2ns[i]));
+    }
+    for (uint64_t e = 0; e < syntheticExpMax; e++)
+    {
+        exps[e] = getPol(starkInfo, starkInfo.exp2pol.at(to_string(e)));
+    }
+    for (uint64_t i = 0; i < starkInfo.evMap.size(); i++)
+    {
+        SyntheticOpening opening;
+        opening.type = starkInfo.evMap[i].type;
+        opening.prime = starkInfo.evMap[i].prime;
+        opening.id = starkInfo.evMap[i].id;
+        opening.pol = {0, 0, 1};
+        if (opening.type == EvMap::eType::cm)
+        {
+            opening.pol = cm_2ns[opening.id];
+        }
+        else if (opening.type == EvMap::eType::q)
+        {
+            opening.pol = getPol(starkInfo, starkInfo.qs[opening.id]);
+        }
+        openings.push_back(opening);
+    }
+}
+
+SyntheticPol SyntheticSteps::getPol (const StarkInfo &starkInfo, uint64_t polId)
+{
+    const VarPolMap &polInfo = starkInfo.varPolMap[polId];
+    SyntheticPol pol;
+    pol.offset = starkInfo.mapOffsets.section[polInfo.section] + polInfo.sectionPos;
+    pol.stride = starkInfo.mapSectionsN.section[polInfo.section];
+    pol.dim = polInfo.dim;
+    return pol;
+}
+
+void SyntheticSteps::plookupNum (Goldilocks3::Element &num, const Goldilocks3::Element &f, const Goldilocks3::Element &t, const Goldilocks3::Element &tNext, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta)
+{
+    Goldilocks3::Element one, onePlusBeta, gammaOnePlusBeta, gammaF, fTerm, betaTNext, tSum, tTerm;
+    syntheticToExt(one, Goldilocks::one());
+    Goldilocks3::add(onePlusBeta, one, beta);
+    Goldilocks3::mul(gammaOnePlusBeta, gamma, onePlusBeta);
+    Goldilocks3::add(gammaF, gamma, f);
+    Goldilocks3::mul(fTerm, onePlusBeta, gammaF);
+    Goldilocks3::mul(betaTNext, beta, tNext);
+    Goldilocks3::add(tSum, t, betaTNext);
+    Goldilocks3::add(tTerm, gammaOnePlusBeta, tSum);
+    Goldilocks3::mul(num, fTerm, tTerm);
+}
+
+void SyntheticSteps::plookupDen (Goldilocks3::Element &den, const Goldilocks3::Element &h1, const Goldilocks3::Element &h2, const Goldilocks3::Element &h1Next, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta)
+{
+    Goldilocks3::Element one, onePlusBeta, gammaOnePlusBeta, betaH2, sum1, term1, betaH1Next, sum2, term2;
+    syntheticToExt(one, Goldilocks::one());
+    Goldilocks3::add(onePlusBeta, one, beta);
+    Goldilocks3::mul(gammaOnePlusBeta, gamma, onePlusBeta);
+    Goldilocks3::mul(betaH2, beta, h2);
+    Goldilocks3::add(sum1, h1, betaH2);
+    Goldilocks3::add(term1, gammaOnePlusBeta, sum1);
+    Goldilocks3::mul(betaH1Next, beta, h1Next);
+    Goldilocks3::add(sum2, h2, betaH1Next);
+    Goldilocks3::add(term2, gammaOnePlusBeta, sum2);
+    Goldilocks3::mul(den, term1, term2);
+}
+
+void SyntheticSteps::constraints (Goldilocks3::Element &c, const SyntheticRow &row, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta, const Goldilocks3::Element &vc)
+{
+    Goldilocks3::Element e, aux1, aux2;
+    syntheticToExt(c, Goldilocks::zero());
+
+    // aSquare = a * a
+    Goldilocks3::mul(aux1, row.a, row.a);
+    Goldilocks3::sub(e, row.aSquare, aux1);
+    horner(c, vc, e);
+
+    // Plookup of f in T; imNum and imDen keep the degree of the grand product constraint to 2
+    firstRowConstraint(e, row.L1, row.zPu);
+    horner(c, vc, e);
+    grandProductConstraint(e, row.zPu, row.zPuNext, row.imNum, row.imDen);
+    horner(c, vc, e);
+    plookupNum(aux1, row.f, row.T, row.TNext, gamma, beta);
+    Goldilocks3::sub(e, row.imNum, aux1);
+    horner(c, vc, e);
+    plookupDen(aux1, row.h1, row.h2, row.h1Next, gamma, beta);
+    Goldilocks3::sub(e, row.imDen, aux1);
+    horner(c, vc, e);
+
+    // Permutation of permA into permB
+    firstRowConstraint(e, row.L1, row.zPe);
+    horner(c, vc, e);
+    permutationTerm(aux1, row.permA, gamma);
+    permutationTerm(aux2, row.permB, gamma);
+    grandProductConstraint(e, row.zPe, row.zPeNext, aux1, aux2);
+    horner(c, vc, e);
+
+    // Connection of conn by S
+    firstRowConstraint(e, row.L1, row.zCi);
+    horner(c, vc, e);
+    connectionTerm(aux1, row.conn, row.ID, gamma, beta);
+    connectionTerm(aux2, row.conn, row.S, gamma, beta);
+    grandProductConstraint(e, row.zCi, row.zCiNext, aux1, aux2);
+    horner(c, vc, e);
+}
+
+void SyntheticSteps::friAccumulate (Goldilocks3::Element &accXi, Goldilocks3::Element &accWXi, bool prime, const Goldilocks3::Element &p, const Goldilocks3::Element &ev, const Goldilocks3::Element &v1, const Goldilocks3::Element &v2)
+{
+    Goldilocks3::Element d;
+    Goldilocks3::sub(d, p, ev);
+    if (prime)
+    {
+        horner(accWXi, v2, d);
+    }
+    else
+    {
+        horner(accXi, v1, d);
+    }
+}
+
+void SyntheticSteps::friValue (Goldilocks3::Element &f, const Goldilocks3::Element &accXi, const Goldilocks3::Element &accWXi, const Goldilocks3::Element &xDivXSubXi, const Goldilocks3::Element &xDivXSubWXi)
+{
+    Goldilocks3::Element aux1, aux2;
+    Goldilocks3::mul(aux1, accXi, xDivXSubXi);
+    Goldilocks3::mul(aux2, accWXi, xDivXSubWXi);
+    Goldilocks3::add(f, aux1, aux2);
+}
+
+void SyntheticSteps::getRow2ns (SyntheticRow &row, StepsParams &params, uint64_t i)
+{
+    uint64_t next = (i + (1 << extendBits)) % NExtended;
+    Goldilocks::Element *pols = params.pols;
+
+    getValue(row.f, pols, cm_2ns[syntheticF], i);
+    getValue(row.permA, pols, cm_2ns[syntheticPermA], i);
+    getValue(row.permB, pols, cm_2ns[syntheticPermB], i);
+    getValue(row.conn, pols, cm_2ns[syntheticConn], i);
+    getValue(row.a, pols, cm_2ns[syntheticA], i);
+    getValue(row.aSquare, pols, cm_2ns[syntheticASquare], i);
+    getValue(row.h1, pols, cm_2ns[nCm1 + syntheticH1], i);
+    getValue(row.h2, pols, cm_2ns[nCm1 + syntheticH2], i);
+    getValue(row.h1Next, pols, cm_2ns[nCm1 + syntheticH1], next);
+    getValue(row.zPu, pols, cm_2ns[nCm1 + syntheticZPu], i);
+    getValue(row.zPuNext, pols, cm_2ns[nCm1 + syntheticZPu], next);
+    getValue(row.zPe, pols, cm_2ns[nCm1 + syntheticZPe], i);
+    getValue(row.zPeNext, pols, cm_2ns[nCm1 + syntheticZPe], next);
+    getValue(row.zCi, pols, cm_2ns[nCm1 + syntheticZCi], i);
+    getValue(row.zCiNext, pols, cm_2ns[nCm1 + syntheticZCi], next);
+    getValue(row.imNum, pols, cm_2ns[nCm1 + syntheticImNum], i);
+    getValue(row.imDen, pols, cm_2ns[nCm1 + syntheticImDen], i);
+    syntheticToExt(row.L1, params.pConstPols2ns->getElement(syntheticL1, i));
+    syntheticToExt(row.T, params.pConstPols2ns->getElement(syntheticT, i));
+    syntheticToExt(row.TNext, params.pConstPols2ns->getElement(syntheticT, next));
+    syntheticToExt(row.ID, params.pConstPols2ns->getElement(syntheticID, i));
+    syntheticToExt(row.S, params.pConstPols2ns->getElement(syntheticS, i));
+}
+
+// t = T
+void SyntheticSteps::step2prev_first (StepsParams &params, uint64_t i)
+{
+    params.pols[exps[syntheticExpT].offset + i * exps[syntheticExpT].stride] = params.pConstPols->getElement(syntheticT, i);
+}
+
+void SyntheticSteps::step2prev_i (StepsParams &params, uint64_t i)
+{
+    step2prev_first(params, i);
+}
+
+void SyntheticSteps::step2prev_last (StepsParams &params, uint64_t i)
+{
+    step2prev_first(params, i);
+}
+
+// Numerators and denominators of the grand products
+void SyntheticSteps::step3prev_first (StepsParams &params, uint64_t i)
+{
+    uint64_t next = (i + 1) % N;
+    Goldilocks::Element *pols = params.pols;
+    Goldilocks3::Element &gamma = (Goldilocks3::Element &)*params.challenges[2];
+    Goldilocks3::Element &beta = (Goldilocks3::Element &)*params.challenges[3];
+    Goldilocks3::Element f, t, tNext, h1, h2, h1Next, v, sigma, r;
+
+    getValue(f, pols, cm_n[syntheticF], i);
+    syntheticToExt(t, params.pConstPols->getElement(syntheticT, i));
+    syntheticToExt(tNext, params.pConstPols->getElement(syntheticT, next));
+    plookupNum(r, f, t, tNext, gamma, beta);
+    setValue(pols, exps[syntheticExpPuNum], i, r);
+    getValue(h1, pols, cm_n[nCm1 + syntheticH1], i);
+    getValue(h2, pols, cm_n[nCm1 + syntheticH2], i);
+    getValue(h1Next, pols, cm_n[nCm1 + syntheticH1], next);
+    plookupDen(r, h1, h2, h1Next, gamma, beta);
+    setValue(pols, exps[syntheticExpPuDen], i, r);
+
+    getValue(v, pols, cm_n[syntheticPermA], i);
+    permutationTerm(r, v, gamma);
+    setValue(pols, exps[syntheticExpPeNum], i, r);
+    getValue(v, pols, cm_n[syntheticPermB], i);
+    permutationTerm(r, v, gamma);
+    setValue(pols, exps[syntheticExpPeDen], i, r);
+
+    getValue(v, pols, cm_n[syntheticConn], i);
+    syntheticToExt(sigma, params.pConstPols->getElement(syntheticID, i));
+    connectionTerm(r, v, sigma, gamma, beta);
+    setValue(pols, exps[syntheticExpCiNum], i, r);
+    syntheticToExt(sigma, params.pConstPols->getElement(syntheticS, i));
+    connectionTerm(r, v, sigma, gamma, beta);
+    setValue(pols, exps[syntheticExpCiDen], i, r);
+}
+
+void SyntheticSteps::step3prev_i (StepsParams &params, uint64_t i)
+{
+    step3prev_first(params, i);
+}
+
+void SyntheticSteps::step3prev_last (StepsParams &params, uint64_t i)
+{
+    step3prev_first(params, i);
+}
+
+// imNum and imDen, the plookup numerator and denominator
+void SyntheticSteps::step3_first (StepsParams &params, uint64_t i)
+{
+    Goldilocks3::Element v;
+    getValue(v, params.pols, exps[syntheticExpPuNum], i);
+    setValue(params.pols, cm_n[nCm1 + syntheticImNum], i, v);
+    getValue(v, params.pols, exps[syntheticExpPuDen], i);
+    setValue(params.pols, cm_n[nCm1 + syntheticImDen], i, v);
+}
+
+void SyntheticSteps::step3_i (StepsParams &params, uint64_t i)
+{
+    step3_first(params, i);
+}
+
+void SyntheticSteps::step3_last (StepsParams &params, uint64_t i)
+{
+    step3_first(params, i);
+}
+
+// Quotient polynomial: constraints / Zh
+void SyntheticSteps::step42ns_first (StepsParams &params, uint64_t i)
+{
+    SyntheticRow row;
+    getRow2ns(row, params, i);
+    Goldilocks3::Element c, q;
+    constraints(c, row, (Goldilocks3::Element &)*params.challenges[2], (Goldilocks3::Element &)*params.challenges[3], (Goldilocks3::Element &)*params.challenges[4]);
+    Goldilocks::Element zhInv = params.zi.zhInv(i);
+    Goldilocks3::mul(q, c, zhInv);
+    params.q_2ns[i * FIELD_EXTENSION] = q[0];
+    params.q_2ns[i * FIELD_EXTENSION + 1] = q[1];
+    params.q_2ns[i * FIELD_EXTENSION + 2] = q[2];
+}
+
+void SyntheticSteps::step42ns_i (StepsParams &params, uint64_t i)
+{
+    step42ns_first(params, i);
+}
+
+void SyntheticSteps::step42ns_last (StepsParams &params, uint64_t i)
+{
+    step42ns_first(params, i);
+}
+
+// FRI polynomial: every opening, minus its evaluation, divided by x-xi or x-w*xi
+void SyntheticSteps::step52ns_first (StepsParams &params, uint64_t i)
+{
+    Goldilocks3::Element &v1 = (Goldilocks3::Element &)*params.challenges[5];
+    Goldilocks3::Element &v2 = (Goldilocks3::Element &)*params.challenges[6];
+    Goldilocks3::Element accXi, accWXi, p, f;
+    syntheticToExt(accXi, Goldilocks::zero());
+    syntheticToExt(accWXi, Goldilocks::zero());
+    for (uint64_t k = 0; k < openings.size(); k++)
+    {
+        if (openings[k].type == EvMap::eType::_const)
+        {
+            syntheticToExt(p, params.pConstPols2ns->getElement(openings[k].id, i));
+        }
+        else
+        {
+            getValue(p, params.pols, openings[k].pol, i);
+        }
+        friAccumulate(accXi, accWXi, openings[k].prime, p, (Goldilocks3::Element &)*params.evals[k], v1, v2);
+    }
+    friValue(f, accXi, accWXi, (Goldilocks3::Element &)*params.xDivXSubXi[i], (Goldilocks3::Element &)*params.xDivXSubWXi[i]);
+    params.f_2ns[i * FIELD_EXTENSION] = f[0];
+    params.f_2ns[i * FIELD_EXTENSION + 1] = f[1];
+    params.f_2ns[i * FIELD_EXTENSION + 2] = f[2];
+}
+
+void SyntheticSteps::step52ns_i (StepsParams &params, uint64_t i)
+{
+    step52ns_first(params, i);
+}
+
+void SyntheticSteps::step52ns_last (StepsParams &params, uint64_t i)
+{
+    step52ns_first(params, i);
+}
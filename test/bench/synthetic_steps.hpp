@@ -0,0 +1,104 @@
+#ifndef SYNTHETIC_STEPS_HPP
+#define SYNTHETIC_STEPS_HPP
+
+#include <vector>
+#include "goldilocks_cubic_extension.hpp"
+#include "starks.hpp"
+#include "synthetic_stark.hpp"
+
+using namespace std;
+
+// Position of a polynomial in the committed polynomials memory (StepsParams::pols)
+struct SyntheticPol
+{
+    uint64_t offset;
+    uint64_t stride;
+    uint64_t dim;
+};
+
+// Polynomial opened by the FRI polynomial, i.e. an entry of the evMap
+struct SyntheticOpening
+{
+    EvMap::eType type;
+    bool prime;
+    uint64_t id;
+    SyntheticPol pol; // Its _2ns or q polynomial, if it is not a constant
+};
+
+/* Values of the columns used by the synthetic PIL constraints at a point, and at the next one (Next)
+   Every value is in the extension field, so that the constraints are evaluated by the same code on
+   the rows of the extended domain (prover) and at xi (verifier) */
+struct SyntheticRow
+{
+    Goldilocks3::Element f, permA, permB, conn, a, aSquare;
+    Goldilocks3::Element h1, h2, h1Next;
+    Goldilocks3::Element zPu, zPuNext, zPe, zPeNext, zCi, zCiNext;
+    Goldilocks3::Element imNum, imDen;
+    Goldilocks3::Element L1, T, TNext, ID, S;
+};
+
+/* Steps of the PIL generated by SyntheticStark, written by hand instead of generated from the stark
+   info; the _i and _last variants are not used by Starks::genProof() */
+class SyntheticSteps : public Steps
+{
+private:
+    uint64_t N;
+    uint64_t NExtended;
+    uint64_t extendBits;
+    uint64_t nCm1;
+    vector<SyntheticPol> cm_n;   // By cm id
+    vector<SyntheticPol> cm_2ns; // By cm id
+    SyntheticPol exps[syntheticExpMax];
+    vector<SyntheticOpening> openings;
+
+    // Fills the values of row i of the extended domain
+    void getRow2ns (SyntheticRow &row, StepsParams &params, uint64_t i);
+
+public:
+    SyntheticSteps (const StarkInfo &starkInfo);
+
+    static SyntheticPol getPol (const StarkInfo &starkInfo, uint64_t polId);
+
+    // Grand product terms of the plookup: (1+beta)*(gamma+f)*(gamma*(1+beta)+t+beta*t') / ((gamma*(1+beta)+h1+beta*h2)*(gamma*(1+beta)+h2+beta*h1'))
+    static void plookupNum (Goldilocks3::Element &num, const Goldilocks3::Element &f, const Goldilocks3::Element &t, const Goldilocks3::Element &tNext, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta);
+    static void plookupDen (Goldilocks3::Element &den, const Goldilocks3::Element &h1, const Goldilocks3::Element &h2, const Goldilocks3::Element &h1Next, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta);
+
+    // Evaluates the constraints, combined with powers of vc, that must vanish in the base domain
+    static void constraints (Goldilocks3::Element &c, const SyntheticRow &row, const Goldilocks3::Element &gamma, const Goldilocks3::Element &beta, const Goldilocks3::Element &vc);
+
+    // Adds the term (p - ev) of an opening to the accumulator of its evaluation point, combined with powers of v1 (xi) or v2 (w*xi)
+    static void friAccumulate (Goldilocks3::Element &accXi, Goldilocks3::Element &accWXi, bool prime, const Goldilocks3::Element &p, const Goldilocks3::Element &ev, const Goldilocks3::Element &v1, const Goldilocks3::Element &v2);
+
+    // FRI polynomial value: accXi * x/(x-xi) + accWXi * x/(x-w*xi)
+    static void friValue (Goldilocks3::Element &f, const Goldilocks3::Element &accXi, const Goldilocks3::Element &accWXi, const Goldilocks3::Element &xDivXSubXi, const Goldilocks3::Element &xDivXSubWXi);
+
+    void step2prev_first (StepsParams &params, uint64_t i);
+    void step2prev_i (StepsParams &params, uint64_t i);
+    void step2prev_last (StepsParams &params, uint64_t i);
+
+    void step3prev_first (StepsParams &params, uint64_t i);
+    void step3prev_i (StepsParams &params, uint64_t i);
+    void step3prev_last (StepsParams &params, uint64_t i);
+
+    void step3_first (StepsParams &params, uint64_t i);
+    void step3_i (StepsParams &params, uint64_t i);
+    void step3_last (StepsParams &params, uint64_t i);
+
+    void step42ns_first (StepsParams &params, uint64_t i);
+    void step42ns_i (StepsParams &params, uint64_t i);
+    void step42ns_last (StepsParams &params, uint64_t i);
+
+    void step52ns_first (StepsParams &params, uint64_t i);
+    void step52ns_i (StepsParams &params, uint64_t i);
+    void step52ns_last (StepsParams &params, uint64_t i);
+};
+
+// Sets the extension field element e to the base field element v
+inline void syntheticToExt (Goldilocks3::Element &e, const Goldilocks::Element &v)
+{
+    e[0] = v;
+    e[1] = Goldilocks::zero();
+    e[2] = Goldilocks::zero();
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "synthetic_stark.hpp"
+#include "synthetic_steps.hpp"
+#include "exit_process.hpp"
+
+// Position of an opening in the leaves of the stage trees (0 to 3) and the constants tree (4) of a query
+struct SyntheticLeafPos
+{
+    uint64_t tree;
+    uint64_t pos;
+    uint64_t dim;
+};
+
+// Verifies a merkle proof of the FRI proof, and returns the leaf it opens
+static bool checkMerkleProof (const Goldilocks::Element *root, MerkleProof &mkProof, uint64_t idx, vector<Goldilocks::Element> &leaf)
+{
+    leaf.resize(mkProof.v.size());
+    for (uint64_t i = 0; i < mkProof.v.size(); i++)
+    {
+        leaf[i] = mkProof.v[i][0];
+    }
+    vector<Goldilocks::Element> siblings(mkProof.mp.size() * HASH_SIZE);
+    for (uint64_t j = 0; j < mkProof.mp.size(); j++)
+    {
+        memcpy(&siblings[j * HASH_SIZE], &mkProof.mp[j][0], HASH_SIZE * sizeof(Goldilocks::Element));
+    }
+    return MerkleTreeGL::verifyMerkleProof(root, leaf.data(), leaf.size(), idx, siblings.data(), mkProof.mp.size());
+}
+
+static bool equal (const Goldilocks3::Element &a, const Goldilocks3::Element &b)
+{
+    return (Goldilocks::toU64(a[0]) == Goldilocks::toU64(b[0])) &&
+           (Goldilocks::toU64(a[1]) == Goldilocks::toU64(b[1])) &&
+           (Goldilocks::toU64(a[2]) == Goldilocks::toU64(b[2]));
+}
+
+// Index of an opening in the evMap
+static uint64_t evIndex (const StarkInfo &starkInfo, EvMap::eType type, uint64_t id, bool prime)
+{
+    for (uint64_t i = 0; i < starkInfo.evMap.size(); i++)
+    {
+        if ((starkInfo.evMap[i].type == type) && (starkInfo.evMap[i].id == id) && (starkInfo.evMap[i].prime == prime))
+        {
+            return i;
+        }
+    }
+    cerr << "Error: SyntheticStark::verify() found no opening of type=" << type << " id=" << id << " prime=" << prime << endl;
+    exitProcess();
+    return 0;
+}
+
+bool SyntheticStark::verify (const StarkInfo &starkInfo, FRIProof &proof)
+{
+    uint64_t N = 1 << nBits;
+    const vector<StepStruct> &steps = starkInfo.starkStruct.steps;
+    uint64_t nSteps = steps.size();
+    uint64_t nQueries = starkInfo.starkStruct.nQueries;
+    Proofs &proofs = proof.proofs;
+
+    // Replay the transcript of Starks::genProof() and FRIProve::prove()
+    Transcript transcript;
+    Polinomial challenges(NUM_CHALLENGES, FIELD_EXTENSION);
+    transcript.put(proofs.root1.data(), HASH_SIZE);
+    transcript.getField(challenges[0]); // u
+    transcript.getField(challenges[1]); // defVal
+    transcript.put(proofs.root2.data(), HASH_SIZE);
+    transcript.getField(challenges[2]); // gamma
+    transcript.getField(challenges[3]); // beta
+    transcript.put(proofs.root3.data(), HASH_SIZE);
+    transcript.getField(challenges[4]); // vc
+    transcript.put(proofs.root4.data(), HASH_SIZE);
+    transcript.getField(challenges[7]); // xi
+    for (uint64_t i = 0; i < proofs.evals.size(); i++)
+    {
+        transcript.put(proofs.evals[i].data(), FIELD_EXTENSION);
+    }
+    transcript.getField(challenges[5]); // v1
+    transcript.getField(challenges[6]); // v2
+    Polinomial specialX(nSteps, FIELD_EXTENSION);
+    for (uint64_t si = 0; si < nSteps; si++)
+    {
+        transcript.getField(specialX[si]);
+        if (si < nSteps - 1)
+        {
+            transcript.put(proofs.fri.trees[si + 1].root.data(), HASH_SIZE);
+        }
+        else
+        {
+            for (uint64_t i = 0; i < proofs.fri.pol.size(); i++)
+            {
+                transcript.put(proofs.fri.pol[i].data(), FIELD_EXTENSION);
+            }
+        }
+    }
+    uint64_t ys[nQueries];
+    transcript.getPermutations(ys, nQueries, steps[0].nBits);
+
+    Goldilocks3::Element &gamma = (Goldilocks3::Element &)*challenges[2];
+    Goldilocks3::Element &beta = (Goldilocks3::Element &)*challenges[3];
+    Goldilocks3::Element &xi = (Goldilocks3::Element &)*challenges[7];
+    Goldilocks3::Element &v1 = (Goldilocks3::Element &)*challenges[5];
+    Goldilocks3::Element &v2 = (Goldilocks3::Element &)*challenges[6];
+    Polinomial evals(proofs.evals.size(), FIELD_EXTENSION);
+    for (uint64_t i = 0; i < proofs.evals.size(); i++)
+    {
+        memcpy(evals[i], proofs.evals[i].data(), FIELD_EXTENSION * sizeof(Goldilocks::Element));
+    }
+
+    // The constraints at xi must match Zh(xi) * q(xi), where q(xi) = sum(xi^(p*N) * q_p(xi))
+    SyntheticRow row;
+    const EvMap::eType cm = EvMap::eType::cm;
+    const EvMap::eType _const = EvMap::eType::_const;
+    Goldilocks3::copy(&row.f, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, syntheticF, false)]);
+    Goldilocks3::copy(&row.permA, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, syntheticPermA, false)]);
+    Goldilocks3::copy(&row.permB, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, syntheticPermB, false)]);
+    Goldilocks3::copy(&row.conn, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, syntheticConn, false)]);
+    Goldilocks3::copy(&row.a, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, syntheticA, false)]);
+    Goldilocks3::copy(&row.aSquare, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, syntheticASquare, false)]);
+    Goldilocks3::copy(&row.h1, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticH1, false)]);
+    Goldilocks3::copy(&row.h2, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticH2, false)]);
+    Goldilocks3::copy(&row.h1Next, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticH1, true)]);
+    Goldilocks3::copy(&row.zPu, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticZPu, false)]);
+    Goldilocks3::copy(&row.zPuNext, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticZPu, true)]);
+    Goldilocks3::copy(&row.zPe, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticZPe, false)]);
+    Goldilocks3::copy(&row.zPeNext, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticZPe, true)]);
+    Goldilocks3::copy(&row.zCi, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticZCi, false)]);
+    Goldilocks3::copy(&row.zCiNext, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticZCi, true)]);
+    Goldilocks3::copy(&row.imNum, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticImNum, false)]);
+    Goldilocks3::copy(&row.imDen, (Goldilocks3::Element *)evals[evIndex(starkInfo, cm, nCm1 + syntheticImDen, false)]);
+    Goldilocks3::copy(&row.L1, (Goldilocks3::Element *)evals[evIndex(starkInfo, _const, syntheticL1, false)]);
+    Goldilocks3::copy(&row.T, (Goldilocks3::Element *)evals[evIndex(starkInfo, _const, syntheticT, false)]);
+    Goldilocks3::copy(&row.TNext, (Goldilocks3::Element *)evals[evIndex(starkInfo, _const, syntheticT, true)]);
+    Goldilocks3::copy(&row.ID, (Goldilocks3::Element *)evals[evIndex(starkInfo, _const, syntheticID, false)]);
+    Goldilocks3::copy(&row.S, (Goldilocks3::Element *)evals[evIndex(starkInfo, _const, syntheticS, false)]);
+    Goldilocks3::Element c;
+    SyntheticSteps::constraints(c, row, gamma, beta, (Goldilocks3::Element &)*challenges[4]);
+
+    Goldilocks3::Element xiN, aux, one, zh, q, xiPN, qZh;
+    Goldilocks3::copy(&xiN, &xi);
+    for (uint64_t i = 0; i < nBits; i++)
+    {
+        Goldilocks3::mul(aux, xiN, xiN);
+        Goldilocks3::copy(&xiN, &aux);
+    }
+    syntheticToExt(one, Goldilocks::one());
+    syntheticToExt(q, Goldilocks::zero());
+    Goldilocks3::copy(&xiPN, &one);
+    for (uint64_t p = 0; p < starkInfo.qDeg; p++)
+    {
+        Goldilocks3::Element term, sum;
+        Goldilocks3::mul(term, xiPN, (Goldilocks3::Element &)*evals[evIndex(starkInfo, EvMap::eType::q, p, false)]);
+        Goldilocks3::add(sum, q, term);
+        Goldilocks3::copy(&q, &sum);
+        Goldilocks3::mul(aux, xiPN, xiN);
+        Goldilocks3::copy(&xiPN, &aux);
+    }
+    Goldilocks3::sub(zh, xiN, one);
+    Goldilocks3::mul(qZh, q, zh);
+    if (!equal(c, qZh))
+    {
+        cerr << "Error: SyntheticStark::verify() found that the constraints do not match the quotient polynomial at xi" << endl;
+        return false;
+    }
+
+    // Position of every opening in the leaves of a query
+    vector<SyntheticLeafPos> leafPos;
+    for (uint64_t k = 0; k < starkInfo.evMap.size(); k++)
+    {
+        const EvMap &ev = starkInfo.evMap[k];
+        SyntheticLeafPos pos = {4, ev.id, 1};
+        if (ev.type != EvMap::eType::_const)
+        {
+            const VarPolMap &polInfo = starkInfo.varPolMap[(ev.type == EvMap::eType::cm) ? starkInfo.cm_2ns[ev.id] : starkInfo.qs[ev.id]];
+            pos.tree = (polInfo.section == cm1_2ns) ? 0 : (polInfo.section == cm2_2ns) ? 1 : (polInfo.section == cm3_2ns) ? 2 : 3;
+            pos.pos = polInfo.sectionPos;
+            pos.dim = polInfo.dim;
+        }
+        leafPos.push_back(pos);
+    }
+
+    const Goldilocks::Element *roots[5] = {proofs.root1.data(), proofs.root2.data(), proofs.root3.data(), proofs.root4.data(), constRoot};
+    Goldilocks3::Element wxi;
+    Goldilocks3::mul(wxi, xi, Goldilocks::w(nBits));
+    vector<Goldilocks::Element> leaves[5];
+    vector<Goldilocks::Element> group;
+    for (uint64_t qi = 0; qi < nQueries; qi++)
+    {
+        uint64_t idx = ys[qi];
+
+        // Openings of the stage trees and the constants tree
+        for (uint64_t t = 0; t < 5; t++)
+        {
+            if (!checkMerkleProof(roots[t], proofs.fri.trees[0].polQueries[qi][t], idx, leaves[t]))
+            {
+                cerr << "Error: SyntheticStark::verify() found an invalid merkle proof of tree " << t << " in query " << qi << endl;
+                return false;
+            }
+        }
+
+        // FRI polynomial at x = shift * w^idx, from the opened values
+        Goldilocks::Element x = Goldilocks::shift() * Goldilocks::exp(Goldilocks::w(nBitsExt), idx);
+        Goldilocks3::Element xExt, d, dInv, xDivXSubXi, xDivXSubWXi, accXi, accWXi, p, value;
+        syntheticToExt(xExt, x);
+        Goldilocks3::sub(d, xExt, xi);
+        Goldilocks3::inv(&dInv, &d);
+        Goldilocks3::mul(xDivXSubXi, dInv, x);
+        Goldilocks3::sub(d, xExt, wxi);
+        Goldilocks3::inv(&dInv, &d);
+        Goldilocks3::mul(xDivXSubWXi, dInv, x);
+        syntheticToExt(accXi, Goldilocks::zero());
+        syntheticToExt(accWXi, Goldilocks::zero());
+        for (uint64_t k = 0; k < leafPos.size(); k++)
+        {
+            Goldilocks::Element *v = &leaves[leafPos[k].tree][leafPos[k].pos];
+            if (leafPos[k].dim == 1)
+            {
+                syntheticToExt(p, v[0]);
+            }
+            else
+            {
+                memcpy(p, v, FIELD_EXTENSION * sizeof(Goldilocks::Element));
+            }
+            SyntheticSteps::friAccumulate(accXi, accWXi, starkInfo.evMap[k].prime, p, (Goldilocks3::Element &)*evals[k], v1, v2);
+        }
+        SyntheticSteps::friValue(value, accXi, accWXi, xDivXSubXi, xDivXSubWXi);
+
+        // Every FRI step opens the group of the previous polynomial that contains the value, and folds it
+        Goldilocks::Element shiftInv = Goldilocks::inv(Goldilocks::shift());
+        for (uint64_t si = 1; si < nSteps; si++)
+        {
+            uint64_t groupIdx = idx % (1 << steps[si].nBits);
+            if (!checkMerkleProof(proofs.fri.trees[si].root.data(), proofs.fri.trees[si].polQueries[qi][0], groupIdx, group))
+            {
+                cerr << "Error: SyntheticStark::verify() found an invalid merkle proof of FRI step " << si << " in query " << qi << endl;
+                return false;
+            }
+            uint64_t j = idx >> steps[si].nBits;
+            if (!equal(value, (Goldilocks3::Element &)group[j * FIELD_EXTENSION]))
+            {
+                cerr << "Error: SyntheticStark::verify() found a wrong value in FRI step " << si << " of query " << qi << endl;
+                return false;
+            }
+
+            uint64_t polBits = steps[si - 1].nBits;
+            uint64_t reductionBits = polBits - steps[si].nBits;
+            uint64_t nX = 1 << reductionBits;
+            Polinomial ppar(group.data(), nX, FIELD_EXTENSION, FIELD_EXTENSION);
+            Polinomial ppar_c(nX, FIELD_EXTENSION);
+            Polinomial folded(1, FIELD_EXTENSION);
+            Polinomial special_x(specialX[si], 1, FIELD_EXTENSION, FIELD_EXTENSION);
+            NTT_Goldilocks ntt(nX, 1);
+            ntt.INTT(ppar_c.address(), ppar.address(), nX, FIELD_EXTENSION);
+            Goldilocks::Element sinv = shiftInv * Goldilocks::exp(Goldilocks::inv(Goldilocks::w(polBits)), groupIdx);
+            FRIProve::polMulAxi(ppar_c, Goldilocks::one(), sinv);
+            FRIProve::evalPol(folded, 0, ppar_c, special_x);
+            memcpy(value, folded[0], FIELD_EXTENSION * sizeof(Goldilocks::Element));
+
+            for (uint64_t r = 0; r < reductionBits; r++)
+            {
+                shiftInv = shiftInv * shiftInv;
+            }
+            idx = groupIdx;
+        }
+        if (!equal(value, (Goldilocks3::Element &)proofs.fri.pol[idx][0]))
+        {
+            cerr << "Error: SyntheticStark::verify() found a wrong value of the last FRI polynomial in query " << qi << endl;
+            return false;
+        }
+    }
+
+    // The last FRI polynomial, of degree lower than N folded nSteps-1 times, has only zero coefficients above it
+    uint64_t lastN = proofs.fri.pol.size();
+    Polinomial lastPol(lastN, FIELD_EXTENSION);
+    Polinomial lastCoefs(lastN, FIELD_EXTENSION);
+    for (uint64_t i = 0; i < lastN; i++)
+    {
+        memcpy(lastPol[i], proofs.fri.pol[i].data(), FIELD_EXTENSION * sizeof(Goldilocks::Element));
+    }
+    NTT_Goldilocks ntt(lastN);
+    ntt.INTT(lastCoefs.address(), lastPol.address(), lastN, FIELD_EXTENSION);
+    uint64_t maxDegree = N >> (steps[0].nBits - steps[nSteps - 1].nBits);
+    for (uint64_t i = maxDegree * FIELD_EXTENSION; i < lastN * FIELD_EXTENSION; i++)
+    {
+        if (Goldilocks::toU64(lastCoefs.address()[i]) != 0)
+        {
+            cerr << "Error: SyntheticStark::verify() found that the last FRI polynomial has degree " << i / FIELD_EXTENSION << " >= " << maxDegree << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include "input_test.hpp"
+#include "input.hpp"
+#include "zkresult.hpp"
+#include "test_utils.hpp"
+
+using namespace std;
+
+// Saves the input in binary format, loads it into a new input and compares every field
+static void roundTrip (Goldilocks &fr, TestChecker &checker, Input &input, const string &name)
+{
+    string data;
+    input.saveBinary(data);
+
+    Input loaded(fr);
+    zkresult zkr = loaded.loadBinary((const uint8_t *)data.data(), data.size());
+    checker.check(zkr == ZKR_SUCCESS, name + " loadBinary() result");
+
+    const PublicInputs &a = input.publicInputsExtended.publicInputs;
+    const PublicInputs &b = loaded.publicInputsExtended.publicInputs;
+    checker.check(a.oldStateRoot == b.oldStateRoot, name + " oldStateRoot");
+    checker.check(a.oldAccInputHash == b.oldAccInputHash, name + " oldAccInputHash");
+    checker.check(a.oldBatchNum == b.oldBatchNum, name + " oldBatchNum");
+    checker.check(a.chainID == b.chainID, name + " chainID");
+    checker.check(a.batchL2Data == b.batchL2Data, name + " batchL2Data");
+    checker.check(a.globalExitRoot == b.globalExitRoot, name + " globalExitRoot");
+    checker.check(a.timestamp == b.timestamp, name + " timestamp");
+    checker.check(a.sequencerAddr == b.sequencerAddr, name + " sequencerAddr");
+    checker.check(a.aggregatorAddress == b.aggregatorAddress, name + " aggregatorAddress");
+    checker.check(input.publicInputsExtended.newStateRoot == loaded.publicInputsExtended.newStateRoot, name + " newStateRoot");
+    checker.check(input.publicInputsExtended.newAccInputHash == loaded.publicInputsExtended.newAccInputHash, name + " newAccInputHash");
+    checker.check(input.publicInputsExtended.newLocalExitRoot == loaded.publicInputsExtended.newLocalExitRoot, name + " newLocalExitRoot");
+    checker.check(input.publicInputsExtended.newBatchNum == loaded.publicInputsExtended.newBatchNum, name + " newBatchNum");
+    checker.check(input.from == loaded.from, name + " from");
+    checker.check(input.bUpdateMerkleTree == loaded.bUpdateMerkleTree, name + " bUpdateMerkleTree");
+    checker.check(input.bNoCounters == loaded.bNoCounters, name + " bNoCounters");
+    checker.check(input.txHashToGenerateExecuteTrace == loaded.txHashToGenerateExecuteTrace, name + " txHashToGenerateExecuteTrace");
+    checker.check(input.txHashToGenerateCallTrace == loaded.txHashToGenerateCallTrace, name + " txHashToGenerateCallTrace");
+    checker.check(mtMapEqual(fr, input.db, loaded.db), name + " db");
+    checker.check(input.contractsBytecode == loaded.contractsBytecode, name + " contractsBytecode");
+
+    // Saving the loaded input must give the same data, but for the order of the map entries
+    string data2;
+    loaded.saveBinary(data2);
+    checker.check(data2.size() == data.size(), name + " size of the data saved again");
+
+    // Every truncation of the data, and any data after its end, must be rejected
+    for (uint64_t size=0; size<data.size(); size++)
+    {
+        Input truncated(fr);
+        if (truncated.loadBinary((const uint8_t *)data.data(), size) == ZKR_SUCCESS)
+        {
+            checker.check(false, name + " truncated to " + to_string(size) + " bytes");
+            break;
+        }
+    }
+    string extended = data + '\0';
+    Input extendedInput(fr);
+    checker.check(extendedInput.loadBinary((const uint8_t *)extended.data(), extended.size()) != ZKR_SUCCESS, name + " with trailing data");
+
+    // Another version must be rejected
+    string otherVersion = data;
+    otherVersion[4]++;
+    Input otherVersionInput(fr);
+    checker.check(otherVersionInput.loadBinary((const uint8_t *)otherVersion.data(), otherVersion.size()) != ZKR_SUCCESS, name + " with another version");
+}
+
+uint64_t InputBinaryTest (Goldilocks &fr)
+{
+    cout << "InputBinaryTest starting..." << endl;
+    TestChecker checker("InputBinaryTest");
+
+    // Empty input, with the default values
+    {
+        Input input(fr);
+        roundTrip(fr, checker, input, "empty input");
+    }
+
+    // Input with all the fields set, and db and contractsBytecode records of every kind
+    {
+        Input input(fr);
+        PublicInputs &publicInputs = input.publicInputsExtended.publicInputs;
+        publicInputs.oldStateRoot.set_str("2dc4db4293af236cb329700be43f08ace740a05088f8c7654736871709687e90", 16);
+        publicInputs.oldAccInputHash.set_str("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", 16);
+        publicInputs.oldBatchNum = 0xFFFFFFFF;
+        publicInputs.chainID = 1000;
+        publicInputs.batchL2Data = string("\xee\x80\x84\x3b\x9a\xca\x00\x00\x01", 9);
+        publicInputs.globalExitRoot = 0;
+        publicInputs.timestamp = 1944498031;
+        publicInputs.sequencerAddr.set_str("617b3a3528F9cDd6630fd3301B9c8911F7Bf063D", 16);
+        publicInputs.aggregatorAddress = 1;
+        input.publicInputsExtended.newStateRoot.set_str("bff23fc2c168c033aaac77503ce18f958e9689d5cdaebb88c5524ce5c0319de3", 16);
+        input.publicInputsExtended.newAccInputHash.set_str("1", 16);
+        input.publicInputsExtended.newLocalExitRoot.set_str("100000000000000000000000000000000", 16);
+        input.publicInputsExtended.newBatchNum = 2;
+        input.from = "0x617b3a3528F9cDd6630fd3301B9c8911F7Bf063D";
+        input.bUpdateMerkleTree = false;
+        input.bNoCounters = true;
+        input.txHashToGenerateExecuteTrace = "0x1d2f5a9d8dbdb6b1a6b2ef4b1d46e64ad94d0b2e6bfae4c8efa5b3a3aa0a3e7e";
+        input.txHashToGenerateCallTrace = "";
+
+        // Keys are saved as 32 bytes, so they are loaded as 64 lower case hex chars
+        vector<Goldilocks::Element> value;
+        input.db["0000000000000000000000000000000000000000000000000000000000000000"] = value;
+        for (uint64_t i=0; i<INPUT_BINARY_DB_VALUES; i++) value.push_back(fr.fromU64(i*0x100000001ULL));
+        input.db["00000000000000000000000000000000000000000000000000000000000000ff"] = value;
+        value.resize(8);
+        input.db["0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"] = value;
+        for (uint64_t i=0; i<3*INPUT_BINARY_DB_VALUES; i++) value.push_back(fr.fromU64(0xFFFFFFFF00000000ULL - i));
+        input.db["ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"] = value;
+        input.contractsBytecode["1111111111111111111111111111111111111111111111111111111111111111"] = vector<uint8_t>();
+        input.contractsBytecode["fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210"] = {0x60, 0x80, 0x60, 0x40, 0x52, 0x00, 0xff};
+
+        roundTrip(fr, checker, input, "full input");
+    }
+
+    cout << "InputBinaryTest done with " << checker.errors << " errors" << endl;
+    return checker.errors;
+}
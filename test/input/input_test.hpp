@@ -0,0 +1,10 @@
+#ifndef INPUT_TEST_HPP
+#define INPUT_TEST_HPP
+
+#include "goldilocks_base_field.hpp"
+
+// Round trip of the binary batch input format: saves an input with Input::saveBinary(), loads it
+// with Input::loadBinary() and compares every field; returns the number of errors
+uint64_t InputBinaryTest (Goldilocks &fr);
+
+#endif
@@ -122,12 +122,10 @@ using grpc::Status;
         aggregator::v1::InputProver *pInputProver = new aggregator::v1::InputProver();
         zkassertpermanent(pInputProver != NULL);
         Input input(fr);
-        json inputJson;
-        file2json(config.inputFile, inputJson);
-        zkresult zkResult = input.load(inputJson);
+        zkresult zkResult = input.loadFile(config.inputFile);
         if (zkResult != ZKR_SUCCESS)
         {
-            cerr << "Error: AggregatorServiceImpl::Channel() failed calling input.load() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
+            cerr << "Error: AggregatorServiceImpl::Channel() failed calling input.loadFile() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
             exitProcess();
         }
 
@@ -54,12 +54,10 @@ bool ExecutorClient::ProcessBatch (void)
     ::grpc::ClientContext context;
     ::executor::v1::ProcessBatchRequest request;
     Input input(fr);
-    json inputJson;
-    file2json(config.inputFile, inputJson);
-    zkresult zkResult = input.load(inputJson);
+    zkresult zkResult = input.loadFile(config.inputFile);
     if (zkResult != ZKR_SUCCESS)
     {
-        cerr << "Error: ProverClient::GenProof() failed calling input.load() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
+        cerr << "Error: ProverClient::GenProof() failed calling input.loadFile() zkResult=" << zkResult << "=" << zkresult2string(zkResult) << endl;
         exit(-1);
     }
 
@@ -3,7 +3,9 @@
 
 #include "config.hpp"
 
+// Launches the StateDB performance test thread, and waits for it to end
 void runStateDBPerfTest (const Config& config);
+void waitStateDBPerfTest (void);
 void* stateDBPerfTestThread (const Config& config);
 
 #endif
@@ -0,0 +1,306 @@
+#include <iostream>
+#include "statedb_test_stream.hpp"
+#include "statedb_stream.hpp"
+#include "statedb_interface.hpp"
+#include "zkresult.hpp"
+#include "test_utils.hpp"
+
+using namespace std;
+
+/* The fake StateDB stores the arguments decoded by stateDBStreamProcess() and returns canned
+   results, so that both directions of the codec are checked without a database */
+
+class StateDBStreamTestDB : public StateDBInterface
+{
+public:
+    Goldilocks &fr;
+
+    // Arguments of the last call
+    Goldilocks::Element root[4];
+    Goldilocks::Element key[4];
+    mpz_class value;
+    bool persistent;
+    bool bDbReadLog;
+    vector<Goldilocks::Element> keys;
+    vector<mpz_class> values;
+
+    // Results of every call
+    zkresult zkr;
+    SmtGetResult getResult;
+    SmtSetResult setResult;
+    DatabaseMap::MTMap dbReadLog;
+
+    StateDBStreamTestDB (Goldilocks &fr) : fr(fr), persistent(false), bDbReadLog(false), zkr(ZKR_SUCCESS) {};
+
+    void saveArguments (const Goldilocks::Element (&_root)[4], DatabaseMap *_dbReadLog)
+    {
+        for (uint64_t i=0; i<4; i++) root[i] = _root[i];
+        bDbReadLog = (_dbReadLog != NULL);
+        if (_dbReadLog != NULL) _dbReadLog->add(dbReadLog);
+    }
+
+    zkresult set (const Goldilocks::Element (&oldRoot)[4], const Goldilocks::Element (&_key)[4], const mpz_class &_value, const bool _persistent, Goldilocks::Element (&newRoot)[4], SmtSetResult *result, DatabaseMap *_dbReadLog)
+    {
+        saveArguments(oldRoot, _dbReadLog);
+        for (uint64_t i=0; i<4; i++) key[i] = _key[i];
+        value = _value;
+        persistent = _persistent;
+        for (uint64_t i=0; i<4; i++) newRoot[i] = setResult.newRoot[i];
+        if (result != NULL) *result = setResult;
+        return zkr;
+    }
+
+    zkresult get (const Goldilocks::Element (&_root)[4], const Goldilocks::Element (&_key)[4], mpz_class &_value, SmtGetResult *result, DatabaseMap *_dbReadLog)
+    {
+        saveArguments(_root, _dbReadLog);
+        for (uint64_t i=0; i<4; i++) key[i] = _key[i];
+        _value = getResult.value;
+        if (result != NULL) *result = getResult;
+        return zkr;
+    }
+
+    zkresult multiGet (const Goldilocks::Element (&_root)[4], const vector<Goldilocks::Element> &_keys, vector<mpz_class> &_values, DatabaseMap *_dbReadLog)
+    {
+        saveArguments(_root, _dbReadLog);
+        keys = _keys;
+        _values = values;
+        return zkr;
+    }
+
+    zkresult multiSet (const Goldilocks::Element (&oldRoot)[4], const vector<Goldilocks::Element> &_keys, const vector<mpz_class> &_values, const bool _persistent, vector<Goldilocks::Element> &newRoots, DatabaseMap *_dbReadLog)
+    {
+        saveArguments(oldRoot, _dbReadLog);
+        keys = _keys;
+        values = _values;
+        persistent = _persistent;
+        newRoots = keys; // Any list of 4*n elements will do
+        return zkr;
+    }
+
+    zkresult setProgram (const Goldilocks::Element (&key)[4], const vector<uint8_t> &data, const bool persistent) { return ZKR_SUCCESS; };
+    zkresult getProgram (const Goldilocks::Element (&key)[4], vector<uint8_t> &data, DatabaseMap *dbReadLog) { return ZKR_SUCCESS; };
+    void loadDB (const DatabaseMap::MTMap &input, const bool persistent) {};
+    void loadProgramDB (const DatabaseMap::ProgramMap &input, const bool persistent) {};
+    void flush () {};
+};
+
+static bool feaEqual (Goldilocks &fr, const Goldilocks::Element (&a)[4], const Goldilocks::Element (&b)[4])
+{
+    for (uint64_t i=0; i<4; i++)
+    {
+        if (fr.toU64(a[i]) != fr.toU64(b[i])) return false;
+    }
+    return true;
+}
+
+static bool siblingsEqual (Goldilocks &fr, const map<uint64_t, vector<Goldilocks::Element>> &a, const map<uint64_t, vector<Goldilocks::Element>> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (auto it = a.begin(); it != a.end(); it++)
+    {
+        auto other = b.find(it->first);
+        if ((other == b.end()) || !feVectorEqual(fr, it->second, other->second)) return false;
+    }
+    return true;
+}
+
+// Frames the request as a record, as the client does, and unframes it, as the server does, before processing it
+static void process (Goldilocks &fr, TestChecker &checker, StateDBStreamTestDB &db, const StateDBStreamWriter &request, string &response)
+{
+    StateDBStreamWriter message;
+    message.record(7, request.data);
+    message.record(8, request.data);
+
+    StateDBStreamReader r(message.data);
+    uint64_t id;
+    string body;
+    checker.check(r.record(id, body) && (id == 7) && (body == request.data), "first record");
+    checker.check(r.record(id, body) && (id == 8) && (body == request.data), "second record");
+    checker.check(!r.record(id, body) && !r.error() && r.eof(), "end of the message");
+
+    stateDBStreamProcess(fr, db, body, response);
+}
+
+uint64_t StateDBStreamTest (Goldilocks &fr)
+{
+    cout << "StateDBStreamTest starting..." << endl;
+    TestChecker checker("StateDBStreamTest");
+
+    StateDBStreamTestDB db(fr);
+    Goldilocks::Element root[4] = {fr.fromU64(1), fr.fromU64(0xFFFFFFFF00000000ULL), fr.fromU64(3), fr.fromU64(4)};
+    Goldilocks::Element key[4] = {fr.fromU64(5), fr.fromU64(6), fr.fromU64(0x123456789ABCDEFULL), fr.fromU64(0)};
+
+    // Canned results
+    for (uint64_t i=0; i<4; i++)
+    {
+        db.getResult.root[i] = root[i];
+        db.getResult.key[i] = key[i];
+        db.getResult.insKey[i] = fr.fromU64(100 + i);
+        db.setResult.oldRoot[i] = root[i];
+        db.setResult.key[i] = key[i];
+        db.setResult.newRoot[i] = fr.fromU64(200 + i);
+        db.setResult.insKey[i] = fr.fromU64(300 + i);
+    }
+    db.getResult.siblings[0] = {fr.fromU64(1), fr.fromU64(2), fr.fromU64(3), fr.fromU64(4)};
+    db.getResult.siblings[1] = {};
+    db.getResult.siblings[255] = {fr.fromU64(0xFFFFFFFF00000000ULL)};
+    db.getResult.insValue.set_str("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF", 16);
+    db.getResult.isOld0 = true;
+    db.getResult.value.set_str("1234567890abcdef1234567890abcdef", 16);
+    db.getResult.proofHashCounter = 0xFFFFFFFFFFFFFFFFULL;
+    db.setResult.siblings = db.getResult.siblings;
+    db.setResult.insValue = 0;
+    db.setResult.isOld0 = false;
+    db.setResult.oldValue = 1;
+    db.setResult.newValue.set_str("100000000000000000000000000000000", 16);
+    db.setResult.mode = "insertNotFound";
+    db.setResult.proofHashCounter = 3;
+    db.dbReadLog["0123"] = {fr.fromU64(1), fr.fromU64(2)};
+    db.dbReadLog["abcd"] = {};
+    db.values = {mpz_class(0), mpz_class(1), mpz_class("ffffffffffffffffffffffffffffffffffff", 16)};
+
+    // get, with details and database reads
+    {
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamGetRequest(fr, request, root, key, STATEDB_STREAM_FLAG_DETAILS | STATEDB_STREAM_FLAG_DB_READ_LOG);
+        process(fr, checker, db, request, response);
+        checker.check(feaEqual(fr, db.root, root) && feaEqual(fr, db.key, key) && db.bDbReadLog, "get request");
+
+        StateDBStreamReader r(response);
+        mpz_class value;
+        SmtGetResult result;
+        DatabaseMap dbReadLog;
+        zkresult zkr = stateDBStreamGetResponse(fr, r, value, &result, &dbReadLog);
+        checker.check(zkr == ZKR_SUCCESS, "get result");
+        checker.check(value == db.getResult.value, "get value");
+        checker.check(feaEqual(fr, result.root, db.getResult.root) && feaEqual(fr, result.key, db.getResult.key) && feaEqual(fr, result.insKey, db.getResult.insKey), "get details roots and keys");
+        checker.check(siblingsEqual(fr, result.siblings, db.getResult.siblings), "get details siblings");
+        checker.check((result.insValue == db.getResult.insValue) && (result.isOld0 == db.getResult.isOld0) && (result.value == db.getResult.value) && (result.proofHashCounter == db.getResult.proofHashCounter), "get details values");
+        checker.check(mtMapEqual(fr, dbReadLog.getMTDB(), db.dbReadLog), "get database reads");
+        checker.check(r.eof(), "end of the get response");
+    }
+
+    // get, without details nor database reads, failing
+    {
+        db.zkr = ZKR_DB_KEY_NOT_FOUND;
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamGetRequest(fr, request, root, key, 0);
+        process(fr, checker, db, request, response);
+        checker.check(!db.bDbReadLog, "get request without database reads");
+
+        StateDBStreamReader r(response);
+        mpz_class value;
+        zkresult zkr = stateDBStreamGetResponse(fr, r, value, NULL, NULL);
+        checker.check(zkr == ZKR_DB_KEY_NOT_FOUND, "failed get result");
+        checker.check(r.eof(), "end of the failed get response");
+        db.zkr = ZKR_SUCCESS;
+    }
+
+    // set, with details and database reads
+    {
+        mpz_class value("fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210", 16);
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamSetRequest(fr, request, root, key, value, true, STATEDB_STREAM_FLAG_DETAILS | STATEDB_STREAM_FLAG_DB_READ_LOG);
+        process(fr, checker, db, request, response);
+        checker.check(feaEqual(fr, db.root, root) && feaEqual(fr, db.key, key) && (db.value == value) && db.persistent && db.bDbReadLog, "set request");
+
+        StateDBStreamReader r(response);
+        Goldilocks::Element newRoot[4];
+        SmtSetResult result;
+        DatabaseMap dbReadLog;
+        zkresult zkr = stateDBStreamSetResponse(fr, r, newRoot, &result, &dbReadLog);
+        checker.check(zkr == ZKR_SUCCESS, "set result");
+        checker.check(feaEqual(fr, newRoot, db.setResult.newRoot), "set new root");
+        checker.check(feaEqual(fr, result.oldRoot, db.setResult.oldRoot) && feaEqual(fr, result.key, db.setResult.key) && feaEqual(fr, result.newRoot, db.setResult.newRoot) && feaEqual(fr, result.insKey, db.setResult.insKey), "set details roots and keys");
+        checker.check(siblingsEqual(fr, result.siblings, db.setResult.siblings), "set details siblings");
+        checker.check((result.insValue == db.setResult.insValue) && (result.isOld0 == db.setResult.isOld0) && (result.oldValue == db.setResult.oldValue) && (result.newValue == db.setResult.newValue), "set details values");
+        checker.check((result.mode == db.setResult.mode) && (result.proofHashCounter == db.setResult.proofHashCounter), "set details mode and counter");
+        checker.check(mtMapEqual(fr, dbReadLog.getMTDB(), db.dbReadLog), "set database reads");
+        checker.check(r.eof(), "end of the set response");
+    }
+
+    // multiGet
+    {
+        vector<Goldilocks::Element> keys;
+        for (uint64_t i=0; i<12; i++) keys.push_back(fr.fromU64(i*0x1000000001ULL));
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamMultiGetRequest(fr, request, root, keys, STATEDB_STREAM_FLAG_DB_READ_LOG);
+        process(fr, checker, db, request, response);
+        checker.check(feaEqual(fr, db.root, root) && feVectorEqual(fr, db.keys, keys) && db.bDbReadLog, "multiGet request");
+
+        StateDBStreamReader r(response);
+        vector<mpz_class> values;
+        DatabaseMap dbReadLog;
+        zkresult zkr = stateDBStreamMultiGetResponse(fr, r, values, &dbReadLog);
+        checker.check(zkr == ZKR_SUCCESS, "multiGet result");
+        checker.check(values == db.values, "multiGet values");
+        checker.check(mtMapEqual(fr, dbReadLog.getMTDB(), db.dbReadLog), "multiGet database reads");
+        checker.check(r.eof(), "end of the multiGet response");
+    }
+
+    // multiSet
+    {
+        vector<Goldilocks::Element> keys;
+        for (uint64_t i=0; i<8; i++) keys.push_back(fr.fromU64(i + 1));
+        vector<mpz_class> values = {mpz_class(7), mpz_class(0)};
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamMultiSetRequest(fr, request, root, keys, values, false, 0);
+        process(fr, checker, db, request, response);
+        checker.check(feaEqual(fr, db.root, root) && feVectorEqual(fr, db.keys, keys) && (db.values == values) && !db.persistent && !db.bDbReadLog, "multiSet request");
+
+        StateDBStreamReader r(response);
+        vector<Goldilocks::Element> newRoots;
+        zkresult zkr = stateDBStreamMultiSetResponse(fr, r, newRoots, NULL);
+        checker.check(zkr == ZKR_SUCCESS, "multiSet result");
+        checker.check(feVectorEqual(fr, newRoots, keys), "multiSet new roots");
+        checker.check(r.eof(), "end of the multiSet response");
+    }
+
+    // Truncated messages must fail, not read past their end
+    {
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamGetRequest(fr, request, root, key, STATEDB_STREAM_FLAG_DETAILS | STATEDB_STREAM_FLAG_DB_READ_LOG);
+        stateDBStreamProcess(fr, db, request.data, response);
+        for (uint64_t size=0; size<response.size(); size++)
+        {
+            StateDBStreamReader r((const uint8_t *)response.data(), size);
+            mpz_class value;
+            SmtGetResult result;
+            DatabaseMap dbReadLog;
+            checker.check(stateDBStreamGetResponse(fr, r, value, &result, &dbReadLog) == ZKR_INTERNAL_ERROR, "truncated get response of size " + to_string(size));
+        }
+
+        string truncated = request.data.substr(0, request.data.size() - 1);
+        stateDBStreamProcess(fr, db, truncated, response);
+        StateDBStreamReader r(response);
+        mpz_class value;
+        checker.check(stateDBStreamGetResponse(fr, r, value, NULL, NULL) == ZKR_INTERNAL_ERROR, "truncated get request");
+
+        StateDBStreamWriter message;
+        message.record(1, request.data);
+        StateDBStreamReader recordReader((const uint8_t *)message.data.data(), message.data.size() - 1);
+        uint64_t id;
+        string body;
+        checker.check(!recordReader.record(id, body) && recordReader.error(), "truncated record");
+    }
+
+    // A response of another operation must fail
+    {
+        StateDBStreamWriter request;
+        string response;
+        stateDBStreamGetRequest(fr, request, root, key, 0);
+        stateDBStreamProcess(fr, db, request.data, response);
+        StateDBStreamReader r(response);
+        Goldilocks::Element newRoot[4];
+        checker.check(stateDBStreamSetResponse(fr, r, newRoot, NULL, NULL) == ZKR_INTERNAL_ERROR, "response of another operation");
+    }
+
+    cout << "StateDBStreamTest done with " << checker.errors << " errors" << endl;
+    return checker.errors;
+}
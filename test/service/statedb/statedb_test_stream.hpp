@@ -0,0 +1,10 @@
+#ifndef STATEDB_TEST_STREAM_HPP
+#define STATEDB_TEST_STREAM_HPP
+
+#include "goldilocks_base_field.hpp"
+
+// Round trip of the StateDB streaming protocol codec: requests encoded by the client are decoded
+// by stateDBStreamProcess(), and its responses are decoded by the client; returns the number of errors
+uint64_t StateDBStreamTest (Goldilocks &fr);
+
+#endif
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <unistd.h>
+#include "database_journal_test.hpp"
+#include "database_journal.hpp"
+#include "database_map.hpp"
+#include "db_reads_journal.hpp"
+#include "input.hpp"
+#include "utils.hpp"
+#include "test_utils.hpp"
+
+using namespace std;
+
+static vector<Goldilocks::Element> mtValue (Goldilocks &fr, uint64_t size, uint64_t seed)
+{
+    vector<Goldilocks::Element> value;
+    for (uint64_t i=0; i<size; i++) value.push_back(fr.fromU64(seed*0x100000001ULL + i));
+    return value;
+}
+
+uint64_t DatabaseJournalTest (Goldilocks &fr, const Config &config)
+{
+    cout << "DatabaseJournalTest starting..." << endl;
+    TestChecker checker("DatabaseJournalTest");
+
+    string journalFile = (filesystem::temp_directory_path() / ("zkprover_database_journal_test_" + to_string(getpid()) + ".journal")).string();
+
+    // Input of the batch, without its database, as ProverRequest::openDbReadLogJournal() journals it
+    Input input(fr);
+    input.publicInputsExtended.publicInputs.oldStateRoot.set_str("2dc4db4293af236cb329700be43f08ace740a05088f8c7654736871709687e90", 16);
+    input.publicInputsExtended.publicInputs.oldBatchNum = 7;
+    input.publicInputsExtended.publicInputs.chainID = 1000;
+    input.publicInputsExtended.publicInputs.timestamp = 1944498031;
+    input.publicInputsExtended.publicInputs.batchL2Data = string("\xee\x80\x84\x3b\x9a\xca\x00\x00\x01", 9);
+    input.publicInputsExtended.newStateRoot.set_str("bff23fc2c168c033aaac77503ce18f958e9689d5cdaebb88c5524ce5c0319de3", 16);
+    input.from = "0x617b3a3528f9cdd6630fd3301b9c8911f7bf063d";
+
+    DatabaseJournal journal;
+    journal.open(journalFile, 2);
+    DatabaseMap emptyDB;
+    string inputBinary;
+    input.saveBinary(inputBinary, emptyDB);
+    journal.addInput(inputBinary);
+
+    // Journal writes of every kind into the map
+    DatabaseMap dbMap;
+    dbMap.setJournal(&journal);
+    dbMap.add("0000000000000000000000000000000000000000000000000000000000000001", mtValue(fr, 12, 1));
+    dbMap.add("0000000000000000000000000000000000000000000000000000000000000002", mtValue(fr, 8, 2));
+    dbMap.add("0000000000000000000000000000000000000000000000000000000000000003", mtValue(fr, 40, 3));
+    dbMap.add("0000000000000000000000000000000000000000000000000000000000000004", mtValue(fr, 0, 4));
+    dbMap.add("0000000000000000000000000000000000000000000000000000000000000002", mtValue(fr, 12, 5)); // Replaces the previous value
+    dbMap.add("abcdef0000000000000000000000000000000000000000000000000000000001", vector<uint8_t>{0x60, 0x80, 0x60, 0x40, 0x52});
+    dbMap.add("abcdef0000000000000000000000000000000000000000000000000000000002", vector<uint8_t>());
+    dbMap.add("abcdef0000000000000000000000000000000000000000000000000000000003", vector<uint8_t>(17, 0xff));
+    DatabaseMap::MTMap mtMap;
+    mtMap["0000000000000000000000000000000000000000000000000000000000000001"] = mtValue(fr, 12, 6); // Already present, so it is kept
+    mtMap["ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"] = mtValue(fr, 13, 7);
+    dbMap.add(mtMap);
+    DatabaseMap::ProgramMap programMap;
+    programMap["abcdef0000000000000000000000000000000000000000000000000000000001"] = vector<uint8_t>{0x00}; // Already present, so it is kept
+    programMap["abcdef0000000000000000000000000000000000000000000000000000000004"] = vector<uint8_t>(8, 0x01);
+    dbMap.add(programMap);
+    dbMap.setJournal(NULL);
+    journal.close();
+
+    // A record truncated by a crash at the end of the journal must be ignored
+    {
+        ofstream file(journalFile, ios::binary | ios::app);
+        string truncatedRecord(20, '\x01');
+        file.write(truncatedRecord.data(), truncatedRecord.size());
+    }
+
+    // Expected result: the JSON dump of the input with the map as its database
+    json expected;
+    input.save(expected, dbMap);
+
+    // Convert the journal into a JSON input file
+    Config converterConfig = config;
+    converterConfig.inputFile = journalFile;
+    converterConfig.saveInputInBinaryFormat = false;
+    DbReadsJournalConvert(fr, converterConfig);
+    json converted;
+    file2json(journalFile + ".json", converted);
+    checker.check(converted == expected, "the JSON input file converted from the journal");
+
+    // Convert the journal into a binary input file
+    converterConfig.saveInputInBinaryFormat = true;
+    DbReadsJournalConvert(fr, converterConfig);
+    Input loaded(fr);
+    checker.check(loaded.loadFile(journalFile + ".bin") == ZKR_SUCCESS, "the loading of the binary input file converted from the journal");
+    json convertedBinary;
+    loaded.save(convertedBinary);
+    checker.check(convertedBinary == expected, "the binary input file converted from the journal");
+
+    remove(journalFile.c_str());
+    remove((journalFile + ".json").c_str());
+    remove((journalFile + ".bin").c_str());
+
+    cout << "DatabaseJournalTest done with " << checker.errors << " errors" << endl;
+    return checker.errors;
+}
@@ -0,0 +1,11 @@
+#ifndef DATABASE_JOURNAL_TEST_HPP
+#define DATABASE_JOURNAL_TEST_HPP
+
+#include "goldilocks_base_field.hpp"
+#include "config.hpp"
+
+// Journals database map writes, converts the journal back into an input file with the
+// runDbReadsJournalConverter tool and compares it with the JSON dump of the map; returns the number of errors
+uint64_t DatabaseJournalTest (Goldilocks &fr, const Config &config);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef TEST_UTILS_HPP
+#define TEST_UTILS_HPP
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "goldilocks_base_field.hpp"
+#include "database_map.hpp"
+
+using namespace std;
+
+// Counts the failed checks of a test, logging every one of them with the name of the test
+class TestChecker
+{
+    const string testName;
+public:
+    uint64_t errors;
+
+    TestChecker (const string &testName) : testName(testName), errors(0) {};
+
+    void check (bool bOk, const string &what)
+    {
+        if (!bOk)
+        {
+            cerr << "Error: " << testName << "() failed checking " << what << endl;
+            errors++;
+        }
+    }
+};
+
+inline bool feVectorEqual (Goldilocks &fr, const vector<Goldilocks::Element> &a, const vector<Goldilocks::Element> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (uint64_t i=0; i<a.size(); i++)
+    {
+        if (fr.toU64(a[i]) != fr.toU64(b[i])) return false;
+    }
+    return true;
+}
+
+inline bool mtMapEqual (Goldilocks &fr, const DatabaseMap::MTMap &a, const DatabaseMap::MTMap &b)
+{
+    if (a.size() != b.size()) return false;
+    for (DatabaseMap::MTMap::const_iterator it = a.begin(); it != a.end(); it++)
+    {
+        DatabaseMap::MTMap::const_iterator other = b.find(it->first);
+        if ((other == b.end()) || !feVectorEqual(fr, it->second, other->second)) return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,36 @@
+#include <iostream>
+#include "db_reads_journal.hpp"
+#include "database_journal.hpp"
+#include "database_map.hpp"
+#include "input.hpp"
+#include "timer.hpp"
+#include "exit_process.hpp"
+
+void DbReadsJournalConvert (Goldilocks &fr, const Config &config)
+{
+    TimerStart(DB_READS_JOURNAL_CONVERT);
+
+    // Read the input and the database reads
+    string inputBinary;
+    DatabaseMap dbReadLog;
+    zkresult zkr = DatabaseJournal::load(config.inputFile, inputBinary, dbReadLog);
+    if (zkr != ZKR_SUCCESS)
+    {
+        cerr << "Error: DbReadsJournalConvert() failed calling DatabaseJournal::load() of file " << config.inputFile << " zkr=" << zkr << "=" << zkresult2string(zkr) << endl;
+        exitProcess();
+    }
+    Input input(fr);
+    zkr = input.loadBinary((const uint8_t *)inputBinary.c_str(), inputBinary.size());
+    if (zkr != ZKR_SUCCESS)
+    {
+        cerr << "Error: DbReadsJournalConvert() failed calling Input::loadBinary() zkr=" << zkr << "=" << zkresult2string(zkr) << endl;
+        exitProcess();
+    }
+
+    // Save them as an input file, with the database reads as its database
+    string outputFile = config.inputFile + (config.saveInputInBinaryFormat ? ".bin" : ".json");
+    input.saveFile(outputFile, config.saveInputInBinaryFormat, dbReadLog);
+    cout << "DbReadsJournalConvert() saved " << dbReadLog.getMTDB().size() << " database reads and " << dbReadLog.getProgramDB().size() << " program reads into file " << outputFile << endl;
+
+    TimerStopAndLog(DB_READS_JOURNAL_CONVERT);
+}
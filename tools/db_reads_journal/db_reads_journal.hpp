@@ -0,0 +1,11 @@
+#ifndef DB_READS_JOURNAL_HPP
+#define DB_READS_JOURNAL_HPP
+
+#include "goldilocks_base_field.hpp"
+#include "config.hpp"
+
+/* Converts the database reads journal in config.inputFile into an input file, in the same format
+   saveDbReadsToFile generates, named <inputFile>.json or <inputFile>.bin as per saveInputInBinaryFormat */
+void DbReadsJournalConvert (Goldilocks &fr, const Config &config);
+
+#endif